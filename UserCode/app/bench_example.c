@@ -0,0 +1,294 @@
+/**
+ * @file    bench_example.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   an example measuring the cost of the control hot path
+ *
+ * 测量 解包 -> PID -> 打包发送 各环节以及完整 8 电机控制周期的 CPU 周期数，
+ * 结果以 CSV 写入 bench_report，可用调试器查看或通过串口输出，
+ * 用于在修改驱动后发现性能回归，以及评估提升控制频率 (1kHz -> 2~4kHz) 的余量。
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+
+#include <string.h>
+#include "bsp/can_driver.h"
+#include "bsp/perf_counter.h"
+#include "can.h"
+#include "drivers/DJI.h"
+#include "drivers/DM.h"
+#include "drivers/vesc.h"
+#include "interfaces/motor_if.h"
+#include "libs/pid_bank.h"
+#include "libs/pid_motor.h"
+#include "libs/velocity_observer.h"
+
+#define BENCH_ITERATIONS (1000) ///< 每一项的测量次数
+#define BENCH_DJI_NUM    (8)
+#define BENCH_PID_NUM    (12) ///< 批量 PID 对比的控制器数
+
+typedef enum
+{
+    BENCH_DJI_DECODE = 0U,
+    BENCH_DM_DECODE,
+    BENCH_VESC_DECODE,
+    BENCH_PID_CALCULATE,
+    BENCH_POS_CTRL_UPDATE,
+    BENCH_DJI_SEND,
+    BENCH_TICK_8_MOTORS, ///< 8 个大疆电机的位置环更新 + 两组电流指令发送
+    BENCH_REPLAY_8,      ///< 全速回放 8 帧大疆反馈（路由查找 + 解码）
+    BENCH_IF_SWITCH,     ///< 按 MotorType_t switch 读取角度和转速
+    BENCH_IF_OPS,        ///< 通过 MotorOps_t 读取角度和转速
+    BENCH_PID_12,        ///< 逐个计算 12 个 MotorPID_t
+    BENCH_PID_BATCH_12,  ///< MotorPID_CalculateBatch 计算 12 个控制器
+    BENCH_OBSERVER,      ///< VelocityObserver_Update 更新一步
+    BENCH_DJI_OBSERVED,  ///< 挂接了速度观测器的大疆电机解包
+
+    BENCH_COUNT
+} Bench_Item_t;
+
+static const char* bench_names[BENCH_COUNT] = {
+    [BENCH_DJI_DECODE]      = "dji_decode",
+    [BENCH_DM_DECODE]       = "dm_decode",
+    [BENCH_VESC_DECODE]     = "vesc_decode",
+    [BENCH_PID_CALCULATE]   = "pid_calculate",
+    [BENCH_POS_CTRL_UPDATE] = "pos_ctrl_update",
+    [BENCH_DJI_SEND]        = "dji_send_iq",
+    [BENCH_TICK_8_MOTORS]   = "tick_8_motors",
+    [BENCH_REPLAY_8]        = "replay_8_frames",
+    [BENCH_IF_SWITCH]       = "motor_if_switch",
+    [BENCH_IF_OPS]          = "motor_if_ops",
+    [BENCH_PID_12]          = "pid_12",
+    [BENCH_PID_BATCH_12]    = "pid_batch_12",
+    [BENCH_OBSERVER]        = "observer_update",
+    [BENCH_DJI_OBSERVED]    = "dji_decode_observer",
+};
+
+/**
+ * 测量结果，可直接在调试器中查看
+ */
+PerfCounter_t bench_counters[BENCH_COUNT];
+
+/**
+ * CSV 格式的测量结果
+ */
+char bench_report[1152];
+
+/**
+ * MotorPID_CalculateBatch 与逐个 MotorPID_Calculate 输出不逐位一致的次数，应为 0
+ */
+uint32_t bench_pid_mismatch;
+
+static DJI_t              dji[BENCH_DJI_NUM];
+static Motor_PosCtrl_t    pos_dji[BENCH_DJI_NUM];
+static DM_t               dm;
+static VESC_t             vesc;
+static MotorPID_t         pid;
+static MotorPID_t         pids[BENCH_PID_NUM];
+static MotorPID_Bank_t    pid_bank;
+static DJI_t              dji_observed; ///< 挂接了速度观测器，与 dji 对比
+static VelocityObserver_t dji_observer;
+static VelocityObserver_t observer;
+
+static CAN_TraceRecord_t trace[BENCH_DJI_NUM];
+
+static volatile float bench_sink; ///< 防止被测表达式被优化掉
+
+/**
+ * 生成第 i 次测量使用的反馈数据，角度和转速随 i 变化以覆盖过圈等分支
+ */
+static void bench_feedback(const uint32_t i, uint8_t data[8])
+{
+    const uint16_t angle = (uint16_t) (i * 97U & 0x1FFF);
+    const int16_t  rpm   = (int16_t) ((int32_t) (i % 2000U) - 1000);
+    data[0]              = angle >> 8;
+    data[1]              = angle & 0xFF;
+    data[2]              = (uint16_t) rpm >> 8;
+    data[3]              = (uint16_t) rpm & 0xFF;
+    data[4]              = 0;
+    data[5]              = (uint8_t) i;
+    data[6]              = (uint8_t) (i >> 8);
+    data[7]              = (uint8_t) i;
+}
+
+static void bench_motor_init(void)
+{
+    for (uint8_t i = 0; i < BENCH_DJI_NUM; i++)
+    {
+        DJI_Init(&dji[i],
+                 &(DJI_Config_t) {
+                         .auto_zero  = false,
+                         .motor_type = M3508_C620,
+                         .hcan       = &hcan1,
+                         .id1        = i + 1,
+                 });
+        Motor_PosCtrl_Init(&pos_dji[i],
+                           &(Motor_PosCtrlConfig_t) {
+                                   .motor_type         = MOTOR_TYPE_DJI,
+                                   .motor              = &dji[i],
+                                   .velocity_pid       = { .Kp             = 12.0f,
+                                                           .Ki             = 0.20f,
+                                                           .Kd             = 5.00f,
+                                                           .abs_output_max = 16384.0f },
+                                   .position_pid       = { .Kp             = 80.0f,
+                                                           .Ki             = 1.00f,
+                                                           .Kd             = 0.00f,
+                                                           .abs_output_max = 2000.0f },
+                                   .pos_vel_freq_ratio = 1,
+                           });
+        Motor_PosCtrl_SetRef(&pos_dji[i], 360.0f);
+    }
+
+    DM_Init(&dm,
+            &(DM_Config_t) { .hcan        = &hcan2,
+                             .id0         = 0,
+                             .POS_MAX_RAD = 3.1416f,
+                             .VEL_MAX_RAD = 40,
+                             .T_MAX       = 10,
+                             .mode        = DM_MODE_VEL,
+                             .motor_type  = DM_S3519 });
+
+    VESC_Init(&vesc, &(VESC_Config_t) { .hcan = &hcan2, .id = 15, .electrodes = 14 });
+
+    MotorPID_Init(&pid,
+                  (MotorPID_Config_t) {
+                          .Kp = 12.0f, .Ki = 0.20f, .Kd = 5.00f, .abs_output_max = 16384.0f });
+
+    MotorPID_BankInit(&pid_bank);
+    for (uint32_t k = 0; k < BENCH_PID_NUM; k++)
+    {
+        const MotorPID_Config_t config = { .Kp             = 12.0f + (float) k,
+                                           .Ki             = 0.20f,
+                                           .Kd             = 5.00f,
+                                           .abs_output_max = 16384.0f };
+        MotorPID_Init(&pids[k], config);
+        MotorPID_BankAdd(&pid_bank, config);
+    }
+
+    // 观测器的耗时与参数无关，取 M3508 的典型值
+    const VelocityObserver_Config_t observer_config = {
+        .accel_noise    = 3000.0f,
+        .velocity_noise = 0.1f,
+        .command_gain   = 0.5f,
+    };
+    VelocityObserver_Init(&observer, &observer_config, 1.0f / DJI_FEEDBACK_HZ, 360.0f / 8192.0f);
+    DJI_Init(&dji_observed,
+             &(DJI_Config_t) {
+                     .auto_zero  = false,
+                     .motor_type = M3508_C620,
+                     .hcan       = &hcan2,
+                     .id1        = 1,
+             });
+    DJI_AttachObserver(&dji_observed, &dji_observer, &observer_config);
+}
+
+/**
+ * 运行全部测量
+ *
+ * @attention 本例与其他 *_example.c 一样独立使用：会初始化 hcan1 上 8 个大疆电机，
+ *            hcan2 上 1 个大疆电机（ID 1，挂接速度观测器）、1 个达妙和 1 个 VESC，
+ *            请不要与实际控制程序同时运行。
+ *            发送环节测量的是入队开销，请接上总线或将 CAN 配置为回环模式，否则发送队列满后
+ *            测得的是丢弃路径
+ * @note 测量期间不关中断，被打断的测量会体现在 cycles_max 中，回归对比请以 cycles_min
+ *       和 cycles_avg 为准
+ */
+void Bench_Run(void)
+{
+    uint8_t data[8];
+
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    CAN_Start(&hcan2, CAN_IT_RX_FIFO0_MSG_PENDING);
+    bench_motor_init();
+
+    PerfCounter_Init();
+    for (uint32_t k = 0; k < BENCH_COUNT; k++)
+        PerfCounter_Reset(&bench_counters[k], bench_names[k]);
+    bench_pid_mismatch = 0;
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        bench_feedback(i, data);
+
+        PERF_MEASURE(&bench_counters[BENCH_DJI_DECODE],
+                     DJI_DataDecode(&dji[i % BENCH_DJI_NUM], data));
+        PERF_MEASURE(&bench_counters[BENCH_DM_DECODE], DM_DataDecode(&dm, data));
+        PERF_MEASURE(&bench_counters[BENCH_VESC_DECODE],
+                     VESC_CAN_DataDecode(&vesc, VESC_CAN_STATUS_4, data));
+
+        pid.ref = 1000.0f;
+        pid.fdb = (float) (i % 2000U);
+        PERF_MEASURE(&bench_counters[BENCH_PID_CALCULATE], MotorPID_Calculate(&pid));
+
+        PERF_MEASURE(&bench_counters[BENCH_POS_CTRL_UPDATE],
+                     Motor_PosCtrlUpdate(&pos_dji[i % BENCH_DJI_NUM]));
+        PERF_MEASURE(&bench_counters[BENCH_DJI_SEND],
+                     DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_1_4));
+
+        const uint32_t start = PerfCounter_Now();
+        for (uint32_t m = 0; m < BENCH_DJI_NUM; m++)
+            Motor_PosCtrlUpdate(&pos_dji[m]);
+        DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_1_4);
+        DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_5_8);
+        PerfCounter_Record(&bench_counters[BENCH_TICK_8_MOTORS], PerfCounter_Now() - start);
+
+        // 与现场记录回放相同的路径，帧率 = 8 * SystemCoreClock / cycles
+        for (uint8_t m = 0; m < BENCH_DJI_NUM; m++)
+        {
+            trace[m] = (CAN_TraceRecord_t) { .id = 0x201U + m, .bus = 0, .dlc = 8 };
+            bench_feedback(i + m, trace[m].data);
+        }
+        PERF_MEASURE(&bench_counters[BENCH_REPLAY_8],
+                     CAN_Trace_Replay((CAN_HandleTypeDef* const[CAN_NUM]) { &hcan1, &hcan2 },
+                                      trace,
+                                      BENCH_DJI_NUM,
+                                      false));
+
+        // 旧的 switch 分发与操作表分发对比，两者读取同一个电机
+        const Motor_PosCtrl_t* ctrl = &pos_dji[i % BENCH_DJI_NUM];
+        PERF_MEASURE(&bench_counters[BENCH_IF_SWITCH],
+                     bench_sink = Motor_GetAngle(ctrl->motor_type, ctrl->motor) +
+                                  Motor_GetVelocity(ctrl->motor_type, ctrl->motor));
+        PERF_MEASURE(&bench_counters[BENCH_IF_OPS],
+                     bench_sink = MotorCtrl_GetAngle(ctrl) + MotorCtrl_GetVelocity(ctrl));
+
+        // 相同的参数和输入，两者的输出应逐位一致，不一致计入 bench_pid_mismatch
+        for (uint32_t k = 0; k < BENCH_PID_NUM; k++)
+        {
+            pids[k].ref = pid_bank.ref[k] = 1000.0f;
+            pids[k].fdb = pid_bank.fdb[k] = (float) ((i + k * 97U) % 2000U);
+        }
+        const uint32_t pid_start = PerfCounter_Now();
+        for (uint32_t k = 0; k < BENCH_PID_NUM; k++)
+            MotorPID_Calculate(&pids[k]);
+        PerfCounter_Record(&bench_counters[BENCH_PID_12], PerfCounter_Now() - pid_start);
+        PERF_MEASURE(&bench_counters[BENCH_PID_BATCH_12], MotorPID_CalculateBatch(&pid_bank));
+        for (uint32_t k = 0; k < BENCH_PID_NUM; k++)
+            if (memcmp(&pids[k].output, &pid_bank.output[k], sizeof(float)) != 0)
+                bench_pid_mismatch++;
+
+        // 与 dji_decode 对比即为解包中观测器的额外开销
+        PERF_MEASURE(&bench_counters[BENCH_OBSERVER],
+                     VelocityObserver_Update(&observer,
+                                             (int32_t) (i % 64U) - 32,
+                                             (float) (i % 2000U) - 1000.0f,
+                                             (float) (i % 128U)));
+        PERF_MEASURE(&bench_counters[BENCH_DJI_OBSERVED], DJI_DataDecode(&dji_observed, data));
+    }
+
+    PerfCounter_FormatCsv(bench_counters, BENCH_COUNT, bench_report, sizeof(bench_report));
+}
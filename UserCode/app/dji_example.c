@@ -163,6 +163,8 @@ void DJI_Control_Init()
                             },
                     .pos_vel_freq_ratio = 1, //<
                                              // 内外环频率比（外环的频率可能需要比内环低）
+                    .fixed_point        = false, //< 为 true 时使用定点控制，控制中断不使用
+                                                 // FPU，PID 参数不变
             });
 
     /**
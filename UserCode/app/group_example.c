@@ -0,0 +1,185 @@
+/**
+ * @file    group_example.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   an example driving several motors through one control group
+ *
+ * hcan1 上 4 个大疆电机（ID 1、2、5、6），hcan2 上 1 个达妙和 1 个 VESC，
+ * 每个控制周期只调用一次 MotorCtrlGroup_Tick：hcan1 上发出 0x200 和 0x1FF 两帧，
+ * hcan2 上发出达妙和 VESC 各一帧，同一总线上的帧连续发出
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+
+#include "bsp/can_driver.h"
+#include "can.h"
+#include "interfaces/motor_group.h"
+#include "interfaces/motor_watchdog.h"
+#include "tim.h"
+
+#define GROUP_DJI_NUM (4)
+
+static const uint8_t group_dji_ids[GROUP_DJI_NUM] = { 1, 2, 5, 6 };
+
+DJI_t  group_dji[GROUP_DJI_NUM];
+DM_t   group_dm;
+VESC_t group_vesc;
+
+/**
+ * 控制组，控制器保存在组内，通过下面的指针访问
+ */
+MotorCtrlGroup_t motor_group;
+
+Motor_PosCtrl_t* group_pos_dji[GROUP_DJI_NUM];
+Motor_VelCtrl_t* group_vel_dm;
+Motor_VelCtrl_t* group_vel_vesc;
+
+/**
+ * 反馈超时看门狗，掉线的电机冻结 PID 并输出 0
+ */
+MotorWatchdog_t group_watchdog;
+MotorWatch_t    group_watch[GROUP_DJI_NUM + 2];
+
+/**
+ * 1kHz 定时器回调，一次调用完成全部电机的计算和发送
+ * @param htim unused
+ */
+static void Group_TIM_Callback(TIM_HandleTypeDef* htim)
+{
+    MotorWatchdog_Tick(&group_watchdog);
+    MotorCtrlGroup_Tick(&motor_group);
+}
+
+/**
+ * CAN 接收回调，分发反馈后检查是否有总线的反馈已经到齐
+ * @attention CAN 接收中断和定时器中断须设为相同的抢占优先级
+ * @param hcan can handle
+ */
+static void Group_CAN_Fifo0Callback(CAN_HandleTypeDef* hcan)
+{
+    CAN_Fifo0ReceiveCallback(hcan);
+    MotorCtrlGroup_Poll(&motor_group);
+}
+
+void Group_Control_Init(void)
+{
+    /**
+     * Step0: 启动 CAN
+     *
+     * 使用路由表分发反馈：在回调中调用 bsp 的 CAN_Fifo0ReceiveCallback，
+     * 各驱动在 *_Init 时注册反馈 ID，最后由 CAN_ConfigFilters 自动配置过滤器
+     */
+    HAL_CAN_RegisterCallback(&hcan1, HAL_CAN_RX_FIFO0_MSG_PENDING_CB_ID, Group_CAN_Fifo0Callback);
+    HAL_CAN_RegisterCallback(&hcan2, HAL_CAN_RX_FIFO0_MSG_PENDING_CB_ID, Group_CAN_Fifo0Callback);
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    CAN_Start(&hcan2, CAN_IT_RX_FIFO0_MSG_PENDING);
+
+    /**
+     * Step1: 初始化电机
+     */
+    for (uint8_t i = 0; i < GROUP_DJI_NUM; i++)
+    {
+        DJI_Init(&group_dji[i],
+                 &(DJI_Config_t) {
+                         .auto_zero  = false,
+                         .motor_type = M3508_C620,
+                         .hcan       = &hcan1,
+                         .id1        = group_dji_ids[i],
+                 });
+    }
+    DM_Init(&group_dm,
+            &(DM_Config_t) { .hcan        = &hcan2,
+                             .id0         = 0,
+                             .POS_MAX_RAD = 3.1416f,
+                             .VEL_MAX_RAD = 40,
+                             .T_MAX       = 10,
+                             .mode        = DM_MODE_VEL,
+                             .motor_type  = DM_S3519 });
+    VESC_Init(&group_vesc, &(VESC_Config_t) { .hcan = &hcan2, .id = 15, .electrodes = 14 });
+    CAN_ConfigFilters(CAN_FILTER_FIFO0);
+
+    /**
+     * Step2: 将控制器加入控制组
+     *
+     * 最后一个参数为分频：达妙和 VESC 的内部速度环指令 200Hz 发送一次即可
+     */
+    MotorCtrlGroup_Init(&motor_group, 1000);
+    for (uint8_t i = 0; i < GROUP_DJI_NUM; i++)
+    {
+        group_pos_dji[i] = MotorCtrlGroup_AddPos(
+                &motor_group,
+                &(Motor_PosCtrlConfig_t) {
+                        .motor_type         = MOTOR_TYPE_DJI,
+                        .motor              = &group_dji[i],
+                        .velocity_pid       = { .Kp             = 12.0f,
+                                                .Ki             = 0.20f,
+                                                .Kd             = 5.00f,
+                                                .abs_output_max = DJI_M3508_C620_IQ_MAX },
+                        .position_pid       = { .Kp             = 80.0f,
+                                                .Ki             = 1.00f,
+                                                .Kd             = 0.00f,
+                                                .abs_output_max = 2000.0f },
+                        .pos_vel_freq_ratio = 1,
+                },
+                1);
+    }
+    group_vel_dm   = MotorCtrlGroup_AddVel(&motor_group,
+                                         &(Motor_VelCtrlConfig_t) {
+                                                 .motor_type = MOTOR_TYPE_DM,
+                                                 .motor      = &group_dm,
+                                         },
+                                         5);
+    group_vel_vesc = MotorCtrlGroup_AddVel(&motor_group,
+                                           &(Motor_VelCtrlConfig_t) {
+                                                   .motor_type = MOTOR_TYPE_VESC,
+                                                   .motor      = &group_vesc,
+                                           },
+                                           5);
+
+    /**
+     * Step3: 监视反馈
+     *
+     * 达妙只在收到指令后回复，指令不变时最多 DM_CMD_KEEPALIVE_MS 才重发一次，超时设长一些
+     */
+    MotorWatchdog_Init(&group_watchdog);
+    for (uint8_t i = 0; i < GROUP_DJI_NUM; i++)
+        MotorWatchdog_AddPos(&group_watchdog, &group_watch[i], group_pos_dji[i], 20);
+    MotorWatchdog_AddVel(&group_watchdog, &group_watch[GROUP_DJI_NUM], group_vel_dm, 250);
+    MotorWatchdog_AddVel(&group_watchdog, &group_watch[GROUP_DJI_NUM + 1], group_vel_vesc, 100);
+
+    /**
+     * Step4: 启用事件驱动并设置目标值
+     *
+     * hcan1 上 4 个大疆电机的反馈到齐后立即更新并发出指令，定时器作为兜底；
+     * hcan2 上达妙只在收到指令后回复，通常由定时器更新
+     *
+     * motor_group.monitor 记录每次 Tick 的执行时间、周期抖动、超时次数和各阶段耗时，
+     * motor_group.event_monitor 记录事件触发的更新的执行时间和各阶段耗时，
+     * 可以在调试器中查看，或用 LoopMonitor_FormatCsv 输出
+     */
+    MotorCtrlGroup_SetEventDriven(&motor_group, true);
+    for (uint8_t i = 0; i < GROUP_DJI_NUM; i++)
+        Motor_PosCtrl_SetRef(group_pos_dji[i], 360.0f);
+    Motor_VelCtrl_SetRef(group_vel_dm, 60.0f);
+    Motor_VelCtrl_SetRef(group_vel_vesc, 1000.0f);
+
+    /**
+     * Step5: 注册定时器回调并开启定时器
+     */
+    HAL_TIM_RegisterCallback(&htim6, HAL_TIM_PERIOD_ELAPSED_CB_ID, Group_TIM_Callback);
+    HAL_TIM_Base_Start_IT(&htim6);
+}
@@ -0,0 +1,415 @@
+/**
+ * @file    sim_example.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   an example tuning a position loop against the motor simulator
+ *
+ * 在虚拟总线上仿真一个 M3508，对位置环做阶跃响应并计算上升时间、超调量和调节时间，
+ * 仿真时钟与实际时间无关，2 秒的闭环响应在 MCU 上也只需要几十毫秒。
+ * Sim_FixedPointCompare 用同一组参数分别以浮点和定点控制两个电机，验证定点控制与浮点控制一致。
+ * Sim_TurnUnwrap 在高转速、低反馈频率和丢帧下检查 DJI 和 VESC 的多圈位置没有丢圈。
+ * 需要在 bsp/can_driver.h 中定义 USE_CAN_SIM
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include "bsp/can_driver.h"
+#include "can.h"
+#include "drivers/DJI.h"
+#include "drivers/motor_sim.h"
+#include "drivers/vesc.h"
+#include "interfaces/motor_if.h"
+
+#ifdef USE_CAN_SIM
+
+#define SIM_DT          (0.001f) ///< 仿真步长，与实际控制周期一致 (unit: s)
+#define SIM_STEPS       (2000)   ///< 仿真步数
+#define SIM_STEP_REF    (90.0f)  ///< 阶跃目标 (unit: deg)
+#define SIM_SETTLE_BAND (0.02f)  ///< 调节时间的误差带（相对阶跃幅值）
+
+#define SIM_UNWRAP_STEPS   (3000)  ///< 多圈位置仿真的步数，前一半正转加速，后一半反向制动并反转
+#define SIM_UNWRAP_DIVIDER (20U)   ///< 反馈间隔 (unit: 仿真步)，即 50Hz
+#define SIM_UNWRAP_HZ      (50U)   ///< 反馈频率，与 SIM_DT 和 SIM_UNWRAP_DIVIDER 对应 (unit: Hz)
+#define SIM_UNWRAP_DROP    (0.25f) ///< 每帧反馈丢失的概率
+
+/**
+ * 阶跃响应指标
+ */
+typedef struct
+{
+    float rise_time;    ///< 10% -> 90% 上升时间 (unit: s)
+    float overshoot;    ///< 超调量（相对阶跃幅值）
+    float settle_time;  ///< 进入并保持在误差带内的时间 (unit: s)
+    float steady_error; ///< 仿真结束时的误差 (unit: deg)
+} Sim_StepResponse_t;
+
+/**
+ * 定点控制与浮点控制的对比结果
+ */
+typedef struct
+{
+    Sim_StepResponse_t float_response;  ///< 浮点控制的阶跃响应
+    Sim_StepResponse_t fixed_response;  ///< 定点控制的阶跃响应
+    float              max_angle_error; ///< 两者角度之差的最大值 (unit: deg)
+    int32_t            max_iq_error;    ///< 两者电流指令之差的最大值
+} Sim_FixedPointCompare_t;
+
+/**
+ * 多圈位置的检查结果
+ */
+typedef struct
+{
+    float    dji_max_error;  ///< DJI 转子多圈位置与模型之差的最大值 (unit: 刻度)
+    float    dji_max_turns;  ///< DJI 相邻两次收到位置之间转子转过圈数的最大值
+    uint32_t dji_dropped;    ///< DJI 丢失的反馈帧数
+    float    vesc_max_error; ///< VESC 多圈位置与模型之差的最大值 (unit: 刻度)
+    float    vesc_max_turns; ///< VESC 相邻两次收到位置之间转过圈数的最大值
+    uint32_t vesc_dropped;   ///< VESC 丢失的反馈帧数
+    bool     passed;         ///< 误差都小于 1 个刻度，且两帧之间都转过了 1 圈以上
+} Sim_TurnUnwrap_t;
+
+/**
+ * 阶跃响应的跟踪量
+ */
+typedef struct
+{
+    float t10, t90, peak, settle;
+} Sim_StepTrack_t;
+
+DJI_t              dji;
+Motor_PosCtrl_t    pos_dji;
+MotorSim_t         sim_dji;
+Sim_StepResponse_t step_response;
+
+DJI_t                   dji_cmp[2];
+Motor_PosCtrl_t         pos_cmp[2];
+MotorSim_t              sim_cmp[2];
+Sim_FixedPointCompare_t fixed_point_compare;
+
+DJI_t            dji_unwrap;
+VESC_t           vesc_unwrap;
+MotorSim_t       sim_unwrap[2];
+Sim_TurnUnwrap_t turn_unwrap;
+
+static const MotorPID_Config_t sim_velocity_pid = {
+    .Kp = 12.0f, .Ki = 0.20f, .Kd = 5.00f, .abs_output_max = 16384.0f
+};
+static const MotorPID_Config_t sim_position_pid = {
+    .Kp = 80.0f, .Ki = 1.00f, .Kd = 0.00f, .abs_output_max = 2000.0f
+};
+
+static void sim_track_init(Sim_StepTrack_t* track)
+{
+    *track = (Sim_StepTrack_t) { .t10 = -1, .t90 = -1, .peak = 0, .settle = 0 };
+}
+
+/**
+ * 记录一步的角度
+ */
+static void sim_track_update(Sim_StepTrack_t* track, const float t, const float angle)
+{
+    if (track->t10 < 0 && angle >= 0.1f * SIM_STEP_REF)
+        track->t10 = t;
+    if (track->t90 < 0 && angle >= 0.9f * SIM_STEP_REF)
+        track->t90 = t;
+    if (angle > track->peak)
+        track->peak = angle;
+    if (fabsf(angle - SIM_STEP_REF) > SIM_SETTLE_BAND * SIM_STEP_REF)
+        track->settle = t;
+}
+
+/**
+ * 由跟踪量计算阶跃响应指标
+ */
+static void sim_track_finish(const Sim_StepTrack_t* track,
+                             const float            final_angle,
+                             Sim_StepResponse_t*    response)
+{
+    response->rise_time = track->t10 >= 0 && track->t90 >= 0 ? track->t90 - track->t10 : -1.0f;
+    response->overshoot =
+            track->peak > SIM_STEP_REF ? (track->peak - SIM_STEP_REF) / SIM_STEP_REF : 0.0f;
+    response->settle_time  = track->settle;
+    response->steady_error = SIM_STEP_REF - final_angle;
+}
+
+/**
+ * 对位置环做一次阶跃响应仿真，结果写入 step_response
+ */
+void Sim_StepResponse(void)
+{
+    /**
+     * Step0: 启动（虚拟）CAN，仿真模式下不会访问硬件
+     */
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+
+    /**
+     * Step1: 与实际程序完全相同地初始化电机和控制实例
+     */
+    DJI_Init(&dji,
+             &(DJI_Config_t) {
+                     .auto_zero  = false,
+                     .motor_type = M3508_C620,
+                     .hcan       = &hcan1,
+                     .id1        = 1,
+             });
+    Motor_PosCtrl_Init(&pos_dji,
+                       &(Motor_PosCtrlConfig_t) {
+                               .motor_type         = MOTOR_TYPE_DJI,
+                               .motor              = &dji,
+                               .velocity_pid       = sim_velocity_pid,
+                               .position_pid       = sim_position_pid,
+                               .pos_vel_freq_ratio = 1,
+                       });
+
+    /**
+     * Step2: 创建仿真电机，挂在同一条总线上，ID 与电调一致
+     *
+     * 负载可以通过 __MOTOR_SIM_SET_LOAD 设置
+     */
+    MotorSim_Init(&sim_dji,
+                  &(MotorSim_Config_t) {
+                          .type = MOTOR_SIM_M3508_C620,
+                          .hcan = &hcan1,
+                          .id   = 1,
+                  });
+
+    /**
+     * Step3: 闭环仿真
+     *
+     * 每一步：推进模型（反馈帧同步分发给驱动） -> 控制更新 -> 发送指令（同步交给仿真电机）
+     */
+    Motor_PosCtrl_SetRef(&pos_dji, SIM_STEP_REF);
+
+    Sim_StepTrack_t track;
+    sim_track_init(&track);
+    for (uint32_t i = 0; i < SIM_STEPS; i++)
+    {
+        MotorSim_Step(SIM_DT);
+        Motor_PosCtrlUpdate(&pos_dji);
+        DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_1_4);
+
+        sim_track_update(&track, (float) (i + 1) * SIM_DT, __DJI_GET_ANGLE(&dji));
+    }
+    sim_track_finish(&track, __DJI_GET_ANGLE(&dji), &step_response);
+}
+
+/**
+ * 用同一组参数分别以浮点和定点控制两个电机，比较阶跃响应，结果写入 fixed_point_compare
+ *
+ * 两个电机的 ID 为 2 和 3，可以与 Sim_StepResponse 在同一次运行中使用
+ */
+void Sim_FixedPointCompare(void)
+{
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+
+    /**
+     * Step1: 两个电机只有 fixed_point 不同
+     */
+    for (uint8_t k = 0; k < 2; k++)
+    {
+        DJI_Init(&dji_cmp[k],
+                 &(DJI_Config_t) {
+                         .auto_zero  = false,
+                         .motor_type = M3508_C620,
+                         .hcan       = &hcan1,
+                         .id1        = 2 + k,
+                 });
+        Motor_PosCtrl_Init(&pos_cmp[k],
+                           &(Motor_PosCtrlConfig_t) {
+                                   .motor_type         = MOTOR_TYPE_DJI,
+                                   .motor              = &dji_cmp[k],
+                                   .velocity_pid       = sim_velocity_pid,
+                                   .position_pid       = sim_position_pid,
+                                   .pos_vel_freq_ratio = 1,
+                                   .fixed_point        = k == 1,
+                           });
+        MotorSim_Init(&sim_cmp[k],
+                      &(MotorSim_Config_t) {
+                              .type = MOTOR_SIM_M3508_C620,
+                              .hcan = &hcan1,
+                              .id   = 2 + k,
+                      });
+        Motor_PosCtrl_SetRef(&pos_cmp[k], SIM_STEP_REF);
+    }
+
+    /**
+     * Step2: 闭环仿真，逐步比较角度和电流指令
+     */
+    Sim_StepTrack_t track[2];
+    sim_track_init(&track[0]);
+    sim_track_init(&track[1]);
+    fixed_point_compare.max_angle_error = 0;
+    fixed_point_compare.max_iq_error    = 0;
+    for (uint32_t i = 0; i < SIM_STEPS; i++)
+    {
+        MotorSim_Step(SIM_DT);
+        Motor_PosCtrlUpdate(&pos_cmp[0]);
+        Motor_PosCtrlUpdate(&pos_cmp[1]);
+        DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_1_4);
+
+        const float t = (float) (i + 1) * SIM_DT;
+        sim_track_update(&track[0], t, __DJI_GET_ANGLE(&dji_cmp[0]));
+        sim_track_update(&track[1], t, __DJI_GET_ANGLE(&dji_cmp[1]));
+
+        const float angle_error =
+                fabsf(__DJI_GET_ANGLE(&dji_cmp[0]) - __DJI_GET_ANGLE(&dji_cmp[1]));
+        const int32_t iq_error = abs((int16_t) dji_cmp[0].iq_cmd - (int16_t) dji_cmp[1].iq_cmd);
+        if (angle_error > fixed_point_compare.max_angle_error)
+            fixed_point_compare.max_angle_error = angle_error;
+        if (iq_error > fixed_point_compare.max_iq_error)
+            fixed_point_compare.max_iq_error = iq_error;
+    }
+    sim_track_finish(&track[0],
+                     __DJI_GET_ANGLE(&dji_cmp[0]),
+                     &fixed_point_compare.float_response);
+    sim_track_finish(&track[1],
+                     __DJI_GET_ANGLE(&dji_cmp[1]),
+                     &fixed_point_compare.fixed_response);
+}
+
+/**
+ * 模型的转子多圈角度 (unit: deg)
+ */
+static double sim_rotor_angle(const MotorSim_t* hsim)
+{
+    return ((double) hsim->plant.turns + hsim->plant.angle / MOTOR_PLANT_2PI) * 360.0;
+}
+
+/**
+ * 收到一帧新的位置反馈时，比较驱动的多圈位置与模型，记录误差和两帧之间转过的圈数
+ *
+ * 以刻度比较，不经过浮点角度，误差只剩编码器的量化误差：大疆截断，小于 1 个刻度；VESC 舍入
+ * @param ticks 驱动的多圈位置 (unit: 刻度)
+ * @param expected 模型的多圈位置 (unit: 刻度)
+ * @param last 上一帧的模型位置，更新为本帧
+ * @param ticks_per_round 一圈的刻度数
+ * @param max_error 误差的最大值
+ * @param max_turns 两帧之间转过圈数的最大值
+ */
+static void sim_unwrap_check(const int64_t ticks,
+                             const double  expected,
+                             double*       last,
+                             const double  ticks_per_round,
+                             float*        max_error,
+                             float*        max_turns)
+{
+    const float error = (float) fabs((double) ticks - expected);
+    const float turns = (float) (fabs(expected - *last) / ticks_per_round);
+    if (error > *max_error)
+        *max_error = error;
+    if (turns > *max_turns)
+        *max_turns = turns;
+    *last = expected;
+}
+
+/**
+ * 高转速下以 50Hz 反馈并随机丢帧，检查多圈位置，结果写入 turn_unwrap
+ *
+ * DJI (ID 5) 以最大电流开环加速到空载转速，再反向制动并反转；VESC 以占空比同样运行。
+ * 两帧之间转子转过数圈，单圈值之差已经无法分辨转过的圈数，
+ * 驱动按转速和帧间隔预测转动量，多圈位置应当与模型只差编码器的量化误差。
+ * 反馈频率需要在配置中写明，帧间隔超过数个反馈周期时驱动不再信任转速预测
+ */
+void Sim_TurnUnwrap(void)
+{
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    // 帧的接收时间跟随仿真时钟，驱动才能得到真实的帧间隔
+    MotorSim_DriveCycleCounter(true);
+
+    DJI_Init(&dji_unwrap,
+             &(DJI_Config_t) {
+                     .auto_zero   = false,
+                     .motor_type  = M3508_C620,
+                     .hcan        = &hcan1,
+                     .id1         = 5,
+                     .feedback_hz = SIM_UNWRAP_HZ,
+             });
+    VESC_Init(&vesc_unwrap,
+              &(VESC_Config_t) {
+                      .hcan = &hcan1, .id = 1, .electrodes = 7, .status_hz = SIM_UNWRAP_HZ });
+    MotorSim_Init(&sim_unwrap[0],
+                  &(MotorSim_Config_t) {
+                          .type             = MOTOR_SIM_M3508_C620,
+                          .hcan             = &hcan1,
+                          .id               = 5,
+                          .feedback_divider = SIM_UNWRAP_DIVIDER,
+                          .drop_rate        = SIM_UNWRAP_DROP,
+                  });
+    MotorSim_Init(&sim_unwrap[1],
+                  &(MotorSim_Config_t) {
+                          .type             = MOTOR_SIM_VESC,
+                          .hcan             = &hcan1,
+                          .id               = 1,
+                          .electrodes       = 7,
+                          .feedback_divider = SIM_UNWRAP_DIVIDER,
+                          .drop_rate        = SIM_UNWRAP_DROP,
+                  });
+
+    /**
+     * 驱动以收到的第一帧为起点，模型从 0 开始，收到第一帧之前电机保持静止；
+     * 每收到一帧位置反馈，比较驱动的角度与同一时刻的模型
+     */
+    turn_unwrap = (Sim_TurnUnwrap_t) { 0 };
+
+    double   dji_last   = 0;
+    double   vesc_last  = 0;
+    uint32_t dji_count  = 0;
+    int64_t  vesc_ticks = 0;
+    for (uint32_t i = 0; i < SIM_UNWRAP_STEPS; i++)
+    {
+        const bool forward = i < SIM_UNWRAP_STEPS / 2;
+        if (dji_unwrap.feedback_count > 0)
+            __DJI_SET_IQ_CMD(&dji_unwrap,
+                             forward ? DJI_M3508_C620_IQ_MAX : -DJI_M3508_C620_IQ_MAX);
+        if (vesc_unwrap.turns.started)
+            VESC_SendSetCmd(&vesc_unwrap, VESC_CAN_SET_DUTY, forward ? 0.9f : -0.9f);
+        DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_5_8);
+        MotorSim_Step(SIM_DT);
+
+        if (dji_unwrap.feedback_count != dji_count)
+        {
+            dji_count = dji_unwrap.feedback_count;
+            sim_unwrap_check(DJI_GetTicks(&dji_unwrap),
+                             sim_rotor_angle(&sim_unwrap[0]) / 360.0 * DJI_TICKS_PER_ROUND,
+                             &dji_last,
+                             DJI_TICKS_PER_ROUND,
+                             &turn_unwrap.dji_max_error,
+                             &turn_unwrap.dji_max_turns);
+        }
+        // VESC 的 5 种状态帧分别丢失，以多圈位置的变化判断是否收到了 STATUS_4
+        if (vesc_unwrap.turns.ticks != vesc_ticks)
+        {
+            vesc_ticks = vesc_unwrap.turns.ticks;
+            sim_unwrap_check(VESC_GetTicks(&vesc_unwrap),
+                             sim_rotor_angle(&sim_unwrap[1]) * VESC_TICKS_PER_DEGREE,
+                             &vesc_last,
+                             VESC_TICKS_PER_ROUND,
+                             &turn_unwrap.vesc_max_error,
+                             &turn_unwrap.vesc_max_turns);
+        }
+    }
+    turn_unwrap.dji_dropped  = sim_unwrap[0].dropped;
+    turn_unwrap.vesc_dropped = sim_unwrap[1].dropped;
+
+    turn_unwrap.passed = turn_unwrap.dji_max_error < 1.0f && turn_unwrap.vesc_max_error < 1.0f &&
+                         turn_unwrap.dji_max_turns > 1.0f && turn_unwrap.vesc_max_turns > 1.0f;
+    MotorSim_DriveCycleCounter(false);
+}
+
+#endif // USE_CAN_SIM
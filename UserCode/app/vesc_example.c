@@ -91,11 +91,9 @@ void VESC_Control_Init()
      * Step2: 启动 CAN
      *
      * CAN 必须在注册回调后再启用，否则回调无法正常注册，同样地，我们也只使用 Fifo0
-     * @note: 如果同时启用 DJI 和
-     VESC，你需要另定义一个回调处理函数，手动获取数据并手动调用以下两个函数 void
-     VESC_CAN_BaseReceiveCallback(CAN_HandleTypeDef* hcan, CAN_RxHeaderTypeDef* header, uint8_t
-     data[]) void DJI_CAN_BaseReceiveCallback(CAN_HandleTypeDef* hcan, CAN_RxHeaderTypeDef* header,
-     uint8_t data[])
+     * @note: 如果同时启用 DJI、DM 和 VESC，请改为注册 bsp/can_driver.h 中的
+     *        CAN_Fifo0ReceiveCallback，各驱动在 *_Init 时已向 CAN 路由表注册了反馈帧 ID，
+     *        同一个 FIFO 回调即可按 ID 分发到对应电机
      */
     CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
 
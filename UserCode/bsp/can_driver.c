@@ -21,188 +21,1799 @@
  * Project repository: https://github.com/HITSZ-WTR2026/bsp_drivers
  */
 #include "can_driver.h"
+#include <string.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#ifdef USE_RTOS
-#include "cmsis_os2.h"
-static osMutexId_t can_mutex = NULL;
-static osMutexId_t get_can_mutex()
+#include <stdatomic.h>
+
+#ifdef USE_CAN_DEFERRED_RX
+#    include "cmsis_os2.h"
+#endif
+
+_Static_assert((CAN_TX_QUEUE_SIZE & (CAN_TX_QUEUE_SIZE - 1)) == 0,
+               "CAN_TX_QUEUE_SIZE must be a power of 2");
+_Static_assert((CAN_ROUTER_SIZE & (CAN_ROUTER_SIZE - 1)) == 0,
+               "CAN_ROUTER_SIZE must be a power of 2");
+_Static_assert((CAN_RX_QUEUE_SIZE & (CAN_RX_QUEUE_SIZE - 1)) == 0,
+               "CAN_RX_QUEUE_SIZE must be a power of 2");
+
+#define CAN_ROUTE_KEY_EXT (0x80000000U) ///< 扩展帧标志，ExtId 只有 29 位
+
+/**
+ * 路由表项
+ */
+typedef struct
+{
+    uint32_t           key;     ///< id | CAN_ROUTE_KEY_EXT
+    CAN_FrameDecoder_t decoder; ///< NULL 表示空槽
+    void*              handle;
+} CAN_Route_t;
+
+/**
+ * 开放寻址（线性探测）路由表
+ *
+ * 注册时记录最长探测距离，查询最多探测 max_probe + 1 次，与注册的 ID 数量无关
+ */
+typedef struct
+{
+    CAN_Route_t routes[CAN_ROUTER_SIZE];
+    uint32_t    count;
+    uint32_t    max_probe;
+} CAN_Router_t;
+
+/**
+ * 发送队列槽位，只保存发送需要的字段，不含 CAN_Frame_t 中接收用的 fmi 和 timestamp
+ */
+typedef struct
+{
+    atomic_uint seq; ///< 槽位序号，用于区分 空闲 / 已写入
+    uint32_t    id;
+    uint8_t     ide;
+    uint8_t     rtr;
+    uint8_t     dlc;
+    uint32_t    word[2];
+} CAN_TxSlot_t;
+
+/**
+ * 有界无锁发送队列
+ *
+ * 多生产者（任务、中断均可）单消费者，消费者只会是 can_tx_drain
+ */
+typedef struct
+{
+    CAN_TxSlot_t       slots[CAN_TX_QUEUE_SIZE];
+    atomic_uint        head;     ///< 生产者写入位置
+    atomic_uint        tail;     ///< 消费者读取位置
+    atomic_flag        draining; ///< 是否有上下文正在向邮箱搬运
+    atomic_uint        high_water;
+    atomic_uint        overflow;
+} CAN_TxQueue_t;
+
+/**
+ * 接收队列
+ *
+ * 单生产者（FIFO 接收中断）单消费者（解码任务），每个 FIFO 一个队列，因此无需 CAS
+ */
+typedef struct
+{
+    CAN_Frame_t frames[CAN_RX_QUEUE_SIZE];
+    atomic_uint head; ///< 中断写入位置
+    atomic_uint tail; ///< 解码任务读取位置
+} CAN_RxQueue_t;
+
+/**
+ * 负载统计
+ *
+ * bits 由收发两侧原子累加，窗口的结算只在 CAN_UpdateBusLoad 中进行
+ */
+typedef struct
+{
+    atomic_uint   bits;         ///< 当前窗口内的位数
+    uint32_t      window_start; ///< 当前窗口开始时间 (unit: ms)
+    uint32_t      history_bits[CAN_LOAD_HISTORY];
+    uint16_t      history_ms[CAN_LOAD_HISTORY];
+    uint32_t      history_index;
+    uint32_t      sum_bits; ///< history_bits 之和
+    uint32_t      sum_ms;   ///< history_ms 之和
+    CAN_BusLoad_t stats;
+} CAN_LoadMeter_t;
+
+/**
+ * 每条总线的运行状态
+ */
+typedef struct
+{
+    CAN_HandleTypeDef* hcan;
+    CAN_TxQueue_t      tx;
+    atomic_bool        tx_hold; ///< 暂停向邮箱搬运，见 CAN_TxHold
+    CAN_RxStats_t      rx;
+    CAN_Router_t       router;
+    CAN_LoadMeter_t    load;
+#ifdef USE_CAN_DEFERRED_RX
+    CAN_RxQueue_t rxq[2]; ///< 下标为 FIFO 编号
+#endif
+} CAN_Bus_t;
+
+static CAN_CallbackMap maps[CAN_NUM];
+static size_t map_size = 0;
+
+static CAN_Bus_t buses[CAN_NUM];
+static size_t    bus_size = 0;
+
+#ifdef USE_CAN_SIM
+static CAN_TxHook_t sim_tx_hook = NULL; ///< 虚拟总线，接收全部发送的帧
+#endif
+
+#ifdef USE_CAN_DEFERRED_RX
+#    define CAN_RX_THREAD_FLAG (0x0001U)
+
+static osThreadId_t volatile rx_thread = NULL; ///< 解码任务，NULL 时在中断中直接解码
+#endif
+
+/**
+ * 开启 DWT 周期计数器，用于中断耗时统计和记录时间戳
+ */
+static void dwt_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#ifdef USE_CAN_TRACE
+_Static_assert((CAN_TRACE_SIZE & (CAN_TRACE_SIZE - 1)) == 0, "CAN_TRACE_SIZE must be a power of 2");
+
+static CAN_TraceRecord_t trace_buffer[CAN_TRACE_SIZE];
+static CAN_TraceRing_t   trace_ring; ///< 零初始化时 enable 为 false，不记录
+
+/**
+ * 总线编号，与 CAN 实例绑定，不依赖 CAN_Start 的调用顺序
+ */
+static uint8_t bus_number(const CAN_HandleTypeDef* hcan)
+{
+#ifdef CAN2
+    if (hcan->Instance == CAN2)
+        return 1;
+#endif
+    return 0;
+}
+
+/**
+ * 记录一帧
+ * @param hcan can handle
+ * @param frame 帧
+ * @param flags 0 或 CAN_TRACE_FLAG_TX
+ */
+static void trace_record(const CAN_HandleTypeDef* hcan,
+                         const CAN_Frame_t*       frame,
+                         const uint32_t           flags)
+{
+    // 未开始记录时不取时间戳
+    if (!atomic_load_explicit(&trace_ring.enable, memory_order_relaxed))
+        return;
+    uint32_t id = frame->id | flags;
+    if (frame->ide == CAN_ID_EXT)
+        id |= CAN_TRACE_FLAG_EXT;
+    if (frame->rtr == CAN_RTR_REMOTE)
+        id |= CAN_TRACE_FLAG_RTR;
+
+    CAN_TraceRecord_t record = {
+        .timestamp = CAN_Trace_GetTimestamp(),
+        .id        = id,
+        .bus       = bus_number(hcan),
+        .dlc       = frame->dlc,
+        .fmi       = frame->fmi,
+    };
+    memcpy(record.data, frame->data, sizeof(record.data));
+    CAN_TraceRing_Push(&trace_ring, &record);
+}
+
+#    define TRACE_RX(hcan, frame) trace_record(hcan, frame, 0)
+#    define TRACE_TX(hcan, frame) trace_record(hcan, frame, CAN_TRACE_FLAG_TX)
+#else
+#    define TRACE_RX(hcan, frame) ((void) 0)
+#    define TRACE_TX(hcan, frame) ((void) 0)
+#endif
+
+static CAN_FifoReceiveCallback_t* get_callbacks(const CAN_HandleTypeDef* hcan)
+{
+    for (size_t i = 0; i < map_size; i++)
+        if (maps[i].hcan == hcan)
+            return maps[i].callbacks;
+
+    return NULL;
+}
+
+static CAN_Bus_t* get_bus(const CAN_HandleTypeDef* hcan)
+{
+    for (size_t i = 0; i < bus_size; i++)
+        if (buses[i].hcan == hcan)
+            return &buses[i];
+
+    return NULL;
+}
+
+static void tx_queue_init(CAN_TxQueue_t* q);
+
+/**
+ * 获取总线状态，不存在时创建
+ * @attention 本函数非线程安全，只应在初始化阶段调用
+ */
+static CAN_Bus_t* get_or_add_bus(CAN_HandleTypeDef* hcan)
+{
+    CAN_Bus_t* bus = get_bus(hcan);
+    if (bus != NULL)
+        return bus;
+    if (bus_size >= CAN_NUM)
+        return NULL;
+    bus = &buses[bus_size];
+    memset(bus, 0, sizeof(CAN_Bus_t));
+    bus->hcan = hcan;
+    tx_queue_init(&bus->tx);
+    atomic_init(&bus->tx_hold, false);
+    bus_size++;
+    return bus;
+}
+
+/**
+ * 将一帧计入总线负载
+ */
+static inline void load_account(CAN_Bus_t* bus, const CAN_Frame_t* frame)
+{
+    if (bus != NULL)
+        atomic_fetch_add_explicit(&bus->load.bits,
+                                  CAN_FrameBits(frame->ide, frame->rtr, frame->dlc),
+                                  memory_order_relaxed);
+}
+
+/**
+ * 总线波特率，第一次调用时根据 BTR 和 APB1 时钟计算
+ */
+static uint32_t bus_bitrate(CAN_Bus_t* bus)
+{
+    if (bus->load.stats.bitrate == 0)
+    {
+        uint32_t bitrate = 0;
+#ifndef USE_CAN_SIM
+        const uint32_t btr = bus->hcan->Instance->BTR;
+        const uint32_t brp = (btr & CAN_BTR_BRP) + 1;
+        // 1 (SYNC_SEG) + (TS1 + 1) + (TS2 + 1)
+        const uint32_t tq = 3 + ((btr & CAN_BTR_TS1) >> CAN_BTR_TS1_Pos) +
+                            ((btr & CAN_BTR_TS2) >> CAN_BTR_TS2_Pos);
+        bitrate = HAL_RCC_GetPCLK1Freq() / (brp * tq);
+#endif
+        bus->load.stats.bitrate = bitrate != 0 ? bitrate : CAN_DEFAULT_BITRATE;
+    }
+    return bus->load.stats.bitrate;
+}
+
+static inline uint32_t route_key(const uint32_t ide, const uint32_t id)
+{
+    return ide == CAN_ID_STD ? id : id | CAN_ROUTE_KEY_EXT;
+}
+
+static inline uint32_t route_hash(const uint32_t key)
+{
+    // Fibonacci hashing
+    return (key * 2654435761U) >> 16 & (CAN_ROUTER_SIZE - 1);
+}
+
+static inline const CAN_Route_t* router_find(const CAN_Router_t* router, const uint32_t key)
+{
+    const uint32_t h = route_hash(key);
+    for (uint32_t i = 0; i <= router->max_probe; i++)
+    {
+        const CAN_Route_t* route = &router->routes[(h + i) & (CAN_ROUTER_SIZE - 1)];
+        if (route->decoder == NULL)
+            return NULL;
+        if (route->key == key)
+            return route;
+    }
+    return NULL;
+}
+
+static void tx_queue_init(CAN_TxQueue_t* q)
+{
+    for (uint32_t i = 0; i < CAN_TX_QUEUE_SIZE; i++)
+        atomic_init(&q->slots[i].seq, i);
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_flag_clear(&q->draining);
+    atomic_init(&q->high_water, 0);
+    atomic_init(&q->overflow, 0);
+}
+
+#ifndef USE_CAN_SIM
+// 仿真时帧直接交给 sim_tx_hook，不经过发送队列和邮箱
+
+/**
+ * 入队
+ * @param pos_out 输出帧在队列中的位置，可为 NULL
+ * @return 队列已满时返回 false
+ */
+static bool tx_queue_push(CAN_TxQueue_t* q, const CAN_Frame_t* frame, unsigned int* pos_out)
+{
+    unsigned int  pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    CAN_TxSlot_t* slot;
+    for (;;)
+    {
+        slot                   = &q->slots[pos & (CAN_TX_QUEUE_SIZE - 1)];
+        const unsigned int seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        const int          dif = (int) (seq - pos);
+        if (dif == 0)
+        {
+            // 槽位空闲，尝试占用
+            if (atomic_compare_exchange_weak_explicit(
+                        &q->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0)
+        {
+            // 队列已满
+            atomic_fetch_add_explicit(&q->overflow, 1, memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            // 被其他生产者抢先
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+    slot->id      = frame->id;
+    slot->ide     = frame->ide;
+    slot->rtr     = frame->rtr;
+    slot->dlc     = frame->dlc;
+    slot->word[0] = frame->word[0];
+    slot->word[1] = frame->word[1];
+    if (pos_out != NULL)
+        *pos_out = pos;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    // 更新最高水位
+    const unsigned int depth = pos + 1 - atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned int       hw    = atomic_load_explicit(&q->high_water, memory_order_relaxed);
+    while (depth > hw &&
+           !atomic_compare_exchange_weak_explicit(
+                   &q->high_water, &hw, depth, memory_order_relaxed, memory_order_relaxed))
+        ;
+    return true;
+}
+
+/**
+ * 查看队首（不出队），仅由持有 draining 的上下文调用
+ * @param frame 输出，队首的帧，可为 NULL
+ * @return 队列为空（或生产者尚未写完）时返回 false
+ */
+static bool tx_queue_front(CAN_TxQueue_t* q, CAN_Frame_t* frame)
+{
+    const unsigned int  pos  = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    const CAN_TxSlot_t* slot = &q->slots[pos & (CAN_TX_QUEUE_SIZE - 1)];
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1)
+        return false;
+    if (frame != NULL)
+    {
+        frame->id      = slot->id;
+        frame->ide     = slot->ide;
+        frame->rtr     = slot->rtr;
+        frame->dlc     = slot->dlc;
+        frame->word[0] = slot->word[0];
+        frame->word[1] = slot->word[1];
+    }
+    return true;
+}
+
+/**
+ * 弹出队首，仅由持有 draining 的上下文调用
+ */
+static void tx_queue_pop(CAN_TxQueue_t* q)
+{
+    const unsigned int pos  = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    CAN_TxSlot_t*      slot = &q->slots[pos & (CAN_TX_QUEUE_SIZE - 1)];
+    atomic_store_explicit(&slot->seq, pos + CAN_TX_QUEUE_SIZE, memory_order_release);
+    atomic_store_explicit(&q->tail, pos + 1, memory_order_relaxed);
+}
+
+static inline bool can_tx_mailbox_free(const CAN_HandleTypeDef* hcan)
+{
+#ifdef USE_CAN_FAST_PATH
+    return CAN_TxMailboxFreeFast(hcan->Instance);
+#else
+    return HAL_CAN_GetTxMailboxesFreeLevel(hcan) > 0;
+#endif
+}
+
+/**
+ * 将一帧写入空闲邮箱
+ * @return 写入的邮箱 (CAN_TX_MAILBOX0 ~ CAN_TX_MAILBOX2)，写入失败返回 0
+ */
+static inline uint32_t can_tx_write_mailbox(CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame)
+{
+#ifdef USE_CAN_FAST_PATH
+    return CAN_WriteTxMailboxFast(hcan->Instance, frame);
+#else
+    uint32_t mailbox;
+    if (HAL_CAN_AddTxMessage(hcan,
+                             &(CAN_TxHeaderTypeDef){
+                                     .StdId = frame->id,
+                                     .ExtId = frame->id,
+                                     .IDE   = frame->ide,
+                                     .RTR   = frame->rtr,
+                                     .DLC   = frame->dlc,
+                             },
+                             frame->data,
+                             &mailbox) != HAL_OK)
+        return 0;
+    return mailbox;
+#endif
+}
+
+/**
+ * 将队列中的帧尽可能多地搬运到空闲邮箱
+ *
+ * 任意时刻只有一个上下文在搬运，其余上下文直接返回，由搬运者负责把新入队的帧发出
+ * @param bus 总线
+ * @param own 调用者刚入队的帧在队列中的位置，NULL 表示不关心
+ * @return own 对应的帧在本次调用中写入的邮箱，未写入时返回 CAN_SEND_QUEUED
+ */
+static uint32_t can_tx_drain(CAN_Bus_t* bus, const unsigned int* own)
+{
+    CAN_TxQueue_t* q       = &bus->tx;
+    uint32_t       mailbox = CAN_SEND_QUEUED;
+    do
+    {
+        if (atomic_flag_test_and_set_explicit(&q->draining, memory_order_acquire))
+            return mailbox;
+        // 持有 draining 之后再检查暂停：先检查再占用时，两步之间被 CAN_TxHold 打断仍会写入邮箱
+        if (atomic_load(&bus->tx_hold))
+        {
+            atomic_flag_clear_explicit(&q->draining, memory_order_release);
+            // 持有期间 CAN_TxRelease 的搬运会失败返回，此时暂停已解除，由本次调用继续搬运
+            if (atomic_load(&bus->tx_hold))
+                return mailbox;
+            continue;
+        }
+
+        CAN_Frame_t frame;
+        while (can_tx_mailbox_free(bus->hcan) && tx_queue_front(q, &frame))
+        {
+            const uint32_t written = can_tx_write_mailbox(bus->hcan, &frame);
+            if (written == 0)
+                break;
+            if (own != NULL && atomic_load_explicit(&q->tail, memory_order_relaxed) == *own)
+                mailbox = written;
+            tx_queue_pop(q);
+        }
+
+        atomic_flag_clear_explicit(&q->draining, memory_order_release);
+        // 释放之后可能有被挡在外面的生产者入队，需要再检查一次
+    } while (tx_queue_front(q, NULL) && can_tx_mailbox_free(bus->hcan));
+    return mailbox;
+}
+
+/**
+ * 发送邮箱空中断回调，继续搬运队列
+ * @param hcan can handle
+ */
+static void can_tx_mailbox_callback(CAN_HandleTypeDef* hcan)
+{
+    CAN_Bus_t* bus = get_bus(hcan);
+    if (bus != NULL)
+        can_tx_drain(bus, NULL);
+}
+#endif
+
+/**
+ * 发送一条 CAN 消息
+ *
+ * 消息先进入该总线的无锁发送队列，有空闲邮箱时立刻写入邮箱，否则在发送邮箱空中断中继续发送。
+ * 本函数不会阻塞，可在任务和中断中调用。
+ * @param hcan can handle
+ * @param header CAN_TxHeaderTypeDef
+ * @param data 数据
+ * @attention 必须先调用 CAN_Start 启动对应的 CAN
+ * @attention 3 个邮箱之间的发送顺序见 can_driver.h 开头的说明
+ * @return 帧在本次调用中写入的邮箱 (CAN_TX_MAILBOX0 ~ CAN_TX_MAILBOX2)；
+ *         CAN_SEND_QUEUED 表示已入队，稍后在邮箱空中断中发送；
+ *         CAN_SEND_FAILED 表示发送失败（队列已满或 CAN 未启动）
+ */
+uint32_t CAN_SendMessage(CAN_HandleTypeDef* hcan, const CAN_TxHeaderTypeDef* header, const uint8_t data[])
+{
+    CAN_Bus_t* bus = get_bus(hcan);
+    if (bus == NULL)
+        return CAN_SEND_FAILED;
+
+    CAN_Frame_t frame = {
+        .id  = header->IDE == CAN_ID_STD ? header->StdId : header->ExtId,
+        .ide = (uint8_t) header->IDE,
+        .rtr = (uint8_t) header->RTR,
+        .dlc = (uint8_t) (header->DLC > 8 ? 8 : header->DLC),
+    };
+    memcpy(frame.data, data, frame.dlc);
+
+#ifdef USE_CAN_SIM
+    TRACE_TX(hcan, &frame);
+    load_account(bus, &frame);
+    if (sim_tx_hook != NULL)
+        sim_tx_hook(hcan, &frame);
+    // 虚拟总线没有邮箱，视为立即写入 0 号邮箱
+    return CAN_TX_MAILBOX0;
+#else
+    unsigned int pos;
+    if (!tx_queue_push(&bus->tx, &frame, &pos))
+        return CAN_SEND_FAILED;
+
+    TRACE_TX(hcan, &frame);
+    load_account(bus, &frame);
+    return can_tx_drain(bus, &pos);
+#endif
+}
+
+/**
+ * 初始化发送缓存
+ * @param cache 发送缓存
+ * @param keepalive_ms 保活间隔 (unit: ms)，内容不变时至少每隔该时间发送一次，0 表示每次都发送
+ */
+void CAN_TxCache_Init(CAN_TxCache_t* cache, const uint32_t keepalive_ms)
+{
+    memset(cache, 0, sizeof(CAN_TxCache_t));
+    cache->keepalive = keepalive_ms;
+}
+
+/**
+ * 使缓存失效，下一次 CAN_SendMessageCached 一定发送
+ *
+ * 用于电机重新使能、切换模式等电机端状态可能丢失的场合
+ * @param cache 发送缓存
+ */
+void CAN_TxCache_Invalidate(CAN_TxCache_t* cache)
+{
+    cache->valid = false;
+}
+
+/**
+ * 带缓存的发送：帧的 ID、长度和数据都与上一次发出的帧相同，且距上次发出不足保活间隔时不发送
+ *
+ * 保活间隔应小于电机端的指令超时时间（例如 VESC 的 CAN timeout）
+ * @param cache 发送缓存，每个电机一个
+ * @param hcan can handle
+ * @param header CAN_TxHeaderTypeDef
+ * @param data 数据
+ * @return 同 CAN_SendMessage，被省略时返回 CAN_SEND_SUPPRESSED
+ */
+uint32_t CAN_SendMessageCached(CAN_TxCache_t*             cache,
+                               CAN_HandleTypeDef*         hcan,
+                               const CAN_TxHeaderTypeDef* header,
+                               const uint8_t              data[])
+{
+    const uint32_t now = HAL_GetTick();
+    const uint8_t  dlc = (uint8_t) (header->DLC > 8 ? 8 : header->DLC);
+    const uint32_t id  = header->IDE == CAN_ID_STD ? header->StdId : header->ExtId;
+
+    if (cache->valid && cache->keepalive != 0 && now - cache->tick < cache->keepalive &&
+        cache->frame.id == id && cache->frame.ide == header->IDE &&
+        cache->frame.rtr == header->RTR && cache->frame.dlc == dlc &&
+        memcmp(cache->frame.data, data, dlc) == 0)
+    {
+        cache->suppressed++;
+        return CAN_SEND_SUPPRESSED;
+    }
+
+    const uint32_t ret = CAN_SendMessage(hcan, header, data);
+    if (ret == CAN_SEND_FAILED)
+    {
+        // 没有发出去，下一次必须重发
+        cache->valid = false;
+        return ret;
+    }
+    cache->frame.id  = id;
+    cache->frame.ide = (uint8_t) header->IDE;
+    cache->frame.rtr = (uint8_t) header->RTR;
+    cache->frame.dlc = dlc;
+    memcpy(cache->frame.data, data, dlc);
+    cache->valid     = true;
+    cache->tick      = now;
+    cache->timestamp = DWT->CYCCNT;
+    cache->sent++;
+    return ret;
+}
+
+/**
+ * 暂停发送：之后发送的帧只入队，直到 CAN_TxRelease 时一起写入邮箱
+ *
+ * 用于让同一控制周期内的多帧指令在总线上连续发出。暂停期间其他上下文发送的帧同样会被推迟，
+ * 暂停时间应尽量短，且帧数不应超过 CAN_TX_QUEUE_SIZE。仿真模式下无效
+ * @param hcan can handle
+ */
+void CAN_TxHold(const CAN_HandleTypeDef* hcan)
+{
+    CAN_Bus_t* bus = get_bus(hcan);
+    if (bus != NULL)
+        atomic_store(&bus->tx_hold, true);
+}
+
+/**
+ * 恢复发送，立即将暂停期间入队的帧写入邮箱
+ * @param hcan can handle
+ */
+void CAN_TxRelease(const CAN_HandleTypeDef* hcan)
+{
+    CAN_Bus_t* bus = get_bus(hcan);
+    if (bus == NULL)
+        return;
+    atomic_store(&bus->tx_hold, false);
+#ifndef USE_CAN_SIM
+    can_tx_drain(bus, NULL);
+#endif
+}
+
+/**
+ * 根据 CAN 实例查找已启动的 can handle
+ * @param instance CAN1 / CAN2
+ * @return 未调用 CAN_Start 时返回 NULL
+ */
+CAN_HandleTypeDef* CAN_GetHandle(const CAN_TypeDef* instance)
+{
+    for (size_t i = 0; i < bus_size; i++)
+        if (buses[i].hcan->Instance == instance)
+            return buses[i].hcan;
+
+    return NULL;
+}
+
+/**
+ * 获取发送队列统计信息
+ * @param hcan can handle
+ * @param stats 统计信息输出
+ */
+void CAN_GetTxQueueStats(const CAN_HandleTypeDef* hcan, CAN_TxQueueStats_t* stats)
+{
+    CAN_Bus_t* bus = get_bus(hcan);
+    if (bus == NULL)
+    {
+        *stats = (CAN_TxQueueStats_t){0};
+        return;
+    }
+    CAN_TxQueue_t* q = &bus->tx;
+    stats->depth = atomic_load_explicit(&q->head, memory_order_relaxed) -
+                   atomic_load_explicit(&q->tail, memory_order_relaxed);
+    stats->high_water = atomic_load_explicit(&q->high_water, memory_order_relaxed);
+    stats->overflow   = atomic_load_explicit(&q->overflow, memory_order_relaxed);
+}
+
+/**
+ * 清零发送队列统计信息（不影响队列内容）
+ * @param hcan can handle
+ */
+void CAN_ResetTxQueueStats(const CAN_HandleTypeDef* hcan)
+{
+    CAN_Bus_t* bus = get_bus(hcan);
+    if (bus == NULL)
+        return;
+    CAN_TxQueue_t* q = &bus->tx;
+    atomic_store_explicit(&q->high_water, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->overflow, 0, memory_order_relaxed);
+}
+
+/**
+ * CAN 初始化
+ *
+ * 会额外注册发送邮箱完成/中止回调并开启 CAN_IT_TX_MAILBOX_EMPTY，用于发送队列
+ * @param hcan can handle
+ * @param ActiveITs CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_RX_FIFO1_MSG_PENDING
+ */
+void CAN_Start(CAN_HandleTypeDef* hcan, const uint32_t ActiveITs)
+{
+    CAN_Bus_t* bus = get_or_add_bus(hcan);
+    if (bus == NULL)
+    {
+        CAN_ERROR_HANDLER();
+        return;
+    }
+    dwt_init();
+    bus_bitrate(bus);
+    bus->load.window_start = HAL_GetTick();
+#ifdef USE_CAN_SIM
+    // 仿真时不启动硬件
+    (void) ActiveITs;
+#else
+    static const HAL_CAN_CallbackIDTypeDef tx_callback_ids[] = {
+        HAL_CAN_TX_MAILBOX0_COMPLETE_CB_ID, HAL_CAN_TX_MAILBOX1_COMPLETE_CB_ID,
+        HAL_CAN_TX_MAILBOX2_COMPLETE_CB_ID, HAL_CAN_TX_MAILBOX0_ABORT_CB_ID,
+        HAL_CAN_TX_MAILBOX1_ABORT_CB_ID,    HAL_CAN_TX_MAILBOX2_ABORT_CB_ID,
+    };
+    for (size_t i = 0; i < sizeof(tx_callback_ids) / sizeof(tx_callback_ids[0]); i++)
+    {
+        if (HAL_CAN_RegisterCallback(hcan, tx_callback_ids[i], can_tx_mailbox_callback) != HAL_OK)
+        {
+            CAN_ERROR_HANDLER();
+        }
+    }
+
+    if (HAL_CAN_Start(hcan) != HAL_OK)
+    {
+        CAN_ERROR_HANDLER();
+    }
+
+    if (HAL_CAN_ActivateNotification(hcan, ActiveITs | CAN_IT_TX_MAILBOX_EMPTY) != HAL_OK)
+    {
+        CAN_ERROR_HANDLER();
+    }
+#endif
+}
+
+/**
+ * 注册 CAN Fifo 处理回调
+ *
+ * @attention 本函数非线程安全，调用时请注意
+ * @note 重复注册将会覆盖之前的回调
+ * @param hcan hcan
+ * @param filter_match_index 注册对应的 filter 编号，必须小于 CAN_CALLBACK_NUM
+ * @param callback 回调函数指针
+ */
+void CAN_RegisterCallback(CAN_HandleTypeDef* hcan, const uint32_t filter_match_index, CAN_FifoReceiveCallback_t callback)
+{
+    if (filter_match_index >= CAN_CALLBACK_NUM)
+    {
+        CAN_ERROR_HANDLER();
+        return;
+    }
+
+    CAN_FifoReceiveCallback_t* callbacks = get_callbacks(hcan);
+
+    if (callbacks == NULL)
+    {
+        if (map_size >= CAN_NUM)
+        {
+            CAN_ERROR_HANDLER();
+            return;
+        }
+        maps[map_size] = (CAN_CallbackMap){
+            .hcan      = hcan,
+            .callbacks = {NULL}};
+        callbacks = maps[map_size].callbacks;
+        map_size++;
+    }
+
+    callbacks[filter_match_index] = callback;
+}
+
+/**
+ * 取消注册 CAN Fifo 处理回调
+ *
+ * @attention 本函数非线程安全，调用时请注意
+ * @param hcan can handle
+ * @param filter_match_index 需要取消注册对应的过滤器对应的 id
+ */
+void CAN_UnregisterCallback(CAN_HandleTypeDef* hcan, const uint32_t filter_match_index)
+{
+    if (filter_match_index >= CAN_CALLBACK_NUM)
+    {
+        CAN_ERROR_HANDLER();
+        return;
+    }
+
+    CAN_FifoReceiveCallback_t* callbacks = get_callbacks(hcan);
+    if (callbacks != NULL)
+        callbacks[filter_match_index] = NULL;
+}
+
+/**
+ * 注册帧路由：(IDE, ID) -> (decoder, handle)
+ *
+ * 接收时先查路由表，命中则直接调用 decoder(handle, frame)，不再经过 FilterMatchIndex 回调
+ * @attention 本函数非线程安全，应在驱动初始化 (*_Init) 时调用
+ * @note 重复注册同一 ID 将会覆盖之前的路由
+ * @param hcan can handle
+ * @param ide CAN_ID_STD 或 CAN_ID_EXT
+ * @param id StdId 或 ExtId
+ * @param decoder 解码函数
+ * @param handle 传给解码函数的句柄
+ */
+void CAN_RegisterRoute(CAN_HandleTypeDef*       hcan,
+                       const uint32_t           ide,
+                       const uint32_t           id,
+                       const CAN_FrameDecoder_t decoder,
+                       void*                    handle)
+{
+    CAN_Bus_t* bus = get_or_add_bus(hcan);
+    if (bus == NULL || decoder == NULL)
+    {
+        CAN_ERROR_HANDLER();
+        return;
+    }
+    CAN_Router_t*  router = &bus->router;
+    const uint32_t key    = route_key(ide, id);
+    const uint32_t h      = route_hash(key);
+    for (uint32_t i = 0; i < CAN_ROUTER_SIZE; i++)
+    {
+        CAN_Route_t* route = &router->routes[(h + i) & (CAN_ROUTER_SIZE - 1)];
+        if (route->decoder != NULL && route->key != key)
+            continue;
+        if (route->decoder == NULL)
+        {
+            // 新表项：先写 key/handle，最后写 decoder，中断中不会看到写了一半的表项
+            route->key    = key;
+            route->handle = handle;
+            __DMB();
+            route->decoder = decoder;
+            router->count++;
+            if (i > router->max_probe)
+                router->max_probe = i;
+        }
+        else
+        {
+            route->handle  = handle;
+            route->decoder = decoder;
+        }
+        return;
+    }
+    // 路由表已满
+    CAN_ERROR_HANDLER();
+}
+
+#if defined(CAN2)
+#    define CAN_FILTER_BANK_NUM (28) ///< CAN1 和 CAN2 共享 28 个过滤器组
+#else
+#    define CAN_FILTER_BANK_NUM (14)
+#endif
+
+/**
+ * 过滤器表项，key 格式与路由表相同，mask 为 1 的位需要匹配
+ */
+typedef struct
+{
+    uint32_t key;
+    uint32_t mask;
+} CAN_FilterEntry_t;
+
+static inline uint32_t filter_id_width(const bool ext)
+{
+    return ext ? 0x1FFFFFFFU : 0x7FFU;
+}
+
+/**
+ * 计算一类 ID 需要的过滤器组数
+ * @param ext 扩展帧使用 32 位过滤器，标准帧使用 16 位过滤器
+ */
+static uint32_t filter_bank_count(const CAN_FilterEntry_t* e, const uint32_t n, const bool ext)
+{
+    uint32_t list = 0;
+    for (uint32_t i = 0; i < n; i++)
+        if (e[i].mask == filter_id_width(ext))
+            list++;
+    const uint32_t mask = n - list;
+    if (ext)
+        return (list + 1) / 2 + mask; // 32 位：列表 2 个/组，掩码 1 个/组
+    return (list + 3) / 4 + (mask + 1) / 2; // 16 位：列表 4 个/组，掩码 2 个/组
+}
+
+/**
+ * 找到合并后放行的额外 ID 最少的一对表项
+ * @return 合并代价（新增的不关心位数），n < 2 时返回 UINT32_MAX
+ */
+static uint32_t filter_find_merge(const CAN_FilterEntry_t* e,
+                                  const uint32_t           n,
+                                  const bool               ext,
+                                  uint32_t*                out_i,
+                                  uint32_t*                out_j)
+{
+    uint32_t best = UINT32_MAX;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        for (uint32_t j = i + 1; j < n; j++)
+        {
+            const uint32_t mask = e[i].mask & e[j].mask & ~(e[i].key ^ e[j].key);
+            const uint32_t cost = (uint32_t) __builtin_popcount(filter_id_width(ext) & ~mask);
+            if (cost < best)
+            {
+                best   = cost;
+                *out_i = i;
+                *out_j = j;
+            }
+        }
+    }
+    return best;
+}
+
+static void filter_merge(CAN_FilterEntry_t* e, uint32_t* n, const uint32_t i, const uint32_t j)
+{
+    e[i].mask &= e[j].mask & ~(e[i].key ^ e[j].key);
+    e[i].key &= e[i].mask;
+    e[j] = e[*n - 1];
+    (*n)--;
+}
+
+/**
+ * 写入一个过滤器组
+ */
+static void filter_write_bank(CAN_HandleTypeDef* hcan,
+                              const uint32_t     bank,
+                              const uint32_t     mode,
+                              const uint32_t     scale,
+                              const uint32_t     fr1,
+                              const uint32_t     fr2,
+                              const uint32_t     fifo,
+                              const uint32_t     slave_start)
+{
+    // 16 位模式下 HAL 的字段顺序为 FR1 = MaskIdLow : IdLow, FR2 = MaskIdHigh : IdHigh
+    // 32 位模式下 FR1 = IdHigh : IdLow, FR2 = MaskIdHigh : MaskIdLow
+    const bool              s16 = scale == CAN_FILTERSCALE_16BIT;
+    const CAN_FilterTypeDef cfg = {
+        .FilterIdHigh         = s16 ? fr2 & 0xFFFF : fr1 >> 16,
+        .FilterIdLow          = fr1 & 0xFFFF,
+        .FilterMaskIdHigh     = fr2 >> 16,
+        .FilterMaskIdLow      = s16 ? fr1 >> 16 : fr2 & 0xFFFF,
+        .FilterFIFOAssignment = fifo,
+        .FilterBank           = bank,
+        .FilterMode           = mode,
+        .FilterScale          = scale,
+        .FilterActivation     = ENABLE,
+        .SlaveStartFilterBank = slave_start,
+    };
+    if (HAL_CAN_ConfigFilter(hcan, &cfg) != HAL_OK)
+    {
+        CAN_ERROR_HANDLER();
+    }
+}
+
+static inline uint32_t filter_std16(const uint32_t id)
+{
+    return id << 5; // STID[10:0] RTR IDE EXID[17:15]，RTR = IDE = 0
+}
+
+static inline uint32_t filter_ext32(const uint32_t id)
+{
+    return id << 3 | CAN_ID_EXT; // EXID[28:0] IDE RTR 0，RTR = 0
+}
+
+/**
+ * 将表项写入从 bank 开始的过滤器组
+ * @return 下一个空闲的过滤器组
+ */
+static uint32_t filter_write_entries(CAN_HandleTypeDef*       hcan,
+                                     uint32_t                 bank,
+                                     const CAN_FilterEntry_t* e,
+                                     const uint32_t           n,
+                                     const bool               ext,
+                                     const uint32_t           fifo,
+                                     const uint32_t           slave_start)
+{
+    const uint32_t width = filter_id_width(ext);
+    const uint32_t per   = ext ? 2 : 4; // 每组列表项个数
+    uint32_t       list[4];
+    uint32_t       list_n = 0;
+    uint32_t       mask[2][2];
+    uint32_t       mask_n = 0;
+
+    for (uint32_t i = 0; i <= n; i++)
+    {
+        const bool last = i == n;
+        if (!last && e[i].mask == width)
+        {
+            list[list_n++] = ext ? filter_ext32(e[i].key & width) : filter_std16(e[i].key & width);
+        }
+        else if (!last)
+        {
+            const uint32_t id = e[i].key & width;
+            if (ext)
+            {
+                // 32 位掩码，IDE 和 RTR 必须匹配
+                filter_write_bank(hcan, bank++, CAN_FILTERMODE_IDMASK, CAN_FILTERSCALE_32BIT,
+                                  filter_ext32(id), e[i].mask << 3 | 0x6, fifo, slave_start);
+            }
+            else
+            {
+                mask[mask_n][0] = filter_std16(id);
+                mask[mask_n][1] = e[i].mask << 5 | 0x18; // IDE 和 RTR 必须匹配
+                mask_n++;
+            }
+        }
+
+        if (list_n == per || (last && list_n > 0))
+        {
+            // 不足一组时用第一个 ID 补齐
+            for (uint32_t k = list_n; k < per; k++)
+                list[k] = list[0];
+            if (ext)
+                filter_write_bank(hcan, bank++, CAN_FILTERMODE_IDLIST, CAN_FILTERSCALE_32BIT,
+                                  list[0], list[1], fifo, slave_start);
+            else
+                filter_write_bank(hcan, bank++, CAN_FILTERMODE_IDLIST, CAN_FILTERSCALE_16BIT,
+                                  list[1] << 16 | list[0], list[3] << 16 | list[2], fifo,
+                                  slave_start);
+            list_n = 0;
+        }
+        if (mask_n == 2 || (last && mask_n > 0))
+        {
+            if (mask_n == 1)
+            {
+                mask[1][0] = mask[0][0];
+                mask[1][1] = mask[0][1];
+            }
+            filter_write_bank(hcan, bank++, CAN_FILTERMODE_IDMASK, CAN_FILTERSCALE_16BIT,
+                              mask[0][1] << 16 | mask[0][0], mask[1][1] << 16 | mask[1][0], fifo,
+                              slave_start);
+            mask_n = 0;
+        }
+    }
+    return bank;
+}
+
+/**
+ * 将一条总线路由表中的 ID 收集到过滤器表项中，标准帧在前，扩展帧紧随其后
+ */
+static void filter_collect(const CAN_Bus_t*   bus,
+                           CAN_FilterEntry_t* e,
+                           uint32_t*          n_std,
+                           uint32_t*          n_ext)
+{
+    *n_std = *n_ext = 0;
+    for (int ext = 0; ext <= 1; ext++)
+    {
+        for (uint32_t i = 0; i < CAN_ROUTER_SIZE; i++)
+        {
+            const CAN_Route_t* route = &bus->router.routes[i];
+            if (route->decoder == NULL || ((route->key & CAN_ROUTE_KEY_EXT) != 0) != ext)
+                continue;
+            e[*n_std + *n_ext] = (CAN_FilterEntry_t){
+                .key  = route->key & ~CAN_ROUTE_KEY_EXT,
+                .mask = filter_id_width(ext),
+            };
+            if (ext)
+                (*n_ext)++;
+            else
+                (*n_std)++;
+        }
+    }
+}
+
+/**
+ * 根据路由表自动配置硬件过滤器
+ *
+ * 收集各驱动在 *_Init 中注册的全部 ID，标准帧打包为 16 位列表（4 个/组），扩展帧打包为
+ * 32 位列表（2 个/组）。过滤器组不够时，按放行的额外 ID 最少的原则把 ID 合并为掩码，
+ * 并自动划分 CAN1 / CAN2 的过滤器组 (SlaveStartFilterBank)。
+ * 这样软件只会收到有驱动处理的帧。
+ * @attention 须在所有电机 *_Init 之后调用；会覆盖全部过滤器，不能再与 *_CAN_FilterInit 或
+ *            依赖 FilterMatchIndex 的 CAN_RegisterCallback 混用
+ * @param fifo CAN_FILTER_FIFO0 或 CAN_FILTER_FIFO1
+ */
+void CAN_ConfigFilters(const uint32_t fifo)
 {
-    if (can_mutex == NULL)
-        can_mutex = osMutexNew(&(osMutexAttr_t){.name = "can_mutex"});
-    return can_mutex;
-}
-#else
-#include "cmsis_compiler.h"
-#endif
+    static CAN_FilterEntry_t entries[CAN_NUM][CAN_ROUTER_SIZE];
+    uint32_t                 n_std[CAN_NUM], n_ext[CAN_NUM];
+    uint32_t                 need[CAN_NUM] = {0};
+    uint32_t                 ext_off[CAN_NUM]; // 扩展帧表项的起始位置，合并标准帧后不变
+    uint32_t                 total = 0;
 
+    if (bus_size == 0)
+        return;
 
-static CAN_CallbackMap maps[CAN_NUM];
-static size_t map_size = 0;
+    // 主 CAN (CAN1) 放在前面
+    CAN_Bus_t* order[CAN_NUM] = {NULL};
+    size_t     k              = 0;
+    for (size_t i = 0; i < bus_size; i++)
+        if (buses[i].hcan->Instance == CAN1)
+            order[k++] = &buses[i];
+    for (size_t i = 0; i < bus_size; i++)
+        if (buses[i].hcan->Instance != CAN1)
+            order[k++] = &buses[i];
 
-static CAN_FifoReceiveCallback_t* get_callbacks(const CAN_HandleTypeDef* hcan)
+    for (size_t b = 0; b < bus_size; b++)
+    {
+        filter_collect(order[b], entries[b], &n_std[b], &n_ext[b]);
+        ext_off[b] = n_std[b];
+        need[b]    = filter_bank_count(entries[b], n_std[b], false) +
+                     filter_bank_count(entries[b] + ext_off[b], n_ext[b], true);
+        total += need[b];
+    }
+
+    uint32_t used = 0;
+    for (size_t b = 0; b < bus_size; b++)
+    {
+        // 过滤器组不够时按需求比例分配，最后一条总线使用剩余的全部过滤器组
+        uint32_t budget = need[b];
+        if (total > CAN_FILTER_BANK_NUM)
+        {
+            budget = b + 1 == bus_size ? CAN_FILTER_BANK_NUM - used
+                                       : CAN_FILTER_BANK_NUM * need[b] / total;
+            if (budget == 0)
+                budget = 1;
+        }
+
+        CAN_FilterEntry_t* std_e = entries[b];
+        CAN_FilterEntry_t* ext_e = entries[b] + ext_off[b];
+        while (filter_bank_count(std_e, n_std[b], false) +
+                       filter_bank_count(ext_e, n_ext[b], true) >
+               budget)
+        {
+            uint32_t       si = 0, sj = 0, ei = 0, ej = 0;
+            const uint32_t std_cost = filter_find_merge(std_e, n_std[b], false, &si, &sj);
+            const uint32_t ext_cost = filter_find_merge(ext_e, n_ext[b], true, &ei, &ej);
+            if (std_cost == UINT32_MAX && ext_cost == UINT32_MAX)
+                break; // 每类只剩一个表项，无法再合并
+            if (std_cost <= ext_cost)
+                filter_merge(std_e, &n_std[b], si, sj);
+            else
+                filter_merge(ext_e, &n_ext[b], ei, ej);
+        }
+        need[b] = filter_bank_count(std_e, n_std[b], false) +
+                  filter_bank_count(ext_e, n_ext[b], true);
+        used += need[b];
+    }
+    if (used > CAN_FILTER_BANK_NUM)
+    {
+        CAN_ERROR_HANDLER();
+        return;
+    }
+
+    // CAN2 的过滤器从 CAN1 用完的位置开始
+    const uint32_t slave_start = order[0]->hcan->Instance == CAN1 ? need[0] : 0;
+    uint32_t       bank        = 0;
+    for (size_t b = 0; b < bus_size; b++)
+    {
+        CAN_HandleTypeDef* hcan = order[b]->hcan;
+        bank = filter_write_entries(hcan, bank, entries[b], n_std[b], false, fifo, slave_start);
+        bank = filter_write_entries(hcan, bank, entries[b] + ext_off[b], n_ext[b], true, fifo,
+                                    slave_start);
+    }
+
+    // 关闭剩余的过滤器组
+    for (; bank < CAN_FILTER_BANK_NUM; bank++)
+    {
+        const CAN_FilterTypeDef cfg = {
+            .FilterBank           = bank,
+            .FilterMode           = CAN_FILTERMODE_IDMASK,
+            .FilterScale          = CAN_FILTERSCALE_32BIT,
+            .FilterFIFOAssignment = fifo,
+            .FilterActivation     = DISABLE,
+            .SlaveStartFilterBank = slave_start,
+        };
+        HAL_CAN_ConfigFilter(order[0]->hcan, &cfg);
+    }
+}
+
+/**
+ * 读取并清除 FIFO 溢出标志
+ *
+ * 必须在读 FIFO 之前调用：HAL_CAN_GetRxMessage 以读-改-写的方式释放邮箱，会把 FOVR 一起清除，
+ * 读空之后再检查就永远看不到溢出。读 FIFO 期间再次发生的溢出在 HAL 路径下同样会被清除，
+ * 但此时 FIFO 正在被读空，一般不会出现
+ * @param hcan can handle
+ * @param fifo CAN_RX_FIFO0 或 CAN_RX_FIFO1
+ * @return 自上次调用以来是否发生过溢出
+ */
+bool CAN_TakeRxOverrun(CAN_HandleTypeDef* hcan, const uint32_t fifo)
 {
-    for (size_t i = 0; i < map_size; i++)
-        if (maps[i].hcan == hcan)
-            return maps[i].callbacks;
+    const uint32_t ovr_flag = fifo == CAN_RX_FIFO0 ? CAN_FLAG_FOV0 : CAN_FLAG_FOV1;
+    if (__HAL_CAN_GET_FLAG(hcan, ovr_flag) == 0)
+        return false;
+    // 写 1 清除，不会释放邮箱
+    __HAL_CAN_CLEAR_FLAG(hcan, ovr_flag);
+    return true;
+}
 
-    return NULL;
+/**
+ * 统计一次 FIFO 批量接收
+ *
+ * 自行实现 FIFO 接收回调的驱动应当使用 CAN_DrainFifo；逐帧调用 CAN_ReadFrame 时也应当在读 FIFO
+ * 之前调用 CAN_TakeRxOverrun，读空 FIFO 后调用本函数
+ * @param hcan can handle
+ * @param fifo CAN_RX_FIFO0 或 CAN_RX_FIFO1
+ * @param batch 本次中断读取的帧数
+ * @param overrun 读 FIFO 前 CAN_TakeRxOverrun 的返回值
+ */
+void CAN_UpdateRxStats(const CAN_HandleTypeDef* hcan,
+                       const uint32_t           fifo,
+                       const uint32_t           batch,
+                       const bool               overrun)
+{
+    CAN_Bus_t* bus = get_bus(hcan);
+    if (bus == NULL || fifo > CAN_RX_FIFO1)
+        return;
+    bus->rx.irqs[fifo]++;
+    bus->rx.frames[fifo] += batch;
+    if (batch > bus->rx.max_batch[fifo])
+        bus->rx.max_batch[fifo] = batch;
+    if (overrun)
+        bus->rx.overrun[fifo]++;
 }
 
 /**
- * 发送一条 CAN 消息
+ * 获取接收统计信息
  * @param hcan can handle
- * @param header CAN_TxHeaderTypeDef
- * @param data 数据
- * @note 本身想做成内联展开，但是必须写到 .h 文件，调研发现性能损失不大，所以直接放到此处
- * @attention 本函数大部分情况是线程安全的，少数情况（中断被中断打断）会出现不安全的情况。
- * @return mailbox, 0xFFFF 表示发送失败
+ * @param stats 统计信息输出
  */
-uint32_t CAN_SendMessage(CAN_HandleTypeDef* hcan, const CAN_TxHeaderTypeDef* header, const uint8_t data[])
+void CAN_GetRxStats(const CAN_HandleTypeDef* hcan, CAN_RxStats_t* stats)
+{
+    const CAN_Bus_t* bus = get_bus(hcan);
+    if (bus == NULL)
+        *stats = (CAN_RxStats_t){0};
+    else
+        *stats = bus->rx;
+}
+
+/**
+ * 清零接收统计信息
+ * @attention 与接收中断并发执行时，清零前后的一次统计可能丢失
+ * @param hcan can handle
+ */
+void CAN_ResetRxStats(const CAN_HandleTypeDef* hcan)
 {
-    uint32_t mailbox = CAN_SEND_FAILED;
+    CAN_Bus_t* bus = get_bus(hcan);
+    if (bus != NULL)
+        memset(&bus->rx, 0, sizeof(CAN_RxStats_t));
+}
 
-    // 等待上一个发送完成
-    // while (HAL_CAN_GetTxMailboxesFreeLevel(hcan) == 0)
-    //     ;
-    if (__get_IPSR() != 0)
+/**
+ * 分发一帧：先查路由表，再按 FilterMatchIndex 调用回调
+ * @return 是否被处理
+ */
+static inline bool can_dispatch(CAN_Bus_t* bus, CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame)
+{
+    if (bus != NULL)
     {
-        // 在中断中直接调用
-        if (HAL_CAN_AddTxMessage(hcan, header, data, &mailbox) != HAL_OK)
+        const CAN_Route_t* route = router_find(&bus->router, route_key(frame->ide, frame->id));
+        if (route != NULL)
         {
-            CAN_ERROR_HANDLER();
+            route->decoder(route->handle, frame);
+            return true;
         }
     }
-    else
-#ifdef USE_RTOS
-    { // 任务中调用需要加临界保护
-        if (osMutexAcquire(get_can_mutex(), CAN_SEND_TIMEOUT) != osOK)
-            // 超时
-            return CAN_SEND_FAILED;
-        if (HAL_CAN_AddTxMessage(hcan, header, data, &mailbox) != HAL_OK)
+
+    // 列表模式下 FilterMatchIndex 可能超出回调表
+    const CAN_FifoReceiveCallback_t* callbacks = get_callbacks(hcan);
+    if (callbacks == NULL || frame->fmi >= CAN_CALLBACK_NUM || callbacks[frame->fmi] == NULL)
+        return false;
+    CAN_RxHeaderTypeDef header = {
+        .StdId            = frame->id,
+        .ExtId            = frame->id,
+        .IDE              = frame->ide,
+        .RTR              = frame->rtr,
+        .DLC              = frame->dlc,
+        .FilterMatchIndex = frame->fmi,
+    };
+    callbacks[frame->fmi](hcan, &header, (uint8_t*) frame->data);
+    return true;
+}
+
+/**
+ * 从 FIFO 读取一帧
+ *
+ * 定义 USE_CAN_FAST_PATH 时直接读寄存器，否则通过 HAL_CAN_GetRxMessage 读取
+ * @param hcan can handle
+ * @param fifo CAN_RX_FIFO0 或 CAN_RX_FIFO1
+ * @param frame 输出帧
+ * @return FIFO 为空或读取失败时返回 false
+ */
+bool CAN_ReadFrame(CAN_HandleTypeDef* hcan, const uint32_t fifo, CAN_Frame_t* frame)
+{
+#ifdef USE_CAN_FAST_PATH
+    if (CAN_RxFifoFillLevelFast(hcan->Instance, fifo) == 0)
+        return false;
+    CAN_ReadRxFifoFast(hcan->Instance, fifo, frame);
+    frame->timestamp = DWT->CYCCNT;
+    TRACE_RX(hcan, frame);
+    load_account(get_bus(hcan), frame);
+    return true;
+#else
+    if (HAL_CAN_GetRxFifoFillLevel(hcan, fifo) == 0)
+        return false;
+    CAN_RxHeaderTypeDef header;
+    // 数据直接读入 frame，无需再拷贝
+    if (HAL_CAN_GetRxMessage(hcan, fifo, &header, frame->data) != HAL_OK)
+    {
+        CAN_ERROR_HANDLER();
+        return false;
+    }
+    frame->id        = header.IDE == CAN_ID_STD ? header.StdId : header.ExtId;
+    frame->ide       = (uint8_t) header.IDE;
+    frame->rtr       = (uint8_t) header.RTR;
+    frame->dlc       = (uint8_t) header.DLC;
+    frame->fmi       = (uint8_t) header.FilterMatchIndex;
+    frame->timestamp = DWT->CYCCNT;
+    TRACE_RX(hcan, frame);
+    load_account(get_bus(hcan), frame);
+    return true;
+#endif
+}
+
+/**
+ * 读空指定 FIFO，逐帧交给 callback，并计入接收统计
+ *
+ * 用于自行实现 FIFO 接收回调的驱动（如 DJI_CAN_Fifo0ReceiveCallback），帧不经过路由表。
+ * 溢出标志在读 FIFO 之前取出，读空后调用 CAN_UpdateRxStats
+ * @param hcan can handle
+ * @param fifo CAN_RX_FIFO0 或 CAN_RX_FIFO1
+ * @param callback 逐帧接收回调
+ */
+void CAN_DrainFifo(CAN_HandleTypeDef* hcan, const uint32_t fifo, const CAN_FrameCallback_t callback)
+{
+    const bool  overrun = CAN_TakeRxOverrun(hcan, fifo);
+    uint32_t    batch   = 0;
+    CAN_Frame_t frame;
+    while (CAN_ReadFrame(hcan, fifo, &frame))
+    {
+        batch++;
+        callback(hcan, &frame);
+    }
+    CAN_UpdateRxStats(hcan, fifo, batch, overrun);
+}
+
+#ifdef USE_CAN_DEFERRED_RX
+/**
+ * 读空指定 FIFO，帧放入接收队列后通知解码任务
+ *
+ * 帧直接读入队列槽位，队列满时读到临时变量后丢弃：FIFO 必须读空，否则中断会反复进入
+ * @return 读取的帧数
+ */
+static uint32_t can_fifo_enqueue(CAN_Bus_t* bus, const uint32_t fifo)
+{
+    CAN_RxQueue_t* q     = &bus->rxq[fifo];
+    uint32_t       head  = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint32_t       batch = 0;
+    CAN_Frame_t    discard;
+
+    for (;;)
+    {
+        const uint32_t depth = head - atomic_load_explicit(&q->tail, memory_order_acquire);
+        CAN_Frame_t*   dst   = depth < CAN_RX_QUEUE_SIZE
+                                       ? &q->frames[head & (CAN_RX_QUEUE_SIZE - 1)]
+                                       : &discard;
+        if (!CAN_ReadFrame(bus->hcan, fifo, dst))
+            break;
+        batch++;
+        if (dst == &discard)
         {
-            CAN_ERROR_HANDLER();
+            bus->rx.queue_overflow[fifo]++;
+            continue;
         }
-        osMutexRelease(get_can_mutex());
+        head++;
+        if (depth + 1 > bus->rx.queue_high_water[fifo])
+            bus->rx.queue_high_water[fifo] = depth + 1;
     }
-#else
+    // 整批发布，一次中断只通知一次
+    atomic_store_explicit(&q->head, head, memory_order_release);
+    if (batch > 0)
+        osThreadFlagsSet(rx_thread, CAN_RX_THREAD_FLAG);
+    return batch;
+}
+#endif
+
+/**
+ * 读空指定 FIFO，逐帧分发（USE_CAN_DEFERRED_RX 且解码任务已启动时只入队）
+ */
+static void can_fifo_receive(CAN_HandleTypeDef* hcan, const uint32_t fifo)
+{
+    const uint32_t start     = DWT->CYCCNT;
+    CAN_Bus_t*     bus       = get_bus(hcan);
+    const bool     overrun   = CAN_TakeRxOverrun(hcan, fifo);
+    uint32_t       batch     = 0;
+    uint32_t       unhandled = 0;
+    CAN_Frame_t    frame;
+
+#ifdef USE_CAN_DEFERRED_RX
+    if (bus != NULL && rx_thread != NULL && fifo <= CAN_RX_FIFO1)
+    {
+        batch = can_fifo_enqueue(bus, fifo);
+    }
+    else
+#endif
     {
-        // 裸机状态下非中断调用需要保护
-        __disable_irq();
-        if (HAL_CAN_AddTxMessage(hcan, header, data, &mailbox) != HAL_OK)
+        while (CAN_ReadFrame(hcan, fifo, &frame))
         {
-            CAN_ERROR_HANDLER();
+            batch++;
+            if (!can_dispatch(bus, hcan, &frame))
+                unhandled++;
         }
-        __enable_irq();
     }
-#endif
+    CAN_UpdateRxStats(hcan, fifo, batch, overrun);
+    if (bus != NULL && fifo <= CAN_RX_FIFO1)
+    {
+        bus->rx.unhandled[fifo] += unhandled;
+        const uint32_t cycles = DWT->CYCCNT - start;
+        if (cycles > bus->rx.isr_cycles_max[fifo])
+            bus->rx.isr_cycles_max[fifo] = cycles;
+    }
+}
 
-    return mailbox;
+/**
+ * 按接收处理一帧（查路由表 / 调用回调），计入 FIFO0 的接收统计
+ */
+static bool can_inject(CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame)
+{
+    CAN_Bus_t* bus     = get_bus(hcan);
+    const bool handled = can_dispatch(bus, hcan, frame);
+    load_account(bus, frame);
+    if (bus != NULL)
+    {
+        bus->rx.frames[CAN_RX_FIFO0]++;
+        if (!handled)
+            bus->rx.unhandled[CAN_RX_FIFO0]++;
+    }
+    return handled;
 }
 
 /**
- * CAN 初始化
+ * 注入一帧，按接收处理（查路由表 / 调用回调），计入 FIFO0 的接收统计
+ *
+ * 用于仿真，帧直接在调用者的上下文中分发，定义 USE_CAN_TRACE 时会被记录
+ * @param hcan can handle，须已调用 CAN_Start
+ * @param frame 注入的帧，fmi 字段用于无路由时选择回调，timestamp 字段会被替换为注入时间
+ * @return 是否被处理
+ */
+bool CAN_InjectFrame(CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame)
+{
+    CAN_Frame_t stamped = *frame;
+    stamped.timestamp   = DWT->CYCCNT;
+    TRACE_RX(hcan, &stamped);
+    return can_inject(hcan, &stamped);
+}
+
+/**
+ * 结算负载统计窗口
+ *
+ * 应在固定周期的任务或定时器中断中调用，周期不大于 CAN_LOAD_WINDOW_MS，
+ * 距上次结算不足 CAN_LOAD_WINDOW_MS 时直接返回
+ */
+void CAN_UpdateBusLoad(void)
+{
+    const uint32_t now = HAL_GetTick();
+    for (size_t i = 0; i < bus_size; i++)
+    {
+        CAN_Bus_t*       bus     = &buses[i];
+        CAN_LoadMeter_t* m       = &bus->load;
+        const uint32_t   elapsed = now - m->window_start;
+        if (elapsed < CAN_LOAD_WINDOW_MS)
+            continue;
+
+        const uint32_t bits       = atomic_exchange_explicit(&m->bits, 0, memory_order_relaxed);
+        const uint32_t ms         = elapsed > UINT16_MAX ? UINT16_MAX : elapsed;
+        const float    bit_per_ms = (float) bus_bitrate(bus) / 1000.0f;
+        m->window_start           = now;
+
+        // 滑动窗口：替换最旧的一个窗口
+        const uint32_t slot   = m->history_index++ % CAN_LOAD_HISTORY;
+        m->sum_bits           = m->sum_bits - m->history_bits[slot] + bits;
+        m->sum_ms             = m->sum_ms - m->history_ms[slot] + ms;
+        m->history_bits[slot] = bits;
+        m->history_ms[slot]   = (uint16_t) ms;
+
+        m->stats.load    = (float) bits / (bit_per_ms * (float) ms);
+        m->stats.average = (float) m->sum_bits / (bit_per_ms * (float) m->sum_ms);
+        if (m->stats.load > m->stats.peak)
+            m->stats.peak = m->stats.load;
+        m->stats.windows++;
+    }
+}
+
+/**
+ * 获取总线负载统计
  * @param hcan can handle
- * @param ActiveITs CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_RX_FIFO1_MSG_PENDING
+ * @param load 统计信息输出
  */
-void CAN_Start(CAN_HandleTypeDef* hcan, const uint32_t ActiveITs)
+void CAN_GetBusLoad(const CAN_HandleTypeDef* hcan, CAN_BusLoad_t* load)
 {
-    if (HAL_CAN_Start(hcan) != HAL_OK)
+    const CAN_Bus_t* bus = get_bus(hcan);
+    if (bus == NULL)
+        *load = (CAN_BusLoad_t) { 0 };
+    else
+        *load = bus->load.stats;
+}
+
+/**
+ * 清零负载统计，保留波特率和已声明的带宽
+ * @attention 应与 CAN_UpdateBusLoad 在同一上下文中调用
+ * @param hcan can handle
+ */
+void CAN_ResetBusLoad(const CAN_HandleTypeDef* hcan)
+{
+    CAN_Bus_t* bus = get_bus(hcan);
+    if (bus == NULL)
+        return;
+    CAN_LoadMeter_t* m = &bus->load;
+    atomic_store_explicit(&m->bits, 0, memory_order_relaxed);
+    memset(m->history_bits, 0, sizeof(m->history_bits));
+    memset(m->history_ms, 0, sizeof(m->history_ms));
+    m->history_index = 0;
+    m->sum_bits      = 0;
+    m->sum_ms        = 0;
+    m->window_start  = HAL_GetTick();
+    m->stats.load    = 0;
+    m->stats.average = 0;
+    m->stats.peak    = 0;
+    m->stats.windows = 0;
+}
+
+/**
+ * 声明一种周期帧占用的带宽，由各驱动在注册电机时调用
+ *
+ * 计入本次声明后超出波特率的 CAN_LOAD_BUDGET_PERCENT 时拒绝本次声明并计入 over_budget，
+ * 定义 CAN_LOAD_ADMISSION_STRICT 时进入 CAN_ERROR_HANDLER。
+ * 未定义 CAN_LOAD_ADMISSION_STRICT 时结果只是提示，驱动仍会注册电机并按原帧率收发
+ * @param hcan can handle
+ * @param ide CAN_ID_STD / CAN_ID_EXT
+ * @param dlc 数据长度
+ * @param rate_hz 帧率 (unit: Hz)
+ * @return 在预算内并已计入 reserved 时返回 true
+ */
+bool CAN_ReserveBandwidth(CAN_HandleTypeDef* hcan,
+                          const uint32_t     ide,
+                          const uint32_t     dlc,
+                          const uint32_t     rate_hz)
+{
+    CAN_Bus_t* bus = get_or_add_bus(hcan);
+    if (bus == NULL)
     {
         CAN_ERROR_HANDLER();
+        return false;
+    }
+    // 先检查再计入，超出预算的声明不计入 reserved，以免之后的声明都被拒绝
+    const uint64_t bits   = (uint64_t) CAN_FrameBits(ide, CAN_RTR_DATA, dlc) * rate_hz;
+    const uint64_t budget = (uint64_t) bus_bitrate(bus) * CAN_LOAD_BUDGET_PERCENT / 100U;
+    if (bus->load.stats.reserved + bits <= budget)
+    {
+        bus->load.stats.reserved += (uint32_t) bits;
+        return true;
+    }
+
+    bus->load.stats.over_budget++;
+#ifdef CAN_LOAD_ADMISSION_STRICT
+    CAN_ERROR_HANDLER();
+#endif
+    return false;
+}
+
+#ifdef USE_CAN_DEFERRED_RX
+/**
+ * 取出并分发一个接收队列中的全部帧
+ */
+static void can_rx_queue_drain(CAN_Bus_t* bus, const uint32_t fifo)
+{
+    CAN_RxQueue_t* q         = &bus->rxq[fifo];
+    uint32_t       tail      = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    const uint32_t head      = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint32_t       unhandled = 0;
+
+    while (tail != head)
+    {
+        if (!can_dispatch(bus, bus->hcan, &q->frames[tail & (CAN_RX_QUEUE_SIZE - 1)]))
+            unhandled++;
+        // 逐帧释放槽位，分发期间中断可以继续写入
+        atomic_store_explicit(&q->tail, ++tail, memory_order_release);
+    }
+    bus->rx.unhandled[fifo] += unhandled;
+}
+
+/**
+ * 解码任务，每次被唤醒时处理所有总线上积压的帧
+ */
+static void can_rx_task(void* argument)
+{
+    (void) argument;
+    for (;;)
+    {
+        osThreadFlagsWait(CAN_RX_THREAD_FLAG, osFlagsWaitAny, osWaitForever);
+        for (size_t i = 0; i < bus_size; i++)
+        {
+            can_rx_queue_drain(&buses[i], CAN_RX_FIFO0);
+            can_rx_queue_drain(&buses[i], CAN_RX_FIFO1);
+        }
     }
+}
 
-    if (HAL_CAN_ActivateNotification(hcan, ActiveITs) != HAL_OK)
+/**
+ * 创建解码任务，此后 CAN_Fifo0ReceiveCallback / CAN_Fifo1ReceiveCallback 只把帧放入接收队列，
+ * 路由解码函数和 FifoReceiveCallback 改为在解码任务中调用
+ *
+ * 各驱动自带的 *_CAN_FifoxReceiveCallback 不受影响，仍在中断中解码；
+ * 需要延迟解码时请注册 CAN_Fifo0ReceiveCallback（各驱动 Init 时已注册路由）。
+ * 未调用本函数时与未定义 USE_CAN_DEFERRED_RX 的行为相同
+ * @attention 须在 RTOS 内核初始化之后调用；解码任务优先级 CAN_RX_TASK_PRIORITY 应高于控制任务，
+ *            电机反馈的读取仍需与解码任务互斥（或者使用快照接口）
+ */
+void CAN_DeferredRx_Start(void)
+{
+    static const osThreadAttr_t attr = {
+        .name       = "can_rx",
+        .stack_size = CAN_RX_TASK_STACK_SIZE,
+        .priority   = CAN_RX_TASK_PRIORITY,
+    };
+    if (rx_thread != NULL)
+        return;
+    rx_thread = osThreadNew(can_rx_task, NULL, &attr);
+    if (rx_thread == NULL)
     {
         CAN_ERROR_HANDLER();
     }
 }
+#endif
+
+#ifdef USE_CAN_SIM
+/**
+ * 注册虚拟总线的发送钩子，CAN_SendMessage 发送的帧都会同步交给它
+ * @param hook 发送钩子，NULL 表示丢弃发送的帧
+ */
+void CAN_SetSimTxHook(const CAN_TxHook_t hook)
+{
+    sim_tx_hook = hook;
+}
+#endif
 
 /**
- * 注册 CAN Fifo 处理回调
+ * 记录和实时回放使用的时间戳 (unit: us)
  *
- * @attention 本函数非线程安全，调用时请注意
- * @note 重复注册将会覆盖之前的回调
- * @param hcan hcan
- * @param filter_match_index 注册对应的 filter 编号
- * @param callback 回调函数指针
+ * 默认由 DWT 周期计数器换算，CYCCNT 在 168MHz 下约 25s 回绕一次，
+ * 因此两次调用间隔不能超过一个回绕周期，否则中间的时间会丢失。
+ * 可以在用户代码中重新实现本函数（如使用 32 位硬件定时器）
+ * @return 时间戳，约 71 分钟回绕一次
  */
-void CAN_RegisterCallback(CAN_HandleTypeDef* hcan, const uint32_t filter_match_index, CAN_FifoReceiveCallback_t callback)
+__weak uint32_t CAN_Trace_GetTimestamp(void)
 {
-    CAN_FifoReceiveCallback_t* callbacks = get_callbacks(hcan);
+    static uint32_t last_cycles = 0, us = 0, remainder = 0;
 
-    if (callbacks == NULL)
+    const uint32_t cycles_per_us = SystemCoreClock / 1000000U;
+    // 中断和任务都可能调用，扩展计数器时需要关中断
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t cycles = DWT->CYCCNT;
+    remainder += cycles - last_cycles;
+    last_cycles = cycles;
+    us += remainder / cycles_per_us;
+    remainder %= cycles_per_us;
+    const uint32_t timestamp = us;
+    __set_PRIMASK(primask);
+    return timestamp;
+}
+
+/**
+ * 将记录回放到驱动中
+ *
+ * 每条接收记录按 bus 找到 hcan 后像 CAN_InjectFrame 一样分发（路由表中注册的解码函数，
+ * 或按 fmi 选择的 FifoReceiveCallback），发送记录会被跳过，回放的帧不会被记录。
+ * 全速回放可用于解码性能测试，实时回放按相邻记录的时间差忙等，用于复现现场问题
+ * @param hcans 下标为记录中的总线编号，NULL 表示跳过该总线的记录
+ * @param records 记录，来自 CAN_Trace_ParseFile 或 CAN_Trace_ParseCandump
+ * @param count 记录条数
+ * @param realtime 是否按记录的时间间隔回放
+ * @return 被处理的帧数
+ */
+size_t CAN_Trace_Replay(CAN_HandleTypeDef* const hcans[CAN_NUM],
+                        const CAN_TraceRecord_t* records,
+                        const size_t             count,
+                        const bool               realtime)
+{
+    size_t   handled = 0;
+    uint32_t first = 0, elapsed = 0, last = 0;
+    bool     started = false;
+
+    if (realtime)
     {
-        if (map_size >= CAN_NUM)
+        dwt_init();
+        last = CAN_Trace_GetTimestamp();
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const CAN_TraceRecord_t* record = &records[i];
+        if ((record->id & CAN_TRACE_FLAG_TX) || record->bus >= CAN_NUM ||
+            hcans[record->bus] == NULL)
+            continue;
+
+        if (realtime)
         {
-            CAN_ERROR_HANDLER();
-            return;
+            if (!started)
+            {
+                first   = record->timestamp;
+                started = true;
+            }
+            // 与第一条记录的时间差，用无符号减法处理时间戳回绕
+            const uint32_t target = record->timestamp - first;
+            while ((int32_t) (target - elapsed) > 0)
+            {
+                const uint32_t now = CAN_Trace_GetTimestamp();
+                elapsed += now - last;
+                last = now;
+            }
         }
-        maps[map_size] = (CAN_CallbackMap){
-            .hcan      = hcan,
-            .callbacks = {NULL}};
-        callbacks = maps[map_size].callbacks;
-        map_size++;
+
+        CAN_Frame_t frame = {
+            .id  = record->id & CAN_TRACE_ID_MASK,
+            .ide = (uint8_t) (record->id & CAN_TRACE_FLAG_EXT ? CAN_ID_EXT : CAN_ID_STD),
+            .rtr = (uint8_t) (record->id & CAN_TRACE_FLAG_RTR ? CAN_RTR_REMOTE : CAN_RTR_DATA),
+            .dlc = record->dlc > 8 ? 8 : record->dlc,
+            .fmi = record->fmi,
+        };
+        memcpy(frame.data, record->data, sizeof(frame.data));
+        frame.timestamp = DWT->CYCCNT;
+        if (can_inject(hcans[record->bus], &frame))
+            handled++;
     }
+    return handled;
+}
 
-    callbacks[filter_match_index] = callback;
+/**
+ * 检查文件头后回放 CAN_Trace_Export 导出的文件，见 CAN_Trace_Replay
+ * @attention data 须按 4 字节对齐
+ * @param hcans 下标为记录中的总线编号，NULL 表示跳过该总线的记录
+ * @param data 文件内容
+ * @param size 文件的字节数
+ * @param realtime 是否按记录的时间间隔回放
+ * @return 被处理的帧数，文件头无效或文件被截断时进入 CAN_ERROR_HANDLER 并返回 0
+ */
+size_t CAN_Trace_ReplayFile(CAN_HandleTypeDef* const hcans[CAN_NUM],
+                            const void*              data,
+                            const size_t             size,
+                            const bool               realtime)
+{
+    const CAN_TraceRecord_t* records;
+    size_t                   count;
+    if (!CAN_Trace_ParseFile(data, size, &records, &count))
+    {
+        CAN_ERROR_HANDLER();
+        return 0;
+    }
+    return CAN_Trace_Replay(hcans, records, count, realtime);
 }
 
+#ifdef USE_CAN_TRACE
 /**
- * 取消注册 CAN Fifo 处理回调
+ * 清空记录缓冲区并开始记录
  *
- * @attention 本函数非线程安全，调用时请注意
- * @param hcan can handle
- * @param filter_match_index 需要取消注册对应的过滤器对应的 id
+ * 记录接收（CAN_ReadFrame、CAN_InjectFrame）和发送（CAN_SendMessage 入队成功）的帧，
+ * 缓冲区满后覆盖最旧的记录
  */
-void CAN_UnregisterCallback(CAN_HandleTypeDef* hcan, const uint32_t filter_match_index)
+void CAN_Trace_Start(void)
 {
-    CAN_FifoReceiveCallback_t* callbacks = get_callbacks(hcan);
-    if (callbacks != NULL)
-        callbacks[filter_match_index] = NULL;
+    dwt_init();
+    atomic_store_explicit(&trace_ring.enable, false, memory_order_relaxed);
+    CAN_TraceRing_Init(&trace_ring, trace_buffer, CAN_TRACE_SIZE);
+}
+
+/**
+ * 停止记录，缓冲区内容保留，可以用 CAN_Trace_Export 导出
+ */
+void CAN_Trace_Stop(void)
+{
+    atomic_store_explicit(&trace_ring.enable, false, memory_order_release);
+}
+
+/**
+ * 按时间顺序导出为文件（CAN_TraceHeader_t 加记录），可以用 CAN_Trace_ReplayFile 回放
+ * @attention 应先调用 CAN_Trace_Stop，out 须按 4 字节对齐
+ * @param out 输出
+ * @param size out 的字节数，不足时只导出最新的记录
+ * @return 写入的字节数
+ */
+size_t CAN_Trace_Export(void* out, const size_t size)
+{
+    return CAN_TraceRing_ExportFile(&trace_ring, out, size);
 }
+#endif
 
 /**
  * CAN Fifo0 接收处理函数
  *
- * 本函数将会根据 hcan 和 rx_header 内部的 filter_id 来调用对应的回调函数
+ * 本函数一次中断内读空 FIFO，优先按路由表分发，其次根据 hcan 和 rx_header 内部的 filter_id
+ * 来调用对应的回调函数
  * @param hcan can handle
  */
 void CAN_Fifo0ReceiveCallback(CAN_HandleTypeDef* hcan)
 {
-    CAN_RxHeaderTypeDef header;
-    uint8_t data[8];
-    if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &header, data) != HAL_OK)
-    {
-        CAN_ERROR_HANDLER();
-        return;
-    }
-    const CAN_FifoReceiveCallback_t* callbacks = get_callbacks(hcan);
-    if (callbacks != NULL && callbacks[header.FilterMatchIndex] != NULL)
-        callbacks[header.FilterMatchIndex](hcan, &header, data);
+    can_fifo_receive(hcan, CAN_RX_FIFO0);
 }
 
 /**
  * CAN Fifo1 接收处理函数
  *
- * 本函数将会根据 hcan 和 rx_header 内部的 filter_id 来调用对应的回调函数
+ * 本函数一次中断内读空 FIFO，优先按路由表分发，其次根据 hcan 和 rx_header 内部的 filter_id
+ * 来调用对应的回调函数
  * @param hcan can handle
  */
 void CAN_Fifo1ReceiveCallback(CAN_HandleTypeDef* hcan)
 {
-    CAN_RxHeaderTypeDef header;
-    uint8_t data[8];
-    if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO1, &header, data) != HAL_OK)
-    {
-        CAN_ERROR_HANDLER();
-        return;
-    }
-    const CAN_FifoReceiveCallback_t* callbacks = get_callbacks(hcan);
-    if (callbacks != NULL && callbacks[header.FilterMatchIndex] != NULL)
-        callbacks[header.FilterMatchIndex](hcan, &header, data);
+    can_fifo_receive(hcan, CAN_RX_FIFO1);
 }
 
 #ifdef __cplusplus
@@ -6,6 +6,26 @@
  *
  * 本驱动是对 HAL 库的一层简要封装
  *
+ * 发送：每条总线一个无锁发送队列，有空闲邮箱时立即发送，否则在发送邮箱空中断中继续发送，
+ *      任务和中断中均可调用 CAN_SendMessage，不会阻塞
+ *      队列按入队顺序写入邮箱，但 3 个邮箱之间的发送顺序由 bxCAN 决定：默认 (TXFP = 0) 按标识符
+ *      优先级，标识符相同时按邮箱编号，因此同一总线上相邻的至多 3 帧可能乱序。同一 ID 的帧
+ *      需要保持顺序时（例如 DM 的使能帧和随后的指令帧）应在 CubeMX 中开启
+ *      Transmit Fifo Priority，邮箱按请求顺序发送
+ * 接收：每次中断读空整个 FIFO，并统计 FIFO 溢出次数
+ *      帧先按 (IDE, ID) 查路由表 (O(1))，查不到再按 FilterMatchIndex 调用注册的回调，
+ *      因此不同类型的电机可以共用同一条总线和同一个 FIFO
+ * 过滤器：CAN_ConfigFilters 根据路由表中注册的 ID 自动打包硬件过滤器
+ * 定义 USE_CAN_FAST_PATH 后收发直接读写寄存器，跳过 HAL 的状态检查和 header 转换
+ * 定义 USE_CAN_SIM 后不访问 CAN 硬件，收发都经过虚拟总线，用于无硬件仿真 (drivers/motor_sim.h)
+ * 定义 USE_CAN_DEFERRED_RX 后接收中断只把帧放入队列，由 CAN_DeferredRx_Start 创建的解码任务分发，
+ *      缩短接收中断的执行时间（需要 CMSIS-RTOS2）
+ * 定义 USE_CAN_TRACE 后收发的帧记录到 RAM 环形缓冲区，CAN_Trace_Export 导出为带文件头的文件，
+ *      由 CAN_Trace_ReplayFile 检查文件头后回放到驱动的解码函数中；
+ *      candump 日志经 CAN_Trace_ParseCandump 转换后通过 CAN_Trace_Replay 回放
+ * 负载：收发的每一帧按最坏情况位填充计入所在总线，周期调用 CAN_UpdateBusLoad 得到负载率；
+ *      各驱动注册电机时通过 CAN_ReserveBandwidth 声明反馈和指令帧率，超出预算时告警或拒绝
+ *
  * --------------------------------------------------------------------------
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -25,17 +45,112 @@
 #ifndef CAN_H
 #define CAN_H
 
+#include <stdbool.h>
+#include "libs/can_trace.h"
 #include "main.h"
 
 #define CAN_ERROR_HANDLER() Error_Handler()
+#define CAN_SEND_QUEUED     (0x0000) ///< 邮箱已满，帧在发送队列中等待邮箱空中断
+#define CAN_SEND_SUPPRESSED (0x0100) ///< 与上一帧相同，被 CAN_SendMessageCached 省略
 #define CAN_SEND_FAILED     (0xFFFF)
-#define CAN_SEND_TIMEOUT    (10)
+
+// 启用后收发直接读写 bxCAN 寄存器，绕过 HAL_CAN_GetRxMessage / HAL_CAN_AddTxMessage
+// #define USE_CAN_FAST_PATH
+
+// 启用后不访问 CAN 硬件：发送的帧交给 CAN_SetSimTxHook 注册的虚拟总线，接收由 CAN_InjectFrame 注入
+// #define USE_CAN_SIM
+
+// 启用后在 RTOS 任务中解码接收到的帧，见 CAN_DeferredRx_Start
+// #define USE_CAN_DEFERRED_RX
+
+// 启用后记录收发的帧，见 CAN_Trace_Start
+// #define USE_CAN_TRACE
+
+// 启用后注册电机时总线带宽超出预算直接进入 CAN_ERROR_HANDLER，否则只计入 over_budget
+// #define CAN_LOAD_ADMISSION_STRICT
+
+#ifndef CAN_TX_QUEUE_SIZE
+/**
+ * 每条 CAN 总线的发送队列长度，必须为 2 的幂
+ */
+#    define CAN_TX_QUEUE_SIZE (32)
+#endif
+
+#ifndef CAN_ROUTER_SIZE
+/**
+ * 每条 CAN 总线的路由表容量，必须为 2 的幂，建议不低于实际注册 ID 数的 2 倍
+ */
+#    define CAN_ROUTER_SIZE (128)
+#endif
+
+#ifndef CAN_RX_QUEUE_SIZE
+/**
+ * USE_CAN_DEFERRED_RX 时每条总线每个 FIFO 的接收队列长度，必须为 2 的幂
+ */
+#    define CAN_RX_QUEUE_SIZE (64)
+#endif
+
+#ifndef CAN_RX_TASK_PRIORITY
+/**
+ * USE_CAN_DEFERRED_RX 时解码任务的优先级，应高于控制任务
+ */
+#    define CAN_RX_TASK_PRIORITY (osPriorityRealtime)
+#endif
+
+#ifndef CAN_RX_TASK_STACK_SIZE
+/**
+ * USE_CAN_DEFERRED_RX 时解码任务的栈大小 (unit: byte)
+ */
+#    define CAN_RX_TASK_STACK_SIZE (512)
+#endif
+
+#ifndef CAN_TRACE_SIZE
+/**
+ * 记录缓冲区容量（所有总线共用），必须为 2 的幂，每条记录 20 字节
+ */
+#    define CAN_TRACE_SIZE (256)
+#endif
+
+#ifndef CAN_LOAD_WINDOW_MS
+/**
+ * 负载统计窗口长度 (unit: ms)
+ */
+#    define CAN_LOAD_WINDOW_MS (10U)
+#endif
+
+#ifndef CAN_LOAD_HISTORY
+/**
+ * 平均负载率统计的窗口数，默认为最近 500 ms
+ */
+#    define CAN_LOAD_HISTORY (50U)
+#endif
+
+#ifndef CAN_LOAD_BUDGET_PERCENT
+/**
+ * 总线带宽预算 (unit: %)，CAN_ReserveBandwidth 声明的带宽之和不应超过波特率的该比例
+ */
+#    define CAN_LOAD_BUDGET_PERCENT (80U)
+#endif
+
+#ifndef CAN_DEFAULT_BITRATE
+/**
+ * 无法从寄存器计算波特率时（仿真）使用的波特率 (unit: bit/s)
+ */
+#    define CAN_DEFAULT_BITRATE (1000000U)
+#endif
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 #define CAN_NUM (2)
+/**
+ * 按 FilterMatchIndex 注册的回调数量
+ *
+ * 掩码模式下每个过滤器组占 1 ~ 2 个编号，28 个足够；列表模式下一个 16 位过滤器组占 4 个编号，
+ * FilterMatchIndex 最大可到 111，超出本范围的编号不能注册回调，收到时按未处理计数
+ */
+#define CAN_CALLBACK_NUM (28)
 
     typedef void (*CAN_FifoReceiveCallback_t)(CAN_HandleTypeDef*   hcan,
                                               CAN_RxHeaderTypeDef* header,
@@ -44,22 +159,264 @@ extern "C"
     typedef struct
     {
         CAN_HandleTypeDef*        hcan;
-        CAN_FifoReceiveCallback_t callbacks[28];
+        CAN_FifoReceiveCallback_t callbacks[CAN_CALLBACK_NUM];
     } CAN_CallbackMap;
 
+    /**
+     * 发送队列统计信息
+     */
+    typedef struct
+    {
+        uint32_t depth;      ///< 当前队列中等待发送的帧数
+        uint32_t high_water; ///< 队列深度历史最大值
+        uint32_t overflow;   ///< 队列满导致发送失败的帧数
+    } CAN_TxQueueStats_t;
+
+    /**
+     * 接收统计信息，下标为 FIFO 编号
+     */
+    typedef struct
+    {
+        uint32_t frames[2];           ///< 接收帧数
+        uint32_t irqs[2];             ///< 接收中断次数
+        uint32_t max_batch[2];        ///< 单次中断读取的最大帧数
+        uint32_t overrun[2];          ///< FIFO 溢出（丢帧）次数
+        uint32_t unhandled[2];        ///< 没有路由也没有回调处理的帧数
+        uint32_t isr_cycles_max[2];   ///< CAN_FifoxReceiveCallback 单次最长耗时 (unit: cycles)
+        uint32_t queue_high_water[2]; ///< 接收队列深度历史最大值，仅 USE_CAN_DEFERRED_RX
+        uint32_t queue_overflow[2];   ///< 接收队列满导致丢弃的帧数，仅 USE_CAN_DEFERRED_RX
+    } CAN_RxStats_t;
+
+    /**
+     * 总线负载统计，负载率为总线占用时间的比例 (0 ~ 1)
+     */
+    typedef struct
+    {
+        uint32_t bitrate;     ///< 波特率 (unit: bit/s)
+        float    load;        ///< 最近一个窗口的负载率
+        float    average;     ///< 最近 CAN_LOAD_HISTORY 个窗口的平均负载率
+        float    peak;        ///< 单个窗口负载率的历史最大值
+        uint32_t windows;     ///< 已统计的窗口数
+        uint32_t reserved;    ///< 注册时声明并被接受的带宽之和 (unit: bit/s)
+        uint32_t over_budget; ///< 因超出 CAN_LOAD_BUDGET_PERCENT 被拒绝的声明次数
+    } CAN_BusLoad_t;
+
+    /**
+     * 紧凑 CAN 帧 (20 字节)
+     *
+     * 用于接收队列和寄存器快速路径，data 与 RDLR/RDHR、TDLR/TDHR 的内存布局一致。
+     * 发送队列的槽位只保存 id、ide、rtr、dlc 和 data
+     */
+    typedef struct
+    {
+        uint32_t id;  ///< StdId 或 ExtId，由 ide 决定
+        uint8_t  ide; ///< CAN_ID_STD / CAN_ID_EXT
+        uint8_t  rtr; ///< CAN_RTR_DATA / CAN_RTR_REMOTE
+        uint8_t  dlc; ///< 数据长度
+        uint8_t  fmi; ///< 接收时匹配的过滤器编号 (FilterMatchIndex)
+        union
+        {
+            uint8_t  data[8];
+            uint32_t word[2];
+        };
+        uint32_t timestamp; ///< 从 FIFO 读出（或注入）时的 DWT 周期计数，发送时不使用
+    } CAN_Frame_t;
+
+    /**
+     * 帧解码函数
+     * @param handle 注册路由时传入的句柄（通常是电机句柄）
+     * @param frame 接收到的帧
+     */
+    typedef void (*CAN_FrameDecoder_t)(void* handle, const CAN_Frame_t* frame);
+
+    /**
+     * 发送钩子
+     * @param hcan 发送使用的 can handle
+     * @param frame 发送的帧
+     */
+    typedef void (*CAN_TxHook_t)(CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame);
+
+    /**
+     * 逐帧接收回调，见 CAN_DrainFifo
+     * @param hcan 接收的 can handle
+     * @param frame 接收到的帧
+     */
+    typedef void (*CAN_FrameCallback_t)(const CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame);
+
+    /**
+     * 发送缓存，记录上一次发出的帧
+     *
+     * 用于周期性发送的指令帧：编码后的内容与上一帧相同且未到保活时间时不再发送
+     */
+    typedef struct
+    {
+        CAN_Frame_t frame;      ///< 上一次发出的帧
+        bool        valid;      ///< frame 是否有效
+        uint32_t    tick;       ///< 上一次发出的时间 (unit: ms)
+        uint32_t    timestamp;  ///< 上一次写入邮箱或入队时的 DWT 周期计数，用于测量指令延迟
+        uint32_t    keepalive;  ///< 保活间隔 (unit: ms)，0 表示每次都发送
+        uint32_t    sent;       ///< 发出的帧数
+        uint32_t    suppressed; ///< 因内容未变化而省略的帧数
+    } CAN_TxCache_t;
+
     // TODO: 增加更完善的错误返回逻辑
 
     uint32_t CAN_SendMessage(CAN_HandleTypeDef*         hcan,
                              const CAN_TxHeaderTypeDef* header,
                              const uint8_t              data[]);
     void     CAN_Start(CAN_HandleTypeDef* hcan, uint32_t ActiveITs);
+    void     CAN_GetTxQueueStats(const CAN_HandleTypeDef* hcan, CAN_TxQueueStats_t* stats);
+    void     CAN_ResetTxQueueStats(const CAN_HandleTypeDef* hcan);
+    uint32_t CAN_SendMessageCached(CAN_TxCache_t*             cache,
+                                   CAN_HandleTypeDef*         hcan,
+                                   const CAN_TxHeaderTypeDef* header,
+                                   const uint8_t              data[]);
+    void     CAN_TxCache_Init(CAN_TxCache_t* cache, uint32_t keepalive_ms);
+    void     CAN_TxCache_Invalidate(CAN_TxCache_t* cache);
+    void     CAN_TxHold(const CAN_HandleTypeDef* hcan);
+    void     CAN_TxRelease(const CAN_HandleTypeDef* hcan);
+
+    CAN_HandleTypeDef* CAN_GetHandle(const CAN_TypeDef* instance);
 
     void CAN_RegisterCallback(CAN_HandleTypeDef*        hcan,
                               uint32_t                  filter_match_index,
                               CAN_FifoReceiveCallback_t callback);
     void CAN_UnregisterCallback(CAN_HandleTypeDef* hcan, uint32_t filter_match_index);
+    void CAN_RegisterRoute(CAN_HandleTypeDef* hcan,
+                           uint32_t           ide,
+                           uint32_t           id,
+                           CAN_FrameDecoder_t decoder,
+                           void*              handle);
+    void CAN_ConfigFilters(uint32_t fifo);
     void CAN_Fifo0ReceiveCallback(CAN_HandleTypeDef* hcan);
     void CAN_Fifo1ReceiveCallback(CAN_HandleTypeDef* hcan);
+    bool CAN_ReadFrame(CAN_HandleTypeDef* hcan, uint32_t fifo, CAN_Frame_t* frame);
+    void CAN_DrainFifo(CAN_HandleTypeDef* hcan, uint32_t fifo, CAN_FrameCallback_t callback);
+    bool CAN_TakeRxOverrun(CAN_HandleTypeDef* hcan, uint32_t fifo);
+    void CAN_UpdateRxStats(const CAN_HandleTypeDef* hcan,
+                           uint32_t                 fifo,
+                           uint32_t                 batch,
+                           bool                     overrun);
+    void CAN_GetRxStats(const CAN_HandleTypeDef* hcan, CAN_RxStats_t* stats);
+    void CAN_ResetRxStats(const CAN_HandleTypeDef* hcan);
+    bool CAN_InjectFrame(CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame);
+    void CAN_UpdateBusLoad(void);
+    void CAN_GetBusLoad(const CAN_HandleTypeDef* hcan, CAN_BusLoad_t* load);
+    void CAN_ResetBusLoad(const CAN_HandleTypeDef* hcan);
+    bool CAN_ReserveBandwidth(CAN_HandleTypeDef* hcan,
+                              uint32_t           ide,
+                              uint32_t           dlc,
+                              uint32_t           rate_hz);
+#ifdef USE_CAN_SIM
+    void CAN_SetSimTxHook(CAN_TxHook_t hook);
+#endif
+#ifdef USE_CAN_DEFERRED_RX
+    void CAN_DeferredRx_Start(void);
+#endif
+
+    uint32_t CAN_Trace_GetTimestamp(void);
+    size_t   CAN_Trace_Replay(CAN_HandleTypeDef* const hcans[CAN_NUM],
+                              const CAN_TraceRecord_t*  records,
+                              size_t                    count,
+                              bool                      realtime);
+    size_t   CAN_Trace_ReplayFile(CAN_HandleTypeDef* const hcans[CAN_NUM],
+                                  const void*               data,
+                                  size_t                    size,
+                                  bool                      realtime);
+#ifdef USE_CAN_TRACE
+    void   CAN_Trace_Start(void);
+    void   CAN_Trace_Stop(void);
+    size_t CAN_Trace_Export(void* out, size_t size);
+#endif
+
+    /**
+     * 一帧在总线上占用的位数，按最坏情况的位填充计算，含 3 位帧间隔
+     *
+     * 标准帧为 8n + 47 + (8n + 33) / 4，扩展帧为 8n + 67 + (8n + 53) / 4，
+     * 8 字节数据帧分别为 135 位和 160 位
+     * @param ide CAN_ID_STD / CAN_ID_EXT
+     * @param rtr CAN_RTR_DATA / CAN_RTR_REMOTE
+     * @param dlc 数据长度
+     */
+    static inline uint32_t CAN_FrameBits(const uint32_t ide, const uint32_t rtr, const uint32_t dlc)
+    {
+        const uint32_t n = rtr == CAN_RTR_REMOTE ? 0 : (dlc > 8 ? 8 : dlc) * 8;
+        return ide == CAN_ID_STD ? n + 47 + (n + 33) / 4 : n + 67 + (n + 53) / 4;
+    }
+
+    /* 寄存器快速路径 */
+
+    /**
+     * 获取 FIFO 中待读取的帧数
+     * @param can CAN 实例
+     * @param fifo CAN_RX_FIFO0 或 CAN_RX_FIFO1
+     */
+    static inline uint32_t CAN_RxFifoFillLevelFast(const CAN_TypeDef* can, const uint32_t fifo)
+    {
+        return (fifo == CAN_RX_FIFO0 ? can->RF0R : can->RF1R) & CAN_RF0R_FMP0;
+    }
+
+    /**
+     * 直接从 FIFO 邮箱寄存器读取一帧并释放邮箱
+     * @attention 调用前必须确认 FIFO 非空，本函数不做 HAL 状态检查
+     * @param can CAN 实例
+     * @param fifo CAN_RX_FIFO0 或 CAN_RX_FIFO1
+     * @param frame 输出帧
+     */
+    static inline void CAN_ReadRxFifoFast(CAN_TypeDef* can, const uint32_t fifo, CAN_Frame_t* frame)
+    {
+        const CAN_FIFOMailBox_TypeDef* mb   = &can->sFIFOMailBox[fifo];
+        const uint32_t                 rir  = mb->RIR;
+        const uint32_t                 rdtr = mb->RDTR;
+
+        frame->ide     = (uint8_t) (rir & CAN_RI0R_IDE); // 与 CAN_ID_EXT 数值一致
+        frame->rtr     = (uint8_t) (rir & CAN_RI0R_RTR); // 与 CAN_RTR_REMOTE 数值一致
+        frame->id      = frame->ide ? rir >> CAN_RI0R_EXID_Pos : rir >> CAN_RI0R_STID_Pos;
+        frame->dlc     = (uint8_t) (rdtr & CAN_RDT0R_DLC);
+        frame->fmi     = (uint8_t) (rdtr >> CAN_RDT0R_FMI_Pos);
+        frame->word[0] = mb->RDLR;
+        frame->word[1] = mb->RDHR;
+
+        // 只写 RFOM，不能用读-改-写，否则会把 FOVR 等写 1 清除的标志一起清掉
+        if (fifo == CAN_RX_FIFO0)
+            can->RF0R = CAN_RF0R_RFOM0;
+        else
+            can->RF1R = CAN_RF1R_RFOM1;
+    }
+
+    /**
+     * 是否有空闲发送邮箱
+     * @param can CAN 实例
+     */
+    static inline bool CAN_TxMailboxFreeFast(const CAN_TypeDef* can)
+    {
+        return (can->TSR & CAN_TSR_TME) != 0;
+    }
+
+    /**
+     * 直接写入空闲发送邮箱并请求发送
+     * @param can CAN 实例
+     * @param frame 待发送帧
+     * @return 写入的邮箱 (CAN_TX_MAILBOX0 ~ CAN_TX_MAILBOX2)，没有空闲邮箱时返回 0
+     */
+    static inline uint32_t CAN_WriteTxMailboxFast(CAN_TypeDef* can, const CAN_Frame_t* frame)
+    {
+        const uint32_t tsr = can->TSR;
+        if ((tsr & CAN_TSR_TME) == 0)
+            return 0;
+
+        const uint32_t         code = (tsr & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+        CAN_TxMailBox_TypeDef* mb   = &can->sTxMailBox[code];
+
+        mb->TDTR = frame->dlc;
+        mb->TDLR = frame->word[0];
+        mb->TDHR = frame->word[1];
+        // 标识符与 TXRQ 一次写入
+        mb->TIR = (frame->ide == CAN_ID_STD ? frame->id << CAN_TI0R_STID_Pos
+                                            : frame->id << CAN_TI0R_EXID_Pos) |
+                  frame->ide | frame->rtr | CAN_TI0R_TXRQ;
+        return CAN_TX_MAILBOX0 << code;
+    }
 
 #ifdef __cplusplus
 }
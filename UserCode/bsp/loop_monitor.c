@@ -0,0 +1,109 @@
+/**
+ * @file    loop_monitor.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "loop_monitor.h"
+#include <stdio.h>
+
+/**
+ * 初始化监视器
+ *
+ * 会启用 DWT 周期计数器
+ * @param monitor 监视器
+ * @param name 监视项名称
+ * @param period_us 期望周期 (unit: us)，0 表示不统计抖动、超时和丢失
+ * @param stage_names 各阶段名称，可以为 NULL（不分阶段）
+ * @param stage_count 阶段数，超过 LOOP_MONITOR_STAGES 的部分不记录
+ */
+void LoopMonitor_Init(LoopMonitor_t*    monitor,
+                      const char*       name,
+                      const uint32_t    period_us,
+                      const char* const stage_names[],
+                      const uint32_t    stage_count)
+{
+    PerfCounter_Init();
+    monitor->name          = name;
+    monitor->period_cycles = (uint32_t) ((uint64_t) period_us * SystemCoreClock / 1000000U);
+    monitor->stage_count   = stage_count < LOOP_MONITOR_STAGES ? stage_count : LOOP_MONITOR_STAGES;
+    PerfCounter_Reset(&monitor->exec, "exec");
+    PerfCounter_Reset(&monitor->period, "period");
+    for (uint32_t i = 0; i < LOOP_MONITOR_STAGES; i++)
+        PerfCounter_Reset(&monitor->stages[i],
+                          stage_names != NULL && i < monitor->stage_count ? stage_names[i] : "");
+    LoopMonitor_Reset(monitor);
+}
+
+/**
+ * 清零统计数据，保留名称、周期和阶段设置
+ * @attention 不应在 Begin 和 End 之间调用
+ * @param monitor 监视器
+ */
+void LoopMonitor_Reset(LoopMonitor_t* monitor)
+{
+    PerfCounter_Reset(&monitor->exec, monitor->exec.name);
+    PerfCounter_Reset(&monitor->period, monitor->period.name);
+    for (uint32_t i = 0; i < LOOP_MONITOR_STAGES; i++)
+        PerfCounter_Reset(&monitor->stages[i], monitor->stages[i].name);
+    monitor->jitter_max = 0;
+    monitor->overruns   = 0;
+    monitor->missed     = 0;
+    monitor->running    = false;
+    monitor->started    = false;
+    monitor->stage      = 0;
+}
+
+/**
+ * 以 CSV 格式输出统计结果
+ *
+ * 第一段表头为 name,ticks,overruns,missed,period_ns,jitter_max_ns，
+ * 第二段与 PerfCounter_FormatCsv 相同，依次为 exec、period 和各阶段
+ * @param monitor 监视器
+ * @param buf 输出缓冲区
+ * @param len 缓冲区长度
+ * @return 写入的字符数（不含结尾的 '\0'），缓冲区不足时截断
+ */
+size_t LoopMonitor_FormatCsv(const LoopMonitor_t* monitor, char* buf, const size_t len)
+{
+    if (len == 0)
+        return 0;
+
+    const int ret = snprintf(buf, len, "name,ticks,overruns,missed,period_ns,jitter_max_ns\n"
+                                       "%s,%lu,%lu,%lu,%lu,%lu\n",
+                             monitor->name ? monitor->name : "",
+                             (unsigned long) monitor->exec.count,
+                             (unsigned long) monitor->overruns,
+                             (unsigned long) monitor->missed,
+                             (unsigned long) PerfCounter_CyclesToNs(monitor->period_cycles),
+                             (unsigned long) PerfCounter_CyclesToNs(monitor->jitter_max));
+    if (ret < 0)
+        return 0;
+    if ((size_t) ret >= len)
+        return len - 1;
+
+    PerfCounter_t counters[2 + LOOP_MONITOR_STAGES];
+    counters[0] = monitor->exec;
+    counters[1] = monitor->period;
+    for (uint32_t i = 0; i < monitor->stage_count; i++)
+        counters[2 + i] = monitor->stages[i];
+    return (size_t) ret + PerfCounter_FormatCsv(counters,
+                                                2 + monitor->stage_count,
+                                                buf + ret,
+                                                len - (size_t) ret);
+}
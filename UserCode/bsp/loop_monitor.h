@@ -0,0 +1,150 @@
+/**
+ * @file    loop_monitor.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   period, jitter and overrun monitor for fixed-rate control loops
+ *
+ * 在控制周期回调（定时器中断或控制任务）的首尾调用 LoopMonitor_Begin / LoopMonitor_End，
+ * 记录执行时间、实际周期（相邻两次 Begin 的间隔）、周期抖动、超时和丢失的周期数；
+ * 在中间调用 LoopMonitor_Mark 可以把一次执行拆分为若干阶段分别计时。
+ * 全部数据保存在 LoopMonitor_t 中，可以直接在调试器中查看，也可以用 LoopMonitor_FormatCsv 输出。
+ *
+ * 使用方法：
+ *   static const char* const stages[] = { "update", "send" };
+ *   LoopMonitor_Init(&monitor, "control", 1000, stages, 2); // 1 ms 周期
+ *
+ *   LoopMonitor_Begin(&monitor);
+ *   Motor_PosCtrlUpdate(&pos);
+ *   LoopMonitor_Mark(&monitor);                             // 结束 update 阶段
+ *   DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_1_4);
+ *   LoopMonitor_Mark(&monitor);                             // 结束 send 阶段
+ *   LoopMonitor_End(&monitor);
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef LOOP_MONITOR_H
+#define LOOP_MONITOR_H
+
+#include <stdbool.h>
+#include "bsp/perf_counter.h"
+
+#ifndef LOOP_MONITOR_STAGES
+/**
+ * 每个监视器最多记录的阶段数
+ */
+#    define LOOP_MONITOR_STAGES (4U)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct
+{
+    const char* name;          ///< 监视项名称，输出 CSV 时使用
+    uint32_t    period_cycles; ///< 期望周期 (unit: cycles)
+
+    PerfCounter_t exec;       ///< 单次执行时间
+    PerfCounter_t period;     ///< 实际周期
+    uint32_t      jitter_max; ///< 实际周期与期望周期之差的最大绝对值 (unit: cycles)
+    uint32_t      overruns;   ///< 执行时间超过周期，或上一次还没结束就再次进入的次数
+    uint32_t      missed;     ///< 按实际周期推算丢失的周期数
+
+    PerfCounter_t stages[LOOP_MONITOR_STAGES]; ///< 各阶段执行时间
+    uint32_t      stage_count;                 ///< 阶段数
+
+    volatile bool running;     ///< 是否在 Begin 和 End 之间
+    bool          started;     ///< 是否调用过 Begin
+    uint32_t      last_start;  ///< 上一次 Begin 的时间
+    uint32_t      stage;       ///< 当前阶段
+    uint32_t      stage_start; ///< 当前阶段开始时间
+} LoopMonitor_t;
+
+void   LoopMonitor_Init(LoopMonitor_t*    monitor,
+                        const char*       name,
+                        uint32_t          period_us,
+                        const char* const stage_names[],
+                        uint32_t          stage_count);
+void   LoopMonitor_Reset(LoopMonitor_t* monitor);
+size_t LoopMonitor_FormatCsv(const LoopMonitor_t* monitor, char* buf, size_t len);
+
+/**
+ * 一个周期开始，应在回调的第一条语句调用
+ * @param monitor 监视器
+ */
+static inline void LoopMonitor_Begin(LoopMonitor_t* monitor)
+{
+    const uint32_t now = PerfCounter_Now();
+    // 在任务中调用时，上一次还没执行完又被触发
+    if (monitor->running)
+        monitor->overruns++;
+    monitor->running = true;
+
+    if (monitor->started)
+    {
+        const uint32_t period   = now - monitor->last_start;
+        const uint32_t expected = monitor->period_cycles;
+        PerfCounter_Record(&monitor->period, period);
+        if (expected != 0)
+        {
+            const uint32_t deviation = period > expected ? period - expected : expected - period;
+            if (deviation > monitor->jitter_max)
+                monitor->jitter_max = deviation;
+            // 超过 1.5 个周期才认为丢失，四舍五入
+            if (period > expected + expected / 2)
+                monitor->missed += (period + expected / 2) / expected - 1;
+        }
+    }
+    monitor->started     = true;
+    monitor->last_start  = now;
+    monitor->stage       = 0;
+    monitor->stage_start = now;
+}
+
+/**
+ * 结束当前阶段并开始下一阶段
+ * @param monitor 监视器
+ */
+static inline void LoopMonitor_Mark(LoopMonitor_t* monitor)
+{
+    const uint32_t now = PerfCounter_Now();
+    if (monitor->stage < monitor->stage_count)
+        PerfCounter_Record(&monitor->stages[monitor->stage], now - monitor->stage_start);
+    monitor->stage++;
+    monitor->stage_start = now;
+}
+
+/**
+ * 一个周期结束，应在回调的最后一条语句调用
+ * @param monitor 监视器
+ */
+static inline void LoopMonitor_End(LoopMonitor_t* monitor)
+{
+    const uint32_t exec = PerfCounter_Now() - monitor->last_start;
+    PerfCounter_Record(&monitor->exec, exec);
+    // 执行时间超过周期时，下一次触发时本次还在执行
+    if (monitor->period_cycles != 0 && exec > monitor->period_cycles)
+        monitor->overruns++;
+    monitor->running = false;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOOP_MONITOR_H
@@ -0,0 +1,164 @@
+/**
+ * @file    perf_counter.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "perf_counter.h"
+#include <stdio.h>
+
+/**
+ * 启用 DWT 周期计数器，USE_PERF_CLOCK_GETTIME 时无需初始化
+ */
+void PerfCounter_Init(void)
+{
+#ifndef USE_PERF_CLOCK_GETTIME
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+ * 清空计数器
+ * @param counter 计数器
+ * @param name 测量项名称
+ */
+void PerfCounter_Reset(PerfCounter_t* counter, const char* name)
+{
+    counter->name  = name;
+    counter->count = 0;
+    counter->total = 0;
+    counter->min   = UINT32_MAX;
+    counter->max   = 0;
+}
+
+/**
+ * 以 CSV 格式输出测量结果
+ *
+ * 表头为 name,count,cycles_min,cycles_avg,cycles_max,ns_avg，每个计数器一行。
+ * 只使用整数格式化，newlib-nano 不开启浮点 printf 也可使用
+ * @param counters 计数器数组
+ * @param n 计数器个数
+ * @param buf 输出缓冲区
+ * @param len 缓冲区长度
+ * @return 写入的字符数（不含结尾的 '\0'），缓冲区不足时截断
+ */
+size_t PerfCounter_FormatCsv(const PerfCounter_t* counters,
+                             const size_t         n,
+                             char*                buf,
+                             const size_t         len)
+{
+    if (len == 0)
+        return 0;
+
+    size_t pos = 0;
+    int    ret = snprintf(buf, len, "name,count,cycles_min,cycles_avg,cycles_max,ns_avg\n");
+    for (size_t i = 0; ret >= 0 && i <= n; i++)
+    {
+        // 截断时 pos 停在缓冲区末尾的 '\0' 上
+        pos += (size_t) ret < len - pos ? (size_t) ret : len - pos - 1;
+        if (i == n || pos + 1 >= len)
+            break;
+
+        const PerfCounter_t* c   = &counters[i];
+        const uint32_t       avg = PerfCounter_Average(c);
+        ret = snprintf(buf + pos, len - pos, "%s,%lu,%lu,%lu,%lu,%lu\n", c->name ? c->name : "",
+                       (unsigned long) c->count, (unsigned long) (c->count ? c->min : 0),
+                       (unsigned long) avg, (unsigned long) c->max,
+                       (unsigned long) PerfCounter_CyclesToNs(avg));
+    }
+    return pos;
+}
+
+/**
+ * 清空直方图
+ * @param hist 直方图
+ * @param name 测量项名称
+ * @param bucket_ns 桶宽 (unit: ns)，至少为 1 个周期
+ */
+void PerfHistogram_Reset(PerfHistogram_t* hist, const char* name, const uint32_t bucket_ns)
+{
+    PerfCounter_Reset(&hist->summary, name);
+    const uint32_t cycles = (uint32_t) ((uint64_t) bucket_ns * SystemCoreClock / 1000000000ULL);
+    hist->bucket_cycles   = cycles ? cycles : 1;
+    for (size_t i = 0; i < PERF_HISTOGRAM_BUCKETS; i++)
+        hist->buckets[i] = 0;
+}
+
+/**
+ * 估计百分位数，返回所在桶的上界
+ * @param hist 直方图
+ * @param percent 百分位 (0 ~ 100)
+ * @return 百分位数的上界 (unit: cycles)，不超过最大值，没有测量时返回 0
+ */
+uint32_t PerfHistogram_Percentile(const PerfHistogram_t* hist, const uint32_t percent)
+{
+    const uint32_t count = hist->summary.count;
+    if (count == 0)
+        return 0;
+    // 向上取整，至少 1 个样本
+    const uint64_t target = ((uint64_t) count * percent + 99) / 100;
+    uint64_t       seen   = 0;
+    for (uint32_t i = 0; i < PERF_HISTOGRAM_BUCKETS - 1; i++)
+    {
+        seen += hist->buckets[i];
+        if (seen >= target && seen > 0)
+        {
+            const uint32_t upper = (i + 1) * hist->bucket_cycles;
+            return upper < hist->summary.max ? upper : hist->summary.max;
+        }
+    }
+    return hist->summary.max;
+}
+
+/**
+ * 以 CSV 格式输出直方图
+ *
+ * 表头为 name,bucket_ns_lo,bucket_ns_hi,count，每个桶一行，最后一个桶的上界为最大值
+ * @param hist 直方图
+ * @param buf 输出缓冲区
+ * @param len 缓冲区长度
+ * @return 写入的字符数（不含结尾的 '\0'），缓冲区不足时截断
+ */
+size_t PerfHistogram_FormatCsv(const PerfHistogram_t* hist, char* buf, const size_t len)
+{
+    if (len == 0)
+        return 0;
+
+    const char* name = hist->summary.name ? hist->summary.name : "";
+    size_t      pos  = 0;
+    int         ret  = snprintf(buf, len, "name,bucket_ns_lo,bucket_ns_hi,count\n");
+    for (uint32_t i = 0; ret >= 0 && i <= PERF_HISTOGRAM_BUCKETS; i++)
+    {
+        // 截断时 pos 停在缓冲区末尾的 '\0' 上
+        pos += (size_t) ret < len - pos ? (size_t) ret : len - pos - 1;
+        if (i == PERF_HISTOGRAM_BUCKETS || pos + 1 >= len)
+            break;
+
+        const uint32_t lo = i * hist->bucket_cycles;
+        uint32_t       hi = lo + hist->bucket_cycles;
+        if (i == PERF_HISTOGRAM_BUCKETS - 1)
+            hi = hist->summary.max > lo ? hist->summary.max : lo;
+        ret = snprintf(buf + pos, len - pos, "%s,%lu,%lu,%lu\n", name,
+                       (unsigned long) PerfCounter_CyclesToNs(lo),
+                       (unsigned long) PerfCounter_CyclesToNs(hi),
+                       (unsigned long) hist->buckets[i]);
+    }
+    return pos;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file    perf_counter.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   基于 DWT CYCCNT 的周期计数器
+ *
+ * 用于测量热路径（解包、PID 计算、指令打包发送）每次调用消耗的 CPU 周期，
+ * 记录次数、最小、平均、最大周期数，并可输出为 CSV 便于对比回归。
+ * PerfHistogram_t 额外按固定宽度的桶统计分布，用于观察延迟的尾部。
+ *
+ * 使用方法：
+ *   PerfCounter_Init();                       // 启用 DWT 周期计数器，只需调用一次
+ *   PERF_MEASURE(&counter, DJI_DataDecode(&dji, data));
+ *
+ * 定义 USE_PERF_CLOCK_GETTIME 后改用 clock_gettime (CLOCK_MONOTONIC) 计时，用于主机构建，
+ * 时间按 SystemCoreClock 换算为等效周期数，其余接口不变
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef PERF_COUNTER_H
+#define PERF_COUNTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "main.h"
+
+// 启用后使用 clock_gettime 代替 DWT CYCCNT，用于主机构建
+// #define USE_PERF_CLOCK_GETTIME
+
+#ifdef USE_PERF_CLOCK_GETTIME
+#    include <time.h>
+#endif
+
+#ifndef PERF_HISTOGRAM_BUCKETS
+/**
+ * 直方图桶数，最后一个桶包含所有更大的值
+ */
+#    define PERF_HISTOGRAM_BUCKETS (16U)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct
+{
+    const char* name;  ///< 测量项名称，输出 CSV 时使用
+    uint32_t    count; ///< 测量次数
+    uint64_t    total; ///< 总周期数
+    uint32_t    min;   ///< 最小周期数
+    uint32_t    max;   ///< 最大周期数
+} PerfCounter_t;
+
+/**
+ * 固定桶宽的直方图
+ *
+ * 第 i 个桶统计 [i * bucket_cycles, (i + 1) * bucket_cycles) 内的测量值
+ */
+typedef struct
+{
+    PerfCounter_t summary;       ///< 次数、最小、平均、最大
+    uint32_t      bucket_cycles; ///< 桶宽 (unit: cycles)
+    uint32_t      buckets[PERF_HISTOGRAM_BUCKETS];
+} PerfHistogram_t;
+
+void     PerfCounter_Init(void);
+void     PerfCounter_Reset(PerfCounter_t* counter, const char* name);
+size_t   PerfCounter_FormatCsv(const PerfCounter_t* counters, size_t n, char* buf, size_t len);
+void     PerfHistogram_Reset(PerfHistogram_t* hist, const char* name, uint32_t bucket_ns);
+uint32_t PerfHistogram_Percentile(const PerfHistogram_t* hist, uint32_t percent);
+size_t   PerfHistogram_FormatCsv(const PerfHistogram_t* hist, char* buf, size_t len);
+
+/**
+ * 读取当前周期计数
+ */
+static inline uint32_t PerfCounter_Now(void)
+{
+#ifdef USE_PERF_CLOCK_GETTIME
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    // 与 CYCCNT 一样按 32 位回绕，差值仍然正确
+    return (uint32_t) ((uint64_t) ts.tv_sec * SystemCoreClock +
+                       (uint64_t) ts.tv_nsec * SystemCoreClock / 1000000000ULL);
+#else
+    return DWT->CYCCNT;
+#endif
+}
+
+/**
+ * 记录一次测量
+ * @param counter 计数器
+ * @param cycles 本次消耗的周期数
+ */
+static inline void PerfCounter_Record(PerfCounter_t* counter, const uint32_t cycles)
+{
+    counter->count++;
+    counter->total += cycles;
+    if (cycles < counter->min)
+        counter->min = cycles;
+    if (cycles > counter->max)
+        counter->max = cycles;
+}
+
+/**
+ * 平均周期数
+ */
+static inline uint32_t PerfCounter_Average(const PerfCounter_t* counter)
+{
+    return counter->count ? (uint32_t) (counter->total / counter->count) : 0;
+}
+
+/**
+ * 周期数换算为纳秒
+ */
+static inline uint32_t PerfCounter_CyclesToNs(const uint32_t cycles)
+{
+    return (uint32_t) ((uint64_t) cycles * 1000000000ULL / SystemCoreClock);
+}
+
+/**
+ * 向直方图记录一次测量
+ * @param hist 直方图
+ * @param cycles 测量值 (unit: cycles)
+ */
+static inline void PerfHistogram_Record(PerfHistogram_t* hist, const uint32_t cycles)
+{
+    const uint32_t index = cycles / hist->bucket_cycles;
+    hist->buckets[index < PERF_HISTOGRAM_BUCKETS ? index : PERF_HISTOGRAM_BUCKETS - 1]++;
+    PerfCounter_Record(&hist->summary, cycles);
+}
+
+/**
+ * 测量一条语句消耗的周期数
+ * @param __PERF_COUNTER__ PerfCounter_t*
+ * @param __STMT__ 被测语句
+ * @note 结果包含读取 CYCCNT 本身的开销（几个周期），对比时请以同一方式测得的基线为准
+ */
+#define PERF_MEASURE(__PERF_COUNTER__, __STMT__)                                                   \
+    do                                                                                             \
+    {                                                                                              \
+        const uint32_t __perf_start = PerfCounter_Now();                                           \
+        __STMT__;                                                                                  \
+        PerfCounter_Record((__PERF_COUNTER__), PerfCounter_Now() - __perf_start);                  \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PERF_COUNTER_H
@@ -28,6 +28,9 @@
 static DJI_FeedbackMap map[CAN_NUM];
 static size_t          map_size = 0;
 
+static void dji_route_decode(void* handle, const CAN_Frame_t* frame);
+static void dji_reset_angle(DJI_t* hdji);
+
 /**
  * 电机减速比 map
  */
@@ -36,11 +39,11 @@ static float reduction_rate_map[DJI_MOTOR_TYPE_COUNT] = {
     [M2006_C610] = (36.0f),
 };
 
-static inline DJI_t* getDJIHandle(DJI_t* motors[8], const CAN_RxHeaderTypeDef* header)
+static inline DJI_t* getDJIHandle(DJI_t* motors[8], const uint32_t ide, const uint32_t std_id)
 {
-    if (header->IDE != CAN_ID_STD)
+    if (ide != CAN_ID_STD)
         return NULL;
-    const uint8_t id0 = header->StdId - 0x201;
+    const uint8_t id0 = std_id - 0x201;
     // 不是 DJI 的反馈数据
     if (id0 >= 8)
         return NULL;
@@ -56,6 +59,7 @@ void DJI_Init(DJI_t* hdji, const DJI_Config_t* dji_config)
 {
     memset(hdji, 0, sizeof(DJI_t));
 
+    Seqlock_Init(&hdji->lock);
     hdji->enable             = true;
     hdji->reverse            = dji_config->reverse;
     hdji->auto_zero          = dji_config->auto_zero;
@@ -65,6 +69,13 @@ void DJI_Init(DJI_t* hdji, const DJI_Config_t* dji_config)
                                ((dji_config->reduction_rate > 0 ? dji_config->reduction_rate
                                                                 : 1.0f)        // 外接减速比
                                 * reduction_rate_map[dji_config->motor_type]); // 电机内部减速比
+    hdji->angle_per_tick  = 360.0f / DJI_TICKS_PER_ROUND * hdji->inv_reduction_rate;
+    hdji->feedback_hz     = dji_config->feedback_hz ? dji_config->feedback_hz : DJI_FEEDBACK_HZ;
+    hdji->feedback_period = SystemCoreClock / hdji->feedback_hz;
+
+    const uint64_t max_dt = (uint64_t) DJI_UNWRAP_MAX_PERIODS * hdji->feedback_period;
+    hdji->unwrap_max_dt   = max_dt < UINT32_MAX ? (uint32_t) max_dt : UINT32_MAX;
+    MultiTurn_Init(&hdji->turns, DJI_TICKS_PER_ROUND);
 
     /* 注册回调 */
     DJI_t** mapped_motors = NULL;
@@ -80,7 +91,9 @@ void DJI_Init(DJI_t* hdji, const DJI_Config_t* dji_config)
         mapped_motors = map[map_size].motors;
         map_size++;
     }
-    if (mapped_motors[hdji->id1 - 1] != NULL)
+    // 同一个 handle 重复初始化（重新配置）时不再重复注册和声明带宽
+    const bool reinit = mapped_motors[hdji->id1 - 1] == hdji;
+    if (mapped_motors[hdji->id1 - 1] != NULL && !reinit)
     {
         // 电调 ID 冲突
         DJI_ERROR_HANDLER();
@@ -89,6 +102,47 @@ void DJI_Init(DJI_t* hdji, const DJI_Config_t* dji_config)
     {
         mapped_motors[hdji->id1 - 1] = hdji;
     }
+
+    /* 注册路由，反馈帧 ID 为 0x200 + id1 */
+    CAN_RegisterRoute(dji_config->hcan, CAN_ID_STD, 0x200 + hdji->id1, dji_route_decode, hdji);
+
+    /* 声明带宽：每个电机一路反馈，同组 4 个电机共用一帧电流指令，只在组内第一个电机注册时声明。
+     * 超出预算只计入 over_budget（严格模式下进入 CAN_ERROR_HANDLER），电机照常注册 */
+    if (reinit)
+        return;
+    CAN_ReserveBandwidth(dji_config->hcan, CAN_ID_STD, 8, hdji->feedback_hz);
+    const uint8_t group_first = (hdji->id1 - 1) / 4 * 4;
+    bool          group_new   = true;
+    for (uint8_t i = group_first; i < group_first + 4; i++)
+        if (i != hdji->id1 - 1 && mapped_motors[i] != NULL)
+            group_new = false;
+    if (group_new)
+        CAN_ReserveBandwidth(dji_config->hcan,
+                             CAN_ID_STD,
+                             8,
+                             dji_config->command_hz ? dji_config->command_hz : DJI_CMD_HZ);
+}
+
+/**
+ * 由前后两帧转速的平均值和帧间隔预测转过的刻度数，按预测值选取整圈数，
+ * 反馈频率低于转速或者丢帧时也不会丢圈，只要求预测误差小于半圈
+ *
+ * 使用 64 位整数运算，不受浮点尾数的限制，分子不超过 2^16 * 2^32 * 2^13。
+ * 没有接收时间（直接调用 DJI_DataDecode）时间隔为 0；
+ * 间隔超过 DJI_UNWRAP_MAX_PERIODS 个反馈周期时转速已不可信，两种情况都退化为最短路径
+ * @param hdji DJI handle
+ * @param raw_rpm 本帧的转子转速 (unit: rpm)
+ * @param dt 与上一帧的间隔 (unit: DWT 周期)
+ * @return 预测的转动量 (unit: 转子刻度)
+ */
+static inline int32_t dji_predict_ticks(const DJI_t* hdji, const int16_t raw_rpm, const uint32_t dt)
+{
+    if (dt > hdji->unwrap_max_dt)
+        return 0;
+    // 刻度 = (rpm0 + rpm1) / 2 * dt / SystemCoreClock / 60 * DJI_TICKS_PER_ROUND，就近舍入
+    const int64_t num = ((int64_t) hdji->feedback.raw_rpm + raw_rpm) * dt * DJI_TICKS_PER_ROUND;
+    const int64_t den = 2 * 60 * (int64_t) SystemCoreClock;
+    return (int32_t) ((num >= 0 ? num + den / 2 : num - den / 2) / den);
 }
 
 /**
@@ -98,44 +152,169 @@ void DJI_Init(DJI_t* hdji, const DJI_Config_t* dji_config)
  */
 void DJI_DataDecode(DJI_t* hdji, const uint8_t data[8])
 {
-    const float feedback_angle = (float) ((uint16_t) data[0] << 8 | data[1]) * 360.0f / 8192.0f;
-    const float feedback_rpm   = (int16_t) ((uint16_t) data[2] << 8 | data[3]);
+    const uint16_t raw_angle      = (uint16_t) data[0] << 8 | data[1];
+    const int16_t  raw_rpm        = (int16_t) ((uint16_t) data[2] << 8 | data[3]);
+    const float    feedback_angle = (float) raw_angle * 360.0f / 8192.0f;
+    const float    feedback_rpm   = raw_rpm;
     // TODO: 堵转电流检测
     // const float feedback_current = (float)((int16_t)data[4] << 8 | data[5]) / 16384.0f * 20.0f;
 
-    // M3508 和 M2006 的转速均不会超过 120 deg/s
-    if (feedback_angle < 90 && hdji->feedback.mech_angle > 270)
-        hdji->feedback.round_cnt++;
-    if (feedback_angle > 270 && hdji->feedback.mech_angle < 90)
-        hdji->feedback.round_cnt--;
+    const uint32_t dt        = hdji->feedback_timestamp - hdji->turns_timestamp;
+    const int32_t  predicted = dji_predict_ticks(hdji, raw_rpm, dt);
 
+    const int64_t last_ticks = hdji->turns.ticks;
+
+    Seqlock_WriteBegin(&hdji->lock);
+    // 多圈位置只做整数累加，角度在读取时换算
+    hdji->feedback.round_cnt += MultiTurn_UpdatePredicted(&hdji->turns, raw_angle, predicted);
+    hdji->turns_timestamp     = hdji->feedback_timestamp;
     hdji->feedback.mech_angle = feedback_angle;
-    hdji->abs_angle           = (hdji->reverse ? -1.0f : 1.0f) * // 反转时需要反转角度输入
-                      ((float) hdji->feedback.round_cnt * 360.0f + hdji->feedback.mech_angle -
-                       hdji->angle_zero) *
-                      hdji->inv_reduction_rate;
 
     hdji->feedback.rpm = feedback_rpm;
     hdji->velocity     = (hdji->reverse ? -1.0f : 1.0f) * // 反转时需要反转速度输入
                      hdji->feedback.rpm * hdji->inv_reduction_rate;
 
+    // 定点控制使用的原始值，只用整数运算
+    hdji->feedback.raw_angle = raw_angle;
+    hdji->feedback.raw_rpm   = raw_rpm;
+    hdji->rotor_rpm          = hdji->reverse ? -raw_rpm : raw_rpm;
+
+    /**
+     * 第一帧的多圈位置是起点而不是增量，从第二帧开始更新观测器；丢帧时按经过的反馈周期数预测。
+     * 帧间隔超过 DJI_UNWRAP_MAX_PERIODS 个周期时多圈位置取了最短路径，增量不可信，
+     * 清除观测器，从下一帧重新开始
+     */
+    if (hdji->observer != NULL && hdji->feedback_count > 0)
+    {
+        if (dt > hdji->unwrap_max_dt)
+        {
+            VelocityObserver_Reset(hdji->observer);
+        }
+        else
+        {
+            const int32_t delta = (int32_t) (hdji->turns.ticks - last_ticks);
+            VelocityObserver_UpdateSteps(hdji->observer,
+                                         (dt + hdji->feedback_period / 2) / hdji->feedback_period,
+                                         hdji->reverse ? -delta : delta,
+                                         hdji->velocity,
+                                         (float) (int16_t) hdji->iq_cmd);
+        }
+    }
+
     hdji->feedback_count++;
     if (hdji->feedback_count == 50 && hdji->auto_zero)
     {
         // 上电后第 50 次反馈执行输出轴清零操作
-        DJI_ResetAngle(hdji);
+        dji_reset_angle(hdji);
     }
+    Seqlock_WriteEnd(&hdji->lock);
+    hdji->fresh = true;
+}
+
+/**
+ * 读取反馈数据的一致副本
+ *
+ * 不关中断，也不阻塞解包：复制期间被解包打断时重新复制
+ * @param hdji DJI handle
+ * @param out 输出
+ * @return 连续 SEQLOCK_READ_RETRIES 次都被打断时返回 false，此时 out 无效
+ */
+bool DJI_GetSnapshot(const DJI_t* hdji, DJI_Snapshot_t* out)
+{
+    for (uint32_t i = 0; i < SEQLOCK_READ_RETRIES; i++)
+    {
+        const unsigned seq  = Seqlock_ReadBegin(&hdji->lock);
+        out->feedback       = hdji->feedback;
+        out->abs_ticks      = MultiTurn_Get(&hdji->turns);
+        out->velocity       = hdji->velocity;
+        out->rotor_rpm      = hdji->rotor_rpm;
+        out->feedback_count = hdji->feedback_count;
+        if (!Seqlock_ReadRetry(&hdji->lock, seq))
+        {
+            // 角度在锁外由复制下来的多圈位置换算
+            if (hdji->reverse)
+                out->abs_ticks = -out->abs_ticks;
+            out->abs_angle = (float) out->abs_ticks * hdji->angle_per_tick;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 路由解码函数
+ * @param handle DJI handle
+ * @param frame 反馈帧
+ */
+static void dji_route_decode(void* handle, const CAN_Frame_t* frame)
+{
+    ((DJI_t*) handle)->feedback_timestamp = frame->timestamp;
+    DJI_DataDecode(handle, frame->data);
+}
+
+/**
+ * 清零输出角度，调用者负责加锁
+ */
+static void dji_reset_angle(DJI_t* hdji)
+{
+    hdji->feedback.round_cnt = 0;
+    MultiTurn_Zero(&hdji->turns);
 }
 
 /**
  * 清零 DJI 输出角度
+ * @note 与解包共用一把锁，调用期间打断本函数的读者 DJI_GetSnapshot 会重读，可能返回 false
+ * @note 在任务中调用时短暂关中断
  * @param hdji DJI handle
  */
 void DJI_ResetAngle(DJI_t* hdji)
 {
-    hdji->feedback.round_cnt = 0;
-    hdji->angle_zero         = hdji->feedback.mech_angle;
-    hdji->abs_angle          = 0;
+    // seqlock 只允许一个写者：解包在接收中断（或 USE_CAN_DEFERRED_RX 的解码任务）中写，
+    // 关中断后二者都不能打断这里的写操作，中断中调用时也不会提前打开中断
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Seqlock_WriteBegin(&hdji->lock);
+    dji_reset_angle(hdji);
+    Seqlock_WriteEnd(&hdji->lock);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * 清除速度观测器的运行数据，保留增益，用于反馈超时和恢复时丢弃过时的估计
+ * @note 在任务中调用时短暂关中断，解包不会在清除的中途更新观测器
+ * @param hdji DJI handle
+ */
+void DJI_ResetObserver(DJI_t* hdji)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (hdji->observer != NULL)
+        VelocityObserver_Reset(hdji->observer);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * 挂接速度观测器，此后解包时更新观测器，__DJI_GET_VELOCITY 返回观测值
+ *
+ * 观测器以每帧反馈为一步，位置为转子刻度，转速为 velocity，指令为 iq_cmd，
+ * 因此 config->command_gain 的单位为 每个电流原始值产生的输出轴加速度 (deg/s^2)；
+ * 更新周期为 DJI_Config_t::feedback_hz 对应的反馈周期，丢帧时按帧间隔折算的周期数预测
+ * @note 初始化观测器耗时数毫秒，不要在中断中调用
+ * @param hdji DJI handle
+ * @param observer 观测器，NULL 时取消挂接
+ * @param config 观测器参数
+ */
+void DJI_AttachObserver(DJI_t*                           hdji,
+                        VelocityObserver_t*              observer,
+                        const VelocityObserver_Config_t* config)
+{
+    // 先摘下旧的观测器，初始化期间解包不会使用
+    hdji->observer = NULL;
+    if (observer == NULL)
+        return;
+    VelocityObserver_Init(
+            observer, config, 1.0f / (float) hdji->feedback_hz, hdji->angle_per_tick);
+    hdji->observer = observer;
 }
 
 /**
@@ -160,13 +339,19 @@ void DJI_SendSetIqCommand(CAN_HandleTypeDef* hcan, const DJI_IqSetCmdGroup_t cmd
                     iq_data[0 + j * 2]   = (uint8_t) (iq_cmd >> 8 & 0xFF); // 电流值高 8 位
                 }
             }
-            CAN_SendMessage(hcan,
-                            &(CAN_TxHeaderTypeDef) { .StdId = cmd_group == IQ_CMD_GROUP_1_4 ? 0x200
-                                                                                            : 0x1FF,
-                                                     .IDE   = CAN_ID_STD,
-                                                     .RTR   = CAN_RTR_DATA,
-                                                     .DLC   = 8 },
-                            iq_data);
+            const uint32_t ret = CAN_SendMessage(
+                    hcan,
+                    &(CAN_TxHeaderTypeDef) { .StdId = cmd_group == IQ_CMD_GROUP_1_4 ? 0x200 : 0x1FF,
+                                             .IDE   = CAN_ID_STD,
+                                             .RTR   = CAN_RTR_DATA,
+                                             .DLC   = 8 },
+                    iq_data);
+            if (ret == CAN_SEND_FAILED)
+                return;
+            const uint32_t now = DWT->CYCCNT;
+            for (int j = 0; j < 4; j++)
+                if (map[i].motors[j + cmd_group] != NULL)
+                    map[i].motors[j + cmd_group]->command_timestamp = now;
             return;
         }
     }
@@ -201,14 +386,7 @@ void DJI_CAN_FilterInit(CAN_HandleTypeDef* hcan, const uint32_t filter_bank)
  */
 void DJI_CAN_Fifo0ReceiveCallback(CAN_HandleTypeDef* hcan)
 {
-    CAN_RxHeaderTypeDef header;
-    uint8_t             data[8];
-    if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &header, data) != HAL_OK)
-    {
-        DJI_ERROR_HANDLER();
-        return;
-    }
-    DJI_CAN_BaseReceiveCallback(hcan, &header, data);
+    CAN_DrainFifo(hcan, CAN_RX_FIFO0, DJI_CAN_FrameReceiveCallback);
 }
 
 /**
@@ -218,34 +396,53 @@ void DJI_CAN_Fifo0ReceiveCallback(CAN_HandleTypeDef* hcan)
  */
 void DJI_CAN_Fifo1ReceiveCallback(CAN_HandleTypeDef* hcan)
 {
-    CAN_RxHeaderTypeDef header;
-    uint8_t             data[8];
-    if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO1, &header, data) != HAL_OK)
-    {
-        DJI_ERROR_HANDLER();
-        return;
-    }
-    DJI_CAN_BaseReceiveCallback(hcan, &header, data);
+    CAN_DrainFifo(hcan, CAN_RX_FIFO1, DJI_CAN_FrameReceiveCallback);
 }
 
 /**
- * CAN 基本接收回调函数
- * @param hcan
- * @param header
- * @param data
+ * 根据 CAN 实例和帧 ID 找到电机并解包
  */
-void DJI_CAN_BaseReceiveCallback(const CAN_HandleTypeDef*   hcan,
-                                 const CAN_RxHeaderTypeDef* header,
-                                 const uint8_t              data[])
+static inline void dji_receive(const CAN_HandleTypeDef* hcan,
+                               const uint32_t           ide,
+                               const uint32_t           id,
+                               const uint8_t            data[],
+                               const uint32_t           timestamp)
 {
     for (int i = 0; i < map_size; i++)
     {
         if (hcan->Instance == map[i].can)
         {
-            DJI_t* hdji = getDJIHandle(map[i].motors, header);
+            DJI_t* hdji = getDJIHandle(map[i].motors, ide, id);
             if (hdji != NULL)
+            {
+                hdji->feedback_timestamp = timestamp;
                 DJI_DataDecode(hdji, data);
+            }
             return;
         }
     }
 }
+
+/**
+ * CAN 基本接收回调函数
+ * @param hcan
+ * @param header
+ * @param data
+ */
+void DJI_CAN_BaseReceiveCallback(const CAN_HandleTypeDef*   hcan,
+                                 const CAN_RxHeaderTypeDef* header,
+                                 const uint8_t              data[])
+{
+    // HAL 的 header 不带接收时间，以解包时间代替
+    dji_receive(hcan, header->IDE, header->StdId, data, DWT->CYCCNT);
+}
+
+/**
+ * CAN 帧接收回调函数，直接在 frame 上解包，无中间拷贝
+ * @param hcan
+ * @param frame 接收到的帧
+ */
+void DJI_CAN_FrameReceiveCallback(const CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame)
+{
+    dji_receive(hcan, frame->ide, frame->id, frame->data, frame->timestamp);
+}
@@ -41,8 +41,30 @@
 #define DJI_M2006_C610_IQ_MAX (10000)
 #define DJI_M3508_C620_IQ_MAX (16384)
 
+#define DJI_FEEDBACK_HZ     (1000U) ///< 电调默认反馈频率，C610 / C620 出厂为 1kHz
+#define DJI_TICKS_PER_ROUND (8192)  ///< 转子编码器每圈的刻度数
+
+#ifndef DJI_UNWRAP_MAX_PERIODS
+/**
+ * 按转速预测转动量的最大帧间隔 (unit: 反馈周期)，间隔更长时转速不足以代表期间的运动，
+ * 退化为最短路径选取整圈数
+ */
+#    define DJI_UNWRAP_MAX_PERIODS (8U)
+#endif
+
+#ifndef DJI_CMD_HZ
+/**
+ * 默认的电流指令发送频率，用于注册时声明总线带宽
+ */
+#    define DJI_CMD_HZ (1000U)
+#endif
+
 #include <stdbool.h>
 #include "main.h"
+#include "bsp/can_driver.h"
+#include "libs/multiturn.h"
+#include "libs/seqlock.h"
+#include "libs/velocity_observer.h"
 
 typedef enum
 {
@@ -58,6 +80,18 @@ typedef enum
     IQ_CMD_GROUP_5_8 = 4U,
 } DJI_IqSetCmdGroup_t;
 
+typedef struct
+{
+    float    mech_angle; //< 单圈机械角度 (unit: degree)
+    float    rpm;        //< 转速
+    uint16_t raw_angle;  ///< 单圈机械角度原始值 (0 ~ 8191)
+    int16_t  raw_rpm;    ///< 转速原始值 (unit: rpm)
+    // float current; //< 电流大小
+    // float temperature; //< 温度
+
+    int32_t round_cnt; //< 圈数
+} DJI_Feedback_t;
+
 typedef struct
 {
     bool enable;    // 是否启用
@@ -67,30 +101,46 @@ typedef struct
     DJI_MotorType_t motor_type; //< 电机类型
     CAN_TypeDef*    can;        //< CAN 实例
     uint8_t         id1;        //< 电调 ID (1 ~ 8)
-    float           angle_zero; //< 零点角度 (unit: degree)
 
-    float inv_reduction_rate; ///< 减速比
+    float    inv_reduction_rate; ///< 减速比
+    float    angle_per_tick;     ///< 一个转子刻度对应的输出轴角度 (unit: degree)
+    uint32_t feedback_hz;        ///< 反馈频率 (unit: Hz)
+    uint32_t feedback_period;    ///< 反馈周期 (unit: DWT 周期)
+    uint32_t unwrap_max_dt;      ///< 按转速预测转动量的最大帧间隔 (unit: DWT 周期)
 
     /* Feedback */
-    uint32_t feedback_count; //< 接收到的反馈数据数量
-    struct
-    {
-        float mech_angle; //< 单圈机械角度 (unit: degree)
-        float rpm;        //< 转速
-        // float current; //< 电流大小
-        // float temperature; //< 温度
-
-        int32_t round_cnt; //< 圈数
-    } feedback;
+    uint32_t       feedback_count;     //< 接收到的反馈数据数量
+    uint32_t       feedback_timestamp; ///< 最近一帧反馈的接收时间 (DWT 周期计数)
+    uint32_t       turns_timestamp;    ///< 上一次累加多圈位置时的 feedback_timestamp
+    uint32_t       command_timestamp;  ///< 最近一条电流指令写入邮箱或入队的时间 (DWT 周期计数)
+    volatile bool  fresh;              ///< 解包后置位，由使用者读取后清除
+    Seqlock_t      lock;               ///< 解包时写 feedback、turns 和 velocity
+    DJI_Feedback_t feedback;
 
     /* Data */
-    float abs_angle; //< 电机轴输出角度 (unit: degree)
-    float velocity;  //< 电机轴输出速度 (unit: rpm)
+    MultiTurn_t turns;     ///< 转子多圈位置，未计入反转，通过 DJI_GetTicks 读取
+    float       velocity;  //< 电机轴输出速度 (unit: rpm)
+    int32_t     rotor_rpm; ///< 转子转速，已计入反转 (unit: rpm)
+
+    VelocityObserver_t* observer; ///< 速度观测器，NULL 时不使用，见 DJI_AttachObserver
 
     /* Output */
     uint16_t iq_cmd; //< 电流指令值
 } DJI_t;
 
+/**
+ * 反馈数据的一致副本，见 DJI_GetSnapshot
+ */
+typedef struct
+{
+    DJI_Feedback_t feedback;
+    float          abs_angle;      ///< 电机轴输出角度 (unit: degree)
+    float          velocity;       ///< 电机轴输出速度 (unit: rpm)
+    int64_t        abs_ticks;      ///< 转子多圈位置 (unit: 1 / DJI_TICKS_PER_ROUND 圈)
+    int32_t        rotor_rpm;      ///< 转子转速 (unit: rpm)
+    uint32_t       feedback_count; ///< 接收到的反馈数据数量
+} DJI_Snapshot_t;
+
 typedef struct
 {
     CAN_TypeDef* can;       //< CAN 实例
@@ -105,6 +155,8 @@ typedef struct
     CAN_HandleTypeDef* hcan;
     uint8_t            id1;            ///< 电机编号 1~8
     float              reduction_rate; ///< 外接减速比
+    uint32_t           command_hz;     ///< 电流指令发送频率 (unit: Hz)，0 使用 DJI_CMD_HZ
+    uint32_t           feedback_hz;    ///< 电调的反馈频率 (unit: Hz)，0 使用 DJI_FEEDBACK_HZ
 } DJI_Config_t;
 
 /**
@@ -115,18 +167,69 @@ typedef struct
 #define __DJI_SET_IQ_CMD(__DJI_HANDLE__, __IQ_CMD__)                                               \
     (((DJI_t*) (__DJI_HANDLE__))->iq_cmd = (int16_t) (__IQ_CMD__))
 
-#define __DJI_GET_ANGLE(__DJI_HANDLE__)    (((DJI_t*) (__DJI_HANDLE__))->abs_angle)
-#define __DJI_GET_VELOCITY(__DJI_HANDLE__) (((DJI_t*) (__DJI_HANDLE__))->velocity)
+#define __DJI_GET_ANGLE(__DJI_HANDLE__)    DJI_GetAngle((DJI_t*) (__DJI_HANDLE__))
+#define __DJI_GET_VELOCITY(__DJI_HANDLE__) DJI_GetVelocity((DJI_t*) (__DJI_HANDLE__))
+
+/**
+ * 读取转子多圈位置，已计入零点和反转
+ * @note 64 位的位置不能一次读出，被解包打断时重读，连续 SEQLOCK_READ_RETRIES 次被打断时短暂关中断
+ * @param hdji DJI handle
+ * @return 转子多圈位置 (unit: 1 / DJI_TICKS_PER_ROUND 圈)
+ */
+static inline int64_t DJI_GetTicks(const DJI_t* hdji)
+{
+    int64_t ticks;
+    for (uint32_t i = 0; i < SEQLOCK_READ_RETRIES; i++)
+    {
+        const unsigned seq = Seqlock_ReadBegin(&hdji->lock);
+        ticks              = MultiTurn_Get(&hdji->turns);
+        if (!Seqlock_ReadRetry(&hdji->lock, seq))
+            return hdji->reverse ? -ticks : ticks;
+    }
+    // 重读次数用完时关中断再读一次，解包不能再打断，不会返回写了一半的值
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ticks = MultiTurn_Get(&hdji->turns);
+    __set_PRIMASK(primask);
+    return hdji->reverse ? -ticks : ticks;
+}
+
+/**
+ * 读取电机轴输出角度，由多圈位置换算，不随圈数损失分辨率
+ * @param hdji DJI handle
+ * @return 电机轴输出角度 (unit: degree)
+ */
+static inline float DJI_GetAngle(const DJI_t* hdji)
+{
+    return (float) DJI_GetTicks(hdji) * hdji->angle_per_tick;
+}
+
+/**
+ * 读取电机轴输出速度
+ * @param hdji DJI handle
+ * @return 挂接了速度观测器时为观测值，否则为反馈值 (unit: rpm)
+ */
+static inline float DJI_GetVelocity(const DJI_t* hdji)
+{
+    return hdji->observer != NULL ? hdji->observer->velocity : hdji->velocity;
+}
 
 void DJI_ResetAngle(DJI_t* hdji);
 void DJI_Init(DJI_t* hdji, const DJI_Config_t* dji_config);
 void DJI_CAN_FilterInit(CAN_HandleTypeDef* hcan, uint32_t filter_bank);
+void DJI_DataDecode(DJI_t* hdji, const uint8_t data[8]);
+bool DJI_GetSnapshot(const DJI_t* hdji, DJI_Snapshot_t* out);
+void DJI_ResetObserver(DJI_t* hdji);
+void DJI_AttachObserver(DJI_t*                           hdji,
+                        VelocityObserver_t*              observer,
+                        const VelocityObserver_Config_t* config);
 
 void DJI_CAN_Fifo0ReceiveCallback(CAN_HandleTypeDef* hcan);
 void DJI_CAN_Fifo1ReceiveCallback(CAN_HandleTypeDef* hcan);
 void DJI_CAN_BaseReceiveCallback(const CAN_HandleTypeDef*   hcan,
                                  const CAN_RxHeaderTypeDef* header,
                                  const uint8_t              data[]);
+void DJI_CAN_FrameReceiveCallback(const CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame);
 
 void DJI_SendSetIqCommand(CAN_HandleTypeDef* hcan, DJI_IqSetCmdGroup_t cmd_group);
 
@@ -9,15 +9,16 @@ static float reduction_rate_map[DM_MOTOR_TYPE_COUNT] = {
     [DM_S3519] = (19.203f),
 };
 
-static inline DM_t* getDMHandle(DM_t*                      motors[8],
-                                const uint8_t*             data,
-                                const CAN_RxHeaderTypeDef* header)
+static void dm_route_decode(void* handle, const CAN_Frame_t* frame);
+static void dm_reset_angle(DM_t* hdm);
+
+static inline DM_t* getDMHandle(DM_t* motors[DM_NUM], const uint8_t* data, const uint32_t ide)
 {
-    if (header->IDE != CAN_ID_STD)
+    if (ide != CAN_ID_STD)
         return NULL;
     const int8_t id0 = (int8_t) (data[0] & 0x0f);
     // 不是 DM 的反馈数据
-    if (id0 >= 16)
+    if (id0 >= DM_NUM)
         return NULL;
     if (motors[id0] == NULL)
     {
@@ -64,6 +65,7 @@ void DM_Init(DM_t* hdm, const DM_Config_t* dm_config)
         0xFF, 0XFF, 0XFF, 0xFF, 0XFF, 0XFF, 0XFF, 0XFC
     }; // DM电机初始化需要发送的数据
     memset(hdm, 0, sizeof(DM_t));
+    Seqlock_Init(&hdm->lock);
     hdm->id0                = dm_config->id0;
     hdm->hcan               = dm_config->hcan;
     hdm->POS_MAX            = dm_config->POS_MAX_RAD * 180.0f / 3.1416f;
@@ -76,6 +78,11 @@ void DM_Init(DM_t* hdm, const DM_Config_t* dm_config)
                               ((dm_config->reduction_rate > 0 ? dm_config->reduction_rate
                                                               : 1.0f)        // 外接减速比
                                * reduction_rate_map[dm_config->motor_type]); // 电机内部减速比
+    hdm->angle_per_tick = 2.0f * dm_config->POS_MAX_RAD / DM_TICKS_PER_ROUND * 180.0f / 3.1416f *
+                          hdm->inv_reduction_rate;
+    MultiTurn_Init(&hdm->turns, DM_TICKS_PER_ROUND);
+    CAN_TxCache_Init(&hdm->tx_cache,
+                     dm_config->keepalive_ms ? dm_config->keepalive_ms : DM_CMD_KEEPALIVE_MS);
     /* 注册回调 */
     DM_t** mapped_motors = NULL;
     for (int i = 0; i < map_size; i++)
@@ -90,7 +97,9 @@ void DM_Init(DM_t* hdm, const DM_Config_t* dm_config)
         mapped_motors = map[map_size].motors;
         map_size++;
     }
-    if (mapped_motors[hdm->id0] != NULL)
+    // 同一个 handle 重复初始化（重新配置）时不再重复声明带宽
+    const bool reinit = mapped_motors[hdm->id0] == hdm;
+    if (mapped_motors[hdm->id0] != NULL && !reinit)
     {
         // 电调 id0 冲突
         DM_ERROR_HANDLER();
@@ -99,6 +108,12 @@ void DM_Init(DM_t* hdm, const DM_Config_t* dm_config)
     {
         mapped_motors[hdm->id0] = hdm;
     }
+    /* 注册路由，同一条总线上的 DM 电机共用 MST_ID，由 data[0] 区分 */
+    CAN_RegisterRoute(hdm->hcan, CAN_ID_STD, MST_ID, dm_route_decode, mapped_motors);
+    /* 声明带宽：一帧指令对应一帧反馈，两者都是 8 字节标准帧；结果仅作提示，被拒绝时电机照常使用 */
+    const uint32_t command_hz = dm_config->command_hz ? dm_config->command_hz : DM_CMD_HZ;
+    if (!reinit)
+        CAN_ReserveBandwidth(hdm->hcan, CAN_ID_STD, 8, 2 * command_hz);
     CAN_SendMessage(dm_config->hcan,
                     &(CAN_TxHeaderTypeDef) { .StdId = dm_config->mode | hdm->id0,
                                              .IDE   = CAN_ID_STD,
@@ -120,20 +135,19 @@ void DM_DataDecode(DM_t* hdm, const uint8_t data[8])
                             4095.0f; // 读取到的浮点数是和12位位置数据成线性关系，计算k值
     const float scale_t = 2.0f * hdm->T_MAX / 4095.0f;
 
-    const float feedback_angle =
-            scale_angle * (float) (uint16_t) (data[1] << 8 | data[2]) -
+    const uint16_t raw_angle = (uint16_t) (data[1] << 8 | data[2]);
+    const float    feedback_angle =
+            scale_angle * (float) raw_angle -
             hdm->POS_MAX_RAD; // 反馈位置数据，达妙3519和2520反馈的数据是减速前的
     const float feedback_vel = scale_vel * (float) (uint16_t) (data[3] << 4 | data[4] >> 4) -
                                hdm->VEL_MAX_RAD; // 反馈速度数据，达妙3519和2520反馈的数据是减速后的
     const float feedback_t = scale_t *
                              (float) (uint16_t) ((data[4] & 0x0F) << 8 | data[5]); // 反馈力矩数据
-    const float angle = feedback_angle * 180.0f / 3.1416f;
-    const float vel   = feedback_vel / 2.0f / 3.1416f * 60.0f;
+    const float vel = feedback_vel / 2.0f / 3.1416f * 60.0f;
 
-    if (angle < -90 && hdm->feedback.angle >= 1.5708)
-        hdm->round_cnt++;
-    if (angle > 90 && hdm->feedback.angle < -1.5708)
-        hdm->round_cnt--;
+    Seqlock_WriteBegin(&hdm->lock);
+    // 位置在 ±POS_MAX 处回绕，多圈位置只做整数累加，角度在读取时换算
+    hdm->round_cnt += MultiTurn_Update(&hdm->turns, raw_angle);
 
     hdm->feedback.vel     = feedback_vel;
     hdm->feedback.angle   = feedback_angle;
@@ -143,28 +157,87 @@ void DM_DataDecode(DM_t* hdm, const uint8_t data[8])
     hdm->feedback_count++;
     hdm->feedback.ERR = data[0] & 0x0F;
 
-    hdm->abs_angle = (hdm->reverse ? -1.0f : 1.0f) * // 反转时需要反转角度输入
-                     ((float) hdm->round_cnt * 360.0f + angle - hdm->angle_zero) *
-                     hdm->inv_reduction_rate;
     hdm->vel = (hdm->reverse ? -1.0f : 1.0f) * vel;
     hdm->feedback_count++;
 
     if (hdm->feedback_count == 10 && hdm->auto_zero)
     {
         // 上电后第 10 次反馈执行输出轴清零操作
-        DM_ResetAngle(hdm);
+        dm_reset_angle(hdm);
+    }
+    Seqlock_WriteEnd(&hdm->lock);
+    hdm->fresh = true;
+}
+
+/**
+ * 读取反馈数据的一致副本
+ *
+ * 不关中断，也不阻塞解包：复制期间被解包打断时重新复制
+ * @param hdm DM handle
+ * @param out 输出
+ * @return 连续 SEQLOCK_READ_RETRIES 次都被打断时返回 false，此时 out 无效
+ */
+bool DM_GetSnapshot(const DM_t* hdm, DM_Snapshot_t* out)
+{
+    for (uint32_t i = 0; i < SEQLOCK_READ_RETRIES; i++)
+    {
+        const unsigned seq  = Seqlock_ReadBegin(&hdm->lock);
+        out->feedback       = hdm->feedback;
+        out->round_cnt      = hdm->round_cnt;
+        out->abs_ticks      = MultiTurn_Get(&hdm->turns);
+        out->vel            = hdm->vel;
+        out->feedback_count = hdm->feedback_count;
+        if (!Seqlock_ReadRetry(&hdm->lock, seq))
+        {
+            // 角度在锁外由复制下来的多圈位置换算
+            if (hdm->reverse)
+                out->abs_ticks = -out->abs_ticks;
+            out->abs_angle = (float) out->abs_ticks * hdm->angle_per_tick;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 路由解码函数
+ * @param handle 该总线的 DM 电机指针数组
+ * @param frame 反馈帧
+ */
+static void dm_route_decode(void* handle, const CAN_Frame_t* frame)
+{
+    DM_t* hdm = getDMHandle(handle, frame->data, frame->ide);
+    if (hdm != NULL)
+    {
+        hdm->feedback_timestamp = frame->timestamp;
+        DM_DataDecode(hdm, frame->data);
     }
 }
 
 /**
  * 清零 DM 输出角度
+ * @note 与解包共用一把锁，调用期间打断本函数的读者 DM_GetSnapshot 会重读，可能返回 false
+ * @note 在任务中调用时短暂关中断
  * @param hdm DM handle
  */
 void DM_ResetAngle(DM_t* hdm)
 {
-    hdm->round_cnt  = 0;
-    hdm->angle_zero = hdm->feedback.angle;
-    hdm->abs_angle  = 0;
+    // 关中断，避免与解包同时写同一把锁，见 DJI_ResetAngle
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Seqlock_WriteBegin(&hdm->lock);
+    dm_reset_angle(hdm);
+    Seqlock_WriteEnd(&hdm->lock);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * 清零输出角度，调用者负责加锁
+ */
+static void dm_reset_angle(DM_t* hdm)
+{
+    hdm->round_cnt = 0;
+    MultiTurn_Zero(&hdm->turns);
 }
 
 static void dm_vel_set_command_data(DM_t* hdm, const float value_vel, uint8_t data[])
@@ -193,6 +266,11 @@ static void dm_pos_set_command_data(DM_t*       hdm,
     data[7]       = *(vbuf + 3);
 }
 
+/**
+ * 发送速度指令，编码后的指令与上一次相同且未到保活时间时不发送
+ * @param hdm DM handle
+ * @param value_vel 目标速度 (unit: rpm)
+ */
 void DM_Vel_SendSetCmd(DM_t* hdm, const float value_vel)
 {
     static uint8_t data[8] = { 0 };
@@ -200,29 +278,36 @@ void DM_Vel_SendSetCmd(DM_t* hdm, const float value_vel)
     const float value_vel_rad = value_vel * 2 * 3.1416f /
                                 60.0f; // 达妙电机控制的即为输出轴的速度（uint:rad/s）
     dm_vel_set_command_data(hdm, value_vel_rad, data);
-    CAN_SendMessage(hdm->hcan,
-                    &(CAN_TxHeaderTypeDef) {
-                            .StdId = DM_MODE_VEL | hdm->id0,
-                            .IDE   = CAN_ID_STD,
-                            .RTR   = CAN_RTR_DATA,
-                            .DLC   = 8,
-                    },
-                    data);
+    CAN_SendMessageCached(&hdm->tx_cache,
+                          hdm->hcan,
+                          &(CAN_TxHeaderTypeDef) {
+                                  .StdId = DM_MODE_VEL | hdm->id0,
+                                  .IDE   = CAN_ID_STD,
+                                  .RTR   = CAN_RTR_DATA,
+                                  .DLC   = 8,
+                          },
+                          data);
 }
 
+/**
+ * 发送位置指令，编码后的指令与上一次相同且未到保活时间时不发送
+ * @param hdm DM handle
+ * @param value_pos 目标位置 (unit: degree)
+ */
 void DM_Pos_SendSetCmd(DM_t* hdm, const float value_pos)
 {
     static uint8_t data[8]       = { 0 };
     const float    value_pos_rad = value_pos * 3.1416f / 180.0f;
     dm_pos_set_command_data(hdm, hdm->VEL_MAX, value_pos_rad, data);
-    CAN_SendMessage(hdm->hcan,
-                    &(CAN_TxHeaderTypeDef) {
-                            .StdId = DM_MODE_POS | hdm->id0,
-                            .IDE   = CAN_ID_STD,
-                            .RTR   = CAN_RTR_DATA,
-                            .DLC   = 8,
-                    },
-                    data);
+    CAN_SendMessageCached(&hdm->tx_cache,
+                          hdm->hcan,
+                          &(CAN_TxHeaderTypeDef) {
+                                  .StdId = DM_MODE_POS | hdm->id0,
+                                  .IDE   = CAN_ID_STD,
+                                  .RTR   = CAN_RTR_DATA,
+                                  .DLC   = 8,
+                          },
+                          data);
 }
 
 /**
@@ -244,14 +329,7 @@ void DM_ERROR_HANDLER()
  */
 void DM_CAN_Fifo0ReceiveCallback(CAN_HandleTypeDef* hcan)
 {
-    CAN_RxHeaderTypeDef header;
-    uint8_t             data[8];
-    if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &header, data) != HAL_OK)
-    {
-        DM_ERROR_HANDLER();
-        return;
-    }
-    DM_CAN_BaseReceiveCallback(hcan, &header, data);
+    CAN_DrainFifo(hcan, CAN_RX_FIFO0, DM_CAN_FrameReceiveCallback);
 }
 
 /**
@@ -261,34 +339,52 @@ void DM_CAN_Fifo0ReceiveCallback(CAN_HandleTypeDef* hcan)
  */
 void DM_CAN_Fifo1ReceiveCallback(CAN_HandleTypeDef* hcan)
 {
-    CAN_RxHeaderTypeDef header;
-    uint8_t             data[8];
-    if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO1, &header, data) != HAL_OK)
-    {
-        DM_ERROR_HANDLER();
-        return;
-    }
-    DM_CAN_BaseReceiveCallback(hcan, &header, data);
+    CAN_DrainFifo(hcan, CAN_RX_FIFO1, DM_CAN_FrameReceiveCallback);
 }
 
 /**
- * CAN 基本接收回调函数
- * @param hcan
- * @param header
- * @param data
+ * 根据 CAN 句柄和反馈数据找到电机并解包
  */
-void DM_CAN_BaseReceiveCallback(const CAN_HandleTypeDef*   hcan,
-                                const CAN_RxHeaderTypeDef* header,
-                                const uint8_t              data[])
+static inline void dm_receive(const CAN_HandleTypeDef* hcan,
+                              const uint32_t           ide,
+                              const uint8_t            data[],
+                              const uint32_t           timestamp)
 {
     for (int i = 0; i < map_size; i++)
     {
         if (hcan == map[i].hcan)
         {
-            DM_t* hdm = getDMHandle(map[i].motors, data, header);
+            DM_t* hdm = getDMHandle(map[i].motors, data, ide);
             if (hdm != NULL)
+            {
+                hdm->feedback_timestamp = timestamp;
                 DM_DataDecode(hdm, data);
+            }
             return;
         }
     }
 }
+
+/**
+ * CAN 基本接收回调函数
+ * @param hcan
+ * @param header
+ * @param data
+ */
+void DM_CAN_BaseReceiveCallback(const CAN_HandleTypeDef*   hcan,
+                                const CAN_RxHeaderTypeDef* header,
+                                const uint8_t              data[])
+{
+    // HAL 的 header 不带接收时间，以解包时间代替
+    dm_receive(hcan, header->IDE, data, DWT->CYCCNT);
+}
+
+/**
+ * CAN 帧接收回调函数，直接在 frame 上解包，无中间拷贝
+ * @param hcan
+ * @param frame 接收到的帧
+ */
+void DM_CAN_FrameReceiveCallback(const CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame)
+{
+    dm_receive(hcan, frame->ide, frame->data, frame->timestamp);
+}
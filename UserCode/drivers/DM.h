@@ -3,11 +3,27 @@
 
 #include "main.h"
 #include "stdbool.h"
+#include "bsp/can_driver.h"
+#include "libs/multiturn.h"
+#include "libs/seqlock.h"
 
 #define MST_ID     0x114 // 反馈id，如果不喜欢这个数字可以自己改（
 #define DM_CAN_NUM (2)
 #define DM_NUM     (16) // 达妙电机数量上限
 
+// 位置原始值回绕一次的刻度数：0 和 65535 分别对应 -POS_MAX 和 POS_MAX，是同一位置
+#define DM_TICKS_PER_ROUND (65535U)
+
+#ifndef DM_CMD_KEEPALIVE_MS
+// 指令帧保活间隔 (unit: ms)，指令不变时至少每隔该时间重发一次，应小于电机的 CAN 超时时间
+#    define DM_CMD_KEEPALIVE_MS (50U)
+#endif
+
+#ifndef DM_CMD_HZ
+// 默认的指令发送频率，用于注册时声明总线带宽，电机每收到一帧指令回复一帧反馈
+#    define DM_CMD_HZ (1000U)
+#endif
+
 typedef enum
 {
     DM_S3519 = 0U,
@@ -24,20 +40,24 @@ typedef enum
 
 typedef struct
 {
-    uint32_t feedback_count;
-    bool     reverse;   // 是否反转
-    bool     auto_zero; //  是否自动判断零点
-    float    angle_zero;
-    struct
-    {
-        float   angle;   // 目前单圈位置信息
-        float   vel;     // 反馈速度信息
-        float   T;       // 反馈力矩信息
-        int8_t  T_MOS;   // 反馈mos温度
-        int8_t  T_Rotor; // 反馈电机内部线圈平均温度
-        uint8_t ERR;     // 电机目前状态
-
-    } feedback;
+    float   angle;   // 目前单圈位置信息
+    float   vel;     // 反馈速度信息
+    float   T;       // 反馈力矩信息
+    int8_t  T_MOS;   // 反馈mos温度
+    int8_t  T_Rotor; // 反馈电机内部线圈平均温度
+    uint8_t ERR;     // 电机目前状态
+
+} DM_Feedback_t;
+
+typedef struct
+{
+    uint32_t      feedback_count;
+    uint32_t      feedback_timestamp; ///< 最近一帧反馈的接收时间 (DWT 周期计数)
+    volatile bool fresh;              ///< 解包后置位，由使用者读取后清除
+    Seqlock_t     lock;               ///< 解包时写 feedback、round_cnt、turns 和 vel
+    bool          reverse;            // 是否反转
+    bool          auto_zero;          //  是否自动判断零点
+    DM_Feedback_t feedback;
     int32_t            round_cnt;
     uint8_t            id0;  // 电机id
     CAN_HandleTypeDef* hcan; // 电机挂载的can线
@@ -50,16 +70,32 @@ typedef struct
     float     T_MAX;
     DM_MODE_T mode;
 
-    float          abs_angle;          //< 电机轴输出角度 (unit: degree)
+    MultiTurn_t    turns;              ///< 减速前的多圈位置，未计入反转，通过 DM_GetTicks 读取
     float          vel;                // 电机轴输出速度 (unit: rpm)
     DM_MotorType_t motor_type;         //< 电机类型
     float          inv_reduction_rate; ///< 减速比
+    float          angle_per_tick;     ///< 一个位置刻度对应的输出轴角度 (unit: degree)
+
+    CAN_TxCache_t tx_cache; ///< 指令帧发送缓存，记录发出 / 省略的帧数
 } DM_t;
 
+/**
+ * 反馈数据的一致副本，见 DM_GetSnapshot
+ */
 typedef struct
 {
-    CAN_HandleTypeDef* hcan;      //< CAN 实例
-    DM_t*              motors[8]; //< 电机指针数组
+    DM_Feedback_t feedback;
+    int32_t       round_cnt;
+    int64_t       abs_ticks;      ///< 多圈位置 (unit: 位置刻度)
+    float         abs_angle;      ///< 电机轴输出角度 (unit: degree)
+    float         vel;            ///< 电机轴输出速度 (unit: rpm)
+    uint32_t      feedback_count; ///< 反馈数
+} DM_Snapshot_t;
+
+typedef struct
+{
+    CAN_HandleTypeDef* hcan;           //< CAN 实例
+    DM_t*              motors[DM_NUM]; //< 电机指针数组
 } DM_FeedbackMap;
 
 typedef struct
@@ -74,11 +110,47 @@ typedef struct
     DM_MODE_T          mode;
     DM_MotorType_t     motor_type;     //< 电机类型
     float              reduction_rate; ///< 外接减速比
+    uint32_t           keepalive_ms;   ///< 指令帧保活间隔 (unit: ms)，0 使用 DM_CMD_KEEPALIVE_MS
+    uint32_t           command_hz;     ///< 指令发送频率 (unit: Hz)，0 使用 DM_CMD_HZ
 } DM_Config_t;
 
-#define __DM_GET_ANGLE(__DM_HANDLE__)    (((DM_t*) (__DM_HANDLE__))->abs_angle)
+#define __DM_GET_ANGLE(__DM_HANDLE__)    DM_GetAngle((DM_t*) (__DM_HANDLE__))
 #define __DM_GET_VELOCITY(__DM_HANDLE__) (((DM_t*) (__DM_HANDLE__))->vel)
 
+/**
+ * 读取多圈位置，已计入零点和反转
+ * @note 64 位的位置不能一次读出，被解包打断时重读，连续 SEQLOCK_READ_RETRIES 次被打断时短暂关中断
+ * @param hdm DM handle
+ * @return 多圈位置 (unit: 位置刻度，2 * POS_MAX_RAD / 65535 rad)
+ */
+static inline int64_t DM_GetTicks(const DM_t* hdm)
+{
+    int64_t ticks;
+    for (uint32_t i = 0; i < SEQLOCK_READ_RETRIES; i++)
+    {
+        const unsigned seq = Seqlock_ReadBegin(&hdm->lock);
+        ticks              = MultiTurn_Get(&hdm->turns);
+        if (!Seqlock_ReadRetry(&hdm->lock, seq))
+            return hdm->reverse ? -ticks : ticks;
+    }
+    // 重读次数用完时关中断再读一次，解包不能再打断，不会返回写了一半的值
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ticks = MultiTurn_Get(&hdm->turns);
+    __set_PRIMASK(primask);
+    return hdm->reverse ? -ticks : ticks;
+}
+
+/**
+ * 读取电机轴输出角度，由多圈位置换算，不随圈数损失分辨率
+ * @param hdm DM handle
+ * @return 电机轴输出角度 (unit: degree)
+ */
+static inline float DM_GetAngle(const DM_t* hdm)
+{
+    return (float) DM_GetTicks(hdm) * hdm->angle_per_tick;
+}
+
 void DM_ERROR_HANDLER();
 void DM_CAN_FilterInit(CAN_HandleTypeDef* hcan, const uint32_t filter_bank);
 void DM_Init(DM_t* hdm, const DM_Config_t* dm_config);
@@ -88,8 +160,10 @@ void DM_CAN_Fifo1ReceiveCallback(CAN_HandleTypeDef* hcan);
 void DM_CAN_BaseReceiveCallback(const CAN_HandleTypeDef*   hcan,
                                 const CAN_RxHeaderTypeDef* header,
                                 const uint8_t              data[]);
+void DM_CAN_FrameReceiveCallback(const CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame);
 void DM_Vel_SendSetCmd(DM_t* hdm, const float value_vel);
 void DM_Pos_SendSetCmd(DM_t* hdm, const float value_pos);
 void DM_ResetAngle(DM_t* hdm);
+bool DM_GetSnapshot(const DM_t* hdm, DM_Snapshot_t* out);
 
 #endif // !DM_H
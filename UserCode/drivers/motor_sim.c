@@ -0,0 +1,631 @@
+/**
+ * @file    motor_sim.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * 协议常量按电调手册在本文件内独立实现，不引用其他驱动的代码，
+ * 这样仿真可以发现驱动在打包 / 解包上的错误
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "motor_sim.h"
+
+#ifdef USE_CAN_SIM
+
+#include <math.h>
+#include <string.h>
+
+#define MOTOR_SIM_ERROR_HANDLER() Error_Handler()
+
+/* 大疆 C620 / C610 */
+#define SIM_DJI_FEEDBACK_BASE (0x200)
+#define SIM_DJI_CMD_1_4       (0x200)
+#define SIM_DJI_CMD_5_8       (0x1FF)
+#define SIM_DJI_ENCODER       (8192.0f)
+
+/* 达妙 */
+#define SIM_DM_MST_ID   (0x114)
+#define SIM_DM_CMD_MIT  (0x000)
+#define SIM_DM_CMD_POS  (0x100)
+#define SIM_DM_CMD_VEL  (0x200)
+#define SIM_DM_ENABLE   (0xFC)
+#define SIM_DM_DISABLE  (0xFD)
+#define SIM_DM_SET_ZERO (0xFE)
+
+/* VESC */
+#define SIM_VESC_SET_DUTY          (0U)
+#define SIM_VESC_SET_CURRENT       (1U)
+#define SIM_VESC_SET_CURRENT_BRAKE (2U)
+#define SIM_VESC_SET_RPM           (3U)
+#define SIM_VESC_STATUS            (9U)
+#define SIM_VESC_STATUS_2          (14U)
+#define SIM_VESC_STATUS_3          (15U)
+#define SIM_VESC_STATUS_4          (16U)
+#define SIM_VESC_STATUS_5          (27U)
+#define SIM_VESC_BROADCAST         (0xFF)
+
+#define SIM_TEMPERATURE (40) ///< 仿真中的恒定温度 (unit: °C)
+
+/**
+ * 内部速度环带宽 (unit: rad/s)，位置环带宽取其 1/8
+ */
+#define SIM_VELOCITY_BANDWIDTH (2.0f * 3.1415927f * 30.0f)
+
+/**
+ * 各型号默认模型参数（转子侧）
+ */
+static const MotorPlant_Config_t default_plant[MOTOR_SIM_TYPE_COUNT] = {
+    [MOTOR_SIM_M3508_C620] = { .inertia        = 1.5e-5f,
+                               .viscous        = 2.0e-6f,
+                               .coulomb        = 2.0e-3f,
+                               .torque_const   = 0.3f * 187.0f / 3591.0f,
+                               .resistance     = 0.194f,
+                               .voltage_max    = 24.0f,
+                               .current_max    = 20.0f,
+                               .reduction_rate = 3591.0f / 187.0f },
+    [MOTOR_SIM_M2006_C610] = { .inertia        = 2.5e-6f,
+                               .viscous        = 5.0e-7f,
+                               .coulomb        = 5.0e-4f,
+                               .torque_const   = 0.18f / 36.0f,
+                               .resistance     = 0.5f,
+                               .voltage_max    = 24.0f,
+                               .current_max    = 10.0f,
+                               .reduction_rate = 36.0f },
+    [MOTOR_SIM_DM_S3519]   = { .inertia        = 1.5e-5f,
+                               .viscous        = 2.0e-6f,
+                               .coulomb        = 2.0e-3f,
+                               .torque_const   = 0.3f / 19.203f,
+                               .resistance     = 0.2f,
+                               .voltage_max    = 24.0f,
+                               .current_max    = 20.0f,
+                               .reduction_rate = 19.203f },
+    [MOTOR_SIM_VESC]       = { .inertia        = 1.0e-4f,
+                               .viscous        = 1.0e-5f,
+                               .coulomb        = 1.0e-2f,
+                               .torque_const   = 0.03f,
+                               .resistance     = 0.05f,
+                               .voltage_max    = 24.0f,
+                               .current_max    = 40.0f,
+                               .reduction_rate = 1.0f },
+    [MOTOR_SIM_TB6612]     = { .inertia        = 5.0e-7f,
+                               .viscous        = 1.0e-7f,
+                               .coulomb        = 1.0e-4f,
+                               .torque_const   = 0.0127f,
+                               .resistance     = 6.0f,
+                               .voltage_max    = 12.0f,
+                               .current_max    = 1.2f,
+                               .reduction_rate = 30.0f },
+};
+
+static MotorSim_t* sims[MOTOR_SIM_NUM];
+static size_t      sim_size   = 0;
+static uint32_t    step_count = 0;
+static bool        drive_dwt  = false; ///< 由仿真时钟推进 DWT->CYCCNT
+
+static float clamp_value(const float value, const float max)
+{
+    if (value > max)
+        return max;
+    if (value < -max)
+        return -max;
+    return value;
+}
+
+/**
+ * 把 [-max, max] 线性映射为 bits 位无符号整数（达妙协议）
+ */
+static uint32_t float_to_uint(const float value, const float max, const uint32_t bits)
+{
+    const float    span = (float) ((1U << bits) - 1U);
+    const float    x    = (clamp_value(value, max) + max) / (2.0f * max) * span;
+    const uint32_t u    = (uint32_t) (x + 0.5f);
+    return u > (1U << bits) - 1U ? (1U << bits) - 1U : u;
+}
+
+static void put_be16(uint8_t* bytes, const int32_t value)
+{
+    bytes[0] = (uint8_t) (value >> 8);
+    bytes[1] = (uint8_t) value;
+}
+
+static void put_be32(uint8_t* bytes, const int32_t value)
+{
+    bytes[0] = (uint8_t) (value >> 24);
+    bytes[1] = (uint8_t) (value >> 16);
+    bytes[2] = (uint8_t) (value >> 8);
+    bytes[3] = (uint8_t) value;
+}
+
+static int32_t get_be32(const uint8_t* bytes)
+{
+    return (int32_t) ((uint32_t) bytes[0] << 24 | (uint32_t) bytes[1] << 16 |
+                      (uint32_t) bytes[2] << 8 | bytes[3]);
+}
+
+static float get_le_float(const uint8_t* bytes)
+{
+    float value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+/**
+ * 大疆电调电流指令满量程
+ * @return (原始值满量程, 对应电流)
+ */
+static void dji_iq_scale(const MotorSim_t* hsim, float* raw_max, float* current_max)
+{
+    if (hsim->type == MOTOR_SIM_M2006_C610)
+    {
+        *raw_max     = 10000.0f;
+        *current_max = 10.0f;
+    }
+    else
+    {
+        *raw_max     = 16384.0f;
+        *current_max = 20.0f;
+    }
+}
+
+/**
+ * 处理大疆电流指令帧
+ */
+static void dji_command(MotorSim_t* hsim, const CAN_Frame_t* frame)
+{
+    if (frame->ide != CAN_ID_STD)
+        return;
+    int32_t slot;
+    if (frame->id == SIM_DJI_CMD_1_4 && hsim->id >= 1 && hsim->id <= 4)
+        slot = hsim->id - 1;
+    else if (frame->id == SIM_DJI_CMD_5_8 && hsim->id >= 5 && hsim->id <= 8)
+        slot = hsim->id - 5;
+    else
+        return;
+
+    float raw_max, current_max;
+    dji_iq_scale(hsim, &raw_max, &current_max);
+    const uint8_t* bytes = frame->data + slot * 2;
+    const int16_t  raw   = (int16_t) ((uint16_t) bytes[0] << 8 | bytes[1]);
+    hsim->current_cmd = (float) raw / raw_max * current_max;
+}
+
+/**
+ * 处理达妙指令帧
+ */
+static void dm_command(MotorSim_t* hsim, const CAN_Frame_t* frame)
+{
+    if (frame->ide != CAN_ID_STD || (frame->id & 0x0FF) != hsim->id)
+        return;
+    const uint32_t mode = frame->id & 0xF00;
+
+    // 特殊指令：前 7 字节为 0xFF
+    bool special = frame->dlc == 8;
+    for (int i = 0; i < 7 && special; i++)
+        special = frame->data[i] == 0xFF;
+    if (special)
+    {
+        switch (frame->data[7])
+        {
+        case SIM_DM_ENABLE:
+            hsim->enable = true;
+            break;
+        case SIM_DM_DISABLE:
+            hsim->enable = false;
+            break;
+        case SIM_DM_SET_ZERO:
+            hsim->plant.turns = 0;
+            hsim->plant.angle = 0;
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+
+    const float reduction = 1.0f / hsim->plant.inv_reduction_rate;
+    switch (mode)
+    {
+    case SIM_DM_CMD_VEL:
+        // 输出轴速度 (unit: rad/s)
+        hsim->mode         = MOTOR_SIM_MODE_VELOCITY;
+        hsim->velocity_ref = get_le_float(frame->data) * reduction;
+        break;
+    case SIM_DM_CMD_POS:
+        // 输出轴位置 (unit: rad) + 速度上限 (unit: rad/s)
+        hsim->mode         = MOTOR_SIM_MODE_POSITION;
+        hsim->position_ref = get_le_float(frame->data);
+        hsim->velocity_ref = fabsf(get_le_float(frame->data + 4)) * reduction;
+        break;
+    default: // MIT 模式暂不仿真
+        break;
+    }
+}
+
+/**
+ * 处理 VESC 指令帧
+ */
+static void vesc_command(MotorSim_t* hsim, const CAN_Frame_t* frame)
+{
+    const uint32_t target = frame->id & 0xFF;
+    if (frame->ide != CAN_ID_EXT || (target != hsim->id && target != SIM_VESC_BROADCAST))
+        return;
+    const int32_t value = get_be32(frame->data);
+
+    switch (frame->id >> 8)
+    {
+    case SIM_VESC_SET_DUTY:
+        hsim->mode     = MOTOR_SIM_MODE_DUTY;
+        hsim->duty_cmd = clamp_value((float) value / 1e5f, 1.0f);
+        break;
+    case SIM_VESC_SET_CURRENT:
+        hsim->mode        = MOTOR_SIM_MODE_CURRENT;
+        hsim->current_cmd = (float) value / 1e3f;
+        break;
+    case SIM_VESC_SET_CURRENT_BRAKE:
+    {
+        // 刹车电流总是与转动方向相反
+        const float brake = fabsf((float) value / 1e3f);
+        hsim->mode        = MOTOR_SIM_MODE_CURRENT;
+        hsim->current_cmd = hsim->plant.velocity > 0   ? -brake
+                            : hsim->plant.velocity < 0 ? brake
+                                                       : 0.0f;
+        break;
+    }
+    case SIM_VESC_SET_RPM:
+        hsim->mode         = MOTOR_SIM_MODE_VELOCITY;
+        hsim->velocity_ref = (float) value / (float) hsim->electrodes * MOTOR_PLANT_2PI / 60.0f;
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * 虚拟总线发送钩子：驱动发送的指令帧交给同一总线上的仿真电机
+ */
+static void motor_sim_tx_hook(CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame)
+{
+    for (size_t i = 0; i < sim_size; i++)
+    {
+        MotorSim_t* hsim = sims[i];
+        if (hsim->hcan != hcan)
+            continue;
+        switch (hsim->type)
+        {
+        case MOTOR_SIM_M3508_C620:
+        case MOTOR_SIM_M2006_C610:
+            dji_command(hsim, frame);
+            break;
+        case MOTOR_SIM_DM_S3519:
+            dm_command(hsim, frame);
+            break;
+        case MOTOR_SIM_VESC:
+            vesc_command(hsim, frame);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * 电调内部速度环 (PI)
+ * @return 电流指令 (unit: A)
+ */
+static float sim_velocity_loop(MotorSim_t* hsim, const float ref, const float dt)
+{
+    const float error  = ref - hsim->plant.velocity;
+    hsim->vel_integral = clamp_value(hsim->vel_integral + hsim->vel_ki * error * dt,
+                                     hsim->plant.current_max);
+    return hsim->vel_kp * error + hsim->vel_integral;
+}
+
+static void sim_plant_step(MotorSim_t* hsim, const float dt)
+{
+    if (hsim->type == MOTOR_SIM_TB6612)
+    {
+        float duty = 0.0f;
+        if (hsim->duty != NULL)
+            duty = clamp_value(*hsim->duty, 1.0f);
+        else if (hsim->duty_raw != NULL)
+            duty = clamp_value((float) *hsim->duty_raw / 32768.0f, 1.0f); // Q15
+        MotorPlant_StepVoltage(&hsim->plant, duty * hsim->supply_voltage, dt);
+        return;
+    }
+    if (!hsim->enable)
+    {
+        hsim->vel_integral = 0;
+        MotorPlant_StepCurrent(&hsim->plant, 0.0f, dt);
+        return;
+    }
+
+    switch (hsim->mode)
+    {
+    case MOTOR_SIM_MODE_VELOCITY:
+        MotorPlant_StepCurrent(&hsim->plant, sim_velocity_loop(hsim, hsim->velocity_ref, dt), dt);
+        break;
+    case MOTOR_SIM_MODE_POSITION:
+    {
+        const float reduction = 1.0f / hsim->plant.inv_reduction_rate;
+        const float error     = hsim->position_ref - MotorPlant_GetOutputAngle(&hsim->plant);
+        const float ref       = clamp_value(hsim->pos_kp * error * reduction, hsim->velocity_ref);
+        MotorPlant_StepCurrent(&hsim->plant, sim_velocity_loop(hsim, ref, dt), dt);
+        break;
+    }
+    case MOTOR_SIM_MODE_DUTY:
+        MotorPlant_StepVoltage(&hsim->plant, hsim->duty_cmd * hsim->plant.voltage_max, dt);
+        break;
+    default:
+        MotorPlant_StepCurrent(&hsim->plant, hsim->current_cmd, dt);
+        break;
+    }
+}
+
+/**
+ * 按 drop_rate 丢弃或注入一帧反馈，伪随机数使用 xorshift32，每次运行的结果相同
+ */
+static void sim_inject(MotorSim_t* hsim, const CAN_Frame_t* frame)
+{
+    if (hsim->drop_rate > 0)
+    {
+        uint32_t x = hsim->drop_seed;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        hsim->drop_seed = x;
+        if ((float) (x >> 8) < hsim->drop_rate * (float) (1U << 24))
+        {
+            hsim->dropped++;
+            return;
+        }
+    }
+    CAN_InjectFrame(hsim->hcan, frame);
+}
+
+/**
+ * 大疆反馈：转子机械角度 (13 位)、转子转速 (rpm)、实际电流、温度
+ */
+static void dji_feedback(MotorSim_t* hsim)
+{
+    float raw_max, current_max;
+    dji_iq_scale(hsim, &raw_max, &current_max);
+
+    CAN_Frame_t    frame = { .id = SIM_DJI_FEEDBACK_BASE + hsim->id, .ide = CAN_ID_STD, .dlc = 8 };
+    const uint32_t angle =
+            (uint32_t) (hsim->plant.angle / MOTOR_PLANT_2PI * SIM_DJI_ENCODER) & 0x1FFF;
+    const float    rpm   = hsim->plant.velocity * 60.0f / MOTOR_PLANT_2PI;
+    put_be16(frame.data + 0, (int32_t) angle);
+    put_be16(frame.data + 2, (int32_t) lroundf(clamp_value(rpm, 32767.0f)));
+    put_be16(frame.data + 4, (int32_t) lroundf(hsim->plant.current / current_max * raw_max));
+    frame.data[6] = SIM_TEMPERATURE;
+    frame.data[7] = 0;
+    sim_inject(hsim, &frame);
+}
+
+/**
+ * 达妙反馈：id / 状态、转子多圈位置 (16 位)、输出轴速度 (12 位)、输出轴力矩 (12 位)、温度
+ */
+static void dm_feedback(MotorSim_t* hsim)
+{
+    const MotorPlant_t* plant     = &hsim->plant;
+    const float         reduction = 1.0f / plant->inv_reduction_rate;
+
+    // 转子多圈位置折回 [-pos_max, pos_max)
+    const float span  = 2.0f * hsim->pos_max_rad;
+    float       angle = (float) plant->turns * MOTOR_PLANT_2PI + plant->angle + hsim->pos_max_rad;
+    angle             = fmodf(angle, span);
+    if (angle < 0)
+        angle += span;
+    angle -= hsim->pos_max_rad;
+
+    const uint32_t pos = float_to_uint(angle, hsim->pos_max_rad, 16);
+    const uint32_t vel = float_to_uint(MotorPlant_GetOutputVelocity(plant), hsim->vel_max_rad, 12);
+    const uint32_t t =
+            float_to_uint(plant->torque_const * plant->current * reduction, hsim->t_max, 12);
+
+    CAN_Frame_t frame = { .id = SIM_DM_MST_ID, .ide = CAN_ID_STD, .dlc = 8 };
+    frame.data[0]     = (uint8_t) ((hsim->enable ? 1U : 0U) << 4 | (hsim->id & 0x0F));
+    frame.data[1]     = (uint8_t) (pos >> 8);
+    frame.data[2]     = (uint8_t) pos;
+    frame.data[3]     = (uint8_t) (vel >> 4);
+    frame.data[4]     = (uint8_t) ((vel & 0x0F) << 4 | t >> 8);
+    frame.data[5]     = (uint8_t) t;
+    frame.data[6]     = SIM_TEMPERATURE;
+    frame.data[7]     = SIM_TEMPERATURE;
+    sim_inject(hsim, &frame);
+}
+
+/**
+ * VESC 反馈：STATUS 1 ~ 5
+ */
+static void vesc_feedback(MotorSim_t* hsim)
+{
+    const MotorPlant_t* plant = &hsim->plant;
+    const float         rpm   = plant->velocity * 60.0f / MOTOR_PLANT_2PI;
+    const float         vbus  = plant->voltage_max > 0 ? plant->voltage_max : 24.0f;
+    const float         duty  = clamp_value(
+            (plant->torque_const * plant->velocity + plant->current * plant->resistance) / vbus,
+            1.0f);
+    const float current_in = plant->current * duty;
+    const float revs       = (float) plant->turns + plant->angle / MOTOR_PLANT_2PI;
+    CAN_Frame_t frame      = { .ide = CAN_ID_EXT, .dlc = 8 };
+
+    frame.id = SIM_VESC_STATUS << 8 | hsim->id;
+    put_be32(frame.data + 0, (int32_t) lroundf(rpm * (float) hsim->electrodes));
+    put_be16(frame.data + 4, (int32_t) lroundf(plant->current * 10.0f));
+    put_be16(frame.data + 6, (int32_t) lroundf(duty * 1000.0f));
+    sim_inject(hsim, &frame);
+
+    frame.id = SIM_VESC_STATUS_2 << 8 | hsim->id;
+    put_be32(frame.data + 0, (int32_t) lroundf(hsim->amp_hours * 1e4f));
+    put_be32(frame.data + 4, 0);
+    sim_inject(hsim, &frame);
+
+    frame.id = SIM_VESC_STATUS_3 << 8 | hsim->id;
+    put_be32(frame.data + 0, (int32_t) lroundf(hsim->amp_hours * vbus * 1e4f));
+    put_be32(frame.data + 4, 0);
+    sim_inject(hsim, &frame);
+
+    frame.id = SIM_VESC_STATUS_4 << 8 | hsim->id;
+    put_be16(frame.data + 0, SIM_TEMPERATURE * 10);
+    put_be16(frame.data + 2, SIM_TEMPERATURE * 10);
+    put_be16(frame.data + 4, (int32_t) lroundf(current_in * 10.0f));
+    put_be16(frame.data + 6, (int32_t) lroundf(plant->angle * 360.0f / MOTOR_PLANT_2PI * 50.0f));
+    sim_inject(hsim, &frame);
+
+    frame.id = SIM_VESC_STATUS_5 << 8 | hsim->id;
+    put_be32(frame.data + 0, (int32_t) lroundf(revs * 6.0f * (float) hsim->electrodes));
+    put_be16(frame.data + 4, (int32_t) lroundf(vbus * 10.0f));
+    put_be16(frame.data + 6, 0);
+    sim_inject(hsim, &frame);
+}
+
+/**
+ * 把本步转过的角度累加到编码器定时器，未满一个计数的部分留到下一步
+ */
+static void tb6612_encoder_update(MotorSim_t* hsim, const float delta_angle)
+{
+    if (hsim->encoder == NULL)
+        return;
+    hsim->count_residual += delta_angle * hsim->counts_per_rad;
+    const int32_t counts = (int32_t) hsim->count_residual;
+    hsim->count_residual -= (float) counts;
+    __HAL_TIM_SET_COUNTER(hsim->encoder,
+                          (uint16_t) (__HAL_TIM_GET_COUNTER(hsim->encoder) + (uint32_t) counts));
+}
+
+/**
+ * 初始化一个仿真电机，并接入虚拟总线
+ *
+ * @attention 需要在 bsp/can_driver.h 中定义 USE_CAN_SIM，并对电机所在总线调用过 CAN_Start
+ * @param hsim 仿真电机
+ * @param config 配置
+ */
+void MotorSim_Init(MotorSim_t* hsim, const MotorSim_Config_t* config)
+{
+    memset(hsim, 0, sizeof(MotorSim_t));
+
+    hsim->type             = config->type;
+    hsim->hcan             = config->hcan;
+    hsim->id               = config->id;
+    hsim->feedback_divider = config->feedback_divider ? config->feedback_divider : 1;
+    hsim->pos_max_rad      = config->pos_max_rad > 0 ? config->pos_max_rad : 3.1415927f;
+    hsim->vel_max_rad      = config->vel_max_rad > 0 ? config->vel_max_rad : 45.0f;
+    hsim->t_max            = config->t_max > 0 ? config->t_max : 18.0f;
+    hsim->electrodes       = config->electrodes ? config->electrodes : 1;
+    hsim->duty             = config->duty;
+    hsim->duty_raw         = config->duty_raw;
+    hsim->encoder          = config->encoder;
+    hsim->counts_per_rad   = (float) config->roto_radio / MOTOR_PLANT_2PI;
+    hsim->drop_rate        = config->drop_rate;
+    hsim->drop_seed        = 0x9E3779B9U ^ config->id; // xorshift32 的种子不能为 0
+    hsim->supply_voltage   = config->supply_voltage > 0 ? config->supply_voltage : 12.0f;
+
+    if (!MotorPlant_Init(&hsim->plant, config->plant.inertia > 0 ? &config->plant
+                                                                 : &default_plant[config->type]))
+    {
+        MOTOR_SIM_ERROR_HANDLER();
+        return;
+    }
+
+    // 达妙需要收到使能帧才会输出，其余电调上电即可控制
+    hsim->enable = config->type != MOTOR_SIM_DM_S3519;
+    hsim->mode   = MOTOR_SIM_MODE_CURRENT;
+
+    // 按带宽整定内部速度环：kp = J * wc / Kt，积分转折频率取 wc / 4
+    hsim->vel_kp = hsim->plant.inertia * SIM_VELOCITY_BANDWIDTH / hsim->plant.torque_const;
+    hsim->vel_ki = hsim->vel_kp * SIM_VELOCITY_BANDWIDTH / 4.0f;
+    hsim->pos_kp = SIM_VELOCITY_BANDWIDTH / 8.0f;
+
+    if (sim_size >= MOTOR_SIM_NUM)
+    {
+        MOTOR_SIM_ERROR_HANDLER();
+        return;
+    }
+    sims[sim_size++] = hsim;
+    CAN_SetSimTxHook(motor_sim_tx_hook);
+}
+
+/**
+ * 推进仿真一步，并按 feedback_divider 发送反馈帧
+ *
+ * 反馈帧通过 CAN_InjectFrame 在本函数中同步分发给驱动，返回时电机数据已经更新
+ * @param dt 步长 (unit: s)，一般取控制周期
+ */
+void MotorSim_Step(const float dt)
+{
+    step_count++;
+    if (drive_dwt)
+        DWT->CYCCNT += (uint32_t) (dt * (float) SystemCoreClock + 0.5f);
+    for (size_t i = 0; i < sim_size; i++)
+    {
+        MotorSim_t* hsim = sims[i];
+
+        sim_plant_step(hsim, dt);
+        hsim->amp_hours += fabsf(hsim->plant.current) * dt / 3600.0f;
+        hsim->step_count++;
+
+        if (hsim->type == MOTOR_SIM_TB6612)
+        {
+            // 编码器每一步都计数，由 TB6612_Encoder_DataDecode 按自己的周期读取
+            tb6612_encoder_update(hsim, hsim->plant.velocity * dt);
+            continue;
+        }
+        if (hsim->step_count % hsim->feedback_divider != 0)
+            continue;
+        switch (hsim->type)
+        {
+        case MOTOR_SIM_M3508_C620:
+        case MOTOR_SIM_M2006_C610:
+            dji_feedback(hsim);
+            break;
+        case MOTOR_SIM_DM_S3519:
+            dm_feedback(hsim);
+            break;
+        case MOTOR_SIM_VESC:
+            vesc_feedback(hsim);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * 设置是否由仿真时钟推进 DWT->CYCCNT
+ *
+ * 仿真比实际时间快时，反馈帧的接收时间（来自 DWT->CYCCNT）与仿真时间不一致，
+ * 依赖帧间隔的功能（多圈位置的转动量预测、反馈超时检测等）也就无法仿真。
+ * 启用后每次 MotorSim_Step 把 DWT->CYCCNT 推进一个步长，接收时间与仿真时间同步。
+ * @note 会影响同时进行的 DWT 计时，只应在仿真期间启用
+ * @param enable 是否启用
+ */
+void MotorSim_DriveCycleCounter(const bool enable)
+{
+    drive_dwt = enable;
+}
+
+/**
+ * 获取仿真时钟
+ * @return 自启动以来 MotorSim_Step 的调用次数
+ */
+uint32_t MotorSim_GetStepCount(void)
+{
+    return step_count;
+}
+
+#endif // USE_CAN_SIM
@@ -0,0 +1,164 @@
+/**
+ * @file    motor_sim.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   simulated motors behind a virtual CAN bus
+ *
+ * 电机仿真：在 bsp/can_driver.h 的虚拟总线 (USE_CAN_SIM) 上模拟电调，
+ * 按真实协议接收驱动发出的指令帧，并生成驱动解析的反馈帧，用于在没有硬件时调试和整定
+ * Motor_PosCtrl_t / Motor_VelCtrl_t。
+ *
+ * 支持的电机类型
+ *  - M3508_C620 / M2006_C610：反馈 0x200 + id1，接收 0x200 / 0x1FF 电流指令
+ *  - DM_S3519：反馈 MST_ID，接收使能、速度、位置指令
+ *  - VESC：反馈 STATUS 1~5，接收占空比、电流、刹车电流、转速指令
+ *  - TB6612 + 编码器：读取 TB6612_t::duty_cmd，把编码器计数写入编码器定时器
+ *
+ * 仿真时钟由 MotorSim_Step 推进，与实际时间无关，可以任意快地运行闭环。
+ * 使用方法：
+ *   1. 在 bsp/can_driver.h 中定义 USE_CAN_SIM
+ *   2. 照常 CAN_Start、初始化电机和控制实例
+ *   3. MotorSim_Init 为每个电机创建仿真对象
+ *   4. 循环：MotorSim_Step(dt) -> 控制更新 -> 发送指令
+ * 低反馈频率和丢帧分别由 feedback_divider 和 drop_rate 仿真；
+ * 仿真依赖帧间隔的功能时，用 MotorSim_DriveCycleCounter 使帧的接收时间跟随仿真时钟
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef MOTOR_SIM_H
+#define MOTOR_SIM_H
+
+#include <stdbool.h>
+#include "main.h"
+#include "bsp/can_driver.h"
+#include "libs/motor_plant.h"
+
+#ifdef USE_CAN_SIM
+
+#ifndef MOTOR_SIM_NUM
+#    define MOTOR_SIM_NUM (16) ///< 仿真电机数量上限
+#endif
+
+typedef enum
+{
+    MOTOR_SIM_M3508_C620 = 0U,
+    MOTOR_SIM_M2006_C610,
+    MOTOR_SIM_DM_S3519,
+    MOTOR_SIM_VESC,
+    MOTOR_SIM_TB6612,
+
+    MOTOR_SIM_TYPE_COUNT
+} MotorSim_Type_t;
+
+/**
+ * 电调内部闭环模式
+ */
+typedef enum
+{
+    MOTOR_SIM_MODE_CURRENT = 0U, ///< 电流（或占空比）开环
+    MOTOR_SIM_MODE_VELOCITY,     ///< 内部速度环
+    MOTOR_SIM_MODE_POSITION,     ///< 内部位置环（达妙位置速度模式）
+    MOTOR_SIM_MODE_DUTY,         ///< 占空比 (VESC)
+} MotorSim_Mode_t;
+
+typedef struct
+{
+    MotorSim_Type_t    type;
+    CAN_HandleTypeDef* hcan;             ///< CAN 电机挂载的总线
+    uint8_t            id;               ///< DJI: id1 (1~8)，DM: id0，VESC: 控制器 id
+    uint32_t           feedback_divider; ///< 每多少个仿真步发送一次反馈，0 视为 1
+    float              drop_rate;        ///< 每帧反馈丢失的概率 [0, 1)，用于仿真丢帧
+    /**
+     * 模型参数，inertia 为 0 时使用该型号的默认参数
+     */
+    MotorPlant_Config_t plant;
+
+    /* DM，须与调试助手中的设置一致 */
+    float pos_max_rad; ///< 位置映射范围 (unit: rad)
+    float vel_max_rad; ///< 速度映射范围 (unit: rad/s)
+    float t_max;       ///< 力矩映射范围 (unit: N*m)
+
+    /* VESC */
+    uint8_t electrodes; ///< 与 VESC_Config_t::electrodes 一致，erpm = rpm * electrodes
+
+    /* TB6612 */
+    const float*       duty;           ///< 占空比来源，一般为 &TB6612_t::duty_cmd
+    const int32_t*     duty_raw;       ///< Q15 占空比来源，duty 为 NULL 时使用，定点控制时使用
+    TIM_HandleTypeDef* encoder;        ///< 编码器定时器
+    uint32_t           roto_radio;     ///< 倍频器 * 线数
+    float              supply_voltage; ///< 电源电压 (unit: V)，0 视为 12V
+} MotorSim_Config_t;
+
+typedef struct
+{
+    MotorSim_Type_t    type;
+    CAN_HandleTypeDef* hcan;
+    uint8_t            id;
+    uint32_t           feedback_divider;
+    uint32_t           step_count; ///< 已推进的仿真步数
+    float              drop_rate;
+    uint32_t           drop_seed;  ///< 丢帧的伪随机数状态
+    uint32_t           dropped;    ///< 已丢弃的反馈帧数
+
+    MotorPlant_t plant;
+
+    /* 电调内部状态 */
+    bool            enable;       ///< DM 需要使能帧，其余电机始终使能
+    MotorSim_Mode_t mode;         ///< 内部闭环模式
+    float           current_cmd;  ///< 电流指令 (unit: A)
+    float           velocity_ref; ///< 转子速度目标 (unit: rad/s)
+    float           position_ref; ///< 输出轴位置目标 (unit: rad)
+    float           duty_cmd;     ///< 占空比指令 [-1, 1]
+    float           vel_kp;       ///< 内部速度环比例系数 (unit: A/(rad/s))
+    float           vel_ki;       ///< 内部速度环积分系数 (unit: A/rad)
+    float           vel_integral; ///< 内部速度环积分项 (unit: A)
+    float           pos_kp;       ///< 内部位置环比例系数 (unit: 1/s)
+
+    /* DM */
+    float pos_max_rad;
+    float vel_max_rad;
+    float t_max;
+
+    /* VESC */
+    uint8_t electrodes;
+    float   amp_hours; ///< 累计消耗电量 (unit: Ah)
+
+    /* TB6612 */
+    const float*       duty;
+    const int32_t*     duty_raw;
+    TIM_HandleTypeDef* encoder;
+    float              counts_per_rad; ///< 转子每弧度的编码器计数
+    float              count_residual; ///< 未满一个计数的余量
+    float              supply_voltage;
+} MotorSim_t;
+
+void     MotorSim_Init(MotorSim_t* hsim, const MotorSim_Config_t* config);
+void     MotorSim_Step(float dt);
+void     MotorSim_DriveCycleCounter(bool enable);
+uint32_t MotorSim_GetStepCount(void);
+
+/**
+ * 设置输出轴负载力矩
+ * @param __SIM_HANDLE__ MotorSim_t*
+ * @param __TORQUE__ 负载力矩 (unit: N*m)，与转动方向相反时为阻力
+ */
+#define __MOTOR_SIM_SET_LOAD(__SIM_HANDLE__, __TORQUE__)                                           \
+    ((__SIM_HANDLE__)->plant.load_torque = (__TORQUE__))
+
+#endif // USE_CAN_SIM
+
+#endif // MOTOR_SIM_H
@@ -32,6 +32,7 @@
 void TB6612_SetSpeed(TB6612_t* hmotor, float speed)
 {
     speed *= hmotor->output_reverse ? -1.0f : 1.0f;
+    hmotor->duty_cmd = speed;
     if (speed >= 0)
     {
         HAL_GPIO_WritePin(hmotor->in1.port, hmotor->in1.pin, GPIO_PIN_RESET);
@@ -46,6 +47,38 @@ void TB6612_SetSpeed(TB6612_t* hmotor, float speed)
     }
 }
 
+/**
+ * 设置占空比，只使用整数运算
+ * @param hmotor handle
+ * @param duty 占空比，Q15 格式，[-TB6612_DUTY_ONE, TB6612_DUTY_ONE] 对应 [-1, 1]
+ */
+void TB6612_SetDuty(TB6612_t* hmotor, int32_t duty)
+{
+    if (hmotor->output_reverse)
+        duty = -duty;
+    if (duty > TB6612_DUTY_ONE)
+        duty = TB6612_DUTY_ONE;
+    if (duty < -TB6612_DUTY_ONE)
+        duty = -TB6612_DUTY_ONE;
+    hmotor->duty_raw = duty;
+
+    const uint64_t arr = __HAL_TIM_GET_AUTORELOAD(hmotor->pwm.htim);
+    const uint32_t mag = duty >= 0 ? (uint32_t) duty : (uint32_t) -duty;
+    // 与 PWM_SetDutyCircle 相同地四舍五入
+    const uint32_t compare = (uint32_t) ((arr * mag + TB6612_DUTY_ONE / 2) / TB6612_DUTY_ONE);
+    if (duty >= 0)
+    {
+        HAL_GPIO_WritePin(hmotor->in1.port, hmotor->in1.pin, GPIO_PIN_RESET);
+        HAL_GPIO_WritePin(hmotor->in2.port, hmotor->in2.pin, GPIO_PIN_SET);
+    }
+    else
+    {
+        HAL_GPIO_WritePin(hmotor->in1.port, hmotor->in1.pin, GPIO_PIN_SET);
+        HAL_GPIO_WritePin(hmotor->in2.port, hmotor->in2.pin, GPIO_PIN_RESET);
+    }
+    PWM_SetCompare(&hmotor->pwm, compare);
+}
+
 /**
  * 使能电机
  * @param hmotor handle
@@ -95,6 +128,8 @@ void TB6612_Init(TB6612_t* hmotor, const TB6612_Config_t* config)
     hmotor->sampling_period  = config->sampling_period;
     hmotor->roto_radio       = config->roto_radio;
     hmotor->reduction_radio  = config->reduction_radio;
+    hmotor->angle_per_tick   = 360.0f / ((float) config->roto_radio * config->reduction_radio);
+    Seqlock_Init(&hmotor->lock);
 }
 
 /**
@@ -103,14 +138,75 @@ void TB6612_Init(TB6612_t* hmotor, const TB6612_Config_t* config)
  * @param hmotor handle
  */
 void TB6612_Encoder_DataDecode(TB6612_t* hmotor)
+{
+    TB6612_Encoder_RawDecode(hmotor);
+    /* 角度由整数计数换算，不累加浮点增量，不会随圈数漂移 */
+    const float delta = (float) hmotor->delta_ticks * hmotor->angle_per_tick;
+    hmotor->angle     = (float) hmotor->ticks * hmotor->angle_per_tick;
+    hmotor->velocity  = delta / hmotor->sampling_period / 360.0f * 60.0f; // 实际转速 (unit: rpm)
+    if (hmotor->observer != NULL)
+        VelocityObserver_Update(hmotor->observer,
+                                hmotor->delta_ticks,
+                                hmotor->velocity,
+                                hmotor->output_reverse ? -hmotor->duty_cmd : hmotor->duty_cmd);
+}
+
+/**
+ * 电机编码器数据解算，只更新原始计数 ticks 和 delta_ticks，不使用浮点运算
+ * @note 用于定点控制，调用方式与 TB6612_Encoder_DataDecode 相同，两者只调用其一；
+ *       本函数不更新 angle 和 velocity
+ * @param hmotor handle
+ */
+void TB6612_Encoder_RawDecode(TB6612_t* hmotor)
 {
     /* @note: 假定转速不会快到数值溢出 */
     const int16_t counter = __HAL_TIM_GET_COUNTER(hmotor->encoder);
-    /* 计算间隔内旋转的角度 */
-    const float delta = (hmotor->feedback_reverse ? -1.0f : 1.0f) * (float) counter /
-                        ((float) hmotor->roto_radio * hmotor->reduction_radio) * 360.0f;
-    hmotor->angle += delta;
-    hmotor->velocity = delta / hmotor->sampling_period / 360.0f * 60.0f; // 实际转速 (unit: rpm)
+    hmotor->delta_ticks   = hmotor->feedback_reverse ? -counter : counter;
+    Seqlock_WriteBegin(&hmotor->lock);
+    hmotor->ticks += hmotor->delta_ticks;
+    Seqlock_WriteEnd(&hmotor->lock);
     /* 清零计数 */
     __HAL_TIM_SET_COUNTER(hmotor->encoder, 0);
 }
+
+/**
+ * 角度清零
+ *
+ * 在任务中调用时，解算的定时器中断可能在写 64 位位置的中途打断，关中断后写入；
+ * 中断中调用时不会提前打开中断
+ * @param hmotor handle
+ */
+void TB6612_ResetAngle(TB6612_t* hmotor)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Seqlock_WriteBegin(&hmotor->lock);
+    hmotor->ticks = 0;
+    hmotor->angle = 0.0f;
+    Seqlock_WriteEnd(&hmotor->lock);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * 挂接速度观测器，此后 TB6612_Encoder_DataDecode 中更新观测器，__TB6612_GET_VELOCITY 返回观测值
+ *
+ * 观测器以每个采样间隔为一步，位置为编码器计数，指令为 [-1, 1] 的占空比，
+ * 因此 config->command_gain 的单位为 满占空比产生的输出轴加速度 (deg/s^2)；
+ * velocity 由同一组计数差分得到，不含新的信息，config->velocity_noise 应为 0
+ * @note 初始化观测器耗时数毫秒，不要在中断中调用；定点控制使用的 TB6612_Encoder_RawDecode
+ *       不更新观测器
+ * @param hmotor handle
+ * @param observer 观测器，NULL 时取消挂接
+ * @param config 观测器参数
+ */
+void TB6612_AttachObserver(TB6612_t*                        hmotor,
+                           VelocityObserver_t*              observer,
+                           const VelocityObserver_Config_t* config)
+{
+    // 先摘下旧的观测器，初始化期间解算不会使用
+    hmotor->observer = NULL;
+    if (observer == NULL)
+        return;
+    VelocityObserver_Init(observer, config, hmotor->sampling_period, hmotor->angle_per_tick);
+    hmotor->observer = observer;
+}
@@ -30,6 +30,8 @@
 
 #include "bsp/gpio_driver.h"
 #include "bsp/pwm.h"
+#include "libs/seqlock.h"
+#include "libs/velocity_observer.h"
 
 typedef struct
 {
@@ -43,10 +45,18 @@ typedef struct
     uint32_t           roto_radio;       //< 倍频器 * 线数
     float              reduction_radio;  //< 减速比
 
-    float angle;    //< 输出轴角度 (unit: deg)
-    float velocity; //< 输出轴转速 (unit: rpm)
+    float angle;          //< 输出轴角度 (unit: deg)
+    float velocity;       //< 输出轴转速 (unit: rpm)
+    float angle_per_tick; ///< 一个编码器计数对应的输出轴角度 (unit: deg)
 
-    float duty_cmd; //< -1 ~ 1 占空比
+    int64_t   ticks;       ///< 输出轴多圈位置，已计入反向，通过 TB6612_GetTicks 读取 (unit: 计数)
+    int32_t   delta_ticks; ///< 最近一个采样间隔内的计数，已计入反向
+    Seqlock_t lock;        ///< 保护 ticks，解算在定时器中断中写，任务中读取 64 位值可能被打断
+
+    float   duty_cmd; //< -1 ~ 1 占空比
+    int32_t duty_raw; ///< Q15 占空比，由 TB6612_SetDuty 设置
+
+    VelocityObserver_t* observer; ///< 速度观测器，NULL 时不使用，见 TB6612_AttachObserver
 } TB6612_t;
 
 typedef struct
@@ -62,12 +72,54 @@ typedef struct
 } TB6612_Config_t;
 
 #define __TB6612_GET_ANGLE(__TB6612_HANDLE__)    (((TB6612_t*) (__TB6612_HANDLE__))->angle)
-#define __TB6612_GET_VELOCITY(__TB6612_HANDLE__) (((TB6612_t*) (__TB6612_HANDLE__))->velocity)
-#define __TB6612_RESET_ANGLE(__TB6612_HANDLE__)  (((TB6612_t*) (__TB6612_HANDLE__))->angle = 0.0f)
+#define __TB6612_GET_VELOCITY(__TB6612_HANDLE__) TB6612_GetVelocity((TB6612_t*) (__TB6612_HANDLE__))
+#define __TB6612_RESET_ANGLE(__TB6612_HANDLE__)  TB6612_ResetAngle((TB6612_t*) (__TB6612_HANDLE__))
+
+#define TB6612_DUTY_ONE (32768) ///< Q15 格式的满占空比
+
+/**
+ * 读取输出轴转速
+ * @param hmotor handle
+ * @return 挂接了速度观测器时为观测值，否则为编码器差分值 (unit: rpm)
+ */
+static inline float TB6612_GetVelocity(const TB6612_t* hmotor)
+{
+    return hmotor->observer != NULL ? hmotor->observer->velocity : hmotor->velocity;
+}
+
+/**
+ * 读取输出轴多圈位置
+ * @note 64 位的位置不能一次读出，被解算打断时重读，连续 SEQLOCK_READ_RETRIES 次被打断时短暂关中断
+ * @param hmotor handle
+ * @return 输出轴多圈位置，已计入反向 (unit: 编码器计数)
+ */
+static inline int64_t TB6612_GetTicks(const TB6612_t* hmotor)
+{
+    int64_t ticks;
+    for (uint32_t i = 0; i < SEQLOCK_READ_RETRIES; i++)
+    {
+        const unsigned seq = Seqlock_ReadBegin(&hmotor->lock);
+        ticks              = hmotor->ticks;
+        if (!Seqlock_ReadRetry(&hmotor->lock, seq))
+            return ticks;
+    }
+    // 重读次数用完时关中断再读一次，解算不能再打断，不会返回写了一半的值
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ticks = hmotor->ticks;
+    __set_PRIMASK(primask);
+    return ticks;
+}
 
 void TB6612_SetSpeed(TB6612_t* hmotor, float speed);
+void TB6612_SetDuty(TB6612_t* hmotor, int32_t duty);
 void TB6612_Enable(TB6612_t* hmotor);
 void TB6612_Disable(TB6612_t* hmotor);
 void TB6612_Init(TB6612_t* hmotor, const TB6612_Config_t* config);
 void TB6612_Encoder_DataDecode(TB6612_t* hmotor);
+void TB6612_Encoder_RawDecode(TB6612_t* hmotor);
+void TB6612_ResetAngle(TB6612_t* hmotor);
+void TB6612_AttachObserver(TB6612_t*                        hmotor,
+                           VelocityObserver_t*              observer,
+                           const VelocityObserver_Config_t* config);
 #endif // TB6612_H
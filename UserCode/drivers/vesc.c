@@ -23,6 +23,7 @@
  */
 #include "vesc.h"
 
+#include <math.h>
 #include <string.h>
 #include "bsp/can_driver.h"
 #include "main.h"
@@ -30,16 +31,20 @@
 static VESC_FeedbackMap map[VESC_CAN_NUM];
 static size_t           map_size = 0;
 
+static void vesc_reset_angle(VESC_t* hvesc);
+
 static inline int to_map_id(const int id)
 {
     return id - VESC_ID_OFFSET;
 }
 
-static inline VESC_t* get_vesc_handle(VESC_t* motors[VESC_NUM], const CAN_RxHeaderTypeDef* header)
+static inline VESC_t* get_vesc_handle(VESC_t*        motors[VESC_NUM],
+                                      const uint32_t ide,
+                                      const uint32_t ext_id)
 {
-    if (header->IDE != CAN_ID_EXT)
+    if (ide != CAN_ID_EXT)
         return NULL;
-    const uint8_t id = header->ExtId & 0xFF;
+    const uint8_t id = ext_id & 0xFF;
     // 不在注册范围内
     if (id < VESC_ID_OFFSET || id >= VESC_ID_OFFSET + VESC_NUM)
         return NULL;
@@ -165,6 +170,25 @@ static int16_t be_to_i16(const uint8_t* bytes)
     return (int16_t) ((uint16_t) bytes[0] << 8 | (uint16_t) bytes[1]);
 }
 
+/**
+ * 把转速从上次积分的时间积分到本帧的接收时间，得到预测的转动量，调用者负责加锁
+ *
+ * 转速 (STATUS) 和位置 (STATUS_4) 分别反馈，两帧位置之间的每一帧转速都参与梯形积分，
+ * 位置反馈的频率可以低于转速反馈，丢失的转速帧只使积分的步长变大；
+ * 没有接收时间（直接调用 VESC_CAN_DataDecode）时间隔为 0，预测值为 0，退化为最短路径；
+ * 间隔超过 VESC_UNWRAP_MAX_PERIODS 个状态帧周期时转速已不可信，本次位置反馈同样取最短路径
+ * @param velocity 本帧的转速，收到位置反馈时为当前的 velocity (unit: rpm)
+ */
+static inline void vesc_turns_integrate(VESC_t* hvesc, const float velocity)
+{
+    const uint32_t dt = hvesc->feedback_timestamp - hvesc->turns_timestamp;
+    if (dt > hvesc->unwrap_max_dt)
+        hvesc->turns_gap = true;
+    hvesc->turns_predicted +=
+            (hvesc->velocity + velocity) * 0.5f * (float) dt * hvesc->ticks_per_rpm_cycle;
+    hvesc->turns_timestamp = hvesc->feedback_timestamp;
+}
+
 /**
  * VESC 反馈数据解算
  * @param hvesc vesc handle
@@ -175,6 +199,7 @@ void VESC_CAN_DataDecode(VESC_t*                       hvesc,
                          const VESC_CAN_PocketStatus_t pocket_id,
                          const uint8_t                 data[8])
 {
+    Seqlock_WriteBegin(&hvesc->lock);
     ++hvesc->feedback_count;
 
     switch (pocket_id)
@@ -183,7 +208,10 @@ void VESC_CAN_DataDecode(VESC_t*                       hvesc,
         hvesc->feedback.erpm          = (float) be_to_i32(data + 0);
         hvesc->feedback.current_motor = (float) be_to_i16(data + 4) / 10.0f;
         hvesc->feedback.duty          = (float) be_to_i16(data + 6) / 1000.0f;
-        hvesc->velocity               = hvesc->feedback.erpm / (float) hvesc->electrodes;
+        const float velocity          = hvesc->feedback.erpm / (float) hvesc->electrodes;
+        // 先以新旧转速积分到本帧，再更新转速
+        vesc_turns_integrate(hvesc, velocity);
+        hvesc->velocity = velocity;
         break;
     case VESC_CAN_STATUS_2:
         hvesc->feedback.amp_hours         = (float) be_to_i32(data + 0) / 10000.0f;
@@ -197,36 +225,104 @@ void VESC_CAN_DataDecode(VESC_t*                       hvesc,
         hvesc->feedback.mos_temperature   = (float) be_to_i16(data + 0) / 10.0f;
         hvesc->feedback.motor_temperature = (float) be_to_i16(data + 2) / 10.0f;
         hvesc->feedback.current_in        = (float) be_to_i16(data + 4) / 10.0f;
-        const float new_pos               = (float) be_to_i16(data + 6) / 50.0f;
-        // 统计旋转圈数，反馈频率必须 > 转速(rpm) / 30
-        if (new_pos < 90 && hvesc->feedback.pos > 270)
-            hvesc->feedback.round_cnt++;
-        if (new_pos > 270 && hvesc->feedback.pos < 90)
-            hvesc->feedback.round_cnt--;
-        hvesc->feedback.pos = new_pos;
-        hvesc->abs_angle    = (float) hvesc->feedback.round_cnt * 360.0f + hvesc->feedback.pos -
-                           hvesc->angle_zero;
+        hvesc->feedback.raw_pos           = (uint16_t) be_to_i16(data + 6);
+        hvesc->feedback.pos               = (float) hvesc->feedback.raw_pos / VESC_TICKS_PER_DEGREE;
+        // 按预测的转动量选取整圈数；多圈位置只做整数累加，角度在读取时换算
+        vesc_turns_integrate(hvesc, hvesc->velocity);
+        hvesc->feedback.round_cnt += MultiTurn_UpdatePredicted(
+                &hvesc->turns,
+                hvesc->feedback.raw_pos,
+                hvesc->turns_gap ? 0 : (int32_t) lroundf(hvesc->turns_predicted));
+        hvesc->turns_predicted = 0;
+        hvesc->turns_gap       = false;
         break;
     case VESC_CAN_STATUS_5:
         hvesc->feedback.tachometer_value = (float) be_to_i32(data + 0);
         hvesc->feedback.vin              = (float) be_to_i16(data + 4) / 10.0f;
         break;
     default: // 其他数据乱入
+        Seqlock_WriteEnd(&hvesc->lock);
         return;
     }
     if (hvesc->feedback_count == 50 && hvesc->auto_zero) // 第 50 次反馈时清零角度
-        VESC_ResetAngle(hvesc);
+        vesc_reset_angle(hvesc);
+    Seqlock_WriteEnd(&hvesc->lock);
+
+    if (pocket_id == VESC_CAN_STATUS || pocket_id == VESC_CAN_STATUS_4)
+        hvesc->fresh = true;
+}
+
+/**
+ * 读取反馈数据的一致副本
+ *
+ * 不关中断，也不阻塞解包：复制期间被解包打断时重新复制
+ * @param hvesc vesc handle
+ * @param out 输出
+ * @return 连续 SEQLOCK_READ_RETRIES 次都被打断时返回 false，此时 out 无效
+ */
+bool VESC_GetSnapshot(const VESC_t* hvesc, VESC_Snapshot_t* out)
+{
+    for (uint32_t i = 0; i < SEQLOCK_READ_RETRIES; i++)
+    {
+        const unsigned seq  = Seqlock_ReadBegin(&hvesc->lock);
+        out->feedback       = hvesc->feedback;
+        out->velocity       = hvesc->velocity;
+        out->abs_ticks      = MultiTurn_Get(&hvesc->turns);
+        out->feedback_count = hvesc->feedback_count;
+        if (!Seqlock_ReadRetry(&hvesc->lock, seq))
+        {
+            // 角度在锁外由复制下来的多圈位置换算
+            out->abs_angle = (float) out->abs_ticks * (1.0f / VESC_TICKS_PER_DEGREE);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 记录速度 (STATUS) 或位置 (STATUS_4) 反馈的接收时间
+ */
+static inline void vesc_stamp(VESC_t* hvesc, const uint32_t pocket_id, const uint32_t timestamp)
+{
+    if (pocket_id == VESC_CAN_STATUS || pocket_id == VESC_CAN_STATUS_4)
+        hvesc->feedback_timestamp = timestamp;
+}
+
+/**
+ * 路由解码函数
+ * @param handle vesc handle
+ * @param frame 反馈帧
+ */
+static void vesc_route_decode(void* handle, const CAN_Frame_t* frame)
+{
+    vesc_stamp(handle, frame->id >> 8, frame->timestamp);
+    VESC_CAN_DataDecode(handle, frame->id >> 8, frame->data);
 }
 
 /**
  * 清零 VESC 输出角度
+ * @note 与解包共用一把锁，调用期间打断本函数的读者 VESC_GetSnapshot 会重读，可能返回 false
+ * @note 在任务中调用时短暂关中断
  * @param hvesc vesc handle
  */
 void VESC_ResetAngle(VESC_t* hvesc)
+{
+    // 与解包互斥，见 DJI_ResetAngle
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Seqlock_WriteBegin(&hvesc->lock);
+    vesc_reset_angle(hvesc);
+    Seqlock_WriteEnd(&hvesc->lock);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * 清零输出角度，调用者负责加锁
+ */
+static void vesc_reset_angle(VESC_t* hvesc)
 {
     hvesc->feedback.round_cnt = 0;
-    hvesc->angle_zero         = hvesc->feedback.pos;
-    hvesc->abs_angle          = 0;
+    MultiTurn_Zero(&hvesc->turns);
 }
 
 /**
@@ -237,12 +333,22 @@ void VESC_ResetAngle(VESC_t* hvesc)
 void VESC_Init(VESC_t* hvesc, const VESC_Config_t* config)
 {
     memset(hvesc, 0, sizeof(VESC_t));
+    Seqlock_Init(&hvesc->lock);
 
     hvesc->hcan       = config->hcan;
     hvesc->id         = config->id;
     hvesc->electrodes = config->electrodes;
     hvesc->enable     = true;
     hvesc->auto_zero  = config->auto_zero;
+    MultiTurn_Init(&hvesc->turns, VESC_TICKS_PER_ROUND);
+    hvesc->ticks_per_rpm_cycle = VESC_TICKS_PER_ROUND / 60.0f / (float) SystemCoreClock;
+
+    const uint32_t status_hz = config->status_hz ? config->status_hz : VESC_STATUS_HZ;
+    const uint64_t max_dt    = (uint64_t) VESC_UNWRAP_MAX_PERIODS * SystemCoreClock / status_hz;
+    hvesc->unwrap_max_dt     = max_dt < UINT32_MAX ? (uint32_t) max_dt : UINT32_MAX;
+
+    CAN_TxCache_Init(&hvesc->tx_cache,
+                     config->keepalive_ms ? config->keepalive_ms : VESC_CMD_KEEPALIVE_MS);
 
     VESC_t** mapped_motors = NULL;
     for (int i = 0; i < map_size; i++)
@@ -255,7 +361,9 @@ void VESC_Init(VESC_t* hvesc, const VESC_Config_t* config)
         mapped_motors = map[map_size].motors;
         map_size++;
     }
-    if (mapped_motors[to_map_id(hvesc->id)] != NULL)
+    // 同一个 handle 重复初始化（重新配置）时不再重复声明带宽
+    const bool reinit = mapped_motors[to_map_id(hvesc->id)] == hvesc;
+    if (mapped_motors[to_map_id(hvesc->id)] != NULL && !reinit)
     {
         // 电调 ID 冲突
         Error_Handler();
@@ -264,10 +372,34 @@ void VESC_Init(VESC_t* hvesc, const VESC_Config_t* config)
     {
         mapped_motors[to_map_id(hvesc->id)] = hvesc;
     }
+
+    /* 注册路由，反馈帧 ExtId 为 pocket_id << 8 | id */
+    static const VESC_CAN_PocketStatus_t status_ids[] = {
+        VESC_CAN_STATUS,   VESC_CAN_STATUS_2, VESC_CAN_STATUS_3,
+        VESC_CAN_STATUS_4, VESC_CAN_STATUS_5,
+    };
+    for (size_t i = 0; i < sizeof(status_ids) / sizeof(status_ids[0]); i++)
+        CAN_RegisterRoute(hvesc->hcan,
+                          CAN_ID_EXT,
+                          (uint32_t) status_ids[i] << 8 | hvesc->id,
+                          vesc_route_decode,
+                          hvesc);
+
+    /* 声明带宽，指令帧 DLC 为 4，状态帧 DLC 为 8；超出预算时只计入 over_budget，不影响注册 */
+    if (reinit)
+        return;
+    CAN_ReserveBandwidth(hvesc->hcan,
+                         CAN_ID_EXT,
+                         4,
+                         config->command_hz ? config->command_hz : VESC_CMD_HZ);
+    for (size_t i = 0; i < sizeof(status_ids) / sizeof(status_ids[0]); i++)
+        CAN_ReserveBandwidth(hvesc->hcan, CAN_ID_EXT, 8, status_hz);
 }
 
 /**
  * 发送指令
+ *
+ * 编码后的指令与上一次相同且未到保活时间时不发送，见 VESC_CMD_KEEPALIVE_MS
  * @param hvesc vesc handle
  * @param pocket_id 数据包类型
  * @param value 指令值
@@ -276,14 +408,15 @@ void VESC_SendSetCmd(VESC_t* hvesc, const VESC_CAN_PocketSet_t pocket_id, const
 {
     static uint8_t data[8] = { 0 };
     get_set_command_data(hvesc, pocket_id, value, data);
-    CAN_SendMessage(hvesc->hcan,
-                    &(CAN_TxHeaderTypeDef) {
-                            .ExtId = pocket_id << 8 | hvesc->id,
-                            .IDE   = CAN_ID_EXT,
-                            .RTR   = CAN_RTR_DATA,
-                            .DLC   = 4,
-                    },
-                    data);
+    CAN_SendMessageCached(&hvesc->tx_cache,
+                          hvesc->hcan,
+                          &(CAN_TxHeaderTypeDef) {
+                                  .ExtId = pocket_id << 8 | hvesc->id,
+                                  .IDE   = CAN_ID_EXT,
+                                  .RTR   = CAN_RTR_DATA,
+                                  .DLC   = 4,
+                          },
+                          data);
 }
 
 /**
@@ -296,13 +429,31 @@ void VESC_SendSetCmd(VESC_t* hvesc, const VESC_CAN_PocketSet_t pocket_id, const
  */
 void VESC_CAN_Fifo0ReceiveCallback(CAN_HandleTypeDef* hcan)
 {
-    CAN_RxHeaderTypeDef header;
-    uint8_t             data[8];
-    if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &header, data) != HAL_OK)
+    CAN_DrainFifo(hcan, CAN_RX_FIFO0, VESC_CAN_FrameReceiveCallback);
+}
+
+/**
+ * 根据 CAN 句柄和扩展帧 ID 找到电调并解包
+ */
+static inline void vesc_receive(const CAN_HandleTypeDef* hcan,
+                                const uint32_t           ide,
+                                const uint32_t           ext_id,
+                                const uint8_t            data[],
+                                const uint32_t           timestamp)
+{
+    for (int i = 0; i < map_size; i++)
     {
-        return;
+        if (hcan == map[i].hcan)
+        {
+            VESC_t* hvesc = get_vesc_handle(map[i].motors, ide, ext_id);
+            if (hvesc != NULL)
+            {
+                vesc_stamp(hvesc, ext_id >> 8, timestamp);
+                VESC_CAN_DataDecode(hvesc, ext_id >> 8, data);
+            }
+            return;
+        }
     }
-    VESC_CAN_BaseReceiveCallback(hcan, &header, data);
 }
 
 /**
@@ -315,14 +466,16 @@ void VESC_CAN_BaseReceiveCallback(CAN_HandleTypeDef*         hcan,
                                   const CAN_RxHeaderTypeDef* header,
                                   const uint8_t              data[])
 {
-    for (int i = 0; i < map_size; i++)
-    {
-        if (hcan == map[i].hcan)
-        {
-            VESC_t* hvesc = get_vesc_handle(map[i].motors, header);
-            if (hvesc != NULL)
-                VESC_CAN_DataDecode(hvesc, header->ExtId >> 8, data);
-            return;
-        }
-    }
+    // HAL 的 header 不带接收时间，以解包时间代替
+    vesc_receive(hcan, header->IDE, header->ExtId, data, DWT->CYCCNT);
+}
+
+/**
+ * CAN 帧接收回调函数，直接在 frame 上解包，无中间拷贝
+ * @param hcan
+ * @param frame 接收到的帧
+ */
+void VESC_CAN_FrameReceiveCallback(const CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame)
+{
+    vesc_receive(hcan, frame->ide, frame->id, frame->data, frame->timestamp);
 }
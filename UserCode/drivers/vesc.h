@@ -30,6 +30,9 @@
 #include <stdbool.h>
 
 #include "main.h"
+#include "bsp/can_driver.h"
+#include "libs/multiturn.h"
+#include "libs/seqlock.h"
 
 #ifndef VESC_CAN_NUM
 #    define VESC_CAN_NUM (2)
@@ -53,6 +56,40 @@
 #    define VESC_ID_OFFSET (0)
 #endif
 
+#ifndef VESC_CMD_KEEPALIVE_MS
+/**
+ * 指令帧保活间隔 (unit: ms)，指令内容不变时至少每隔该时间重发一次，
+ * 应小于 VESC 的 CAN 超时时间 (App Settings -> General -> Timeout)，定义为 0 则每次都发送
+ */
+#    define VESC_CMD_KEEPALIVE_MS (50U)
+#endif
+
+#ifndef VESC_CMD_HZ
+/**
+ * 默认的指令发送频率 (unit: Hz)，用于注册时声明总线带宽
+ */
+#    define VESC_CMD_HZ (1000U)
+#endif
+
+#ifndef VESC_STATUS_HZ
+/**
+ * 默认的每种状态帧的反馈频率 (VESC Tool 中的 CAN Status Rate, unit: Hz)，用于注册时声明总线带宽。
+ * 多圈位置由转速预测整圈数，STATUS_4 的频率不需要随转速提高，只要求两帧之间预测误差小于半圈
+ */
+#    define VESC_STATUS_HZ (50U)
+#endif
+
+#ifndef VESC_UNWRAP_MAX_PERIODS
+/**
+ * 转速积分的最大步长 (unit: 状态帧周期)，两帧速度或位置反馈的间隔更长时，
+ * 到下一帧位置反馈为止退化为最短路径选取整圈数
+ */
+#    define VESC_UNWRAP_MAX_PERIODS (8U)
+#endif
+
+#define VESC_TICKS_PER_DEGREE (50U) ///< 位置反馈 (STATUS_4) 的分辨率
+#define VESC_TICKS_PER_ROUND  (360U * VESC_TICKS_PER_DEGREE)
+
 /* 参数范围限制 */
 #define VESC_SET_DUTY_MAX              (1.0f)
 #define VESC_SET_CURRENT_MAX           (2e6f)
@@ -167,47 +204,74 @@ typedef enum
 
 typedef struct
 {
-    bool enable;    // 是否启用
-    bool auto_zero; // 是否自动判断零点
+    float erpm;          ///< 电转速
+    float pos;           ///< 绝对角度 0~360
+    float duty;          ///< 占空比
+    float current_motor; ///< 电机电流
+    float current_in;    ///< 输入电流
 
-    CAN_HandleTypeDef* hcan;
-    uint8_t            id;         ///< 控制器 id，0xFF 代表广播
-    uint8_t            electrodes; ///< 电极数
-    float              angle_zero; ///< 零点角度
+    float amp_hours; ///< AH
+    float amp_hours_charged;
+    float watt_hours; ///< WH
+    float watt_hours_charged;
 
-    uint32_t feedback_count; ///< 反馈数
-    struct
-    {
-        float erpm;          ///< 电转速
-        float pos;           ///< 绝对角度 0~360
-        float duty;          ///< 占空比
-        float current_motor; ///< 电机电流
-        float current_in;    ///< 输入电流
+    float motor_temperature; ///< 电机温度
+    float mos_temperature;   ///< MOSFET 温度
 
-        float amp_hours; ///< AH
-        float amp_hours_charged;
-        float watt_hours; ///< WH
-        float watt_hours_charged;
+    float vin; ///< 输入电压
+    float tachometer_value;
 
-        float motor_temperature; ///< 电机温度
-        float mos_temperature;   ///< MOSFET 温度
+    uint16_t raw_pos;   ///< 绝对角度原始值 (unit: 1 / VESC_TICKS_PER_DEGREE degree)
+    int32_t  round_cnt; ///< 圈数统计
+} VESC_Feedback_t;
 
-        float vin; ///< 输入电压
-        float tachometer_value;
+typedef struct
+{
+    bool enable;    // 是否启用
+    bool auto_zero; // 是否自动判断零点
 
-        int32_t round_cnt; ///< 圈数统计
-    } feedback;
+    CAN_HandleTypeDef* hcan;
+    uint8_t            id;         ///< 控制器 id，0xFF 代表广播
+    uint8_t            electrodes; ///< 电极数
 
-    float velocity;
-    float abs_angle;
+    uint32_t        feedback_count;     ///< 反馈数
+    uint32_t        feedback_timestamp; ///< 最近一帧速度或位置反馈的接收时间 (DWT 周期计数)
+    volatile bool   fresh;              ///< 解包速度或位置反馈后置位，由使用者读取后清除
+    Seqlock_t       lock;               ///< 解包时写 feedback、velocity 和 turns
+    VESC_Feedback_t feedback;
+
+    float       velocity;
+    MultiTurn_t turns;               ///< 多圈位置，通过 VESC_GetTicks 读取
+    uint32_t    turns_timestamp;     ///< 转动量已积分到的时间 (DWT 周期计数)
+    float       turns_predicted;     ///< 上一帧位置反馈以来由转速积分得到的转动量 (unit: 刻度)
+    float       ticks_per_rpm_cycle; ///< rpm 乘以 DWT 周期数得到转过的刻度数，用于预测转动量
+    uint32_t    unwrap_max_dt;       ///< 转速积分的最大步长 (unit: DWT 周期)
+    bool        turns_gap;           ///< 积分中出现过超过最大步长的间隔，本次预测不可信
+
+    CAN_TxCache_t tx_cache; ///< 指令帧发送缓存，记录发出 / 省略的帧数
 } VESC_t;
 
+/**
+ * 反馈数据的一致副本，见 VESC_GetSnapshot
+ */
+typedef struct
+{
+    VESC_Feedback_t feedback;
+    float           velocity;       ///< 转速 (unit: rpm)
+    float           abs_angle;      ///< 输出角度 (unit: degree)
+    int64_t         abs_ticks;      ///< 多圈位置 (unit: 1 / VESC_TICKS_PER_DEGREE degree)
+    uint32_t        feedback_count; ///< 反馈数
+} VESC_Snapshot_t;
+
 typedef struct
 {
     bool               auto_zero; ///< 自动重置零点
     CAN_HandleTypeDef* hcan;
     uint8_t            id;         ///< 控制器 id，0xFF 代表广播
-    uint8_t            electrodes; ///< 电极数
+    uint8_t            electrodes;   ///< 电极数
+    uint32_t           keepalive_ms; ///< 指令帧保活间隔 (unit: ms)，0 使用 VESC_CMD_KEEPALIVE_MS
+    uint32_t           command_hz;   ///< 指令发送频率 (unit: Hz)，0 使用 VESC_CMD_HZ
+    uint32_t           status_hz;    ///< 每种状态帧的反馈频率 (unit: Hz)，0 使用 VESC_STATUS_HZ
 } VESC_Config_t;
 
 typedef struct
@@ -216,15 +280,55 @@ typedef struct
     VESC_t*            motors[VESC_NUM];
 } VESC_FeedbackMap;
 
-#define __VESC_GET_ANGLE(__VESC_HANDLE__)    (((VESC_t*) (__VESC_HANDLE__))->abs_angle)
+#define __VESC_GET_ANGLE(__VESC_HANDLE__)    VESC_GetAngle((VESC_t*) (__VESC_HANDLE__))
 #define __VESC_GET_VELOCITY(__VESC_HANDLE__) (((VESC_t*) (__VESC_HANDLE__))->velocity)
 
+/**
+ * 读取多圈位置，已计入零点
+ * @note 64 位的位置不能一次读出，被解包打断时重读，连续 SEQLOCK_READ_RETRIES 次被打断时短暂关中断
+ * @param hvesc vesc handle
+ * @return 多圈位置 (unit: 1 / VESC_TICKS_PER_DEGREE degree)
+ */
+static inline int64_t VESC_GetTicks(const VESC_t* hvesc)
+{
+    int64_t ticks;
+    for (uint32_t i = 0; i < SEQLOCK_READ_RETRIES; i++)
+    {
+        const unsigned seq = Seqlock_ReadBegin(&hvesc->lock);
+        ticks              = MultiTurn_Get(&hvesc->turns);
+        if (!Seqlock_ReadRetry(&hvesc->lock, seq))
+            return ticks;
+    }
+    // 重读次数用完时关中断再读一次，解包不能再打断，不会返回写了一半的值
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ticks = MultiTurn_Get(&hvesc->turns);
+    __set_PRIMASK(primask);
+    return ticks;
+}
+
+/**
+ * 读取输出角度，由多圈位置换算，不随圈数损失分辨率
+ * @param hvesc vesc handle
+ * @return 输出角度 (unit: degree)
+ */
+static inline float VESC_GetAngle(const VESC_t* hvesc)
+{
+    return (float) VESC_GetTicks(hvesc) * (1.0f / VESC_TICKS_PER_DEGREE);
+}
+
 void              VESC_Init(VESC_t* hvesc, const VESC_Config_t* config);
 HAL_StatusTypeDef VESC_CAN_FilterInit(CAN_HandleTypeDef* hcan, uint32_t filter_bank);
 void              VESC_ResetAngle(VESC_t* hvesc);
+bool              VESC_GetSnapshot(const VESC_t* hvesc, VESC_Snapshot_t* out);
 void              VESC_SendSetCmd(VESC_t* hvesc, VESC_CAN_PocketSet_t pocket_id, float value);
+void              VESC_CAN_DataDecode(VESC_t*                 hvesc,
+                                      VESC_CAN_PocketStatus_t pocket_id,
+                                      const uint8_t           data[8]);
 void              VESC_CAN_Fifo0ReceiveCallback(CAN_HandleTypeDef* hcan);
 void              VESC_CAN_BaseReceiveCallback(CAN_HandleTypeDef*         hcan,
                                                const CAN_RxHeaderTypeDef* header,
                                                const uint8_t              data[]);
+void              VESC_CAN_FrameReceiveCallback(const CAN_HandleTypeDef* hcan,
+                                                const CAN_Frame_t*       frame);
 #endif // VESC_H
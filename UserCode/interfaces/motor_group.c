@@ -0,0 +1,368 @@
+/**
+ * @file    motor_group.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "motor_group.h"
+#include <string.h>
+
+#define DJI_GROUP_1_4 (0x01U)
+#define DJI_GROUP_5_8 (0x02U)
+
+/**
+ * 找到电机所在的总线
+ * @param motor_type 电机类型
+ * @param hmotor 电机
+ * @param dji_groups 输出，大疆电机所在的指令帧
+ * @return 不经过 CAN 的电机返回 NULL
+ */
+static CAN_HandleTypeDef* motor_bus(const MotorType_t motor_type,
+                                    void*             hmotor,
+                                    uint8_t*          dji_groups)
+{
+    *dji_groups = 0;
+    switch (motor_type)
+    {
+#ifdef USE_DJI
+    case MOTOR_TYPE_DJI:
+    {
+        const DJI_t* hdji = hmotor;
+        *dji_groups       = hdji->id1 <= 4 ? DJI_GROUP_1_4 : DJI_GROUP_5_8;
+        return CAN_GetHandle(hdji->can);
+    }
+#endif
+#ifdef USE_VESC
+    case MOTOR_TYPE_VESC:
+        return ((VESC_t*) hmotor)->hcan;
+#endif
+#ifdef USE_DM
+    case MOTOR_TYPE_DM:
+        return ((DM_t*) hmotor)->hcan;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * 总线发送阶段在 LoopMonitor 中的名称
+ */
+static const char* bus_stage_name(const CAN_HandleTypeDef* hcan)
+{
+    if (hcan->Instance == CAN1)
+        return "CAN1";
+#ifdef CAN2
+    if (hcan->Instance == CAN2)
+        return "CAN2";
+#endif
+#ifdef CAN3
+    if (hcan->Instance == CAN3)
+        return "CAN3";
+#endif
+    return "CAN";
+}
+
+/**
+ * 记录电机所在的总线，自定义操作表的电机不知道所在总线，其指令帧不参与合并
+ * @return 总线在 buses 中的下标，不经过 CAN 的电机返回 MOTOR_CTRL_GROUP_NO_BUS
+ */
+static uint8_t group_add_bus(MotorCtrlGroup_t* group,
+                             const MotorOps_t* ops,
+                             const MotorType_t motor_type,
+                             void*             hmotor)
+{
+    if (ops != NULL && ops != Motor_GetOps(motor_type))
+        return MOTOR_CTRL_GROUP_NO_BUS;
+
+    uint8_t            dji_groups;
+    CAN_HandleTypeDef* hcan = motor_bus(motor_type, hmotor, &dji_groups);
+    if (hcan == NULL)
+        return MOTOR_CTRL_GROUP_NO_BUS;
+
+    for (uint32_t i = 0; i < group->bus_count; i++)
+    {
+        if (group->buses[i].hcan == hcan)
+        {
+            group->buses[i].dji_groups |= dji_groups;
+            group->buses[i].members++;
+            return i;
+        }
+    }
+    if (group->bus_count >= CAN_NUM)
+    {
+        MOTOR_CTRL_GROUP_ERROR_HANDLER();
+        return MOTOR_CTRL_GROUP_NO_BUS;
+    }
+    group->buses[group->bus_count] = (MotorCtrlGroup_Bus_t) {
+        .hcan       = hcan,
+        .dji_groups = dji_groups,
+        .members    = 1,
+    };
+    // 总线按注册顺序排列，阶段名按 CAN 实例命名，与注册顺序无关
+    group->monitor.stages[1 + group->bus_count].name       = bus_stage_name(hcan);
+    group->event_monitor.stages[1 + group->bus_count].name = bus_stage_name(hcan);
+    return group->bus_count++;
+}
+
+/**
+ * 分配一个控制器槽位
+ * @return 控制组已满时返回 NULL
+ */
+static MotorCtrlGroup_Entry_t* group_alloc(MotorCtrlGroup_t*           group,
+                                           const MotorCtrlGroup_Kind_t kind,
+                                           const uint32_t              divider)
+{
+    if (group->count >= MOTOR_CTRL_GROUP_SIZE)
+    {
+        MOTOR_CTRL_GROUP_ERROR_HANDLER();
+        return NULL;
+    }
+    MotorCtrlGroup_Entry_t* entry = &group->entries[group->count++];
+    entry->kind                   = kind;
+    entry->divider                = divider ? divider : 1;
+    // 第一次 Tick 即更新
+    entry->counter = entry->divider - 1;
+    return entry;
+}
+
+/**
+ * 初始化控制组
+ * @param group 控制组
+ * @param period_us Tick 的调用周期 (unit: us)，用于统计抖动和超时，0 表示不统计
+ */
+void MotorCtrlGroup_Init(MotorCtrlGroup_t* group, const uint32_t period_us)
+{
+    // 每条总线一个发送阶段，名称在总线注册时按 CAN 实例设置
+    static const char* const stage_names[] = { "update", "", "" };
+    _Static_assert(sizeof(stage_names) / sizeof(stage_names[0]) >= 1 + CAN_NUM,
+                   "one stage per bus is required");
+
+    memset(group, 0, sizeof(MotorCtrlGroup_t));
+    LoopMonitor_Init(&group->monitor, "motor_group", period_us, stage_names, 1 + CAN_NUM);
+    // 事件触发的更新没有固定周期，只统计执行时间和各阶段耗时
+    LoopMonitor_Init(&group->event_monitor, "motor_group_event", 0, stage_names, 1 + CAN_NUM);
+}
+
+/**
+ * 向控制组添加一个位置环控制器
+ *
+ * 控制器保存在控制组内部，请使用返回的指针设置目标值、启用或禁用
+ * @attention 电机所在的 CAN 须已调用 CAN_Start
+ * @param group 控制组
+ * @param config 控制器配置，与 Motor_PosCtrl_Init 相同
+ * @param divider 每 divider 次 Tick 更新一次，0 与 1 相同
+ * @return 控制器，控制组已满时返回 NULL
+ */
+Motor_PosCtrl_t* MotorCtrlGroup_AddPos(MotorCtrlGroup_t*            group,
+                                       const Motor_PosCtrlConfig_t* config,
+                                       const uint32_t               divider)
+{
+    MotorCtrlGroup_Entry_t* entry = group_alloc(group, MOTOR_CTRL_GROUP_POS, divider);
+    if (entry == NULL)
+        return NULL;
+    Motor_PosCtrl_Init(&entry->pos, config);
+    entry->bus = group_add_bus(group, config->ops, config->motor_type, config->motor);
+    return &entry->pos;
+}
+
+/**
+ * 向控制组添加一个速度环控制器
+ * @attention 电机所在的 CAN 须已调用 CAN_Start
+ * @param group 控制组
+ * @param config 控制器配置，与 Motor_VelCtrl_Init 相同
+ * @param divider 每 divider 次 Tick 更新一次，0 与 1 相同
+ * @return 控制器，控制组已满时返回 NULL
+ */
+Motor_VelCtrl_t* MotorCtrlGroup_AddVel(MotorCtrlGroup_t*            group,
+                                       const Motor_VelCtrlConfig_t* config,
+                                       const uint32_t               divider)
+{
+    MotorCtrlGroup_Entry_t* entry = group_alloc(group, MOTOR_CTRL_GROUP_VEL, divider);
+    if (entry == NULL)
+        return NULL;
+    Motor_VelCtrl_Init(&entry->vel, config);
+    entry->bus = group_add_bus(group, config->ops, config->motor_type, config->motor);
+    return &entry->vel;
+}
+
+/**
+ * 启用或关闭事件驱动模式
+ *
+ * 启用后应在 CAN 接收回调读空 FIFO 之后调用 MotorCtrlGroup_Poll，Tick 仍需按周期调用
+ * @param group 控制组
+ * @param enable 是否启用
+ */
+void MotorCtrlGroup_SetEventDriven(MotorCtrlGroup_t* group, const bool enable)
+{
+    group->event_driven = enable;
+    for (uint32_t i = 0; i < group->count; i++)
+        group->entries[i].fresh = false;
+    for (uint32_t i = 0; i < group->bus_count; i++)
+    {
+        group->buses[i].fresh   = 0;
+        group->buses[i].updated = false;
+    }
+}
+
+/**
+ * 读取并清除控制器所控电机的新反馈标记，不支持新反馈标记的电机视为总是有新反馈
+ */
+static bool group_take_fresh(const MotorCtrlGroup_Entry_t* entry)
+{
+    const bool        is_pos = entry->kind == MOTOR_CTRL_GROUP_POS;
+    const MotorOps_t* ops    = is_pos ? entry->pos.ops : entry->vel.ops;
+    void*             motor  = is_pos ? entry->pos.motor : entry->vel.motor;
+    return ops->take_fresh == NULL || ops->take_fresh(motor);
+}
+
+/**
+ * 按分频更新一个控制器
+ */
+static void group_update_entry(MotorCtrlGroup_Entry_t* entry)
+{
+    // Tick 兜底更新时同样清除驱动的新反馈标记，否则下一次 Poll 会把这次已经用过的反馈当作新反馈
+    if (!entry->fresh)
+        group_take_fresh(entry);
+    entry->fresh = false;
+    if (++entry->counter < entry->divider)
+        return;
+    entry->counter = 0;
+    if (entry->kind == MOTOR_CTRL_GROUP_POS)
+        Motor_PosCtrlUpdate(&entry->pos);
+    else
+        Motor_VelCtrlUpdate(&entry->vel);
+}
+
+/**
+ * 发出一条总线上的大疆电流指令并恢复发送
+ */
+static void group_flush_bus(MotorCtrlGroup_Bus_t* bus)
+{
+#ifdef USE_DJI
+    if (bus->dji_groups & DJI_GROUP_1_4)
+        DJI_SendSetIqCommand(bus->hcan, IQ_CMD_GROUP_1_4);
+    if (bus->dji_groups & DJI_GROUP_5_8)
+        DJI_SendSetIqCommand(bus->hcan, IQ_CMD_GROUP_5_8);
+#endif
+    CAN_TxRelease(bus->hcan);
+    bus->fresh = 0;
+}
+
+/**
+ * 更新控制组内的全部控制器，并发出本周期的全部指令帧
+ *
+ * 应在固定周期的定时器中断或控制任务中调用。
+ * 事件驱动模式下跳过上一次 Tick 之后已由 MotorCtrlGroup_Poll 更新过的总线
+ * @param group 控制组
+ */
+void MotorCtrlGroup_Tick(MotorCtrlGroup_t* group)
+{
+    LoopMonitor_Begin(&group->monitor);
+    bool run[CAN_NUM];
+    for (uint32_t i = 0; i < group->bus_count; i++)
+    {
+        MotorCtrlGroup_Bus_t* bus = &group->buses[i];
+        run[i]                    = !(group->event_driven && bus->updated);
+        bus->updated              = false;
+        if (run[i])
+            CAN_TxHold(bus->hcan);
+        if (run[i] && group->event_driven)
+            bus->deadlines++;
+    }
+
+    for (uint32_t i = 0; i < group->count; i++)
+    {
+        MotorCtrlGroup_Entry_t* entry = &group->entries[i];
+        if (entry->bus == MOTOR_CTRL_GROUP_NO_BUS || run[entry->bus])
+            group_update_entry(entry);
+    }
+    LoopMonitor_Mark(&group->monitor);
+
+    for (uint32_t i = 0; i < group->bus_count; i++)
+    {
+        if (run[i])
+            group_flush_bus(&group->buses[i]);
+        LoopMonitor_Mark(&group->monitor);
+    }
+    LoopMonitor_End(&group->monitor);
+}
+
+/**
+ * 事件驱动模式下检查新反馈，一条总线上全部电机都收到新反馈时立即更新这条总线
+ *
+ * 应在 CAN 接收回调读空 FIFO 之后调用
+ * @attention 与 MotorCtrlGroup_Tick 修改同一份状态，两者必须在相同抢占优先级的中断
+ *            （或同一个任务）中调用，不能互相打断
+ * @param group 控制组
+ * @return 是否更新了至少一条总线
+ */
+bool MotorCtrlGroup_Poll(MotorCtrlGroup_t* group)
+{
+    if (!group->event_driven)
+        return false;
+
+    for (uint32_t i = 0; i < group->count; i++)
+    {
+        MotorCtrlGroup_Entry_t* entry = &group->entries[i];
+        if (entry->bus == MOTOR_CTRL_GROUP_NO_BUS || entry->fresh)
+            continue;
+        if (group_take_fresh(entry))
+        {
+            entry->fresh = true;
+            group->buses[entry->bus].fresh++;
+        }
+    }
+
+    bool run[CAN_NUM];
+    bool updated = false;
+    for (uint32_t i = 0; i < group->bus_count; i++)
+    {
+        run[i] = group->buses[i].fresh >= group->buses[i].members;
+        updated |= run[i];
+    }
+    if (!updated)
+        return false;
+
+    // 阶段与 Tick 相同：先更新全部就绪总线上的控制器，再逐条总线发出
+    LoopMonitor_Begin(&group->event_monitor);
+    for (uint32_t i = 0; i < group->bus_count; i++)
+        if (run[i])
+            CAN_TxHold(group->buses[i].hcan);
+    for (uint32_t i = 0; i < group->count; i++)
+    {
+        MotorCtrlGroup_Entry_t* entry = &group->entries[i];
+        if (entry->bus != MOTOR_CTRL_GROUP_NO_BUS && run[entry->bus])
+            group_update_entry(entry);
+    }
+    LoopMonitor_Mark(&group->event_monitor);
+
+    for (uint32_t i = 0; i < group->bus_count; i++)
+    {
+        MotorCtrlGroup_Bus_t* bus = &group->buses[i];
+        if (run[i])
+        {
+            group_flush_bus(bus);
+            bus->updated = true;
+            bus->events++;
+        }
+        LoopMonitor_Mark(&group->event_monitor);
+    }
+    LoopMonitor_End(&group->event_monitor);
+    return true;
+}
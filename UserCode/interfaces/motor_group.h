@@ -0,0 +1,126 @@
+/**
+ * @file    motor_group.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   update a group of motor controllers and flush their CAN frames in one tick
+ *
+ * 控制组以连续数组保存控制器，每个控制周期调用一次 MotorCtrlGroup_Tick：
+ *   1. 暂停组内所有总线的发送 (CAN_TxHold)
+ *   2. 依次更新全部控制器，内部控制模式的电机（DM、VESC）在此时产生指令帧（只入队）
+ *   3. 每条总线按需发送一帧 0x200 和一帧 0x1FF 大疆电流指令
+ *   4. 恢复发送 (CAN_TxRelease)，本周期的全部指令帧在总线上连续发出
+ * 因此同一周期内各电机收到指令的时间差只取决于总线传输时间
+ *
+ * monitor 记录每次 Tick 的执行时间、周期抖动、超时和丢失的周期，
+ * 阶段 0 为全部控制器的计算，阶段 1 起按总线注册的顺序依次为各总线的指令发送，
+ * 阶段名为总线的 CAN 实例 ("CAN1" / "CAN2")
+ *
+ * 事件驱动模式 (MotorCtrlGroup_SetEventDriven)：驱动解包反馈时置位 fresh，
+ * 在 CAN 接收回调之后调用 MotorCtrlGroup_Poll，一条总线上全部电机都收到新反馈时
+ * 立即更新这条总线上的控制器并发出指令，不必等到下一次 Tick；
+ * Tick 作为截止时间，只更新上一次 Tick 之后还没有被事件更新过的总线。
+ * 两条路径更新控制器时都会清除新反馈标记；事件触发的更新记录在 event_monitor 中
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef MOTOR_GROUP_H
+#define MOTOR_GROUP_H
+
+#include "bsp/loop_monitor.h"
+#include "interfaces/motor_if.h"
+
+#define MOTOR_CTRL_GROUP_ERROR_HANDLER() Error_Handler()
+
+#define MOTOR_CTRL_GROUP_NO_BUS (0xFFU) ///< 控制器的电机不经过 CAN
+
+#ifndef MOTOR_CTRL_GROUP_SIZE
+/**
+ * 每个控制组最多容纳的控制器数
+ */
+#    define MOTOR_CTRL_GROUP_SIZE (16)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef enum
+{
+    MOTOR_CTRL_GROUP_POS = 0U, ///< 位置环控制器
+    MOTOR_CTRL_GROUP_VEL,      ///< 速度环控制器
+} MotorCtrlGroup_Kind_t;
+
+/**
+ * 控制组中的一个控制器
+ */
+typedef struct
+{
+    MotorCtrlGroup_Kind_t kind;
+    uint32_t              divider; ///< 每 divider 次更新一次
+    uint32_t              counter;
+    uint8_t               bus;   ///< 所在总线在 buses 中的下标，或 MOTOR_CTRL_GROUP_NO_BUS
+    bool                  fresh; ///< 事件驱动模式下，上次更新之后是否收到新反馈
+    union
+    {
+        Motor_PosCtrl_t pos;
+        Motor_VelCtrl_t vel;
+    };
+} MotorCtrlGroup_Entry_t;
+
+/**
+ * 控制组涉及的总线
+ */
+typedef struct
+{
+    CAN_HandleTypeDef* hcan;
+    uint8_t            dji_groups; ///< 需要发送的大疆指令帧，bit0: 0x200 (1~4)，bit1: 0x1FF (5~8)
+    uint32_t           members;    ///< 总线上的控制器数
+    uint32_t           fresh;      ///< 已收到新反馈的控制器数
+    bool               updated;    ///< 上一次 Tick 之后是否已由事件更新
+    uint32_t           events;     ///< 由事件触发的更新次数
+    uint32_t           deadlines;  ///< 由 Tick 兜底的更新次数
+} MotorCtrlGroup_Bus_t;
+
+typedef struct
+{
+    MotorCtrlGroup_Entry_t entries[MOTOR_CTRL_GROUP_SIZE];
+    uint32_t               count;
+    MotorCtrlGroup_Bus_t   buses[CAN_NUM];
+    uint32_t               bus_count;
+    bool                   event_driven; ///< 是否启用事件驱动模式
+
+    LoopMonitor_t monitor;       ///< Tick 的执行时间、周期和各阶段耗时
+    LoopMonitor_t event_monitor; ///< Poll 触发的更新的执行时间和各阶段耗时，阶段与 monitor 相同
+} MotorCtrlGroup_t;
+
+void             MotorCtrlGroup_Init(MotorCtrlGroup_t* group, uint32_t period_us);
+Motor_PosCtrl_t* MotorCtrlGroup_AddPos(MotorCtrlGroup_t*            group,
+                                       const Motor_PosCtrlConfig_t* config,
+                                       uint32_t                     divider);
+Motor_VelCtrl_t* MotorCtrlGroup_AddVel(MotorCtrlGroup_t*            group,
+                                       const Motor_VelCtrlConfig_t* config,
+                                       uint32_t                     divider);
+void             MotorCtrlGroup_SetEventDriven(MotorCtrlGroup_t* group, bool enable);
+void             MotorCtrlGroup_Tick(MotorCtrlGroup_t* group);
+bool             MotorCtrlGroup_Poll(MotorCtrlGroup_t* group);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MOTOR_GROUP_H
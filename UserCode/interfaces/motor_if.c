@@ -32,125 +32,445 @@ extern "C"
 #endif
 
 /******** 🛠️⚠️ 电机扩展提醒块 ⚠️🛠️ ********
- * 新增电机时需要在 motor_if.c 中实现：
- * 1. motor_apply_output, 对于无电流控制的电机可忽略
- * 2. motor_send_internal_velocity, 对于无内部速度控制的电机可忽略
- * 3. motor_send_internal_position, 对于无内部位置控制的电机可忽略
- * 4. get_default_ctrl_mode: 最好和当前一样通过 宏 定义默认值
+ * 新增内置电机类型时需要在 motor_if.c 中：
+ * 1. 实现 MotorOps_t 中的各项操作，不支持的操作置 NULL
+ *    apply_output: 对于无电流控制的电机可忽略
+ *    send_velocity: 对于无内部速度控制的电机可忽略
+ *    send_position: 对于无内部位置控制的电机可忽略
+ *    get_feedback_time: 对于反馈不经过 CAN 的电机可忽略
+ *    take_fresh: 对于反馈不经过 CAN 的电机可忽略
+ *    *_raw, get_raw_scale: 不支持定点控制的电机可忽略
+ * 2. default_mode 最好和当前一样通过 宏 定义默认值
+ * 3. 在 Motor_GetOps 中返回对应的操作表
  ****************************************/
 
+// ATTENTION: apply_output 不做输出限幅校验，输出限幅应当放在 PID 参数中
+
+#ifdef USE_DJI
+static float dji_get_angle(void* hmotor)
+{
+    return __DJI_GET_ANGLE(hmotor);
+}
+
+static float dji_get_velocity(void* hmotor)
+{
+    return __DJI_GET_VELOCITY(hmotor);
+}
+
+static void dji_reset_angle(void* hmotor)
+{
+    DJI_ResetAngle(hmotor);
+}
+
+static void dji_apply_output(void* hmotor, const float output)
+{
+    __DJI_SET_IQ_CMD(hmotor, output);
+}
+
+static bool dji_get_feedback_time(void* hmotor, uint32_t* timestamp)
+{
+    const DJI_t* hdji = hmotor;
+    *timestamp        = hdji->feedback_timestamp;
+    return hdji->feedback_count != 0;
+}
+
+static bool dji_get_command_time(void* hmotor, uint32_t* timestamp)
+{
+    *timestamp = ((const DJI_t*) hmotor)->command_timestamp;
+    return true;
+}
+
+static bool dji_take_fresh(void* hmotor)
+{
+    DJI_t*     hdji  = hmotor;
+    const bool fresh = hdji->fresh;
+    hdji->fresh      = false;
+    return fresh;
+}
+
+static void dji_reset_observer(void* hmotor)
+{
+    DJI_ResetObserver(hmotor);
+}
+
+static int64_t dji_get_angle_raw(void* hmotor)
+{
+    return DJI_GetTicks(hmotor);
+}
+
+static int32_t dji_get_velocity_raw(void* hmotor)
+{
+    return ((DJI_t*) hmotor)->rotor_rpm;
+}
+
+static void dji_apply_output_raw(void* hmotor, const int32_t output)
+{
+    __DJI_SET_IQ_CMD(hmotor, output);
+}
+
 /**
- * 应用电流控制
- * @param motor_type 电机类型
- * @param hmotor 电机数据
- * @param output 电流 （或占空比）
+ * 原始单位为转子编码器刻度和转子 rpm，输出为电流指令值本身
  */
-static inline void motor_apply_output(const MotorType_t motor_type,
-                                      void*             hmotor,
-                                      const float       output)
+static void dji_get_raw_scale(void* hmotor, MotorRawScale_t* scale)
 {
-    // ATTENTION: 此处不做输出限幅校验，输出限幅应当放在 PID 参数中
-    switch (motor_type)
-    {
-#ifdef USE_DJI
-    case MOTOR_TYPE_DJI:
-        __DJI_SET_IQ_CMD(hmotor, output);
-        break;
+    const DJI_t* hdji = hmotor;
+    scale->angle      = 360.0f / DJI_TICKS_PER_ROUND * hdji->inv_reduction_rate;
+    scale->velocity   = hdji->inv_reduction_rate;
+    scale->output     = 1.0f;
+}
+
+static const MotorOps_t dji_ops = {
+    .get_angle         = dji_get_angle,
+    .get_velocity      = dji_get_velocity,
+    .reset_angle       = dji_reset_angle,
+    .apply_output      = dji_apply_output,
+    .get_feedback_time = dji_get_feedback_time,
+    .get_command_time  = dji_get_command_time,
+    .take_fresh        = dji_take_fresh,
+    .reset_observer    = dji_reset_observer,
+    .get_angle_raw     = dji_get_angle_raw,
+    .get_velocity_raw  = dji_get_velocity_raw,
+    .apply_output_raw  = dji_apply_output_raw,
+    .get_raw_scale     = dji_get_raw_scale,
+    .default_mode      = MOTOR_DEFAULT_MODE_DJI,
+};
 #endif
+
 #ifdef USE_TB6612
-    case MOTOR_TYPE_TB6612:
-        return TB6612_SetSpeed(hmotor, output);
+static float tb6612_get_angle(void* hmotor)
+{
+    return __TB6612_GET_ANGLE(hmotor);
+}
+
+static float tb6612_get_velocity(void* hmotor)
+{
+    return __TB6612_GET_VELOCITY(hmotor);
+}
+
+static void tb6612_reset_angle(void* hmotor)
+{
+    __TB6612_RESET_ANGLE(hmotor);
+}
+
+static void tb6612_apply_output(void* hmotor, const float output)
+{
+    TB6612_SetSpeed(hmotor, output);
+}
+
+static int64_t tb6612_get_angle_raw(void* hmotor)
+{
+    return TB6612_GetTicks(hmotor);
+}
+
+static int32_t tb6612_get_velocity_raw(void* hmotor)
+{
+    return ((TB6612_t*) hmotor)->delta_ticks;
+}
+
+static void tb6612_apply_output_raw(void* hmotor, const int32_t output)
+{
+    TB6612_SetDuty(hmotor, output);
+}
+
+/**
+ * 原始单位为编码器计数和每个采样间隔的计数，输出为 Q15 占空比
+ */
+static void tb6612_get_raw_scale(void* hmotor, MotorRawScale_t* scale)
+{
+    const TB6612_t* htb    = hmotor;
+    const float     counts = (float) htb->roto_radio * htb->reduction_radio; // 输出轴每圈的计数
+    scale->angle           = 360.0f / counts;
+    scale->velocity        = 60.0f / (counts * htb->sampling_period);
+    scale->output          = 1.0f / TB6612_DUTY_ONE;
+}
+
+static const MotorOps_t tb6612_ops = {
+    .get_angle        = tb6612_get_angle,
+    .get_velocity     = tb6612_get_velocity,
+    .reset_angle      = tb6612_reset_angle,
+    .apply_output     = tb6612_apply_output,
+    .get_angle_raw    = tb6612_get_angle_raw,
+    .get_velocity_raw = tb6612_get_velocity_raw,
+    .apply_output_raw = tb6612_apply_output_raw,
+    .get_raw_scale    = tb6612_get_raw_scale,
+    .default_mode     = MOTOR_DEFAULT_MODE_TB6612,
+};
 #endif
+
 #ifdef USE_VESC
-    case MOTOR_TYPE_VESC:
-        /* VESC 电调不应在控制时设置电流 */
-        return;
-#endif
-#ifdef USE_DM
-    case MOTOR_TYPE_DM:
-        /* DM 电调不应该在控制时设置电流*/
-        break;
-#endif
-    default:
-        break;
-    }
+static float vesc_get_angle(void* hmotor)
+{
+    return __VESC_GET_ANGLE(hmotor);
+}
+
+static float vesc_get_velocity(void* hmotor)
+{
+    return __VESC_GET_VELOCITY(hmotor);
+}
+
+static void vesc_reset_angle(void* hmotor)
+{
+    VESC_ResetAngle(hmotor);
+}
+
+static void vesc_send_velocity(void* hmotor, const float speed)
+{
+    VESC_SendSetCmd(hmotor, VESC_CAN_SET_RPM, speed);
+}
+
+static void vesc_invalidate_cmd(void* hmotor)
+{
+    CAN_TxCache_Invalidate(&((VESC_t*) hmotor)->tx_cache);
+}
+
+static bool vesc_get_feedback_time(void* hmotor, uint32_t* timestamp)
+{
+    const VESC_t* hvesc = hmotor;
+    *timestamp          = hvesc->feedback_timestamp;
+    return hvesc->feedback_count != 0;
+}
+
+static bool vesc_get_command_time(void* hmotor, uint32_t* timestamp)
+{
+    *timestamp = ((const VESC_t*) hmotor)->tx_cache.timestamp;
+    return true;
+}
+
+static bool vesc_take_fresh(void* hmotor)
+{
+    VESC_t*    hvesc = hmotor;
+    const bool fresh = hvesc->fresh;
+    hvesc->fresh     = false;
+    return fresh;
+}
+
+static int64_t vesc_get_angle_raw(void* hmotor)
+{
+    return VESC_GetTicks(hmotor);
 }
 
 /**
- * 发送电机内部速度控制指令
- * @param motor_type 电机类型
- * @param hmotor 电机对象
- * @param speed 速度
+ * 只提供位置的换算，用于浮点位置环以原始单位计算误差，不支持定点控制
  */
-static inline void motor_send_internal_velocity(const MotorType_t motor_type,
-                                                void*             hmotor,
-                                                const float       speed)
+static void vesc_get_raw_scale(void* hmotor, MotorRawScale_t* scale)
 {
-    switch (motor_type)
-    {
-#ifdef USE_VESC
-    case MOTOR_TYPE_VESC:
-        VESC_SendSetCmd(hmotor, VESC_CAN_SET_RPM, speed);
-        break;
+    scale->angle    = 1.0f / VESC_TICKS_PER_DEGREE;
+    scale->velocity = 0.0f;
+    scale->output   = 0.0f;
+}
+
+/*
+ * VESC 电调不应在控制时设置电流；
+ * VESC_CAN_SET_POS 并不是普遍意义下的多圈位置，仅是单圈位置，因此不提供 send_position
+ */
+static const MotorOps_t vesc_ops = {
+    .get_angle         = vesc_get_angle,
+    .get_velocity      = vesc_get_velocity,
+    .reset_angle       = vesc_reset_angle,
+    .send_velocity     = vesc_send_velocity,
+    .invalidate_cmd    = vesc_invalidate_cmd,
+    .get_feedback_time = vesc_get_feedback_time,
+    .get_command_time  = vesc_get_command_time,
+    .take_fresh        = vesc_take_fresh,
+    .get_angle_raw     = vesc_get_angle_raw,
+    .get_raw_scale     = vesc_get_raw_scale,
+    .default_mode      = MOTOR_DEFAULT_MODE_VESC,
+};
 #endif
 
 #ifdef USE_DM
-    case MOTOR_TYPE_DM:
-        DM_Vel_SendSetCmd(hmotor, speed);
-        break;
-#endif
-    default:
-        break;
-    }
+static float dm_get_angle(void* hmotor)
+{
+    return __DM_GET_ANGLE(hmotor);
 }
 
-static inline void motor_send_internal_position(const MotorType_t motor_type,
-                                                void*             hmotor,
-                                                const float       position)
+static float dm_get_velocity(void* hmotor)
 {
-    switch (motor_type)
-    {
-#ifdef USE_VESC
-    case MOTOR_TYPE_VESC:
-        // 这里并不是普遍意义下的多圈位置，这里仅是单圈位置
-        // VESC_SendSetCmd(hmotor, VESC_CAN_SET_POS, position);
-        // break;
-        return;
-#endif
-#ifdef USE_DM
-    case MOTOR_TYPE_DM:
-        // DM_Pos_SendSetCmd(hmotor,position);
-        return;
+    return __DM_GET_VELOCITY(hmotor);
+}
+
+static void dm_send_velocity(void* hmotor, const float speed)
+{
+    DM_Vel_SendSetCmd(hmotor, speed);
+}
+
+static void dm_invalidate_cmd(void* hmotor)
+{
+    CAN_TxCache_Invalidate(&((DM_t*) hmotor)->tx_cache);
+}
+
+static bool dm_get_feedback_time(void* hmotor, uint32_t* timestamp)
+{
+    const DM_t* hdm = hmotor;
+    *timestamp      = hdm->feedback_timestamp;
+    return hdm->feedback_count != 0;
+}
+
+static bool dm_get_command_time(void* hmotor, uint32_t* timestamp)
+{
+    *timestamp = ((const DM_t*) hmotor)->tx_cache.timestamp;
+    return true;
+}
+
+static bool dm_take_fresh(void* hmotor)
+{
+    DM_t*      hdm   = hmotor;
+    const bool fresh = hdm->fresh;
+    hdm->fresh       = false;
+    return fresh;
+}
+
+static int64_t dm_get_angle_raw(void* hmotor)
+{
+    return DM_GetTicks(hmotor);
+}
+
+/**
+ * 只提供位置的换算，用于浮点位置环以原始单位计算误差，不支持定点控制
+ */
+static void dm_get_raw_scale(void* hmotor, MotorRawScale_t* scale)
+{
+    scale->angle    = ((const DM_t*) hmotor)->angle_per_tick;
+    scale->velocity = 0.0f;
+    scale->output   = 0.0f;
+}
+
+/*
+ * DM 电调不应该在控制时设置电流；内部位置控制 (DM_Pos_SendSetCmd) 暂未启用
+ */
+static const MotorOps_t dm_ops = {
+    .get_angle         = dm_get_angle,
+    .get_velocity      = dm_get_velocity,
+    .send_velocity     = dm_send_velocity,
+    .invalidate_cmd    = dm_invalidate_cmd,
+    .get_feedback_time = dm_get_feedback_time,
+    .get_command_time  = dm_get_command_time,
+    .take_fresh        = dm_take_fresh,
+    .get_angle_raw     = dm_get_angle_raw,
+    .get_raw_scale     = dm_get_raw_scale,
+    .default_mode      = MOTOR_DEFAULT_MODE_DM,
+};
 #endif
-    default:
-        break;
-    }
+
+static float null_get_value(void* hmotor)
+{
+    (void) hmotor;
+    return 0.0f;
 }
 
-static inline MotorCtrlMode_t get_default_ctrl_mode(const MotorType_t motor_type)
+/**
+ * 未知电机类型，与原先 switch 的 default 分支行为一致
+ */
+static const MotorOps_t null_ops = {
+    .get_angle    = null_get_value,
+    .get_velocity = null_get_value,
+    .default_mode = MOTOR_CTRL_EXTERNAL_PID,
+};
+
+/**
+ * 获取内置电机类型的操作表
+ * @param motor_type 电机类型
+ * @return 操作表，不会返回 NULL
+ */
+const MotorOps_t* Motor_GetOps(const MotorType_t motor_type)
 {
     switch (motor_type)
     {
 #ifdef USE_DJI
     case MOTOR_TYPE_DJI:
-        return MOTOR_DEFAULT_MODE_DJI;
+        return &dji_ops;
 #endif
 #ifdef USE_TB6612
     case MOTOR_TYPE_TB6612:
-        return MOTOR_DEFAULT_MODE_TB6612;
+        return &tb6612_ops;
 #endif
 #ifdef USE_VESC
     case MOTOR_TYPE_VESC:
-        return MOTOR_DEFAULT_MODE_VESC;
+        return &vesc_ops;
 #endif
 #ifdef USE_DM
     case MOTOR_TYPE_DM:
-        return MOTOR_DEFAULT_MODE_DM;
+        return &dm_ops;
 #endif
-
     default:
-        return MOTOR_CTRL_EXTERNAL_PID;
+        return &null_ops;
+    }
+}
+
+/**
+ * 记录反馈延迟，在输出交给驱动之前调用
+ *
+ * 指令可能在输出之后才发出（大疆电机的电流指令在 DJI_SendSetIqCommand 中发出），
+ * 因此上一次输出的延迟在本次调用时记录：两次调用之间指令发出时间有变化，说明上一次的输出已经发出
+ */
+static inline void motor_latency_record(MotorLatency_t* latency, const MotorOps_t* ops, void* motor)
+{
+    uint32_t command;
+    if (ops->get_command_time == NULL || !ops->get_command_time(motor, &command))
+        return;
+    if (latency->pending && command != latency->command)
+        PerfHistogram_Record(&latency->hist, command - latency->feedback);
+    latency->command = command;
+    latency->pending =
+            ops->get_feedback_time != NULL && ops->get_feedback_time(motor, &latency->feedback);
+}
+
+/**
+ * 反馈超时时的输出：外部 PID 控制输出 0 电流，内部速度控制发送 0 速度
+ * @param internal 是否为内部速度控制
+ */
+static inline void motor_ctrl_hold(const MotorOps_t* ops, void* motor, const bool internal)
+{
+    if (internal)
+    {
+        if (ops->send_velocity != NULL)
+            ops->send_velocity(motor, 0.0f);
+    }
+    else if (ops->apply_output != NULL)
+    {
+        ops->apply_output(motor, 0.0f);
+    }
+}
+
+/**
+ * 检查定点控制的条件：外部 PID 控制模式，电机实现了定点操作
+ *
+ * 不满足属于配置错误，进入 MOTOR_IF_ERROR_HANDLER（默认的 Error_Handler 不返回）。
+ * 错误处理返回时本函数返回 false，控制器不启用定点控制
+ * @return 是否满足
+ */
+static bool motor_fixed_point_check(const MotorOps_t* ops, const MotorCtrlMode_t ctrl_mode)
+{
+    if (ctrl_mode != MOTOR_CTRL_EXTERNAL_PID || ops->get_angle_raw == NULL ||
+        ops->get_velocity_raw == NULL || ops->apply_output_raw == NULL ||
+        ops->get_raw_scale == NULL)
+    {
+        MOTOR_IF_ERROR_HANDLER();
+        return false;
     }
+    return true;
+}
+
+/**
+ * 初始化定点位置控制器
+ *
+ * 外环：输入为位置原始值，输出为 Q.8 的转速原始值，直接作为内环目标值；
+ * 内环：输入为 Q.8 的转速原始值，输出为 Q.8 的输出原始值
+ */
+static void motor_posctrl_fixed_init(Motor_PosCtrl_t* hctrl, const Motor_PosCtrlConfig_t* config)
+{
+    MotorRawScale_t scale;
+    hctrl->ops->get_raw_scale(hctrl->motor, &scale);
+    const float velocity_lsb = scale.velocity / (float) (1 << MOTOR_PID_FIXED_OUT_FRAC);
+
+    MotorPIDFixed_Init(&hctrl->position_pid_fixed,
+                       config->position_pid,
+                       scale.angle,
+                       scale.velocity);
+    MotorPIDFixed_Init(&hctrl->velocity_pid_fixed,
+                       config->velocity_pid,
+                       velocity_lsb,
+                       scale.output);
 }
 
 /**
@@ -198,17 +518,40 @@ void Motor_PosCtrl_Init(Motor_PosCtrl_t* hctrl, const Motor_PosCtrlConfig_t* con
 {
     hctrl->motor_type = config->motor_type;
     hctrl->motor      = config->motor;
+    hctrl->ops        = config->ops != NULL ? config->ops : Motor_GetOps(config->motor_type);
 #ifdef USE_CUSTOM_CTRL_MODE
-    hctrl->ctrl_mode = config.ctrl_mode;
+    hctrl->ctrl_mode = config->ctrl_mode;
 #else
-    hctrl->ctrl_mode = get_default_ctrl_mode(config->motor_type);
+    hctrl->ctrl_mode = hctrl->ops->default_mode;
 #endif
 
     motor_posctrl_mode_init(hctrl, config);
+    // 控制模式可能与电调当前的模式不同，第一条指令不能被省略
+    MotorCtrl_InvalidateCmd(hctrl);
+    memset(&hctrl->latency, 0, sizeof(hctrl->latency));
+    PerfHistogram_Reset(&hctrl->latency.hist, "pos_latency", MOTOR_LATENCY_BUCKET_NS);
 
     hctrl->settle.count_max       = config->settle_count_max ? config->settle_count_max : 50;
     hctrl->settle.error_threshold = config->error_threshold;
     hctrl->settle.counter         = 0;
+    hctrl->stale                  = false;
+
+    hctrl->tick_ref = hctrl->ops->get_angle_raw != NULL && hctrl->ops->get_raw_scale != NULL;
+    if (hctrl->tick_ref)
+    {
+        MotorRawScale_t scale;
+        hctrl->ops->get_raw_scale(hctrl->motor, &scale);
+        hctrl->raw_to_angle = scale.angle;
+        hctrl->angle_to_raw = 1.0f / scale.angle;
+        hctrl->position_raw = MotorPIDFixed_FloatToI64(hctrl->position * hctrl->angle_to_raw);
+        hctrl->settle.error_threshold_raw =
+                MotorPIDFixed_FloatToI32(config->error_threshold * hctrl->angle_to_raw);
+    }
+
+    hctrl->fixed_point =
+            config->fixed_point && motor_fixed_point_check(hctrl->ops, hctrl->ctrl_mode);
+    if (hctrl->fixed_point)
+        motor_posctrl_fixed_init(hctrl, config);
 
     hctrl->enable = true;
 }
@@ -248,17 +591,81 @@ void Motor_VelCtrl_Init(Motor_VelCtrl_t* hctrl, const Motor_VelCtrlConfig_t* con
 {
     hctrl->motor_type = config->motor_type;
     hctrl->motor      = config->motor;
+    hctrl->ops        = config->ops != NULL ? config->ops : Motor_GetOps(config->motor_type);
 #ifdef USE_CUSTOM_CTRL_MODE
-    hctrl->ctrl_mode = config.ctrl_mode;
+    hctrl->ctrl_mode = config->ctrl_mode;
 #else
-    hctrl->ctrl_mode = get_default_ctrl_mode(config->motor_type);
+    hctrl->ctrl_mode = hctrl->ops->default_mode;
 #endif
 
     motor_velctrl_mode_init(hctrl, config);
+    MotorCtrl_InvalidateCmd(hctrl);
+    memset(&hctrl->latency, 0, sizeof(hctrl->latency));
+    PerfHistogram_Reset(&hctrl->latency.hist, "vel_latency", MOTOR_LATENCY_BUCKET_NS);
+    hctrl->stale = false;
+
+    hctrl->fixed_point =
+            config->fixed_point && motor_fixed_point_check(hctrl->ops, hctrl->ctrl_mode);
+    if (hctrl->fixed_point)
+    {
+        // 输入为 Q.8 的转速原始值，输出为 Q.8 的输出原始值
+        MotorRawScale_t scale;
+        hctrl->ops->get_raw_scale(hctrl->motor, &scale);
+        MotorPIDFixed_Init(&hctrl->pid_fixed,
+                           config->pid,
+                           scale.velocity / (float) (1 << MOTOR_PID_FIXED_OUT_FRAC),
+                           scale.output);
+        hctrl->velocity_to_raw = (float) (1 << MOTOR_PID_FIXED_OUT_FRAC) / scale.velocity;
+        hctrl->velocity_raw    = MotorPIDFixed_FloatToI32(hctrl->velocity * hctrl->velocity_to_raw);
+    }
 
     hctrl->enable = true;
 }
 
+/**
+ * 定点位置环控制计算，与浮点外部 PID 控制的流程相同，只使用整数运算
+ */
+static void motor_posctrl_update_fixed(Motor_PosCtrl_t* hctrl)
+{
+    const MotorOps_t* ops = hctrl->ops;
+    if (hctrl->stale)
+    {
+        MotorPIDFixed_Reset(&hctrl->position_pid_fixed);
+        MotorPIDFixed_Reset(&hctrl->velocity_pid_fixed);
+        hctrl->count          = 0;
+        hctrl->settle.counter = 0;
+        ops->apply_output_raw(hctrl->motor, 0);
+        return;
+    }
+    ++hctrl->count;
+
+    // 误差在 64 位下计算，目标和位置都可以超过 int32 的范围
+    const int64_t error = hctrl->position_raw - ops->get_angle_raw(hctrl->motor);
+    // 检测电机是否就位
+    if ((error >= 0 ? error : -error) < hctrl->settle.error_threshold_raw)
+        ++hctrl->settle.counter;
+    else
+        hctrl->settle.counter = 0;
+
+    if (hctrl->count == hctrl->pos_vel_freq_ratio)
+    {
+        // 外环只用到误差，以饱和后的误差为 ref、0 为 fdb，与直接给 ref 和 fdb 等价
+        hctrl->position_pid_fixed.ref = error > INT32_MAX   ? INT32_MAX
+                                        : error < INT32_MIN ? INT32_MIN
+                                                            : (int32_t) error;
+        hctrl->position_pid_fixed.fdb = 0;
+        MotorPIDFixed_Calculate(&hctrl->position_pid_fixed);
+        hctrl->count = 0;
+    }
+
+    hctrl->velocity_pid_fixed.ref = hctrl->position_pid_fixed.output;
+    hctrl->velocity_pid_fixed.fdb =
+            ops->get_velocity_raw(hctrl->motor) * (1 << MOTOR_PID_FIXED_OUT_FRAC);
+    MotorPIDFixed_Calculate(&hctrl->velocity_pid_fixed);
+    motor_latency_record(&hctrl->latency, ops, hctrl->motor);
+    ops->apply_output_raw(hctrl->motor, MotorPIDFixed_GetOutput(&hctrl->velocity_pid_fixed));
+}
+
 /**
  * 位置环控制计算
  * @param hctrl 受控对象
@@ -267,12 +674,37 @@ void Motor_PosCtrlUpdate(Motor_PosCtrl_t* hctrl)
 {
     if (!hctrl->enable)
         return;
+    if (hctrl->fixed_point)
+    {
+        motor_posctrl_update_fixed(hctrl);
+        return;
+    }
 
+    const MotorOps_t* ops = hctrl->ops;
+    if (hctrl->stale)
+    {
+        // 冻结 PID：反馈恢复后从 0 重新开始累积，不带着超时期间的积分
+        MotorPID_Reset(&hctrl->position_pid);
+        MotorPID_Reset(&hctrl->velocity_pid);
+        hctrl->count          = 0;
+        hctrl->settle.counter = 0;
+#ifdef MOTOR_IF_INTERNAL_VEL_POS
+        // 内部位置控制由电调自己保持位置
+        if (hctrl->ctrl_mode == MOTOR_CTRL_INTERNAL_VEL_POS)
+            return;
+#endif
+        motor_ctrl_hold(ops, hctrl->motor, hctrl->ctrl_mode != MOTOR_CTRL_EXTERNAL_PID);
+        return;
+    }
     ++hctrl->count;
 
-    const float angle = Motor_GetAngle(hctrl->motor_type, hctrl->motor);
+    // 位置超过 2^24 个原始单位后，角度相减的误差低于原始分辨率，有原始值时以原始单位相减
+    const float error = hctrl->tick_ref ? MultiTurn_AngleError(hctrl->position_raw,
+                                                               ops->get_angle_raw(hctrl->motor),
+                                                               hctrl->raw_to_angle)
+                                        : hctrl->position - ops->get_angle(hctrl->motor);
     // 检测电机是否就位
-    if (fabsf(angle - hctrl->position_pid.ref) < hctrl->settle.error_threshold)
+    if (fabsf(error) < hctrl->settle.error_threshold)
         ++hctrl->settle.counter;
     else
         hctrl->settle.counter = 0;
@@ -280,7 +712,8 @@ void Motor_PosCtrlUpdate(Motor_PosCtrl_t* hctrl)
 #ifdef MOTOR_IF_INTERNAL_VEL_POS
     if (hctrl->ctrl_mode == MOTOR_CTRL_INTERNAL_VEL_POS)
     {
-        motor_send_internal_position(hctrl->motor_type, hctrl->motor, hctrl->position);
+        if (ops->send_position != NULL)
+            ops->send_position(hctrl->motor, hctrl->position);
         hctrl->count = 0;
         return;
     }
@@ -288,9 +721,9 @@ void Motor_PosCtrlUpdate(Motor_PosCtrl_t* hctrl)
 
     if (hctrl->count == hctrl->pos_vel_freq_ratio)
     {
-        hctrl->position_pid.ref = hctrl->position;
-        // 反馈为当前电机输出角度
-        hctrl->position_pid.fdb = angle;
+        // 外环只用到误差，以误差为 ref、0 为 fdb，与以目标位置为 ref、当前角度为 fdb 等价
+        hctrl->position_pid.ref = error;
+        hctrl->position_pid.fdb = 0;
         MotorPID_Calculate(&hctrl->position_pid);
         hctrl->count = 0;
     }
@@ -298,15 +731,41 @@ void Motor_PosCtrlUpdate(Motor_PosCtrl_t* hctrl)
 #ifdef MOTOR_IF_INTERNAL_VEL
     if (hctrl->ctrl_mode == MOTOR_CTRL_INTERNAL_VEL)
     {
-        motor_send_internal_velocity(hctrl->motor_type, hctrl->motor, hctrl->position_pid.output);
+        if (ops->send_velocity != NULL)
+        {
+            motor_latency_record(&hctrl->latency, ops, hctrl->motor);
+            ops->send_velocity(hctrl->motor, hctrl->position_pid.output);
+        }
         return;
     }
 #endif
 
     hctrl->velocity_pid.ref = hctrl->position_pid.output;
-    hctrl->velocity_pid.fdb = Motor_GetVelocity(hctrl->motor_type, hctrl->motor);
+    hctrl->velocity_pid.fdb = ops->get_velocity(hctrl->motor);
     MotorPID_Calculate(&hctrl->velocity_pid);
-    motor_apply_output(hctrl->motor_type, hctrl->motor, hctrl->velocity_pid.output);
+    motor_latency_record(&hctrl->latency, ops, hctrl->motor);
+    if (ops->apply_output != NULL)
+        ops->apply_output(hctrl->motor, hctrl->velocity_pid.output);
+}
+
+/**
+ * 定点速度环控制计算，只使用整数运算
+ */
+static void motor_velctrl_update_fixed(Motor_VelCtrl_t* hctrl)
+{
+    const MotorOps_t* ops = hctrl->ops;
+    if (hctrl->stale)
+    {
+        MotorPIDFixed_Reset(&hctrl->pid_fixed);
+        ops->apply_output_raw(hctrl->motor, 0);
+        return;
+    }
+
+    hctrl->pid_fixed.ref = hctrl->velocity_raw;
+    hctrl->pid_fixed.fdb = ops->get_velocity_raw(hctrl->motor) * (1 << MOTOR_PID_FIXED_OUT_FRAC);
+    MotorPIDFixed_Calculate(&hctrl->pid_fixed);
+    motor_latency_record(&hctrl->latency, ops, hctrl->motor);
+    ops->apply_output_raw(hctrl->motor, MotorPIDFixed_GetOutput(&hctrl->pid_fixed));
 }
 
 /**
@@ -317,21 +776,141 @@ void Motor_VelCtrlUpdate(Motor_VelCtrl_t* hctrl)
 {
     if (!hctrl->enable)
         return;
+    if (hctrl->fixed_point)
+    {
+        motor_velctrl_update_fixed(hctrl);
+        return;
+    }
+
+    const MotorOps_t* ops = hctrl->ops;
+    if (hctrl->stale)
+    {
+        MotorPID_Reset(&hctrl->pid);
+        motor_ctrl_hold(ops, hctrl->motor, hctrl->ctrl_mode != MOTOR_CTRL_EXTERNAL_PID);
+        return;
+    }
 
 #if defined(MOTOR_IF_INTERNAL_VEL) || defined(MOTOR_IF_INTERNAL_VEL_POS)
     if (hctrl->ctrl_mode == MOTOR_CTRL_INTERNAL_VEL ||
         hctrl->ctrl_mode == MOTOR_CTRL_INTERNAL_VEL_POS)
     {
-        motor_send_internal_velocity(hctrl->motor_type, hctrl->motor, hctrl->velocity);
+        if (ops->send_velocity != NULL)
+        {
+            motor_latency_record(&hctrl->latency, ops, hctrl->motor);
+            ops->send_velocity(hctrl->motor, hctrl->velocity);
+        }
         return;
     }
 #endif
 
     hctrl->pid.ref = hctrl->velocity;
-    hctrl->pid.fdb = Motor_GetVelocity(hctrl->motor_type, hctrl->motor);
+    hctrl->pid.fdb = ops->get_velocity(hctrl->motor);
     MotorPID_Calculate(&hctrl->pid);
 
-    motor_apply_output(hctrl->motor_type, hctrl->motor, hctrl->pid.output);
+    motor_latency_record(&hctrl->latency, ops, hctrl->motor);
+    if (ops->apply_output != NULL)
+        ops->apply_output(hctrl->motor, hctrl->pid.output);
+}
+
+/**
+ * 初始化速度环组
+ * @param batch 速度环组
+ */
+void Motor_VelCtrlBatch_Init(Motor_VelCtrlBatch_t* batch)
+{
+    memset(batch->ctrls, 0, sizeof(batch->ctrls));
+    MotorPID_BankInit(&batch->bank);
+}
+
+/**
+ * 加入一个速度环，PID 的参数和运行数据复制到 bank 中
+ * @param batch 速度环组
+ * @param hctrl 已初始化的速度环
+ * @return 速度环不是外部 PID 控制的浮点速度环或组已满时进入 MOTOR_IF_ERROR_HANDLER 并返回 false，
+ *         此时速度环仍应单独调用 Motor_VelCtrlUpdate
+ */
+bool Motor_VelCtrlBatch_Add(Motor_VelCtrlBatch_t* batch, Motor_VelCtrl_t* hctrl)
+{
+    if (hctrl->ctrl_mode != MOTOR_CTRL_EXTERNAL_PID || hctrl->fixed_point)
+    {
+        MOTOR_IF_ERROR_HANDLER();
+        return false;
+    }
+    const uint32_t i = MotorPID_BankAdd(&batch->bank,
+                                        (MotorPID_Config_t) {
+                                                .Kp             = hctrl->pid.Kp,
+                                                .Ki             = hctrl->pid.Ki,
+                                                .Kd             = hctrl->pid.Kd,
+                                                .abs_output_max = hctrl->pid.abs_output_max,
+                                        });
+    if (i == MOTOR_PID_BANK_FULL)
+    {
+        MOTOR_IF_ERROR_HANDLER();
+        return false;
+    }
+    batch->ctrls[i]            = hctrl;
+    batch->bank.cur_error[i]   = hctrl->pid.cur_error;
+    batch->bank.prev_error1[i] = hctrl->pid.prev_error1;
+    batch->bank.prev_error2[i] = hctrl->pid.prev_error2;
+    batch->bank.output[i]      = hctrl->pid.output;
+    batch->bank.ref[i]         = hctrl->pid.ref;
+    batch->bank.fdb[i]         = hctrl->pid.fdb;
+    return true;
+}
+
+/**
+ * 速度环组控制计算，与对每个速度环调用 Motor_VelCtrlUpdate 的结果逐位一致
+ *
+ * 先读取全部反馈，再一次计算全部 PID，最后依次输出
+ * @param batch 速度环组
+ */
+void Motor_VelCtrlBatchUpdate(Motor_VelCtrlBatch_t* batch)
+{
+    MotorPID_Bank_t* bank = &batch->bank;
+    bool             run[MOTOR_PID_BANK_SIZE];
+    for (uint32_t i = 0; i < bank->count; i++)
+    {
+        Motor_VelCtrl_t* hctrl = batch->ctrls[i];
+        run[i]                 = hctrl->enable && !hctrl->stale;
+        if (hctrl->enable && hctrl->stale)
+        {
+            MotorPID_Reset(&hctrl->pid);
+            motor_ctrl_hold(hctrl->ops, hctrl->motor, false);
+        }
+        if (run[i])
+        {
+            bank->ref[i] = hctrl->velocity;
+            bank->fdb[i] = hctrl->ops->get_velocity(hctrl->motor);
+        }
+    }
+
+    MotorPID_CalculateBatch(bank);
+
+    for (uint32_t i = 0; i < bank->count; i++)
+    {
+        Motor_VelCtrl_t* hctrl = batch->ctrls[i];
+        if (!run[i])
+        {
+            // 本周期不计算的控制器：撤销 bank 中的计算，保持与 hctrl->pid 相同
+            bank->ref[i]         = hctrl->pid.ref;
+            bank->fdb[i]         = hctrl->pid.fdb;
+            bank->cur_error[i]   = hctrl->pid.cur_error;
+            bank->prev_error1[i] = hctrl->pid.prev_error1;
+            bank->prev_error2[i] = hctrl->pid.prev_error2;
+            bank->output[i]      = hctrl->pid.output;
+            continue;
+        }
+        hctrl->pid.ref         = bank->ref[i];
+        hctrl->pid.fdb         = bank->fdb[i];
+        hctrl->pid.cur_error   = bank->cur_error[i];
+        hctrl->pid.prev_error1 = bank->prev_error1[i];
+        hctrl->pid.prev_error2 = bank->prev_error2[i];
+        hctrl->pid.output      = bank->output[i];
+
+        motor_latency_record(&hctrl->latency, hctrl->ops, hctrl->motor);
+        if (hctrl->ops->apply_output != NULL)
+            hctrl->ops->apply_output(hctrl->motor, hctrl->pid.output);
+    }
 }
 
 #ifdef __cplusplus
@@ -31,16 +31,32 @@
 #ifndef MOTOR_IF_H
 #define MOTOR_IF_H
 
-#define __MOTOR_IF_VERSION__ "1.3.0"
+#define __MOTOR_IF_VERSION__ "1.7.0"
 
 #include <stdbool.h>
+#include "bsp/perf_counter.h"
+#include "libs/multiturn.h"
+#include "libs/pid_bank.h"
+#include "libs/pid_fixed.h"
 #include "libs/pid_motor.h"
 
+#define MOTOR_IF_ERROR_HANDLER() Error_Handler()
+
 // 希望在初始化时手动决定控制模式请启用以下宏
 // #define USE_CUSTOM_CTRL_MODE
 
+#ifndef MOTOR_LATENCY_BUCKET_NS
+/**
+ * 反馈延迟直方图的桶宽 (unit: ns)，共 PERF_HISTOGRAM_BUCKETS 个桶
+ */
+#    define MOTOR_LATENCY_BUCKET_NS (100000U)
+#endif
+
 /******* 🛠️⚠️ 电机扩展提醒块 BEGIN ⚠️🛠️ ********
- * 新增电机时需要在 motor_if.h 中：
+ * 控制器通过 MotorOps_t 操作电机，新驱动可以自己提供一张 MotorOps_t，
+ * 在 *_CtrlConfig_t::ops 中传入即可，无需修改本文件。
+ *
+ * 作为内置类型加入 motor_if 时需要在 motor_if.h 中：
  * 1. 新增 USE_* 的电机类型启用标志
  * 2. 新增条件编译的头文件引入
  *    如果有增加完全使用 `内部PID` 的电机，在引入头文件时添加此项
@@ -51,6 +67,7 @@
  * 4. 通过宏定义新增 电机控制模式 默认值
  * 5. 实现 Motor_GetAngle
  * 6. 实现 Motor_GetVelocity
+ * 并在 motor_if.c 中增加对应的 MotorOps_t
  ****************************************/
 
 #define USE_DJI
@@ -110,6 +127,64 @@ typedef enum
 #endif
 } MotorCtrlMode_t;
 
+/**
+ * 原始单位与浮点单位的换算，用于定点控制
+ */
+typedef struct
+{
+    float angle;    ///< 一个位置原始单位对应的输出轴角度 (unit: deg)
+    float velocity; ///< 一个转速原始单位对应的输出轴转速 (unit: rpm)
+    float output;   ///< 一个输出原始单位对应的 apply_output 输出
+} MotorRawScale_t;
+
+/**
+ * 电机操作表
+ *
+ * 在控制器初始化时确定，控制更新中每个操作只需一次间接调用。
+ * get_angle 和 get_velocity 必须实现，其余操作不支持时置 NULL，
+ * get_feedback_time 在还没有收到反馈时返回 false，
+ * get_command_time 返回最近一条指令帧写入邮箱或入队的时间，
+ * take_fresh 返回上次调用以来是否解包过新反馈，并清除标记，
+ * send_* 每次控制更新都会调用，指令不变时是否省略由驱动决定（如 CAN_SendMessageCached），
+ * invalidate_cmd 使下一次 send_* 一定发出，
+ * reset_observer 清除驱动中速度观测器的运行数据，MotorWatchdog 在掉线和恢复时调用，
+ * *_raw 和 get_raw_scale 是定点控制使用的整数接口，只能全部实现或全部置 NULL；
+ * 例外是只实现 get_angle_raw 和 get_raw_scale（只需填写 angle），此时不支持定点控制，
+ * 浮点位置环以原始单位计算位置误差，不随圈数损失分辨率
+ */
+typedef struct
+{
+    float (*get_angle)(void* hmotor);                             ///< 输出轴角度 (unit: deg)
+    float (*get_velocity)(void* hmotor);                          ///< 输出轴转速 (unit: rpm)
+    void (*reset_angle)(void* hmotor);                            ///< 角度清零
+    void (*apply_output)(void* hmotor, float output);             ///< 设置电流（或占空比）
+    void (*send_velocity)(void* hmotor, float speed);             ///< 发送内部速度控制指令
+    void (*send_position)(void* hmotor, float position);          ///< 发送内部位置控制指令
+    void (*invalidate_cmd)(void* hmotor);                         ///< 下一次指令一定发送
+    bool (*get_feedback_time)(void* hmotor, uint32_t* timestamp); ///< 反馈接收时间 (DWT 周期)
+    bool (*get_command_time)(void* hmotor, uint32_t* timestamp);  ///< 指令发出时间 (DWT 周期)
+    bool (*take_fresh)(void* hmotor);                             ///< 读取并清除新反馈标记
+    void (*reset_observer)(void* hmotor);                         ///< 清除速度观测器
+    int64_t (*get_angle_raw)(void* hmotor);                       ///< 多圈位置原始值
+    int32_t (*get_velocity_raw)(void* hmotor);                    ///< 转速原始值
+    void (*apply_output_raw)(void* hmotor, int32_t output);       ///< 以原始单位设置输出
+    void (*get_raw_scale)(void* hmotor, MotorRawScale_t* scale);  ///< 原始单位的换算
+    MotorCtrlMode_t default_mode;                                 ///< 默认控制模式
+} MotorOps_t;
+
+/**
+ * 反馈延迟：从反馈帧被读出到由它算出的指令写入发送邮箱或发送队列
+ *
+ * 需要电机操作表实现 get_feedback_time 和 get_command_time，被驱动省略的指令不计入
+ */
+typedef struct
+{
+    PerfHistogram_t hist;     ///< 延迟分布
+    uint32_t        feedback; ///< 上一次输出所用反馈的接收时间 (DWT 周期)
+    uint32_t        command;  ///< 上一次输出时的指令发出时间 (DWT 周期)
+    bool            pending;  ///< 上一次输出有对应的反馈，尚未记录
+} MotorLatency_t;
+
 // 电机控制模式的默认值
 #if defined(USE_DJI) && !defined(MOTOR_DEFAULT_MODE_DJI)
 #    define MOTOR_DEFAULT_MODE_DJI MOTOR_CTRL_EXTERNAL_PID
@@ -134,22 +209,34 @@ typedef enum
  */
 typedef struct
 {
-    bool            enable;             ///< 是否启用控制
-    MotorType_t     motor_type;         ///< 受控电机类型
-    MotorCtrlMode_t ctrl_mode;          ///< 控制模式
-    void*           motor;              ///< 受控电机
-    MotorPID_t      velocity_pid;       ///< 内环，速度环
-    MotorPID_t      position_pid;       ///< 外环，位置环
-    uint32_t        pos_vel_freq_ratio; ///< 内外环频率比
-    uint32_t        count;              ///< 计数
-    float           position;           ///< 当前控制的位置
+    bool              enable;             ///< 是否启用控制
+    MotorType_t       motor_type;         ///< 受控电机类型
+    MotorCtrlMode_t   ctrl_mode;          ///< 控制模式
+    const MotorOps_t* ops;                ///< 电机操作表
+    void*             motor;              ///< 受控电机
+    MotorPID_t        velocity_pid;       ///< 内环，速度环
+    MotorPID_t        position_pid;       ///< 外环，位置环
+    uint32_t          pos_vel_freq_ratio; ///< 内外环频率比
+    uint32_t          count;              ///< 计数
+    float             position;           ///< 当前控制的位置
+    MotorLatency_t    latency;            ///< 反馈延迟
+    volatile bool     stale;              ///< 反馈超时，由 MotorWatchdog 设置
+
+    bool            fixed_point;        ///< 使用定点控制，见 Motor_PosCtrlConfig_t::fixed_point
+    MotorPIDFixed_t velocity_pid_fixed; ///< 定点内环，输入和输出见 Motor_PosCtrl_Init
+    MotorPIDFixed_t position_pid_fixed; ///< 定点外环
+    bool            tick_ref;           ///< 位置误差以原始单位计算，电机实现了 get_angle_raw 时启用
+    int64_t         position_raw;       ///< 目标位置，tick_ref 时有效 (unit: 位置原始单位)
+    float           angle_to_raw;       ///< 角度 (unit: deg) 到位置原始单位的换算
+    float           raw_to_angle;       ///< 位置原始单位到角度 (unit: deg) 的换算
 
     struct
     {
-        float    error_threshold; ///< 允许的误差范围
-        uint32_t count_max;       ///< 保持的计数范围
-        uint32_t counter;         ///< 就位计数
-    } settle;                     ///< 就位判断
+        float    error_threshold;     ///< 允许的误差范围
+        int32_t  error_threshold_raw; ///< 允许的误差范围，定点控制使用 (unit: 位置原始单位)
+        uint32_t count_max;           ///< 保持的计数范围
+        uint32_t counter;             ///< 就位计数
+    } settle;                         ///< 就位判断
 
 } Motor_PosCtrl_t;
 
@@ -169,6 +256,15 @@ typedef struct
 
     float    error_threshold;  ///< 允许的误差范围
     uint32_t settle_count_max; ///< 在误差内多少周期认为就位
+
+    const MotorOps_t* ops; ///< 自定义电机操作表，NULL 表示按 motor_type 使用内置实现
+
+    /**
+     * 使用定点控制：反馈、PID 和输出全部为整数运算，控制更新不使用 FPU。
+     * 仅支持外部 PID 控制模式和实现了 *_raw 操作的电机（内置实现中为 DJI 和 TB6612），
+     * 不满足时初始化进入 MOTOR_IF_ERROR_HANDLER。PID 参数仍按浮点单位给出，初始化时换算
+     */
+    bool fixed_point;
 } Motor_PosCtrlConfig_t;
 
 /**
@@ -176,12 +272,20 @@ typedef struct
  */
 typedef struct
 {
-    bool            enable;     //< 是否启用控制
-    MotorType_t     motor_type; //< 受控电机类型
-    MotorCtrlMode_t ctrl_mode;  ///< 控制模式
-    void*           motor;      //< 受控电机
-    MotorPID_t      pid;        //< 速度环
-    float           velocity;   //< 当前控制的速度
+    bool              enable;     //< 是否启用控制
+    MotorType_t       motor_type; //< 受控电机类型
+    MotorCtrlMode_t   ctrl_mode;  ///< 控制模式
+    const MotorOps_t* ops;        ///< 电机操作表
+    void*             motor;      //< 受控电机
+    MotorPID_t        pid;        //< 速度环
+    float             velocity;   //< 当前控制的速度
+    MotorLatency_t    latency;    ///< 反馈延迟
+    volatile bool     stale;      ///< 反馈超时，由 MotorWatchdog 设置
+
+    bool            fixed_point;     ///< 使用定点控制，见 Motor_VelCtrlConfig_t::fixed_point
+    MotorPIDFixed_t pid_fixed;       ///< 定点速度环
+    int32_t         velocity_raw;    ///< 定点控制的目标速度 (unit: 转速原始单位, Q.8)
+    float           velocity_to_raw; ///< 速度 (unit: rpm) 到 velocity_raw 的换算
 } Motor_VelCtrl_t;
 
 /**
@@ -195,18 +299,48 @@ typedef struct
 #endif
     void*             motor; //< 受控电机
     MotorPID_Config_t pid;
+
+    const MotorOps_t* ops; ///< 自定义电机操作表，NULL 表示按 motor_type 使用内置实现
+
+    bool fixed_point; ///< 使用定点控制，限制与 Motor_PosCtrlConfig_t::fixed_point 相同
 } Motor_VelCtrlConfig_t;
 
+/**
+ * 一组速度环，PID 放在 MotorPID_Bank_t 中由 MotorPID_CalculateBatch 一次计算
+ *
+ * 只接受外部 PID 控制的浮点速度环。加入后 PID 的参数和运行数据以 bank 为准，
+ * 每次 Motor_VelCtrlBatchUpdate 后复制回各速度环的 pid，读取 hctrl->pid 的代码不需要修改；
+ * 加入后修改参数请修改 bank 中对应的项
+ */
+typedef struct
+{
+    Motor_VelCtrl_t* ctrls[MOTOR_PID_BANK_SIZE]; ///< 速度环，下标与 bank 中的控制器相同
+    MotorPID_Bank_t  bank;                       ///< 速度环的 PID
+} Motor_VelCtrlBatch_t;
+
+const MotorOps_t* Motor_GetOps(MotorType_t motor_type);
 void Motor_PosCtrl_Init(Motor_PosCtrl_t* hctrl, const Motor_PosCtrlConfig_t* config);
 void Motor_VelCtrl_Init(Motor_VelCtrl_t* hctrl, const Motor_VelCtrlConfig_t* config);
 void Motor_PosCtrlUpdate(Motor_PosCtrl_t* hctrl);
 void Motor_VelCtrlUpdate(Motor_VelCtrl_t* hctrl);
+void Motor_VelCtrlBatch_Init(Motor_VelCtrlBatch_t* batch);
+bool Motor_VelCtrlBatch_Add(Motor_VelCtrlBatch_t* batch, Motor_VelCtrl_t* hctrl);
+void Motor_VelCtrlBatchUpdate(Motor_VelCtrlBatch_t* batch);
+
+/**
+ * 使电机驱动的指令发送缓存失效，下一次内部控制指令不会因与上次相同而被省略
+ * @param __ctrl__ 受控对象 (Motor_PosCtrl_t* 或 Motor_VelCtrl_t*)
+ */
+#define MotorCtrl_InvalidateCmd(__ctrl__)                                                          \
+    ((__ctrl__)->ops->invalidate_cmd != NULL ? (__ctrl__)->ops->invalidate_cmd((__ctrl__)->motor)  \
+                                             : (void) 0)
 
 /**
- * 启用电机控制
+ * 启用电机控制，启用后的第一次更新一定发出内部控制指令
  * @param __CTRL_HANDLE__ 受控对象 (Motor_PosCtrl_t* 或 Motor_VelCtrl_t*)
  */
-#define __MOTOR_CTRL_ENABLE(__CTRL_HANDLE__) ((__CTRL_HANDLE__)->enable = true)
+#define __MOTOR_CTRL_ENABLE(__CTRL_HANDLE__)                                                       \
+    (MotorCtrl_InvalidateCmd(__CTRL_HANDLE__), (__CTRL_HANDLE__)->enable = true)
 
 /**
  * 禁用电机控制
@@ -222,7 +356,11 @@ void Motor_VelCtrlUpdate(Motor_VelCtrl_t* hctrl);
 static inline void Motor_PosCtrl_SetErrorThreshold(Motor_PosCtrl_t* hctrl, const float threshold)
 {
     if (threshold > 0)
-        hctrl->settle.error_threshold = threshold;
+    {
+        hctrl->settle.error_threshold     = threshold;
+        hctrl->settle.error_threshold_raw =
+                MotorPIDFixed_FloatToI32(threshold * hctrl->angle_to_raw);
+    }
 }
 
 /**
@@ -237,42 +375,64 @@ static inline bool Motor_PosCtrl_IsSettle(Motor_PosCtrl_t* hctrl)
 
 /**
  * 设置位置环目标值
+ *
+ * 只记录目标值，内部控制模式下的指令在下一次 Motor_PosCtrlUpdate 时发送
  * @param hctrl 受控对象
  * @param ref 目标值 (unit: deg)
  */
 static inline void Motor_PosCtrl_SetRef(Motor_PosCtrl_t* hctrl, const float ref)
 {
     hctrl->position = ref;
-#ifdef MOTOR_IF_INTERNAL_VEL_POS
-    if (hctrl->ctrl_mode == MOTOR_CTRL_INTERNAL_VEL_POS)
-    { // 在内部位置环控制模式下，需要在设置时立刻同步一次指令
-        Motor_PosCtrlUpdate(hctrl);
-    }
-#endif
+    if (hctrl->tick_ref)
+        hctrl->position_raw = MotorPIDFixed_FloatToI64(ref * hctrl->angle_to_raw);
+}
+
+/**
+ * 以当前目标值为基准移动目标值
+ *
+ * 目标值很大时 float 表示不了较小的增量，tick_ref 时增量累加到原始单位的目标值上，不丢失
+ * @param hctrl 受控对象
+ * @param delta 增量 (unit: deg)
+ */
+static inline void Motor_PosCtrl_MoveRef(Motor_PosCtrl_t* hctrl, const float delta)
+{
+    hctrl->position += delta;
+    if (hctrl->tick_ref)
+        hctrl->position_raw += MotorPIDFixed_FloatToI64(delta * hctrl->angle_to_raw);
+}
+
+/**
+ * 以位置原始单位设置位置环的目标值，不使用浮点运算，不更新 position
+ * @param hctrl 受控对象，必须启用了 tick_ref（定点控制一定启用）
+ * @param ref 目标值 (unit: 位置原始单位，例如 DJI 的转子编码器刻度)
+ */
+static inline void Motor_PosCtrl_SetRefRaw(Motor_PosCtrl_t* hctrl, const int64_t ref)
+{
+    hctrl->position_raw = ref;
 }
 
 /**
  * 设置速度环目标值
+ *
+ * 只记录目标值，内部控制模式下的指令在下一次 Motor_VelCtrlUpdate 时发送
  * @param hctrl 受控对象
  * @param ref 目标值 (unit: rpm)
  */
 static inline void Motor_VelCtrl_SetRef(Motor_VelCtrl_t* hctrl, const float ref)
 {
     hctrl->velocity = ref;
-#if defined(MOTOR_IF_INTERNAL_VEL_POS) || defined(MOTOR_IF_INTERNAL_VEL)
-    switch (hctrl->ctrl_mode)
-    {
-#    ifdef MOTOR_IF_INTERNAL_VEL_POS
-    case MOTOR_CTRL_INTERNAL_VEL_POS:
-#    endif
-#    ifdef MOTOR_IF_INTERNAL_VEL
-    case MOTOR_CTRL_INTERNAL_VEL:
-#    endif
-        // 在内部位置环控制模式以及内部速度环控制模式下，需要在设置时立刻同步一次指令
-        Motor_VelCtrlUpdate(hctrl);
-    default:;
-    }
-#endif
+    if (hctrl->fixed_point)
+        hctrl->velocity_raw = MotorPIDFixed_FloatToI32(ref * hctrl->velocity_to_raw);
+}
+
+/**
+ * 以转速原始单位设置定点速度环的目标值，不使用浮点运算
+ * @param hctrl 受控对象，必须启用了 fixed_point
+ * @param ref 目标值 (unit: 转速原始单位，例如 DJI 的转子 rpm)
+ */
+static inline void Motor_VelCtrl_SetRefRaw(Motor_VelCtrl_t* hctrl, const int32_t ref)
+{
+    hctrl->velocity_raw = ref * (1 << MOTOR_PID_FIXED_OUT_FRAC);
 }
 
 /* 电机反馈量 */
@@ -308,7 +468,7 @@ static inline float Motor_GetAngle(const MotorType_t motor_type, void* hmotor)
     }
 }
 
-#define MotorCtrl_GetAngle(__ctrl__) (Motor_GetAngle((__ctrl__)->motor_type, (__ctrl__)->motor))
+#define MotorCtrl_GetAngle(__ctrl__) ((__ctrl__)->ops->get_angle((__ctrl__)->motor))
 
 static inline void Motor_ResetAngle(const MotorType_t motor_type, void* hmotor)
 {
@@ -338,13 +498,15 @@ static inline void Motor_ResetAngle(const MotorType_t motor_type, void* hmotor)
     }
 }
 
-#define MotorCtrl_ResetAngle(__ctrl__) (Motor_ResetAngle((__ctrl__)->motor_type, (__ctrl__)->motor))
+#define MotorCtrl_ResetAngle(__ctrl__)                                                             \
+    ((__ctrl__)->ops->reset_angle != NULL ? (__ctrl__)->ops->reset_angle((__ctrl__)->motor)        \
+                                          : (void) 0)
 
 /**
  * 获取电机转速
  * @param motor_type 电机类型
  * @param hmotor 电机数据
- * @return 电机输出转速
+ * @return 电机输出转速，电机挂接了速度观测器（DJI、TB6612）时为观测值
  */
 static inline float Motor_GetVelocity(const MotorType_t motor_type, void* hmotor)
 {
@@ -371,8 +533,7 @@ static inline float Motor_GetVelocity(const MotorType_t motor_type, void* hmotor
     }
 }
 
-#define MotorCtrl_GetVelocity(__ctrl__)                                                            \
-    (Motor_GetVelocity((__ctrl__)->motor_type, (__ctrl__)->motor))
+#define MotorCtrl_GetVelocity(__ctrl__) ((__ctrl__)->ops->get_velocity((__ctrl__)->motor))
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,207 @@
+/**
+ * @file    motor_watchdog.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "motor_watchdog.h"
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * 设置掉线状态，通知控制器和回调
+ *
+ * 掉线时速度观测器的估计停在最后一帧，恢复时又从过时的估计开始，两次都清除
+ */
+static void watch_set_stale(MotorWatch_t* watch, const bool stale)
+{
+    watch->stale = stale;
+    if (watch->stale_out != NULL)
+        *watch->stale_out = stale;
+    if (watch->ops->reset_observer != NULL)
+        watch->ops->reset_observer(watch->motor);
+    if (stale)
+        watch->watchdog->stale_count++;
+    else
+        watch->watchdog->stale_count--;
+    if (watch->callback != NULL)
+        watch->callback(watch, stale);
+}
+
+/**
+ * 定时器到期：检查上次检查之后是否收到过反馈
+ * @param timer 定时器
+ * @param now 当前时刻 (unit: ms)
+ */
+static void watch_check(TimingWheel_Timer_t* timer, const uint32_t now)
+{
+    MotorWatch_t* watch = timer->arg;
+
+    uint32_t timestamp;
+    if (watch->ops->get_feedback_time(watch->motor, &timestamp) &&
+        (!watch->seen || timestamp != watch->last_timestamp))
+    {
+        // 收到过新反馈，按反馈时间推算收到的时刻，不会早于上次收到反馈的时刻
+        uint32_t age = (PerfCounter_Now() - timestamp) / (SystemCoreClock / 1000U);
+        if (age > now - watch->last_seen)
+            age = now - watch->last_seen;
+        watch->seen           = true;
+        watch->last_timestamp = timestamp;
+        watch->last_seen      = now - age;
+
+        if (watch->stale)
+        {
+            const uint32_t duration = watch->last_seen - watch->dropout_start;
+            watch->dropout_last_ms  = duration;
+            if (duration > watch->dropout_max_ms)
+                watch->dropout_max_ms = duration;
+            watch->dropout_total_ms += duration;
+            watch_set_stale(watch, false);
+        }
+    }
+
+    if (!watch->stale && now - watch->last_seen >= watch->timeout)
+    {
+        watch->dropouts++;
+        watch->last_dropout_tick = now;
+        watch->dropout_start     = watch->last_seen;
+        watch_set_stale(watch, true);
+    }
+
+    // 正常时在下一次可能超时的时刻再检查，掉线后每个 tick 检查一次以便及时恢复
+    const uint32_t delay = watch->stale ? 1 : watch->last_seen + watch->timeout - now;
+    TimingWheel_Add(&watch->watchdog->wheel, timer, delay);
+}
+
+/**
+ * 初始化看门狗
+ * @param watchdog 看门狗
+ */
+void MotorWatchdog_Init(MotorWatchdog_t* watchdog)
+{
+    memset(watchdog, 0, sizeof(MotorWatchdog_t));
+    TimingWheel_Init(&watchdog->wheel, HAL_GetTick());
+}
+
+/**
+ * 添加一个监视项，从添加时刻开始计算第一次超时
+ * @param watchdog 看门狗
+ * @param watch 监视项，由调用者分配，监视期间必须保持有效
+ * @param config 配置
+ */
+void MotorWatchdog_Add(MotorWatchdog_t*           watchdog,
+                       MotorWatch_t*              watch,
+                       const MotorWatch_Config_t* config)
+{
+    if (config->ops == NULL || config->ops->get_feedback_time == NULL)
+    {
+        // 电机不支持反馈时间，无法监视
+        MOTOR_WATCHDOG_ERROR_HANDLER();
+        return;
+    }
+
+    memset(watch, 0, sizeof(MotorWatch_t));
+    watch->watchdog  = watchdog;
+    watch->ops       = config->ops;
+    watch->motor     = config->motor;
+    watch->timeout   = config->timeout_ms ? config->timeout_ms : MOTOR_WATCHDOG_TIMEOUT_MS;
+    watch->stale_out = config->stale;
+    watch->callback  = config->callback;
+    if (watch->stale_out != NULL)
+        *watch->stale_out = false;
+
+    // 时间轮只在 Tick 中推进，Init 之后还没有开始 Tick 时 wheel.now 早于当前时刻，
+    // 第一次超时从当前时刻计算，定时器按绝对时刻挂到时间轮上
+    const uint32_t now = HAL_GetTick();
+    watch->last_seen   = now;
+    TimingWheel_TimerInit(&watch->timer, watch_check, watch);
+    TimingWheel_Add(&watchdog->wheel, &watch->timer, now - watchdog->wheel.now + watch->timeout);
+    watchdog->count++;
+}
+
+/**
+ * 监视位置环控制器的电机，掉线时控制器冻结 PID 并输出 0
+ * @param watchdog 看门狗
+ * @param watch 监视项
+ * @param hctrl 控制器
+ * @param timeout_ms 反馈超时，0 表示 MOTOR_WATCHDOG_TIMEOUT_MS
+ */
+void MotorWatchdog_AddPos(MotorWatchdog_t* watchdog,
+                          MotorWatch_t*    watch,
+                          Motor_PosCtrl_t* hctrl,
+                          const uint32_t   timeout_ms)
+{
+    MotorWatchdog_Add(watchdog,
+                      watch,
+                      &(MotorWatch_Config_t) { .ops        = hctrl->ops,
+                                               .motor      = hctrl->motor,
+                                               .timeout_ms = timeout_ms,
+                                               .stale      = &hctrl->stale });
+}
+
+/**
+ * 监视速度环控制器的电机，掉线时控制器冻结 PID 并输出 0
+ * @param watchdog 看门狗
+ * @param watch 监视项
+ * @param hctrl 控制器
+ * @param timeout_ms 反馈超时，0 表示 MOTOR_WATCHDOG_TIMEOUT_MS
+ */
+void MotorWatchdog_AddVel(MotorWatchdog_t* watchdog,
+                          MotorWatch_t*    watch,
+                          Motor_VelCtrl_t* hctrl,
+                          const uint32_t   timeout_ms)
+{
+    MotorWatchdog_Add(watchdog,
+                      watch,
+                      &(MotorWatch_Config_t) { .ops        = hctrl->ops,
+                                               .motor      = hctrl->motor,
+                                               .timeout_ms = timeout_ms,
+                                               .stale      = &hctrl->stale });
+}
+
+/**
+ * 移除监视项，掉线中的控制器恢复正常
+ * @param watchdog 看门狗
+ * @param watch 监视项
+ */
+void MotorWatchdog_Remove(MotorWatchdog_t* watchdog, MotorWatch_t* watch)
+{
+    TimingWheel_Remove(&watchdog->wheel, &watch->timer);
+    if (watch->stale)
+        watch_set_stale(watch, false);
+    watchdog->count--;
+}
+
+/**
+ * 检查本 tick 到期的监视项
+ *
+ * 应每 1ms 调用一次，可以与控制组的 Tick 放在同一个定时器回调中
+ * @param watchdog 看门狗
+ */
+void MotorWatchdog_Tick(MotorWatchdog_t* watchdog)
+{
+    TimingWheel_Advance(&watchdog->wheel, HAL_GetTick());
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file    motor_watchdog.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   feedback staleness watchdog for motors, driven by a timing wheel
+ *
+ * 每个被监视的电机在时间轮上挂一个定时器，到期时通过 MotorOps_t::get_feedback_time
+ * 检查上次检查之后是否收到过反馈：收到过则按反馈时间重新挂到下一次可能超时的时刻，
+ * 没有收到且超过 timeout 则判定为掉线，置位控制器的 stale，控制器随即冻结 PID 并输出 0。
+ * 掉线后每个 tick 检查一次，收到反馈立即恢复。掉线和恢复时还通过 MotorOps_t::reset_observer
+ * 清除驱动中的速度观测器（如 DJI_AttachObserver 挂接的），不沿用过时的估计。
+ * 解包路径不需要做任何事，每个 tick 只处理本 tick 到期的电机，与电机总数无关。
+ *
+ * 每个电机记录掉线次数和时长，last_dropout_tick 可以与总线负载的记录对照
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef MOTOR_WATCHDOG_H
+#define MOTOR_WATCHDOG_H
+
+#include "interfaces/motor_if.h"
+#include "libs/timing_wheel.h"
+
+#define MOTOR_WATCHDOG_ERROR_HANDLER() Error_Handler()
+
+#ifndef MOTOR_WATCHDOG_TIMEOUT_MS
+/**
+ * 默认反馈超时 (unit: ms)
+ */
+#    define MOTOR_WATCHDOG_TIMEOUT_MS (20U)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct MotorWatchdog MotorWatchdog_t;
+typedef struct MotorWatch    MotorWatch_t;
+
+/**
+ * 掉线和恢复时的回调
+ * @param watch 监视项
+ * @param stale true 为掉线，false 为恢复
+ */
+typedef void (*MotorWatch_Callback_t)(MotorWatch_t* watch, bool stale);
+
+typedef struct
+{
+    const MotorOps_t*     ops;        ///< 电机操作表，必须实现 get_feedback_time
+    void*                 motor;      ///< 电机
+    uint32_t              timeout_ms; ///< 反馈超时，0 表示 MOTOR_WATCHDOG_TIMEOUT_MS
+    volatile bool*        stale;      ///< 掉线标记输出，通常为控制器的 stale，可以为 NULL
+    MotorWatch_Callback_t callback;   ///< 掉线和恢复时的回调，可以为 NULL
+} MotorWatch_Config_t;
+
+struct MotorWatch
+{
+    TimingWheel_Timer_t   timer;
+    MotorWatchdog_t*      watchdog;
+    const MotorOps_t*     ops;
+    void*                 motor;
+    uint32_t              timeout; ///< 反馈超时 (unit: ms)
+    volatile bool*        stale_out;
+    MotorWatch_Callback_t callback;
+
+    bool     stale;          ///< 是否掉线
+    bool     seen;           ///< 是否收到过反馈
+    uint32_t last_timestamp; ///< 上次检查时的反馈时间 (DWT 周期)
+    uint32_t last_seen;      ///< 最近一次收到反馈的时刻 (unit: ms)
+
+    uint32_t dropouts;          ///< 掉线次数
+    uint32_t last_dropout_tick; ///< 最近一次判定掉线的时刻 (unit: ms)
+    uint32_t dropout_start;     ///< 本次掉线前最后一次收到反馈的时刻 (unit: ms)
+    uint32_t dropout_last_ms;   ///< 上一次掉线的时长
+    uint32_t dropout_max_ms;    ///< 最长的掉线时长
+    uint32_t dropout_total_ms;  ///< 掉线总时长（不含正在进行的掉线）
+};
+
+struct MotorWatchdog
+{
+    TimingWheel_t wheel;
+    uint32_t      count;       ///< 监视的电机数
+    uint32_t      stale_count; ///< 当前掉线的电机数
+};
+
+void MotorWatchdog_Init(MotorWatchdog_t* watchdog);
+void MotorWatchdog_Add(MotorWatchdog_t*           watchdog,
+                       MotorWatch_t*              watch,
+                       const MotorWatch_Config_t* config);
+void MotorWatchdog_AddPos(MotorWatchdog_t* watchdog,
+                          MotorWatch_t*    watch,
+                          Motor_PosCtrl_t* hctrl,
+                          uint32_t         timeout_ms);
+void MotorWatchdog_AddVel(MotorWatchdog_t* watchdog,
+                          MotorWatch_t*    watch,
+                          Motor_VelCtrl_t* hctrl,
+                          uint32_t         timeout_ms);
+void MotorWatchdog_Remove(MotorWatchdog_t* watchdog, MotorWatch_t* watch);
+void MotorWatchdog_Tick(MotorWatchdog_t* watchdog);
+
+/**
+ * 当前掉线已持续的时间
+ * @param watch 监视项
+ * @return 未掉线时返回 0 (unit: ms)
+ */
+static inline uint32_t MotorWatch_StaleFor(const MotorWatch_t* watch)
+{
+    return watch->stale ? HAL_GetTick() - watch->dropout_start : 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MOTOR_WATCHDOG_H
@@ -0,0 +1,333 @@
+/**
+ * @file    can_trace.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "can_trace.h"
+#include <stdio.h>
+#include <string.h>
+
+_Static_assert(sizeof(CAN_TraceRecord_t) == 20, "CAN_TraceRecord_t must be 20 bytes");
+_Static_assert(sizeof(CAN_TraceHeader_t) % _Alignof(CAN_TraceRecord_t) == 0,
+               "records after CAN_TraceHeader_t must stay aligned");
+
+/**
+ * 初始化环形缓冲区，初始化后处于记录状态
+ * @param ring 环形缓冲区
+ * @param buffer 记录存储区
+ * @param size 记录条数，必须为 2 的幂
+ */
+void CAN_TraceRing_Init(CAN_TraceRing_t* ring, CAN_TraceRecord_t* buffer, const uint32_t size)
+{
+    ring->buffer = buffer;
+    ring->size   = size;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->enable, true);
+}
+
+/**
+ * 按时间顺序（从旧到新）导出缓冲区中的记录
+ * @attention 导出前应停止记录
+ * @param ring 环形缓冲区
+ * @param out 输出
+ * @param max out 的容量，不足时只导出最新的 max 条
+ * @return 导出的条数
+ */
+size_t CAN_TraceRing_Export(CAN_TraceRing_t* ring, CAN_TraceRecord_t* out, const size_t max)
+{
+    const uint32_t head  = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t       count = CAN_TraceRing_Count(ring);
+    if (count > max)
+        count = (uint32_t) max;
+
+    const uint32_t mask = ring->size - 1;
+    for (uint32_t i = 0; i < count; i++)
+        out[i] = ring->buffer[(head - count + i) & mask];
+    return count;
+}
+
+/**
+ * 按时间顺序导出为文件：CAN_TraceHeader_t 加记录
+ * @attention 导出前应停止记录，out 须按 4 字节对齐
+ * @param ring 环形缓冲区
+ * @param out 输出
+ * @param size out 的字节数，不足时只导出最新的记录
+ * @return 写入的字节数，size 小于文件头时为 0
+ */
+size_t CAN_TraceRing_ExportFile(CAN_TraceRing_t* ring, void* out, const size_t size)
+{
+    if (size < sizeof(CAN_TraceHeader_t))
+        return 0;
+
+    CAN_TraceRecord_t* records = (CAN_TraceRecord_t*) ((uint8_t*) out + sizeof(CAN_TraceHeader_t));
+    const size_t       count   = CAN_TraceRing_Export(
+            ring, records, (size - sizeof(CAN_TraceHeader_t)) / sizeof(CAN_TraceRecord_t));
+
+    const CAN_TraceHeader_t header = {
+        .magic       = CAN_TRACE_MAGIC,
+        .version     = CAN_TRACE_VERSION,
+        .record_size = sizeof(CAN_TraceRecord_t),
+        .count       = (uint32_t) count,
+    };
+    memcpy(out, &header, sizeof(header));
+    return sizeof(header) + count * sizeof(CAN_TraceRecord_t);
+}
+
+/**
+ * 检查 CAN_TraceRing_ExportFile 导出的文件
+ * @attention data 须按 4 字节对齐
+ * @param data 文件内容
+ * @param size 文件的字节数
+ * @param records 输出，指向 data 中的第一条记录
+ * @param count 输出，记录条数
+ * @return 文件头有效且记录完整时返回 true
+ */
+bool CAN_Trace_ParseFile(const void*               data,
+                         const size_t              size,
+                         const CAN_TraceRecord_t** records,
+                         size_t*                   count)
+{
+    CAN_TraceHeader_t header;
+    if (size < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != CAN_TRACE_MAGIC || header.version != CAN_TRACE_VERSION ||
+        header.record_size != sizeof(CAN_TraceRecord_t))
+        return false;
+    // 截断的文件
+    if (header.count > (size - sizeof(header)) / sizeof(CAN_TraceRecord_t))
+        return false;
+
+    *records = (const CAN_TraceRecord_t*) ((const uint8_t*) data + sizeof(header));
+    *count   = header.count;
+    return true;
+}
+
+static int hex_value(const char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static const char* skip_space(const char* p)
+{
+    while (*p == ' ' || *p == '\t')
+        p++;
+    return p;
+}
+
+/**
+ * 解析十六进制数
+ * @param p 起始位置
+ * @param value 输出
+ * @param digits 输出位数
+ * @return 解析结束的位置
+ */
+static const char* parse_hex(const char* p, uint32_t* value, uint32_t* digits)
+{
+    uint32_t v = 0, n = 0;
+    int      h;
+    while ((h = hex_value(*p)) >= 0)
+    {
+        v = v << 4 | (uint32_t) h;
+        n++;
+        p++;
+    }
+    *value  = v;
+    *digits = n;
+    return p;
+}
+
+/**
+ * 解析 "(sec.usec)"，转换为 us，允许回绕
+ */
+static const char* parse_timestamp(const char* p, uint32_t* timestamp)
+{
+    uint32_t sec = 0, usec = 0, scale = 1000000;
+    p++; // '('
+    while (*p >= '0' && *p <= '9')
+        sec = sec * 10 + (uint32_t) (*p++ - '0');
+    if (*p == '.')
+    {
+        p++;
+        while (*p >= '0' && *p <= '9')
+        {
+            if (scale > 1)
+            {
+                scale /= 10;
+                usec += (uint32_t) (*p - '0') * scale;
+            }
+            p++;
+        }
+    }
+    if (*p != ')')
+        return NULL;
+    *timestamp = sec * 1000000U + usec;
+    return p + 1;
+}
+
+/**
+ * 解析一行 candump 输出
+ *
+ * 总线编号取接口名末尾的数字（can0 -> 0, vcan1 -> 1），没有时间戳的行时间戳为 0，
+ * candump 不区分收发，导入的记录都视为接收。不支持 CAN FD (##)
+ * @param line 一行文本，可以带换行符
+ * @param record 输出
+ * @return 格式错误时返回 false
+ */
+bool CAN_Trace_ParseCandump(const char* line, CAN_TraceRecord_t* record)
+{
+    memset(record, 0, sizeof(CAN_TraceRecord_t));
+
+    const char* p = skip_space(line);
+    if (*p == '(')
+    {
+        p = parse_timestamp(p, &record->timestamp);
+        if (p == NULL)
+            return false;
+        p = skip_space(p);
+    }
+
+    // 接口名
+    const char* name = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t')
+        p++;
+    if (p == name)
+        return false;
+    const char* digit = p;
+    while (digit > name && digit[-1] >= '0' && digit[-1] <= '9')
+        digit--;
+    uint32_t bus = 0;
+    for (; digit < p; digit++)
+        bus = bus * 10 + (uint32_t) (*digit - '0');
+    record->bus = (uint8_t) bus;
+
+    uint32_t id, digits;
+    p = parse_hex(skip_space(p), &id, &digits);
+    if (digits == 0 || digits > 8 || id > CAN_TRACE_ID_MASK)
+        return false;
+    // candump 标准帧固定打印 3 位，扩展帧 8 位
+    record->id = id | (digits > 3 ? CAN_TRACE_FLAG_EXT : 0);
+
+    uint32_t dlc = 0;
+    if (*p == '#')
+    {
+        // 日志格式: 123#DEADBEEF / 123#R
+        p++;
+        if (*p == '#')
+            return false;
+        if (*p == 'R' || *p == 'r')
+        {
+            record->id |= CAN_TRACE_FLAG_RTR;
+            p++;
+            // 可选的 DLC: 123#R4
+            if (*p >= '0' && *p <= '8')
+                dlc = (uint32_t) (*p - '0');
+        }
+        else
+        {
+            int hi, lo;
+            while ((hi = hex_value(p[0])) >= 0 && (lo = hex_value(p[1])) >= 0)
+            {
+                if (dlc >= 8)
+                    return false;
+                record->data[dlc++] = (uint8_t) (hi << 4 | lo);
+                p += 2;
+                if (*p == '.')
+                    p++;
+            }
+        }
+    }
+    else
+    {
+        // 默认格式: 123   [4]  DE AD BE EF / 123   [4]  remote request
+        p = skip_space(p);
+        if (p[0] != '[' || p[1] < '0' || p[1] > '8' || p[2] != ']')
+            return false;
+        dlc = (uint32_t) (p[1] - '0');
+        p   = skip_space(p + 3);
+        if (strncmp(p, "remote", 6) == 0)
+        {
+            record->id |= CAN_TRACE_FLAG_RTR;
+        }
+        else
+        {
+            for (uint32_t i = 0; i < dlc; i++)
+            {
+                const int hi = hex_value(p[0]);
+                const int lo = hi >= 0 ? hex_value(p[1]) : -1;
+                if (lo < 0)
+                    return false;
+                record->data[i] = (uint8_t) (hi << 4 | lo);
+                p               = skip_space(p + 2);
+            }
+        }
+    }
+    record->dlc = (uint8_t) dlc;
+    return true;
+}
+
+/**
+ * 按 candump -l 日志格式输出一条记录，结果可以用 canplayer 回放
+ *
+ * 时间戳只有 32 位 us，秒数部分约 71 分钟回绕一次
+ * @param record 记录
+ * @param buf 输出缓冲区
+ * @param len 缓冲区长度
+ * @return 写入的字符数（不含 '\0'），缓冲区不足时返回 -1
+ */
+int CAN_Trace_FormatCandump(const CAN_TraceRecord_t* record, char* buf, const size_t len)
+{
+    const unsigned long sec  = record->timestamp / 1000000U;
+    const unsigned long usec = record->timestamp % 1000000U;
+    const unsigned long id   = record->id & CAN_TRACE_ID_MASK;
+    const unsigned int  bus  = record->bus;
+
+    int ret = (record->id & CAN_TRACE_FLAG_EXT)
+                      ? snprintf(buf, len, "(%lu.%06lu) can%u %08lX#", sec, usec, bus, id)
+                      : snprintf(buf, len, "(%lu.%06lu) can%u %03lX#", sec, usec, bus, id);
+    if (ret < 0 || (size_t) ret >= len)
+        return -1;
+    size_t pos = (size_t) ret;
+
+    if (record->id & CAN_TRACE_FLAG_RTR)
+    {
+        ret = snprintf(buf + pos, len - pos, "R\n");
+    }
+    else
+    {
+        const uint8_t dlc = record->dlc > 8 ? 8 : record->dlc;
+        for (uint8_t i = 0; i < dlc; i++)
+        {
+            ret = snprintf(buf + pos, len - pos, "%02X", record->data[i]);
+            if (ret < 0 || (size_t) ret >= len - pos)
+                return -1;
+            pos += (size_t) ret;
+        }
+        ret = snprintf(buf + pos, len - pos, "\n");
+    }
+    if (ret < 0 || (size_t) ret >= len - pos)
+        return -1;
+    return (int) (pos + (size_t) ret);
+}
@@ -0,0 +1,125 @@
+/**
+ * @file    can_trace.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   CAN trace format, ring buffer and candump conversion
+ *
+ * 紧凑的 CAN 帧记录格式（每帧 20 字节），环形记录缓冲区（写满后覆盖最旧的记录，
+ * 即"黑匣子"），以及与 candump 文本格式的互相转换。
+ * 本库不依赖硬件，记录和回放见 bsp/can_driver.h 的 CAN_Trace_* 函数。
+ *
+ * 支持导入的 candump 格式
+ *   candump -l 日志：    (1436509052.249713) can0 123#DEADBEEF
+ *   candump 默认输出：     can0  123   [4]  DE AD BE EF
+ * 远程帧写作 123#R，扩展帧 ID 为 8 位十六进制
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef CAN_TRACE_H
+#define CAN_TRACE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CAN_TRACE_MAGIC   (0x544E4143U) ///< "CANT"，小端
+#define CAN_TRACE_VERSION (1U)
+
+/* CAN_TraceRecord_t::id 的高 3 位为标志位，低 29 位为 ID */
+#define CAN_TRACE_FLAG_EXT (1U << 31) ///< 扩展帧
+#define CAN_TRACE_FLAG_RTR (1U << 30) ///< 远程帧
+#define CAN_TRACE_FLAG_TX  (1U << 29) ///< 本机发送的帧
+#define CAN_TRACE_ID_MASK  (0x1FFFFFFFU)
+
+/**
+ * 一帧记录 (20 字节)
+ */
+typedef struct
+{
+    uint32_t timestamp; ///< 时间戳 (unit: us)，允许回绕，回放时只使用相邻记录的差值
+    uint32_t id;        ///< ID | CAN_TRACE_FLAG_*
+    uint8_t  bus;       ///< 总线编号，CAN1 为 0，CAN2 为 1
+    uint8_t  dlc;       ///< 数据长度
+    uint8_t  fmi;       ///< 接收时匹配的过滤器编号，回放时用于选择回调
+    uint8_t  reserved;
+    uint8_t  data[8];
+} CAN_TraceRecord_t;
+
+/**
+ * 导出到文件时放在记录前面的文件头 (12 字节)，记录紧跟在文件头之后
+ *
+ * 读取时检查 magic、version 和 record_size，字节序或格式不同的文件会被拒绝
+ */
+typedef struct
+{
+    uint32_t magic;       ///< CAN_TRACE_MAGIC
+    uint16_t version;     ///< CAN_TRACE_VERSION
+    uint16_t record_size; ///< sizeof(CAN_TraceRecord_t)
+    uint32_t count;       ///< 记录条数
+} CAN_TraceHeader_t;
+
+/**
+ * 环形记录缓冲区
+ *
+ * 多个生产者（接收中断、发送任务）可以同时写入，写满后覆盖最旧的记录。
+ * 读取前应先停止记录 (enable = false)，否则可能读到正在写入的记录
+ */
+typedef struct
+{
+    CAN_TraceRecord_t* buffer;
+    uint32_t           size;   ///< 容量，必须为 2 的幂
+    atomic_uint        head;   ///< 已写入的总条数
+    atomic_bool        enable; ///< 是否记录
+} CAN_TraceRing_t;
+
+void   CAN_TraceRing_Init(CAN_TraceRing_t* ring, CAN_TraceRecord_t* buffer, uint32_t size);
+size_t CAN_TraceRing_Export(CAN_TraceRing_t* ring, CAN_TraceRecord_t* out, size_t max);
+size_t CAN_TraceRing_ExportFile(CAN_TraceRing_t* ring, void* out, size_t size);
+
+bool CAN_Trace_ParseFile(const void*               data,
+                         size_t                    size,
+                         const CAN_TraceRecord_t** records,
+                         size_t*                   count);
+
+bool CAN_Trace_ParseCandump(const char* line, CAN_TraceRecord_t* record);
+int  CAN_Trace_FormatCandump(const CAN_TraceRecord_t* record, char* buf, size_t len);
+
+/**
+ * 写入一条记录
+ * @param ring 环形缓冲区
+ * @param record 记录
+ */
+static inline void CAN_TraceRing_Push(CAN_TraceRing_t* ring, const CAN_TraceRecord_t* record)
+{
+    if (!atomic_load_explicit(&ring->enable, memory_order_relaxed))
+        return;
+    // 先占位再写入，中断打断任务写入时各自写不同的槽位
+    const uint32_t index = atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+    ring->buffer[index & (ring->size - 1)] = *record;
+}
+
+/**
+ * 缓冲区中有效的记录条数
+ */
+static inline uint32_t CAN_TraceRing_Count(CAN_TraceRing_t* ring)
+{
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    return head < ring->size ? head : ring->size;
+}
+
+#endif // CAN_TRACE_H
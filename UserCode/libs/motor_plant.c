@@ -0,0 +1,143 @@
+/**
+ * @file    motor_plant.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "motor_plant.h"
+#include <math.h>
+#include <string.h>
+
+static float clamp_abs(const float value, const float max)
+{
+    if (value > max)
+        return max;
+    if (value < -max)
+        return -max;
+    return value;
+}
+
+/**
+ * 以给定电流推进一步
+ *
+ * 粘滞摩擦使用隐式欧拉，任意步长下都不会发散；库仑摩擦不会使速度越过 0 反向，
+ * 静止时驱动力矩不超过库仑摩擦则保持静止
+ */
+static void plant_step(MotorPlant_t* hplant, const float dt)
+{
+    // 负载力矩经减速器折算到转子
+    const float drive = hplant->torque_const * hplant->current -
+                        hplant->load_torque * hplant->inv_reduction_rate;
+    float velocity = hplant->velocity;
+
+    if (velocity == 0.0f && fabsf(drive) <= hplant->coulomb)
+    {
+        // 静摩擦
+        velocity = 0.0f;
+    }
+    else
+    {
+        const float dir      = velocity != 0.0f ? (velocity > 0 ? 1.0f : -1.0f)
+                                                : (drive > 0 ? 1.0f : -1.0f);
+        const float friction = hplant->coulomb * dir;
+        velocity             = (velocity + dt * (drive - friction) / hplant->inertia) /
+                   (1.0f + dt * hplant->viscous / hplant->inertia);
+        // 库仑摩擦只能让电机停下，不能让它反转
+        if (velocity * dir < 0 && fabsf(drive) <= hplant->coulomb)
+            velocity = 0.0f;
+    }
+    hplant->velocity = velocity;
+
+    // 半隐式欧拉，用新速度积分角度
+    hplant->angle += velocity * dt;
+    while (hplant->angle >= MOTOR_PLANT_2PI)
+    {
+        hplant->angle -= MOTOR_PLANT_2PI;
+        hplant->turns++;
+    }
+    while (hplant->angle < 0)
+    {
+        hplant->angle += MOTOR_PLANT_2PI;
+        hplant->turns--;
+    }
+}
+
+/**
+ * 初始化电机模型，初始状态为静止、零位
+ * @param hplant plant handle
+ * @param config 模型参数
+ * @return 参数无效（inertia 或 resistance 不为正）时返回 false，模型保持清零
+ */
+bool MotorPlant_Init(MotorPlant_t* hplant, const MotorPlant_Config_t* config)
+{
+    memset(hplant, 0, sizeof(MotorPlant_t));
+    // 电压驱动时除以电阻，积分时除以惯量
+    if (!(config->inertia > 0) || !(config->resistance > 0))
+        return false;
+
+    hplant->inertia            = config->inertia;
+    hplant->viscous            = config->viscous;
+    hplant->coulomb            = config->coulomb;
+    hplant->torque_const       = config->torque_const;
+    hplant->resistance         = config->resistance;
+    hplant->voltage_max        = config->voltage_max;
+    hplant->current_max        = config->current_max;
+    hplant->inv_reduction_rate = 1.0f / // 取倒数将除法转为乘法
+                                 (config->reduction_rate > 0 ? config->reduction_rate : 1.0f);
+    return true;
+}
+
+/**
+ * 电流驱动，假定电调电流环带宽远高于机械带宽，电流立即跟随指令
+ *
+ * 设置了 voltage_max 时，电流还受电源电压减去反电动势的限制，
+ * 因此电机有空载最高转速
+ * @param hplant plant handle
+ * @param current_cmd 电流指令 (unit: A)
+ * @param dt 步长 (unit: s)
+ */
+void MotorPlant_StepCurrent(MotorPlant_t* hplant, const float current_cmd, const float dt)
+{
+    float current = clamp_abs(current_cmd, hplant->current_max);
+    if (hplant->voltage_max > 0)
+    {
+        const float emf = hplant->torque_const * hplant->velocity;
+        const float hi  = (hplant->voltage_max - emf) / hplant->resistance;
+        const float lo  = (-hplant->voltage_max - emf) / hplant->resistance;
+        if (current > hi)
+            current = hi;
+        if (current < lo)
+            current = lo;
+    }
+    hplant->current = current;
+    plant_step(hplant, dt);
+}
+
+/**
+ * 电压驱动，忽略电感，电流由电压和反电动势决定
+ * @param hplant plant handle
+ * @param voltage 绕组电压 (unit: V)
+ * @param dt 步长 (unit: s)
+ */
+void MotorPlant_StepVoltage(MotorPlant_t* hplant, const float voltage, const float dt)
+{
+    const float current =
+            (voltage - hplant->torque_const * hplant->velocity) / hplant->resistance;
+    hplant->current = clamp_abs(current, hplant->current_max);
+    plant_step(hplant, dt);
+}
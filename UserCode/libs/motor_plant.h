@@ -0,0 +1,91 @@
+/**
+ * @file    motor_plant.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   电机机械模型，用于仿真
+ *
+ * 单惯量模型：转子惯量 + 粘滞摩擦 + 库仑摩擦（含静摩擦）+ 减速器 + 电流限幅，
+ * 支持电流驱动（电调内部有电流环，如 C620 / VESC / DM）和电压驱动（H 桥，如 TB6612）。
+ * 所有状态量都在转子侧，单位为国际单位制。
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef MOTOR_PLANT_H
+#define MOTOR_PLANT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MOTOR_PLANT_2PI (6.28318531f)
+
+typedef struct
+{
+    float inertia;        ///< 折算到转子的转动惯量 (unit: kg*m^2)
+    float viscous;        ///< 粘滞摩擦系数 (unit: N*m/(rad/s))
+    float coulomb;        ///< 库仑摩擦力矩 (unit: N*m)
+    float torque_const;   ///< 转矩常数，同时作为反电动势常数 (unit: N*m/A)
+    float resistance;     ///< 绕组电阻，必须为正 (unit: ohm)
+    float voltage_max;    ///< 电源电压，电流驱动时限制反电动势下的电流，0 表示不限制 (unit: V)
+    float current_max;    ///< 电流限幅 (unit: A)
+    float reduction_rate; ///< 减速比 (转子转速 / 输出轴转速)
+} MotorPlant_Config_t;
+
+typedef struct
+{
+    /* Arguments */
+    float inertia;            ///< (unit: kg*m^2)
+    float viscous;            ///< (unit: N*m/(rad/s))
+    float coulomb;            ///< (unit: N*m)
+    float torque_const;       ///< (unit: N*m/A)
+    float resistance;         ///< (unit: ohm)
+    float voltage_max;        ///< (unit: V)
+    float current_max;        ///< (unit: A)
+    float inv_reduction_rate; ///< 减速比的倒数
+
+    /* State */
+    float   current;     ///< 实际电流 (unit: A)
+    float   velocity;    ///< 转子角速度 (unit: rad/s)
+    float   angle;       ///< 转子单圈角度 [0, 2pi) (unit: rad)
+    int32_t turns;       ///< 转子圈数
+    float   load_torque; ///< 输出轴上的外部负载力矩 (unit: N*m)
+} MotorPlant_t;
+
+bool MotorPlant_Init(MotorPlant_t* hplant, const MotorPlant_Config_t* config);
+void MotorPlant_StepCurrent(MotorPlant_t* hplant, float current_cmd, float dt);
+void MotorPlant_StepVoltage(MotorPlant_t* hplant, float voltage, float dt);
+
+/**
+ * 输出轴角度
+ * @param hplant plant handle
+ * @return 多圈角度 (unit: rad)
+ */
+static inline float MotorPlant_GetOutputAngle(const MotorPlant_t* hplant)
+{
+    return ((float) hplant->turns * MOTOR_PLANT_2PI + hplant->angle) * hplant->inv_reduction_rate;
+}
+
+/**
+ * 输出轴角速度
+ * @param hplant plant handle
+ * @return (unit: rad/s)
+ */
+static inline float MotorPlant_GetOutputVelocity(const MotorPlant_t* hplant)
+{
+    return hplant->velocity * hplant->inv_reduction_rate;
+}
+
+#endif // MOTOR_PLANT_H
@@ -0,0 +1,144 @@
+/**
+ * @file    multiturn.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   integer multi-turn position accumulator for single-turn encoders
+ *
+ * 把单圈编码器的原始值累加为 64 位多圈位置，解包中只有整数运算。
+ * 浮点的 round_cnt * 360 + angle - zero 在数千圈后分辨率低于一个刻度，
+ * 累加值则始终保持编码器的全部分辨率，换算为角度由读者在读取时完成。
+ *
+ * 两帧之间转过的刻度数由单圈值之差加上整圈得到，整圈数的选取有两种方式：
+ *   MultiTurn_Update 取最短路径，要求两帧之间转过的角度小于半圈；
+ *   MultiTurn_UpdatePredicted 取最接近预测值的一个，预测值由转速和帧间隔得到，
+ *   只要求预测误差小于半圈，反馈频率可以低于转速，也能容忍丢帧
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef MULTITURN_H
+#define MULTITURN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+    int64_t  ticks;    ///< 多圈位置，以第一帧的单圈值为起点 (unit: 刻度)
+    int64_t  zero;     ///< 零点 (unit: 刻度)
+    uint32_t period;   ///< 每圈的刻度数
+    uint32_t last_raw; ///< 上一帧的单圈原始值
+    bool     started;  ///< 是否已收到第一帧
+} MultiTurn_t;
+
+/**
+ * 初始化
+ * @param mt 累加器
+ * @param period 每圈的刻度数，单圈原始值的范围为 [0, period)
+ */
+static inline void MultiTurn_Init(MultiTurn_t* mt, const uint32_t period)
+{
+    mt->ticks    = 0;
+    mt->zero     = 0;
+    mt->period   = period;
+    mt->last_raw = 0;
+    mt->started  = false;
+}
+
+/**
+ * 以预测的转动量累加一帧单圈原始值
+ *
+ * 在 raw - last_raw + k * period 中选取最接近 predicted 的一个作为两帧之间转过的刻度数
+ * @param mt 累加器
+ * @param raw 单圈原始值 [0, period)
+ * @param predicted 预测的两帧之间转过的刻度数，无法预测时为 0
+ * @return 单圈值回绕的次数：正转越过零点为正，反转越过零点为负
+ */
+static inline int32_t MultiTurn_UpdatePredicted(MultiTurn_t*   mt,
+                                                const uint32_t raw,
+                                                const int32_t  predicted)
+{
+    if (!mt->started)
+    {
+        mt->started  = true;
+        mt->ticks    = raw;
+        mt->last_raw = raw;
+        return 0;
+    }
+
+    const int32_t period = (int32_t) mt->period;
+    const int32_t diff   = (int32_t) raw - (int32_t) mt->last_raw;
+    // k = round((predicted - diff) / period)，C 的除法向 0 取整，负数时修正为向下取整
+    const int32_t offset = predicted - diff + period / 2;
+    int32_t       k      = offset / period;
+    if (offset % period < 0)
+        k--;
+    const int32_t delta = diff + k * period;
+
+    mt->ticks += delta;
+    mt->last_raw = raw;
+    // last_raw + delta 与 raw 相差整圈，即回绕的次数
+    return k;
+}
+
+/**
+ * 累加一帧单圈原始值，两帧之间转过的刻度数取最短路径
+ * @param mt 累加器
+ * @param raw 单圈原始值 [0, period)
+ * @return 单圈值回绕的方向：正转越过零点为 1，反转越过零点为 -1，否则为 0
+ */
+static inline int32_t MultiTurn_Update(MultiTurn_t* mt, const uint32_t raw)
+{
+    return MultiTurn_UpdatePredicted(mt, raw, 0);
+}
+
+/**
+ * 以当前位置为零点
+ * @param mt 累加器
+ */
+static inline void MultiTurn_Zero(MultiTurn_t* mt)
+{
+    mt->zero = mt->ticks;
+}
+
+/**
+ * 相对零点的多圈位置
+ * @param mt 累加器
+ * @return 多圈位置 (unit: 刻度)
+ */
+static inline int64_t MultiTurn_Get(const MultiTurn_t* mt)
+{
+    return mt->ticks - mt->zero;
+}
+
+/**
+ * 以刻度为基准的角度误差
+ *
+ * float 只有 24 位有效数字，位置超过 2^24 刻度后，目标和当前位置分别换算为角度再相减，
+ * 误差的分辨率会低于一个刻度；先以 64 位整数相减再换算，误差不超过 2^24 刻度时没有舍入
+ * @param target 目标位置 (unit: 刻度)
+ * @param ticks 当前位置 (unit: 刻度)
+ * @param angle_per_tick 一个刻度对应的角度
+ * @return target - ticks，以 angle_per_tick 的单位表示
+ */
+static inline float MultiTurn_AngleError(const int64_t target,
+                                         const int64_t ticks,
+                                         const float   angle_per_tick)
+{
+    return (float) (target - ticks) * angle_per_tick;
+}
+
+#endif // MULTITURN_H
@@ -0,0 +1,235 @@
+/**
+ * @file    pid_bank.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "pid_bank.h"
+#include <string.h>
+
+/*
+ * 内核选择：
+ * - x86：SSE，有 FMA 时编译器可能把标量路径的乘加融合，SIMD 内核无法保证与之逐位一致，不启用；
+ * - AArch64：NEON，AArch64 总有 FMA，GCC 默认 (-ffp-contract=fast) 会融合标量路径的乘加，
+ *   只有 pid_motor.c 和 pid_bank.c 都以 -ffp-contract=off 编译时才能定义 USE_PID_BANK_NEON 启用；
+ *   AArch32 的 NEON 把非规格化数清零，不使用；
+ * - Cortex-M4/M7：FPU 没有浮点 SIMD，使用每次 4 个控制器的展开循环
+ *   （CMSIS-DSP 的 ARM_MATH_LOOPUNROLL 写法），4 条独立的依赖链交错，
+ *   减少循环开销和 FPU 流水线停顿，每个控制器仍调用 MotorPID_Step；
+ * - 其他：标量循环。
+ */
+#if defined(__SSE__) && !defined(__FMA__)
+#    include <xmmintrin.h>
+#    define PID_BANK_USE_SSE
+#elif defined(USE_PID_BANK_NEON) && defined(__ARM_NEON) && defined(__aarch64__)
+#    include <arm_neon.h>
+#    define PID_BANK_USE_NEON
+#elif defined(__ARM_ARCH_7EM__) && defined(__ARM_FP)
+#    define PID_BANK_USE_UNROLL
+#endif
+
+/**
+ * 初始化 bank
+ * @param bank bank
+ */
+void MotorPID_BankInit(MotorPID_Bank_t* bank)
+{
+    memset(bank, 0, sizeof(MotorPID_Bank_t));
+}
+
+/**
+ * 添加一个控制器
+ * @param bank bank
+ * @param pid_config 参数
+ * @return 控制器下标，bank 已满时返回 MOTOR_PID_BANK_FULL
+ */
+uint32_t MotorPID_BankAdd(MotorPID_Bank_t* bank, const MotorPID_Config_t pid_config)
+{
+    if (bank->count >= MOTOR_PID_BANK_SIZE)
+        return MOTOR_PID_BANK_FULL;
+
+    const uint32_t i        = bank->count++;
+    bank->Kp[i]             = pid_config.Kp;
+    bank->Ki[i]             = pid_config.Ki;
+    bank->Kd[i]             = pid_config.Kd;
+    bank->abs_output_max[i] = pid_config.abs_output_max;
+    MotorPID_BankReset(bank, i);
+    bank->ref[i] = 0;
+    bank->fdb[i] = 0;
+    return i;
+}
+
+/**
+ * 清除一个控制器的运行数据，保留参数和目标值，与 MotorPID_Reset 相同
+ * @param bank bank
+ * @param index 控制器下标
+ */
+void MotorPID_BankReset(MotorPID_Bank_t* bank, const uint32_t index)
+{
+    bank->cur_error[index]   = 0;
+    bank->prev_error1[index] = 0;
+    bank->prev_error2[index] = 0;
+    bank->output[index]      = 0;
+}
+
+/**
+ * 计算一个控制器
+ */
+static inline void pid_bank_step(MotorPID_Bank_t* bank, const uint32_t i)
+{
+    const float e        = bank->ref[i] - bank->fdb[i];
+    bank->output[i]      = MotorPID_Step(bank->output[i],
+                                    bank->Kp[i],
+                                    bank->Ki[i],
+                                    bank->Kd[i],
+                                    bank->abs_output_max[i],
+                                    e,
+                                    bank->prev_error1[i],
+                                    bank->prev_error2[i]);
+    bank->cur_error[i]   = e;
+    bank->prev_error2[i] = bank->prev_error1[i];
+    bank->prev_error1[i] = e;
+}
+
+/**
+ * 标量内核，计算 [from, to) 中的控制器
+ */
+static inline void pid_batch_scalar(MotorPID_Bank_t* bank, const uint32_t from, const uint32_t to)
+{
+    for (uint32_t i = from; i < to; i++)
+        pid_bank_step(bank, i);
+}
+
+#ifdef PID_BANK_USE_SSE
+/**
+ * SSE 内核，每次计算 4 个控制器，运算顺序与 MotorPID_Step 相同
+ * @return 已计算的控制器数
+ */
+static uint32_t pid_batch_sse(MotorPID_Bank_t* bank)
+{
+    const __m128   two = _mm_set1_ps(2.0f);
+    const uint32_t n   = bank->count & ~3U;
+    for (uint32_t i = 0; i < n; i += 4)
+    {
+        const __m128 e   = _mm_sub_ps(_mm_loadu_ps(&bank->ref[i]), _mm_loadu_ps(&bank->fdb[i]));
+        const __m128 e1  = _mm_loadu_ps(&bank->prev_error1[i]);
+        const __m128 e2  = _mm_loadu_ps(&bank->prev_error2[i]);
+        const __m128 max = _mm_loadu_ps(&bank->abs_output_max[i]);
+
+        const __m128 p = _mm_mul_ps(_mm_loadu_ps(&bank->Kp[i]), _mm_sub_ps(e, e1));
+        const __m128 k = _mm_mul_ps(_mm_loadu_ps(&bank->Ki[i]), e);
+        const __m128 d = _mm_mul_ps(_mm_loadu_ps(&bank->Kd[i]),
+                                    _mm_add_ps(_mm_sub_ps(e, _mm_mul_ps(two, e1)), e2));
+        __m128 out = _mm_add_ps(_mm_loadu_ps(&bank->output[i]), _mm_add_ps(_mm_add_ps(p, k), d));
+        // 限幅值放在第一个参数，out 为 NaN 时与标量路径一样保留 NaN；
+        // 下限用符号位取反，与标量的 -abs_output_max 一致（0 - max 在 max 为 0 时得到 +0）
+        out = _mm_min_ps(max, out);
+        out = _mm_max_ps(_mm_xor_ps(max, _mm_set1_ps(-0.0f)), out);
+
+        _mm_storeu_ps(&bank->output[i], out);
+        _mm_storeu_ps(&bank->cur_error[i], e);
+        _mm_storeu_ps(&bank->prev_error2[i], e1);
+        _mm_storeu_ps(&bank->prev_error1[i], e);
+    }
+    return n;
+}
+#endif
+
+#ifdef PID_BANK_USE_NEON
+/**
+ * NEON 内核，每次计算 4 个控制器，运算顺序与 MotorPID_Step 相同，不使用乘加指令
+ *
+ * 限幅用比较和选择实现，与标量路径的两个 if 完全相同（包括 NaN 和 ±0）
+ * @return 已计算的控制器数
+ */
+static uint32_t pid_batch_neon(MotorPID_Bank_t* bank)
+{
+    const float32x4_t two = vdupq_n_f32(2.0f);
+    const uint32_t    n   = bank->count & ~3U;
+    for (uint32_t i = 0; i < n; i += 4)
+    {
+        const float32x4_t e   = vsubq_f32(vld1q_f32(&bank->ref[i]), vld1q_f32(&bank->fdb[i]));
+        const float32x4_t e1  = vld1q_f32(&bank->prev_error1[i]);
+        const float32x4_t e2  = vld1q_f32(&bank->prev_error2[i]);
+        const float32x4_t max = vld1q_f32(&bank->abs_output_max[i]);
+        const float32x4_t min = vnegq_f32(max);
+
+        const float32x4_t p = vmulq_f32(vld1q_f32(&bank->Kp[i]), vsubq_f32(e, e1));
+        const float32x4_t k = vmulq_f32(vld1q_f32(&bank->Ki[i]), e);
+        const float32x4_t d = vmulq_f32(vld1q_f32(&bank->Kd[i]),
+                                        vaddq_f32(vsubq_f32(e, vmulq_f32(two, e1)), e2));
+        float32x4_t out = vaddq_f32(vld1q_f32(&bank->output[i]), vaddq_f32(vaddq_f32(p, k), d));
+        out             = vbslq_f32(vcgtq_f32(out, max), max, out);
+        out             = vbslq_f32(vcltq_f32(out, min), min, out);
+
+        vst1q_f32(&bank->output[i], out);
+        vst1q_f32(&bank->cur_error[i], e);
+        vst1q_f32(&bank->prev_error2[i], e1);
+        vst1q_f32(&bank->prev_error1[i], e);
+    }
+    return n;
+}
+#endif
+
+#ifdef PID_BANK_USE_UNROLL
+/**
+ * Cortex-M 内核，每次展开计算 4 个控制器
+ * @return 已计算的控制器数
+ */
+static uint32_t pid_batch_unroll(MotorPID_Bank_t* bank)
+{
+    const uint32_t n = bank->count & ~3U;
+    for (uint32_t i = 0; i < n; i += 4)
+    {
+        pid_bank_step(bank, i);
+        pid_bank_step(bank, i + 1);
+        pid_bank_step(bank, i + 2);
+        pid_bank_step(bank, i + 3);
+    }
+    return n;
+}
+#endif
+
+/**
+ * 计算 bank 中的全部控制器
+ *
+ * 结果与对每个控制器调用 MotorPID_Calculate 逐位一致
+ * @param bank bank
+ */
+void MotorPID_CalculateBatch(MotorPID_Bank_t* bank)
+{
+#if defined(PID_BANK_USE_SSE)
+    const uint32_t done = pid_batch_sse(bank);
+#elif defined(PID_BANK_USE_NEON)
+    const uint32_t done = pid_batch_neon(bank);
+#elif defined(PID_BANK_USE_UNROLL)
+    const uint32_t done = pid_batch_unroll(bank);
+#else
+    const uint32_t done = 0;
+#endif
+    pid_batch_scalar(bank, done, bank->count);
+}
+
+/**
+ * 只使用标量内核计算全部控制器，作为 SIMD 内核的参考
+ * @param bank bank
+ */
+void MotorPID_CalculateBatchScalar(MotorPID_Bank_t* bank)
+{
+    pid_batch_scalar(bank, 0, bank->count);
+}
@@ -0,0 +1,73 @@
+/**
+ * @file    pid_bank.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   struct-of-arrays bank of incremental PID controllers, calculated in one batch
+ *
+ * 参数和误差历史按字段分别存放在数组中，一次 MotorPID_CalculateBatch 计算全部控制器，
+ * 没有逐个调用的开销，连续访问也便于编译器流水和向量化。
+ * 使用方式：每周期写入 ref[i] 和 fdb[i]，调用 MotorPID_CalculateBatch，读取 output[i]。
+ *
+ * 计算结果与对每个控制器调用 MotorPID_Calculate 逐位一致：
+ *   Cortex-M4 的 FPU 没有浮点 SIMD，目标上使用展开 4 次的循环，表达式与 MotorPID_Calculate 相同；
+ *   主机在有 SSE 且没有 FMA 时使用 SSE 内核，AArch64 在定义 USE_PID_BANK_NEON 时使用 NEON 内核，
+ *   每 4 个控制器一组，运算顺序与标量相同，内核的选择条件见 pid_bank.c。
+ *   host/bench/bench_pid_bank.c 在主机上检查逐位一致并比较耗时
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef PID_BANK_H
+#define PID_BANK_H
+
+#include <stdint.h>
+#include "pid_motor.h"
+
+#ifndef MOTOR_PID_BANK_SIZE
+/**
+ * 每个 bank 最多容纳的控制器数，应为 4 的倍数
+ */
+#    define MOTOR_PID_BANK_SIZE (16U)
+#endif
+
+#define MOTOR_PID_BANK_FULL (0xFFFFFFFFU) ///< MotorPID_BankAdd 在 bank 已满时的返回值
+
+typedef struct
+{
+    /* Arguments */
+    float Kp[MOTOR_PID_BANK_SIZE];             //< 比例系数
+    float Ki[MOTOR_PID_BANK_SIZE];             //< 积分系数
+    float Kd[MOTOR_PID_BANK_SIZE];             //< 微分系数
+    float abs_output_max[MOTOR_PID_BANK_SIZE]; //< 输出限幅
+
+    /* Runtime Data */
+    float ref[MOTOR_PID_BANK_SIZE];         //< 目标值
+    float fdb[MOTOR_PID_BANK_SIZE];         //< 反馈量
+    float cur_error[MOTOR_PID_BANK_SIZE];   //< 当前误差
+    float prev_error1[MOTOR_PID_BANK_SIZE]; //< 上一次误差
+    float prev_error2[MOTOR_PID_BANK_SIZE]; //< 上上次误差
+    float output[MOTOR_PID_BANK_SIZE];      //< 输出量
+
+    uint32_t count; ///< 控制器数
+} MotorPID_Bank_t;
+
+void     MotorPID_BankInit(MotorPID_Bank_t* bank);
+uint32_t MotorPID_BankAdd(MotorPID_Bank_t* bank, MotorPID_Config_t pid_config);
+void     MotorPID_BankReset(MotorPID_Bank_t* bank, uint32_t index);
+void     MotorPID_CalculateBatch(MotorPID_Bank_t* bank);
+void     MotorPID_CalculateBatchScalar(MotorPID_Bank_t* bank);
+
+#endif // PID_BANK_H
@@ -0,0 +1,130 @@
+/**
+ * @file    pid_fixed.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "pid_fixed.h"
+#include <string.h>
+
+#define PID_FIXED_SHIFT_MAX (48U)
+
+static inline int32_t sat_i32(const int64_t x)
+{
+    if (x > INT32_MAX)
+        return INT32_MAX;
+    if (x < INT32_MIN)
+        return INT32_MIN;
+    return (int32_t) x;
+}
+
+/**
+ * 右移 shift 位并四舍五入（0.5 远离 0 舍入），正负对称。
+ * 直接右移向负无穷舍入，每一步都向负方向偏差，增量式 PID 会把偏差累积到输出中
+ */
+static inline int64_t round_shift(const int64_t x, const uint8_t shift)
+{
+    if (shift == 0)
+        return x;
+    const int64_t half = (int64_t) 1 << (shift - 1);
+    return x >= 0 ? (x + half) >> shift : -((-x + half) >> shift);
+}
+
+static inline float abs_f(const float x)
+{
+    return x >= 0 ? x : -x;
+}
+
+/**
+ * 初始化
+ *
+ * 浮点 PID 的输入为 fdb * input_lsb，输出为 output * output_lsb，
+ * 据此把浮点参数换算为定点参数，两者的控制律相同
+ * @param hpid pid handle
+ * @param pid_config 浮点参数，与 MotorPID_Init 相同
+ * @param input_lsb 输入的一个原始单位对应的浮点量
+ * @param output_lsb 输出的一个原始单位对应的浮点量（不含小数位）
+ */
+void MotorPIDFixed_Init(MotorPIDFixed_t*        hpid,
+                        const MotorPID_Config_t pid_config,
+                        const float             input_lsb,
+                        const float             output_lsb)
+{
+    memset(hpid, 0, sizeof(MotorPIDFixed_t));
+
+    const float scale = input_lsb / output_lsb * (float) (1 << MOTOR_PID_FIXED_OUT_FRAC);
+    const float Kp    = pid_config.Kp * scale;
+    const float Ki    = pid_config.Ki * scale;
+    const float Kd    = pid_config.Kd * scale;
+
+    // 选取最大的小数位数，使最大的参数不超过 MOTOR_PID_FIXED_GAIN_MAX
+    float k_max = abs_f(Kp);
+    if (abs_f(Ki) > k_max)
+        k_max = abs_f(Ki);
+    if (abs_f(Kd) > k_max)
+        k_max = abs_f(Kd);
+    uint8_t shift = 0;
+    float   mul   = 1.0f;
+    while (shift < PID_FIXED_SHIFT_MAX && k_max * mul * 2.0f < (float) MOTOR_PID_FIXED_GAIN_MAX)
+    {
+        shift++;
+        mul *= 2.0f;
+    }
+
+    hpid->shift          = shift;
+    hpid->Kp             = MotorPIDFixed_FloatToI32(Kp * mul);
+    hpid->Ki             = MotorPIDFixed_FloatToI32(Ki * mul);
+    hpid->Kd             = MotorPIDFixed_FloatToI32(Kd * mul);
+    hpid->abs_output_max = MotorPIDFixed_FloatToI32(abs_f(pid_config.abs_output_max / output_lsb) *
+                                                    (float) (1 << MOTOR_PID_FIXED_OUT_FRAC));
+}
+
+/**
+ * 计算一步，不使用浮点运算
+ * @param hpid pid handle
+ */
+void MotorPIDFixed_Calculate(MotorPIDFixed_t* hpid)
+{
+    const int64_t e  = sat_i32((int64_t) hpid->ref - hpid->fdb);
+    const int64_t e1 = hpid->prev_error1;
+    const int64_t e2 = hpid->prev_error2;
+
+    const int64_t sum = hpid->Kp * (e - e1) + hpid->Ki * e + hpid->Kd * (e - 2 * e1 + e2);
+    int32_t       out = sat_i32(hpid->output + round_shift(sum, hpid->shift));
+    if (out > hpid->abs_output_max)
+        out = hpid->abs_output_max;
+    if (out < -hpid->abs_output_max)
+        out = -hpid->abs_output_max;
+
+    hpid->cur_error   = (int32_t) e;
+    hpid->output      = out;
+    hpid->prev_error2 = hpid->prev_error1;
+    hpid->prev_error1 = hpid->cur_error;
+}
+
+/**
+ * 清除运行数据，保留参数和目标值，与 MotorPID_Reset 相同
+ * @param hpid pid handle
+ */
+void MotorPIDFixed_Reset(MotorPIDFixed_t* hpid)
+{
+    hpid->cur_error   = 0;
+    hpid->prev_error1 = 0;
+    hpid->prev_error2 = 0;
+    hpid->output      = 0;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file    pid_fixed.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   fixed-point incremental PID for FPU-free control loops
+ *
+ * 与 MotorPID_Calculate 相同的增量式 PID，全程使用整数运算，控制中断不使用 FPU，
+ * 也就没有 FPU 上下文的保存和惰性压栈。
+ *
+ * 数值格式：
+ *   输入 (ref / fdb) 为驱动的原始整数单位，例如编码器刻度、转速原始值；
+ *   输出带 MOTOR_PID_FIXED_OUT_FRAC 位小数，外层的输出直接作为内层的 ref；
+ *   参数在初始化时由浮点参数和单位换算得到，小数位数 shift 按参数大小逐个控制器选取，
+ *   因此与浮点 PID 使用同一组参数，结果只差量化误差。
+ * 中间量用 64 位计算，输出饱和到 int32 后再限幅，不会回绕
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef PID_FIXED_H
+#define PID_FIXED_H
+
+#include <stdint.h>
+#include "pid_motor.h"
+
+#define MOTOR_PID_FIXED_OUT_FRAC (8) ///< 输出的小数位数
+/**
+ * 参数绝对值的上限，误差饱和到 int32 后三项乘积之和不会溢出 int64
+ */
+#define MOTOR_PID_FIXED_GAIN_MAX (1 << 28)
+
+typedef struct
+{
+    /* Arguments */
+    int32_t Kp;             //< 比例系数 (Q.shift)
+    int32_t Ki;             //< 积分系数 (Q.shift)
+    int32_t Kd;             //< 微分系数 (Q.shift)
+    uint8_t shift;          //< 参数的小数位数
+    int32_t abs_output_max; //< 输出限幅 (Q.8)
+
+    /* Runtime Data */
+    int32_t ref;         //< 目标值
+    int32_t fdb;         //< 反馈量
+    int32_t cur_error;   //< 当前误差
+    int32_t prev_error1; //< 上一次误差
+    int32_t prev_error2; //< 上上次误差
+    int32_t output;      //< 输出量 (Q.8)
+} MotorPIDFixed_t;
+
+void MotorPIDFixed_Init(MotorPIDFixed_t*  hpid,
+                        MotorPID_Config_t pid_config,
+                        float             input_lsb,
+                        float             output_lsb);
+void MotorPIDFixed_Calculate(MotorPIDFixed_t* hpid);
+void MotorPIDFixed_Reset(MotorPIDFixed_t* hpid);
+
+/**
+ * 浮点数四舍五入并饱和到 int32，NaN 转为 0。用于初始化和设置目标值，不在控制计算中使用
+ */
+static inline int32_t MotorPIDFixed_FloatToI32(const float x)
+{
+    if (x != x)
+        return 0;
+    if (x >= 2147483520.0f)
+        return INT32_MAX;
+    if (x <= -2147483520.0f)
+        return INT32_MIN;
+    return (int32_t) (x + (x >= 0 ? 0.5f : -0.5f));
+}
+
+/**
+ * 浮点数四舍五入并饱和到 int64，NaN 转为 0
+ */
+static inline int64_t MotorPIDFixed_FloatToI64(const float x)
+{
+    if (x != x)
+        return 0;
+    if (x >= 9223372036854775808.0f)
+        return INT64_MAX;
+    if (x <= -9223372036854775808.0f)
+        return INT64_MIN;
+    return (int64_t) (x + (x >= 0 ? 0.5f : -0.5f));
+}
+
+/**
+ * 取输出的整数部分，与浮点输出转为整数时一样向 0 舍入
+ * @param hpid pid handle
+ * @return 输出，单位为输出的原始单位
+ */
+static inline int32_t MotorPIDFixed_GetOutput(const MotorPIDFixed_t* hpid)
+{
+    return hpid->output >= 0 ? hpid->output >> MOTOR_PID_FIXED_OUT_FRAC
+                             : -(-hpid->output >> MOTOR_PID_FIXED_OUT_FRAC);
+}
+
+#endif // PID_FIXED_H
@@ -27,19 +27,33 @@
 void MotorPID_Calculate(MotorPID_t* hpid)
 {
     hpid->cur_error = hpid->ref - hpid->fdb;
-    hpid->output +=
-        hpid->Kp * (hpid->cur_error - hpid->prev_error1) +
-        hpid->Ki * hpid->cur_error +
-        hpid->Kd * (hpid->cur_error - 2 * hpid->prev_error1 + hpid->prev_error2);
-    if (hpid->output > hpid->abs_output_max)
-        hpid->output = hpid->abs_output_max;
-    if (hpid->output < -hpid->abs_output_max)
-        hpid->output = -hpid->abs_output_max;
+    hpid->output    = MotorPID_Step(hpid->output,
+                                 hpid->Kp,
+                                 hpid->Ki,
+                                 hpid->Kd,
+                                 hpid->abs_output_max,
+                                 hpid->cur_error,
+                                 hpid->prev_error1,
+                                 hpid->prev_error2);
 
     hpid->prev_error2 = hpid->prev_error1;
     hpid->prev_error1 = hpid->cur_error;
 }
 
+/**
+ * 清除运行数据，保留参数和目标值
+ *
+ * 增量式 PID 的积分量就是输出本身，清零后从 0 重新开始累积
+ * @param hpid pid handle
+ */
+void MotorPID_Reset(MotorPID_t* hpid)
+{
+    hpid->cur_error   = 0;
+    hpid->prev_error1 = 0;
+    hpid->prev_error2 = 0;
+    hpid->output      = 0;
+}
+
 void MotorPID_Init(MotorPID_t* hpid, const MotorPID_Config_t pid_config)
 {
     /* reset pid */
@@ -58,7 +58,34 @@ typedef struct
     float abs_output_max; //< 输出限幅
 } MotorPID_Config_t;
 
+/**
+ * 增量式 PID 的一步：返回新的输出
+ *
+ * MotorPID_Calculate 和 MotorPID_CalculateBatch 的标量路径共用本函数，保证两者结果逐位一致
+ * @param output 上一次的输出
+ * @param e 当前误差
+ * @param e1 上一次误差
+ * @param e2 上上次误差
+ */
+static inline float MotorPID_Step(const float output,
+                                  const float Kp,
+                                  const float Ki,
+                                  const float Kd,
+                                  const float abs_output_max,
+                                  const float e,
+                                  const float e1,
+                                  const float e2)
+{
+    float out = output + (Kp * (e - e1) + Ki * e + Kd * (e - 2 * e1 + e2));
+    if (out > abs_output_max)
+        out = abs_output_max;
+    if (out < -abs_output_max)
+        out = -abs_output_max;
+    return out;
+}
+
 void MotorPID_Init(MotorPID_t* hpid, MotorPID_Config_t pid_config);
 void MotorPID_Calculate(MotorPID_t* hpid);
+void MotorPID_Reset(MotorPID_t* hpid);
 
 #endif // PID_MOTOR_H
@@ -0,0 +1,103 @@
+/**
+ * @file    seqlock.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   sequence lock for one writer and lock-free readers
+ *
+ * 写者在修改数据前后各把序号加一，修改期间序号为奇数；
+ * 读者记下序号后复制数据，复制完序号没有变化且为偶数才说明读到的是一致的副本，否则重读。
+ * 写者从不等待读者，读者不关中断，适合中断写、任务读的反馈数据。
+ *
+ * 只允许一个写者：同一把锁的写操作不能互相打断，任务中的写者需要关中断才能与中断写者共用一把锁；
+ * 单核上中断写者在读者看来是原子的，读者最多被打断后重读一次
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef SEQLOCK_READ_RETRIES
+/**
+ * 读者的最大重读次数，超过后放弃（写者在读者之下被打断时才会出现）
+ */
+#    define SEQLOCK_READ_RETRIES (16U)
+#endif
+
+typedef struct
+{
+    atomic_uint seq; ///< 序号，奇数表示正在写
+} Seqlock_t;
+
+/**
+ * 初始化
+ * @param lock 锁
+ */
+static inline void Seqlock_Init(Seqlock_t* lock)
+{
+    atomic_init(&lock->seq, 0);
+}
+
+/**
+ * 开始写
+ * @param lock 锁
+ */
+static inline void Seqlock_WriteBegin(Seqlock_t* lock)
+{
+    const unsigned seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_relaxed);
+    // 数据的写入不能提前到序号变为奇数之前
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * 结束写
+ * @param lock 锁
+ */
+static inline void Seqlock_WriteEnd(Seqlock_t* lock)
+{
+    const unsigned seq = atomic_load_explicit(&lock->seq, memory_order_relaxed);
+    atomic_store_explicit(&lock->seq, seq + 1, memory_order_release);
+}
+
+/**
+ * 开始读
+ * @param lock 锁
+ * @return 序号，交给 Seqlock_ReadRetry
+ */
+static inline unsigned Seqlock_ReadBegin(const Seqlock_t* lock)
+{
+    return atomic_load_explicit(&lock->seq, memory_order_acquire);
+}
+
+/**
+ * 结束读，判断读到的数据是否需要丢弃
+ * @param lock 锁
+ * @param seq Seqlock_ReadBegin 的返回值
+ * @return 读取期间有写入（或开始时正在写）时返回 true，应当重读
+ */
+static inline bool Seqlock_ReadRetry(const Seqlock_t* lock, const unsigned seq)
+{
+    // 数据的读取不能推迟到再次读取序号之后
+    atomic_thread_fence(memory_order_acquire);
+    return (seq & 1U) || atomic_load_explicit(&lock->seq, memory_order_relaxed) != seq;
+}
+
+#endif // SEQLOCK_H
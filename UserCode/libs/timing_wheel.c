@@ -0,0 +1,129 @@
+/**
+ * @file    timing_wheel.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "timing_wheel.h"
+
+/**
+ * 初始化时间轮
+ * @param wheel 时间轮
+ * @param now 当前 tick
+ */
+void TimingWheel_Init(TimingWheel_t* wheel, const uint32_t now)
+{
+    for (uint32_t i = 0; i < TIMING_WHEEL_SLOTS; i++)
+    {
+        wheel->slots[i].prev = &wheel->slots[i];
+        wheel->slots[i].next = &wheel->slots[i];
+    }
+    wheel->now     = now;
+    wheel->pending = 0;
+}
+
+/**
+ * 初始化定时器，初始化后不在任何时间轮中
+ * @param timer 定时器
+ * @param callback 到期回调
+ * @param arg 回调参数
+ */
+void TimingWheel_TimerInit(TimingWheel_Timer_t*         timer,
+                           const TimingWheel_Callback_t callback,
+                           void*                        arg)
+{
+    timer->prev     = NULL;
+    timer->next     = NULL;
+    timer->expire   = 0;
+    timer->callback = callback;
+    timer->arg      = arg;
+}
+
+/**
+ * 添加定时器，已在等待中的定时器会先被移除
+ * @param wheel 时间轮
+ * @param timer 定时器
+ * @param delay 距离 wheel->now 的 tick 数，0 按 1 处理（下一次推进时到期）
+ */
+void TimingWheel_Add(TimingWheel_t* wheel, TimingWheel_Timer_t* timer, const uint32_t delay)
+{
+    if (TimingWheel_IsPending(timer))
+        TimingWheel_Remove(wheel, timer);
+
+    timer->expire             = wheel->now + (delay ? delay : 1);
+    TimingWheel_Timer_t* head = &wheel->slots[timer->expire & (TIMING_WHEEL_SLOTS - 1)];
+
+    timer->prev      = head->prev;
+    timer->next      = head;
+    head->prev->next = timer;
+    head->prev       = timer;
+    wheel->pending++;
+}
+
+/**
+ * 移除定时器，不在等待中的定时器不做处理
+ * @param wheel 时间轮
+ * @param timer 定时器
+ */
+void TimingWheel_Remove(TimingWheel_t* wheel, TimingWheel_Timer_t* timer)
+{
+    if (!TimingWheel_IsPending(timer))
+        return;
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->prev       = NULL;
+    timer->next       = NULL;
+    wheel->pending--;
+}
+
+/**
+ * 推进到 now，依次处理经过的每个槽中已到期的定时器
+ *
+ * 每个 tick 调用一次时只处理一个槽
+ * @attention 回调中只能重新添加或移除到期的定时器本身，不能移除其他定时器
+ * @param wheel 时间轮
+ * @param now 当前 tick
+ */
+void TimingWheel_Advance(TimingWheel_t* wheel, const uint32_t now)
+{
+    // 长时间未推进时最多转一圈，此后每个槽都已处理过
+    uint32_t steps = now - wheel->now;
+    if (steps > TIMING_WHEEL_SLOTS)
+    {
+        wheel->now += steps - TIMING_WHEEL_SLOTS;
+        steps = TIMING_WHEEL_SLOTS;
+    }
+
+    while (steps--)
+    {
+        wheel->now++;
+        TimingWheel_Timer_t* head  = &wheel->slots[wheel->now & (TIMING_WHEEL_SLOTS - 1)];
+        TimingWheel_Timer_t* timer = head->next;
+        while (timer != head)
+        {
+            // 回调中可能重新添加到本槽，先取下一个
+            TimingWheel_Timer_t* next = timer->next;
+            if ((int32_t) (timer->expire - wheel->now) <= 0)
+            {
+                TimingWheel_Remove(wheel, timer);
+                timer->callback(timer, wheel->now);
+            }
+            timer = next;
+        }
+    }
+}
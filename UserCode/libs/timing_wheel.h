@@ -0,0 +1,87 @@
+/**
+ * @file    timing_wheel.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   hashed timing wheel with O(1) add, remove and per-tick advance
+ *
+ * 定时器按到期时间散列到 TIMING_WHEEL_SLOTS 个槽中，每个槽是一个双向链表。
+ * 添加和删除只修改链表，推进一个 tick 只处理当前槽，
+ * 因此开销与定时器总数无关，只与本 tick 到期的定时器数有关。
+ * 超过一圈的定时器在槽中保留到真正到期。
+ * 本库不依赖硬件，tick 的单位由使用者决定。
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TIMING_WHEEL_SLOTS
+/**
+ * 槽数，必须为 2 的幂，应不小于常用的超时 tick 数
+ */
+#    define TIMING_WHEEL_SLOTS (128U)
+#endif
+
+_Static_assert((TIMING_WHEEL_SLOTS & (TIMING_WHEEL_SLOTS - 1)) == 0,
+               "TIMING_WHEEL_SLOTS must be a power of two");
+
+typedef struct TimingWheel_Timer TimingWheel_Timer_t;
+
+/**
+ * 到期回调，可以在回调中重新添加本定时器
+ * @param timer 到期的定时器
+ * @param now 到期时的 tick
+ */
+typedef void (*TimingWheel_Callback_t)(TimingWheel_Timer_t* timer, uint32_t now);
+
+struct TimingWheel_Timer
+{
+    TimingWheel_Timer_t*   prev;
+    TimingWheel_Timer_t*   next;
+    uint32_t               expire;   ///< 到期 tick
+    TimingWheel_Callback_t callback; ///< 到期回调
+    void*                  arg;      ///< 回调参数
+};
+
+typedef struct
+{
+    TimingWheel_Timer_t slots[TIMING_WHEEL_SLOTS]; ///< 各槽的链表头（哨兵）
+    uint32_t            now;                       ///< 已经处理到的 tick
+    uint32_t            pending;                   ///< 等待中的定时器数
+} TimingWheel_t;
+
+void TimingWheel_Init(TimingWheel_t* wheel, uint32_t now);
+void TimingWheel_TimerInit(TimingWheel_Timer_t* timer, TimingWheel_Callback_t callback, void* arg);
+void TimingWheel_Add(TimingWheel_t* wheel, TimingWheel_Timer_t* timer, uint32_t delay);
+void TimingWheel_Remove(TimingWheel_t* wheel, TimingWheel_Timer_t* timer);
+void TimingWheel_Advance(TimingWheel_t* wheel, uint32_t now);
+
+/**
+ * 定时器是否在等待中
+ * @param timer 定时器
+ * @return 是否已添加且未到期
+ */
+static inline bool TimingWheel_IsPending(const TimingWheel_Timer_t* timer)
+{
+    return timer->next != NULL;
+}
+
+#endif // TIMING_WHEEL_H
@@ -0,0 +1,207 @@
+/**
+ * @file    velocity_observer.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "velocity_observer.h"
+#include <string.h>
+
+#define RPM_TO_DEG_PER_S (6.0f)        ///< 1 rpm = 360 deg / 60 s
+#define DEG_PER_S_TO_RPM (1.0f / 6.0f) ///< 运行时用乘法代替除法
+
+static inline double abs_d(const double x)
+{
+    return x >= 0 ? x : -x;
+}
+
+/**
+ * 迭代 Riccati 方程求稳态卡尔曼增益，只在初始化时使用
+ *
+ * 使用 double 计算：dt^5 量级的过程噪声在 float 下会被舍入掉
+ * @param K 输出的增益，不使用转速测量时第二列为 0
+ * @param dt 更新周期 (unit: s)
+ * @param q 扰动加速度随机游走的功率谱密度 (unit: deg^2/s^5)
+ * @param r_p 位置测量噪声方差 (unit: deg^2)
+ * @param r_v 转速测量噪声方差 (unit: (deg/s)^2)，0 表示不使用转速测量
+ */
+static void steady_state_gain(float        K[3][2],
+                              const double dt,
+                              const double q,
+                              const double r_p,
+                              const double r_v)
+{
+    const double F[3][3] = {{1, dt, dt * dt / 2}, {0, 1, dt}, {0, 0, 1}};
+    const double dt2 = dt * dt, dt3 = dt2 * dt, dt4 = dt3 * dt, dt5 = dt4 * dt;
+    const double Q[3][3] = {{q * dt5 / 20, q * dt4 / 8, q * dt3 / 6},
+                            {q * dt4 / 8, q * dt3 / 3, q * dt2 / 2},
+                            {q * dt3 / 6, q * dt2 / 2, q * dt}};
+
+    double P[3][3]  = {{0}};
+    double Kd[3][2] = {{0}};
+    for (uint32_t iter = 0; iter < VELOCITY_OBSERVER_RICCATI_MAX; iter++)
+    {
+        // 预测：Pp = F P F' + Q
+        double FP[3][3], Pp[3][3];
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                FP[i][j] = F[i][0] * P[0][j] + F[i][1] * P[1][j] + F[i][2] * P[2][j];
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                Pp[i][j] = FP[i][0] * F[j][0] + FP[i][1] * F[j][1] + FP[i][2] * F[j][2] + Q[i][j];
+
+        // 增益：K = Pp H' S^-1，H 取 Pp 的前一或两列
+        double K_new[3][2];
+        if (r_v > 0)
+        {
+            const double s00 = Pp[0][0] + r_p, s01 = Pp[0][1], s11 = Pp[1][1] + r_v;
+            const double det = s00 * s11 - s01 * s01;
+            for (int i = 0; i < 3; i++)
+            {
+                K_new[i][0] = (Pp[i][0] * s11 - Pp[i][1] * s01) / det;
+                K_new[i][1] = (Pp[i][1] * s00 - Pp[i][0] * s01) / det;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                K_new[i][0] = Pp[i][0] / (Pp[0][0] + r_p);
+                K_new[i][1] = 0;
+            }
+        }
+
+        // 更新：P = Pp - K H Pp
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                P[i][j] = Pp[i][j] - K_new[i][0] * Pp[0][j] - K_new[i][1] * Pp[1][j];
+
+        double change = 0, norm = 0;
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 2; j++)
+            {
+                if (abs_d(K_new[i][j] - Kd[i][j]) > change)
+                    change = abs_d(K_new[i][j] - Kd[i][j]);
+                if (abs_d(K_new[i][j]) > norm)
+                    norm = abs_d(K_new[i][j]);
+                Kd[i][j] = K_new[i][j];
+            }
+        if (iter > 0 && change <= norm * 1e-9)
+            break;
+    }
+
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 2; j++)
+            K[i][j] = (float) Kd[i][j];
+}
+
+/**
+ * 初始化，求出稳态卡尔曼增益
+ * @note 迭代 Riccati 方程使用 double，在 Cortex-M4 上耗时数毫秒，不要在中断中调用
+ * @param obs 观测器
+ * @param config 噪声参数
+ * @param dt 更新周期 (unit: s)，即反馈周期
+ * @param angle_per_tick 一个位置刻度对应的角度 (unit: deg)
+ */
+void VelocityObserver_Init(VelocityObserver_t*              obs,
+                           const VelocityObserver_Config_t* config,
+                           const float                      dt,
+                           const float                      angle_per_tick)
+{
+    memset(obs, 0, sizeof(VelocityObserver_t));
+
+    obs->dt             = dt;
+    obs->angle_per_tick = angle_per_tick;
+    obs->command_gain   = config->command_gain;
+    obs->use_velocity   = config->velocity_noise > 0;
+
+    // 没有给出位置噪声时取量化噪声，均匀分布的标准差为 刻度 / sqrt(12)
+    const double sigma_p = config->position_noise > 0 ? config->position_noise
+                                                      : angle_per_tick * 0.288675f;
+    const double sigma_v = config->velocity_noise * RPM_TO_DEG_PER_S;
+    steady_state_gain(obs->K,
+                      dt,
+                      (double) config->accel_noise * config->accel_noise,
+                      sigma_p * sigma_p,
+                      sigma_v * sigma_v);
+}
+
+/**
+ * 更新一步：以上一周期的指令预测，再以本周期的测量修正
+ * @note 每次调用耗时固定，应当在每一帧反馈中调用一次
+ * @param obs 观测器
+ * @param delta_ticks 上一次更新以来测量位置的增量 (unit: 刻度)
+ * @param velocity 测量转速 (unit: rpm)，不使用转速测量时忽略
+ * @param command 上一周期施加的指令，单位与 command_gain 对应
+ */
+void VelocityObserver_Update(VelocityObserver_t* obs,
+                             const int32_t       delta_ticks,
+                             const float         velocity,
+                             const float         command)
+{
+    VelocityObserver_UpdateSteps(obs, 1, delta_ticks, velocity, command);
+}
+
+/**
+ * 经过 steps 个周期后更新：以恒定加速度一次预测 steps * dt，再以本帧的测量修正
+ *
+ * 丢帧时位置增量包含了 steps 个周期的运动，按一个周期预测会把多出的位移当作误差，
+ * 速度估计随丢帧跳变。修正仍使用一步的稳态增益：多步预测后的最优增益更大，
+ * 使用一步的增益只是收敛稍慢，不影响稳定
+ * @param obs 观测器
+ * @param steps 上一次更新以来经过的周期数，由帧间隔得到，0 按 1 处理
+ * @param delta_ticks 上一次更新以来测量位置的增量 (unit: 刻度)
+ * @param velocity 测量转速 (unit: rpm)，不使用转速测量时忽略
+ * @param command 上一周期施加的指令，单位与 command_gain 对应
+ */
+void VelocityObserver_UpdateSteps(VelocityObserver_t* obs,
+                                  const uint32_t      steps,
+                                  const int32_t       delta_ticks,
+                                  const float         velocity,
+                                  const float         command)
+{
+    const float dt  = steps > 1 ? obs->dt * (float) steps : obs->dt;
+    const float acc = obs->command_gain * command + obs->disturbance;
+
+    // 预测，同时减去测量位置的增量，position_error 始终是很小的相对量
+    obs->position_error += (obs->omega + 0.5f * acc * dt) * dt -
+                           (float) delta_ticks * obs->angle_per_tick;
+    obs->omega += acc * dt;
+
+    const float r_p = -obs->position_error;
+    const float r_v = obs->use_velocity ? velocity * RPM_TO_DEG_PER_S - obs->omega : 0.0f;
+    obs->position_error += obs->K[0][0] * r_p + obs->K[0][1] * r_v;
+    obs->omega += obs->K[1][0] * r_p + obs->K[1][1] * r_v;
+    obs->disturbance += obs->K[2][0] * r_p + obs->K[2][1] * r_v;
+
+    obs->velocity     = obs->omega * DEG_PER_S_TO_RPM;
+    obs->acceleration = (obs->command_gain * command + obs->disturbance) * DEG_PER_S_TO_RPM;
+}
+
+/**
+ * 清除运行数据，保留增益
+ * @param obs 观测器
+ */
+void VelocityObserver_Reset(VelocityObserver_t* obs)
+{
+    obs->position_error = 0;
+    obs->omega          = 0;
+    obs->disturbance    = 0;
+    obs->velocity       = 0;
+    obs->acceleration   = 0;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file    velocity_observer.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   steady-state Kalman velocity observer fused from position, speed and command
+ *
+ * 由多圈位置、反馈转速和控制指令估计转速和加速度。
+ * 编码器位置差分的分辨率在 1kHz 下只有数十 deg/s，反馈转速又有量化和噪声，
+ * 观测器按两者的噪声大小融合，再以指令作为加速度的前馈，同时得到差分无法给出的加速度。
+ * 融合的效果取决于噪声参数是否符合实际：反馈转速已经很干净时应减小 velocity_noise。
+ *
+ * 模型为常加速度模型，状态为 位置 / 转速 / 扰动加速度：
+ *   加速度 = command_gain * 指令 + 扰动加速度，扰动加速度为随机游走；
+ *   测量为位置，和可选的转速。
+ * 卡尔曼增益在初始化时迭代 Riccati 方程至稳态后固定，运行时每次更新只有
+ * 固定的几十次浮点乘加，没有矩阵求逆，耗时有界。
+ *
+ * 位置以相对量参与计算：内部只保存 估计位置 - 测量位置，
+ * 输入为两次更新之间的位置增量（整数刻度），多圈位置再大也不损失精度，清零位置也不影响。
+ * 更新周期为初始化时的 dt，即在每一帧反馈中更新一次；丢帧时以 VelocityObserver_UpdateSteps
+ * 按实际经过的周期数预测，再以稳态增益修正。反馈中断过久时位置增量已不可信，应当调用
+ * VelocityObserver_Reset 并跳过这一帧
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef VELOCITY_OBSERVER_H
+#define VELOCITY_OBSERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef VELOCITY_OBSERVER_RICCATI_MAX
+/**
+ * 初始化时迭代 Riccati 方程的最大次数
+ */
+#    define VELOCITY_OBSERVER_RICCATI_MAX (2000U)
+#endif
+
+typedef struct
+{
+    /**
+     * 扰动加速度的变化率，即模型误差 (unit: deg/s^2/sqrt(s))；
+     * 越大跟踪越快、输出噪声越大
+     */
+    float accel_noise;
+    float position_noise; ///< 位置测量噪声标准差 (unit: deg)，0 取一个刻度的量化噪声
+    float velocity_noise; ///< 转速测量噪声标准差 (unit: rpm)，0 表示不使用转速测量
+    float command_gain;   ///< 单位指令产生的加速度 (unit: deg/s^2)，0 表示不使用指令
+} VelocityObserver_Config_t;
+
+typedef struct
+{
+    /* Arguments */
+    float dt;             //< 更新周期 (unit: s)
+    float angle_per_tick; //< 一个刻度对应的角度 (unit: deg)
+    float command_gain;   //< 单位指令产生的加速度 (unit: deg/s^2)
+    bool  use_velocity;   //< 是否使用转速测量
+    float K[3][2];        //< 稳态卡尔曼增益，行为 位置 / 转速 / 扰动加速度，列为 位置 / 转速
+
+    /* Runtime Data */
+    float position_error; //< 估计位置 - 测量位置 (unit: deg)
+    float omega;          //< 转速估计 (unit: deg/s)
+    float disturbance;    //< 扰动加速度估计 (unit: deg/s^2)
+
+    /* Output */
+    float velocity;     ///< 转速估计 (unit: rpm)
+    float acceleration; ///< 加速度估计，含指令部分 (unit: rpm/s)
+} VelocityObserver_t;
+
+void VelocityObserver_Init(VelocityObserver_t*              obs,
+                           const VelocityObserver_Config_t* config,
+                           float                            dt,
+                           float                            angle_per_tick);
+void VelocityObserver_Update(VelocityObserver_t* obs,
+                             int32_t             delta_ticks,
+                             float               velocity,
+                             float               command);
+void VelocityObserver_UpdateSteps(VelocityObserver_t* obs,
+                                  uint32_t            steps,
+                                  int32_t             delta_ticks,
+                                  float               velocity,
+                                  float               command);
+void VelocityObserver_Reset(VelocityObserver_t* obs);
+
+#endif // VELOCITY_OBSERVER_H
@@ -0,0 +1,92 @@
+/**
+ * @file    bench.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   主机基准使用的计时工具
+ *
+ * 基准在 PC 上运行，结果只用于比较同一台机器上不同实现的相对开销，
+ * 不代表 Cortex-M 上的周期数。每个基准同时检查不同实现的输出一致，不一致时返回非 0
+ *
+ * 计时与 app/bench_example.c 一样使用 PerfCounter_t，
+ * 主机构建中按 SystemCoreClock 换算为等效周期数。
+ * 单次调用只有几纳秒，比读取时钟本身还短，因此每个样本为连续 BENCH_BATCH 次调用，
+ * 输出的 CSV 中周期数和 ns_avg 都是 BENCH_BATCH 次调用的合计
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bsp/perf_counter.h"
+
+#ifndef BENCH_BATCH
+/**
+ * 每个样本连续调用的次数
+ */
+#    define BENCH_BATCH (1000U)
+#endif
+
+/**
+ * 样本数，第一个命令行参数为总的调用次数，可以覆盖默认值（ctest 中使用较小的值）
+ * @return 至少为 1
+ */
+static inline uint32_t bench_samples(const int argc, char** argv, const uint32_t def)
+{
+    const uint32_t n = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 0) : def;
+    return n >= BENCH_BATCH ? n / BENCH_BATCH : 1U;
+}
+
+/**
+ * 防止编译器删除基准循环
+ */
+#define BENCH_KEEP(__VALUE__) __asm__ volatile("" : : "g"(__VALUE__) : "memory")
+
+/**
+ * 测量 __SAMPLES__ 个样本，每个样本连续执行 BENCH_BATCH 次语句
+ * @param __PERF_COUNTER__ PerfCounter_t*
+ * @param __SAMPLES__ 样本数
+ * @param ... 被测语句，可以使用从 0 开始的调用序号 bench_i
+ */
+#define BENCH_MEASURE(__PERF_COUNTER__, __SAMPLES__, ...)                                          \
+    for (uint32_t bench_s = 0; bench_s < (__SAMPLES__); bench_s++)                                 \
+    {                                                                                              \
+        const uint32_t bench_start = PerfCounter_Now();                                            \
+        for (uint32_t bench_j = 0; bench_j < BENCH_BATCH; bench_j++)                               \
+        {                                                                                          \
+            const uint32_t bench_i = bench_s * BENCH_BATCH + bench_j;                              \
+            (void) bench_i;                                                                        \
+            __VA_ARGS__;                                                                           \
+        }                                                                                          \
+        PerfCounter_Record((__PERF_COUNTER__), PerfCounter_Now() - bench_start);                   \
+    }
+
+/**
+ * 以 PerfCounter_FormatCsv 的格式打印测量结果
+ * @param counters 计数器数组
+ * @param n 计数器个数
+ */
+static inline void bench_print(const PerfCounter_t* counters, const size_t n)
+{
+    static char report[1024];
+    PerfCounter_FormatCsv(counters, n, report, sizeof(report));
+    fputs(report, stdout);
+}
+
+#endif // BENCH_H
@@ -0,0 +1,187 @@
+/**
+ * @file    bench_can_fast_path.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   寄存器快速路径与 HAL 路径的单帧收发开销
+ *
+ * 外设用一组普通内存寄存器代替，FIFO 邮箱中固定放一帧，读取后不真正出队，只比较软件开销。
+ * HAL 库没有随仓库提供，hal_get_rx_message / hal_add_tx_message 按 STM32F4 HAL
+ * 的 HAL_CAN_GetRxMessage / HAL_CAN_AddTxMessage 实现（状态检查、填写 header、逐字节拷贝数据、
+ * 读-改-写释放邮箱），再加上 can_driver 中 header 与 CAN_Frame_t 之间的转换
+ */
+#include <string.h>
+#include "bench.h"
+#include "bsp/can_driver.h"
+
+enum
+{
+    BENCH_RX_HAL = 0,
+    BENCH_RX_FAST,
+    BENCH_TX_HAL,
+    BENCH_TX_FAST,
+
+    BENCH_COUNT
+};
+
+static PerfCounter_t counters[BENCH_COUNT];
+
+static CAN_TypeDef       regs;
+static CAN_HandleTypeDef hcan_regs = {.Instance = &regs, .State = HAL_CAN_STATE_LISTENING};
+
+static HAL_StatusTypeDef hal_get_rx_message(CAN_HandleTypeDef*   hcan,
+                                            const uint32_t       fifo,
+                                            CAN_RxHeaderTypeDef* header,
+                                            uint8_t              data[])
+{
+    if (hcan->State != HAL_CAN_STATE_READY && hcan->State != HAL_CAN_STATE_LISTENING)
+        return HAL_ERROR;
+    volatile uint32_t* rf = fifo == CAN_RX_FIFO0 ? &hcan->Instance->RF0R : &hcan->Instance->RF1R;
+    if ((*rf & CAN_RF0R_FMP0) == 0U)
+        return HAL_ERROR;
+
+    const CAN_FIFOMailBox_TypeDef* mb = &hcan->Instance->sFIFOMailBox[fifo];
+    header->IDE = CAN_RI0R_IDE & mb->RIR;
+    if (header->IDE == CAN_ID_STD)
+        header->StdId = (CAN_RI0R_STID & mb->RIR) >> CAN_RI0R_STID_Pos;
+    else
+        header->ExtId = ((CAN_RI0R_EXID | CAN_RI0R_STID) & mb->RIR) >> CAN_RI0R_EXID_Pos;
+    header->RTR              = CAN_RI0R_RTR & mb->RIR;
+    header->DLC              = CAN_RDT0R_DLC & mb->RDTR;
+    header->FilterMatchIndex = (CAN_RDT0R_FMI & mb->RDTR) >> CAN_RDT0R_FMI_Pos;
+    header->Timestamp        = mb->RDTR >> CAN_RDT0R_TIME_Pos;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        data[i]     = (uint8_t) (mb->RDLR >> (8 * i));
+        data[i + 4] = (uint8_t) (mb->RDHR >> (8 * i));
+    }
+    *rf |= CAN_RF0R_RFOM0;
+    *rf &= ~CAN_RF0R_RFOM0; // 普通内存没有副作用，恢复原值以便重复读取
+    return HAL_OK;
+}
+
+static bool hal_read_frame(CAN_HandleTypeDef* hcan, const uint32_t fifo, CAN_Frame_t* frame)
+{
+    CAN_RxHeaderTypeDef header;
+    if (hal_get_rx_message(hcan, fifo, &header, frame->data) != HAL_OK)
+        return false;
+    frame->id  = header.IDE == CAN_ID_STD ? header.StdId : header.ExtId;
+    frame->ide = (uint8_t) header.IDE;
+    frame->rtr = (uint8_t) header.RTR;
+    frame->dlc = (uint8_t) header.DLC;
+    frame->fmi = (uint8_t) header.FilterMatchIndex;
+    return true;
+}
+
+static bool fast_read_frame(CAN_TypeDef* can, const uint32_t fifo, CAN_Frame_t* frame)
+{
+    if (CAN_RxFifoFillLevelFast(can, fifo) == 0)
+        return false;
+    CAN_ReadRxFifoFast(can, fifo, frame);
+    can->RF0R = 1U; // 恢复 FMP 以便重复读取
+    return true;
+}
+
+static HAL_StatusTypeDef hal_add_tx_message(CAN_HandleTypeDef*         hcan,
+                                            const CAN_TxHeaderTypeDef* header,
+                                            const uint8_t              data[],
+                                            uint32_t*                  mailbox)
+{
+    if (hcan->State != HAL_CAN_STATE_READY && hcan->State != HAL_CAN_STATE_LISTENING)
+        return HAL_ERROR;
+    const uint32_t tsr = hcan->Instance->TSR;
+    if ((tsr & CAN_TSR_TME) == 0U)
+        return HAL_ERROR;
+    const uint32_t index = (tsr & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+    *mailbox             = 1U << index;
+
+    CAN_TxMailBox_TypeDef* mb = &hcan->Instance->sTxMailBox[index];
+    if (header->IDE == CAN_ID_STD)
+        mb->TIR = header->StdId << CAN_TI0R_STID_Pos | header->RTR;
+    else
+        mb->TIR = header->ExtId << CAN_TI0R_EXID_Pos | header->IDE | header->RTR;
+    mb->TDTR = header->DLC;
+    mb->TDHR = (uint32_t) data[7] << 24 | (uint32_t) data[6] << 16 | (uint32_t) data[5] << 8 |
+               (uint32_t) data[4];
+    mb->TDLR = (uint32_t) data[3] << 24 | (uint32_t) data[2] << 16 | (uint32_t) data[1] << 8 |
+               (uint32_t) data[0];
+    mb->TIR |= CAN_TI0R_TXRQ;
+    return HAL_OK;
+}
+
+static bool hal_write_frame(CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame)
+{
+    uint32_t mailbox;
+    return hal_add_tx_message(hcan,
+                              &(CAN_TxHeaderTypeDef){
+                                      .StdId = frame->id,
+                                      .ExtId = frame->id,
+                                      .IDE   = frame->ide,
+                                      .RTR   = frame->rtr,
+                                      .DLC   = frame->dlc,
+                              },
+                              frame->data,
+                              &mailbox) == HAL_OK;
+}
+
+int main(const int argc, char** argv)
+{
+    const uint32_t samples = bench_samples(argc, argv, 10000000U);
+    int            failed  = 0;
+    CAN_Frame_t    a, b;
+
+    PerfCounter_Reset(&counters[BENCH_RX_HAL], "rx HAL_CAN_GetRxMessage");
+    PerfCounter_Reset(&counters[BENCH_RX_FAST], "rx CAN_ReadRxFifoFast");
+    PerfCounter_Reset(&counters[BENCH_TX_HAL], "tx HAL_CAN_AddTxMessage");
+    PerfCounter_Reset(&counters[BENCH_TX_FAST], "tx CAN_WriteTxMailboxFast");
+
+    // 一帧扩展帧在 FIFO0 中
+    regs.RF0R                 = 1U;
+    regs.sFIFOMailBox[0].RIR  = 0x0901U << CAN_RI0R_EXID_Pos | CAN_RI0R_IDE;
+    regs.sFIFOMailBox[0].RDTR = 8U | 3U << CAN_RDT0R_FMI_Pos;
+    regs.sFIFOMailBox[0].RDLR = 0x04030201U;
+    regs.sFIFOMailBox[0].RDHR = 0x08070605U;
+    regs.TSR                  = CAN_TSR_TME;
+
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    hal_read_frame(&hcan_regs, CAN_RX_FIFO0, &a);
+    fast_read_frame(&regs, CAN_RX_FIFO0, &b);
+    if (a.id != b.id || a.ide != b.ide || a.rtr != b.rtr || a.dlc != b.dlc || a.fmi != b.fmi ||
+        memcmp(a.data, b.data, 8) != 0)
+    {
+        printf("rx mismatch\n");
+        failed = 1;
+    }
+
+    BENCH_MEASURE(&counters[BENCH_RX_HAL], samples, {
+        hal_read_frame(&hcan_regs, CAN_RX_FIFO0, &a);
+        BENCH_KEEP(&a);
+    });
+    BENCH_MEASURE(&counters[BENCH_RX_FAST], samples, {
+        fast_read_frame(&regs, CAN_RX_FIFO0, &b);
+        BENCH_KEEP(&b);
+    });
+
+    // 两种写法写出的邮箱寄存器应当相同
+    hal_write_frame(&hcan_regs, &a);
+    const CAN_TxMailBox_TypeDef hal_mb = regs.sTxMailBox[0];
+    memset(regs.sTxMailBox, 0, sizeof(regs.sTxMailBox));
+    CAN_WriteTxMailboxFast(&regs, &a);
+    if (memcmp(&hal_mb, &regs.sTxMailBox[0], sizeof(hal_mb)) != 0)
+    {
+        printf("tx mismatch\n");
+        failed = 1;
+    }
+
+    BENCH_MEASURE(&counters[BENCH_TX_HAL], samples, {
+        hal_write_frame(&hcan_regs, &a);
+        BENCH_KEEP(&regs);
+    });
+    BENCH_MEASURE(&counters[BENCH_TX_FAST], samples, {
+        CAN_WriteTxMailboxFast(&regs, &a);
+        BENCH_KEEP(&regs);
+    });
+
+    bench_print(counters, BENCH_COUNT);
+    return failed;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file    bench_hot_path.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   在主机上运行 bench_example.c 的控制热路径测量
+ *
+ * Bench_Run 的测量次数固定为 BENCH_ITERATIONS，命令行参数被忽略。
+ * 主机上的周期数由 clock_gettime 换算（USE_PERF_CLOCK_GETTIME），只用于对比同一台机器上的结果
+ */
+#include "bench.h"
+
+extern PerfCounter_t bench_counters[];
+extern char          bench_report[];
+extern uint32_t      bench_pid_mismatch;
+
+void Bench_Run(void);
+
+int main(void)
+{
+    Bench_Run();
+    fputs(bench_report, stdout);
+    if (bench_pid_mismatch != 0)
+    {
+        printf("pid_batch mismatch: %u\n", (unsigned) bench_pid_mismatch);
+        return 1;
+    }
+    return 0;
+}
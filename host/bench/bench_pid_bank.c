@@ -0,0 +1,172 @@
+/**
+ * @file    bench_pid_bank.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   批量 PID 与逐个 MotorPID_Calculate 的结果和开销
+ *
+ * 12 个控制器分别用 MotorPID_Calculate、MotorPID_CalculateBatchScalar 和 MotorPID_CalculateBatch
+ * 计算同一组随机输入，逐位比较输出和误差历史。输入中混有 NaN 反馈、±0，
+ * 参数中有无穷大和 0 的限幅。主机上 MotorPID_CalculateBatch 使用 SSE 内核（见 pid_bank.c），
+ * Cortex-M 的展开内核和 NEON 内核不在主机上编译
+ */
+#include <math.h>
+#include <string.h>
+#include "bench.h"
+#include "libs/pid_bank.h"
+
+#define PID_NUM (12U)
+
+static MotorPID_t      pids[PID_NUM];
+static MotorPID_Bank_t bank_scalar;
+static MotorPID_Bank_t bank_batch;
+
+enum
+{
+    BENCH_PID = 0,
+    BENCH_BATCH_SCALAR,
+    BENCH_BATCH_SIMD,
+
+    BENCH_COUNT
+};
+
+static PerfCounter_t counters[BENCH_COUNT];
+
+static uint32_t rng_state = 1U;
+
+static float rng_float(void)
+{
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return (float) (rng_state >> 8) / (float) (1U << 24) * 4000.0f - 2000.0f;
+}
+
+static void set_input(const uint32_t k, const float ref, const float fdb)
+{
+    pids[k].ref = bank_scalar.ref[k] = bank_batch.ref[k] = ref;
+    pids[k].fdb = bank_scalar.fdb[k] = bank_batch.fdb[k] = fdb;
+}
+
+/**
+ * 逐位比较三条路径的运行数据
+ * @return 不一致的控制器数
+ */
+static uint32_t compare(void)
+{
+    uint32_t mismatch = 0;
+    for (uint32_t k = 0; k < PID_NUM; k++)
+    {
+        const float a[4] = {
+                pids[k].output, pids[k].cur_error, pids[k].prev_error1, pids[k].prev_error2};
+        const float b[4] = {bank_scalar.output[k],
+                            bank_scalar.cur_error[k],
+                            bank_scalar.prev_error1[k],
+                            bank_scalar.prev_error2[k]};
+        const float c[4] = {bank_batch.output[k],
+                            bank_batch.cur_error[k],
+                            bank_batch.prev_error1[k],
+                            bank_batch.prev_error2[k]};
+        if (memcmp(a, b, sizeof(a)) != 0 || memcmp(a, c, sizeof(a)) != 0)
+            mismatch++;
+    }
+    return mismatch;
+}
+
+int main(const int argc, char** argv)
+{
+    const uint32_t samples = bench_samples(argc, argv, 10000000U);
+    const uint32_t n       = samples * BENCH_BATCH;
+
+    PerfCounter_Reset(&counters[BENCH_PID], "pid_12 MotorPID_Calculate");
+    PerfCounter_Reset(&counters[BENCH_BATCH_SCALAR], "pid_12 CalculateBatchScalar");
+    PerfCounter_Reset(&counters[BENCH_BATCH_SIMD], "pid_12 CalculateBatch");
+
+    MotorPID_BankInit(&bank_scalar);
+    MotorPID_BankInit(&bank_batch);
+    for (uint32_t k = 0; k < PID_NUM; k++)
+    {
+        MotorPID_Config_t config = {.Kp             = 12.0f + (float) k,
+                                    .Ki             = 0.2f + 0.01f * (float) k,
+                                    .Kd             = 0.5f * (float) (k % 3U),
+                                    .abs_output_max = 16384.0f};
+        if (k == 9)
+            config.abs_output_max = INFINITY;
+        if (k == 10)
+            config.abs_output_max = 0.0f;
+        MotorPID_Init(&pids[k], config);
+        MotorPID_BankAdd(&bank_scalar, config);
+        MotorPID_BankAdd(&bank_batch, config);
+    }
+
+    // 逐位一致
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        for (uint32_t k = 0; k < PID_NUM; k++)
+        {
+            float fdb = rng_float();
+            if (i % 97U == k)
+                fdb = NAN;
+            else if (i % 89U == k)
+                fdb = (i & 1U) ? -0.0f : 0.0f;
+            set_input(k, (i & 64U) ? 1000.0f : -1000.0f, fdb);
+        }
+        for (uint32_t k = 0; k < PID_NUM; k++)
+            MotorPID_Calculate(&pids[k]);
+        MotorPID_CalculateBatchScalar(&bank_scalar);
+        MotorPID_CalculateBatch(&bank_batch);
+        mismatch += compare();
+
+        // NaN 会一直留在增量式 PID 的输出中，定期清除
+        if (i % 256U == 255U)
+        {
+            for (uint32_t k = 0; k < PID_NUM; k++)
+            {
+                MotorPID_Reset(&pids[k]);
+                MotorPID_BankReset(&bank_scalar, k);
+                MotorPID_BankReset(&bank_batch, k);
+            }
+        }
+    }
+    printf("%u steps x %u controllers, %u mismatches\n", n, PID_NUM, mismatch);
+
+    // 耗时，每次都写入新的反馈
+    for (uint32_t k = 0; k < PID_NUM; k++)
+    {
+        MotorPID_Reset(&pids[k]);
+        MotorPID_BankReset(&bank_scalar, k);
+        MotorPID_BankReset(&bank_batch, k);
+    }
+
+    BENCH_MEASURE(&counters[BENCH_PID], samples, {
+        for (uint32_t k = 0; k < PID_NUM; k++)
+        {
+            pids[k].ref = 1000.0f;
+            pids[k].fdb = (float) ((bench_i + k * 97U) % 2000U);
+        }
+        for (uint32_t k = 0; k < PID_NUM; k++)
+            MotorPID_Calculate(&pids[k]);
+        BENCH_KEEP(pids);
+    });
+    BENCH_MEASURE(&counters[BENCH_BATCH_SCALAR], samples, {
+        for (uint32_t k = 0; k < PID_NUM; k++)
+        {
+            bank_scalar.ref[k] = 1000.0f;
+            bank_scalar.fdb[k] = (float) ((bench_i + k * 97U) % 2000U);
+        }
+        MotorPID_CalculateBatchScalar(&bank_scalar);
+        BENCH_KEEP(&bank_scalar);
+    });
+    BENCH_MEASURE(&counters[BENCH_BATCH_SIMD], samples, {
+        for (uint32_t k = 0; k < PID_NUM; k++)
+        {
+            bank_batch.ref[k] = 1000.0f;
+            bank_batch.fdb[k] = (float) ((bench_i + k * 97U) % 2000U);
+        }
+        MotorPID_CalculateBatch(&bank_batch);
+        BENCH_KEEP(&bank_batch);
+    });
+    bench_print(counters, BENCH_COUNT);
+
+    // 相同输入下三条路径的最终状态也应一致
+    mismatch += compare();
+    return mismatch == 0 ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+/**
+ * @file    can.h
+ * @brief   主机构建使用的 can.h 替身，对应 CubeMX 生成的 CAN 句柄
+ */
+#ifndef CAN_H_HOST
+#define CAN_H_HOST
+
+#include "main.h"
+
+extern CAN_HandleTypeDef hcan1;
+extern CAN_HandleTypeDef hcan2;
+
+#endif // CAN_H_HOST
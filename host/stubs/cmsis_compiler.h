@@ -0,0 +1,70 @@
+/**
+ * @file    cmsis_compiler.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   主机构建使用的 CMSIS 内核函数替身
+ *
+ * 中断屏蔽由 host_hal.c 用一把全局递归锁模拟：__disable_irq 持有锁，
+ * 模拟中断的线程通过 HostIrq_Enter / HostIrq_Exit 持有同一把锁，
+ * 因此关中断的代码段与模拟的中断互斥，与单核 MCU 上的效果相同。
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef CMSIS_COMPILER_H
+#define CMSIS_COMPILER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define __STATIC_INLINE      static inline
+#define __STATIC_FORCEINLINE static inline __attribute__((always_inline))
+#define __ALIGNED(x)         __attribute__((aligned(x)))
+
+void     __disable_irq(void);
+void     __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void     __set_PRIMASK(uint32_t priMask);
+uint32_t __get_IPSR(void);
+
+static inline void __DMB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __DSB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __ISB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __NOP(void)
+{
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CMSIS_COMPILER_H
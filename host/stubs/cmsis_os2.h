@@ -0,0 +1,114 @@
+/**
+ * @file    cmsis_os2.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   主机构建使用的 CMSIS-RTOS2 子集，由 host_os.c 基于 pthread 实现
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef CMSIS_OS2_H
+#define CMSIS_OS2_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef enum
+{
+    osOK             = 0,
+    osError          = -1,
+    osErrorTimeout   = -2,
+    osErrorResource  = -3,
+    osErrorParameter = -4,
+    osErrorNoMemory  = -5,
+    osErrorISR       = -6,
+    osStatusReserved = 0x7FFFFFFF
+} osStatus_t;
+
+typedef enum
+{
+    osPriorityNone        = 0,
+    osPriorityIdle        = 1,
+    osPriorityLow         = 8,
+    osPriorityBelowNormal = 16,
+    osPriorityNormal      = 24,
+    osPriorityAboveNormal = 32,
+    osPriorityHigh        = 40,
+    osPriorityRealtime    = 48,
+    osPriorityISR         = 56,
+    osPriorityError       = -1,
+} osPriority_t;
+
+typedef void* osThreadId_t;
+typedef void* osMutexId_t;
+typedef void (*osThreadFunc_t)(void* argument);
+
+typedef struct
+{
+    const char*  name;
+    uint32_t     attr_bits;
+    void*        cb_mem;
+    uint32_t     cb_size;
+    void*        stack_mem;
+    uint32_t     stack_size;
+    osPriority_t priority;
+} osThreadAttr_t;
+
+typedef struct
+{
+    const char* name;
+    uint32_t    attr_bits;
+    void*       cb_mem;
+    uint32_t    cb_size;
+} osMutexAttr_t;
+
+#define osWaitForever  0xFFFFFFFFU
+#define osFlagsWaitAny 0x00000000U
+#define osFlagsWaitAll 0x00000001U
+#define osFlagsNoClear 0x00000002U
+#define osFlagsError   0x80000000U
+
+#define osFlagsErrorUnknown   0xFFFFFFFFU
+#define osFlagsErrorTimeout   0xFFFFFFFEU
+#define osFlagsErrorResource  0xFFFFFFFDU
+#define osFlagsErrorParameter 0xFFFFFFFCU
+
+#define osMutexRecursive 0x00000001U
+
+uint32_t osKernelGetTickCount(void);
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void* argument, const osThreadAttr_t* attr);
+osThreadId_t osThreadGetId(void);
+void         osThreadExit(void);
+uint32_t     osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags);
+uint32_t     osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout);
+osStatus_t   osDelay(uint32_t ticks);
+
+osMutexId_t osMutexNew(const osMutexAttr_t* attr);
+osStatus_t  osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout);
+osStatus_t  osMutexRelease(osMutexId_t mutex_id);
+osStatus_t  osMutexDelete(osMutexId_t mutex_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CMSIS_OS2_H
@@ -0,0 +1,960 @@
+/**
+ * @file    host_hal.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   主机构建的 HAL 模拟：bxCAN、TIM、GPIO、系统时钟和中断屏蔽
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "host_hal.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "can.h"
+#include "tim.h"
+
+#define HOST_CAN_FIFO_DEPTH   (3U)
+#define HOST_CAN_FILTER_BANKS (28U)
+#define HOST_PCLK1_HZ         (42000000U)
+/* 42MHz / 3 / (1 + 11 + 2) = 1Mbps */
+#define HOST_CAN_BTR (1U << CAN_BTR_TS2_Pos | 10U << CAN_BTR_TS1_Pos | 2U)
+
+typedef struct
+{
+    HostCan_Frame_t frame;
+    uint32_t        order;   ///< 请求顺序，TXFP = 1 时按此发送
+    bool            pending; ///< 已请求发送
+    bool            abort;   ///< 已请求中止
+} HostCan_Mailbox_t;
+
+typedef struct
+{
+    CAN_HandleTypeDef*   hcan; ///< 最近一次使用该实例的句柄，用于调用回调
+    HostCan_Frame_t      fifo[2][HOST_CAN_FIFO_DEPTH];
+    uint32_t             fill[2];
+    uint32_t             rf_flags[2]; ///< RFxR 中写 1 清零的 FULL / FOVR
+    HostCan_Mailbox_t    mailbox[3];
+    uint32_t             tx_order;
+    pCAN_CallbackTypeDef callbacks[HAL_CAN_CALLBACK_NUM];
+    HostCan_Frame_t      log[HOST_CAN_LOG_SIZE];
+    size_t               log_head, log_tail;
+} HostCan_t;
+
+/* 外设 */
+
+DWT_Type       HostDWT;
+CoreDebug_Type HostCoreDebug;
+uint32_t       SystemCoreClock = 168000000U;
+
+CAN_TypeDef       HostCAN1, HostCAN2;
+CAN_HandleTypeDef hcan1 = {.Instance = CAN1, .State = HAL_CAN_STATE_READY};
+CAN_HandleTypeDef hcan2 = {.Instance = CAN2, .State = HAL_CAN_STATE_READY};
+
+static TIM_TypeDef host_tim2, host_tim6, host_tim8;
+TIM_HandleTypeDef  htim2 = {.Instance = &host_tim2};
+TIM_HandleTypeDef  htim6 = {.Instance = &host_tim6};
+TIM_HandleTypeDef  htim8 = {.Instance = &host_tim8};
+
+GPIO_TypeDef HostGPIOA, HostGPIOB, HostGPIOC, HostGPIOD, HostGPIOE;
+
+static HostCan_t host_can[2];
+static uint32_t  host_tick        = 0;
+static uint32_t  host_error_count = 0;
+static bool      host_error_trap  = true;
+
+/* 中断屏蔽：一把全局递归锁 */
+
+static pthread_mutex_t  irq_lock;
+static pthread_once_t   irq_once    = PTHREAD_ONCE_INIT;
+static __thread uint8_t irq_primask = 0;
+static __thread uint8_t irq_active  = 0;
+
+static void irq_lock_init(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&irq_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+static void irq_acquire(void)
+{
+    pthread_once(&irq_once, irq_lock_init);
+    pthread_mutex_lock(&irq_lock);
+}
+
+void __disable_irq(void)
+{
+    if (!irq_primask)
+    {
+        irq_acquire();
+        irq_primask = 1;
+    }
+}
+
+void __enable_irq(void)
+{
+    if (irq_primask)
+    {
+        irq_primask = 0;
+        pthread_mutex_unlock(&irq_lock);
+    }
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return irq_primask;
+}
+
+void __set_PRIMASK(const uint32_t priMask)
+{
+    if (priMask & 1U)
+        __disable_irq();
+    else
+        __enable_irq();
+}
+
+uint32_t __get_IPSR(void)
+{
+    return irq_active ? 16U : 0U;
+}
+
+/**
+ * 进入模拟的中断，与关中断的代码段互斥
+ */
+void HostIrq_Enter(void)
+{
+    irq_acquire();
+    irq_active = 1;
+}
+
+/**
+ * 退出模拟的中断
+ */
+void HostIrq_Exit(void)
+{
+    irq_active = 0;
+    pthread_mutex_unlock(&irq_lock);
+}
+
+/* 系统 */
+
+uint32_t HAL_GetTick(void)
+{
+    return __atomic_load_n(&host_tick, __ATOMIC_RELAXED);
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return HOST_PCLK1_HZ;
+}
+
+void Error_Handler(void)
+{
+    host_error_count++;
+    if (host_error_trap)
+    {
+        fprintf(stderr, "Error_Handler called\n");
+        abort();
+    }
+}
+
+/**
+ * 清除全部模拟状态：CAN 寄存器、FIFO、邮箱、发送记录、回调、时间和错误计数
+ * @note 驱动自身的静态状态不受影响
+ */
+void HostHal_Reset(void)
+{
+    memset(host_can, 0, sizeof(host_can));
+    memset(&HostCAN1, 0, sizeof(HostCAN1));
+    memset(&HostCAN2, 0, sizeof(HostCAN2));
+    HostCAN1.BTR = HostCAN2.BTR = HOST_CAN_BTR;
+    HostCAN1.TSR = HostCAN2.TSR = CAN_TSR_TME;
+    hcan1.State = hcan2.State = HAL_CAN_STATE_READY;
+    hcan1.ErrorCode = hcan2.ErrorCode = HAL_CAN_ERROR_NONE;
+    host_tick        = 0;
+    host_error_count = 0;
+    host_error_trap  = true;
+}
+
+void HostHal_SetTick(const uint32_t tick)
+{
+    __atomic_store_n(&host_tick, tick, __ATOMIC_RELAXED);
+}
+
+void HostHal_AdvanceTick(const uint32_t ms)
+{
+    __atomic_fetch_add(&host_tick, ms, __ATOMIC_RELAXED);
+}
+
+/**
+ * 设置 Error_Handler 的行为
+ * @param trap true 时打印并 abort（默认），false 时只计数，用于测试错误路径
+ */
+void HostHal_TrapErrors(const bool trap)
+{
+    host_error_trap = trap;
+}
+
+uint32_t HostHal_ErrorCount(void)
+{
+    return host_error_count;
+}
+
+/* CAN */
+
+static HostCan_t* host_can_of(const CAN_TypeDef* can)
+{
+    return can == CAN1 ? &host_can[0] : &host_can[1];
+}
+
+static HostCan_t* host_can_bind(CAN_HandleTypeDef* hcan)
+{
+    HostCan_t* c = host_can_of(hcan->Instance);
+    c->hcan      = hcan;
+    return c;
+}
+
+static volatile uint32_t* rf_reg(CAN_TypeDef* can, const uint32_t fifo)
+{
+    return fifo == CAN_RX_FIFO0 ? &can->RF0R : &can->RF1R;
+}
+
+/**
+ * 帧转换为 RIR / TIR 的标识符部分（不含 TXRQ）
+ */
+static uint32_t frame_ir(const HostCan_Frame_t* f)
+{
+    const uint32_t id = f->ide == CAN_ID_STD ? f->id << CAN_RI0R_STID_Pos
+                                             : f->id << CAN_RI0R_EXID_Pos | CAN_RI0R_IDE;
+    return id | (f->rtr ? CAN_RI0R_RTR : 0U);
+}
+
+static uint32_t frame_word(const uint8_t* data)
+{
+    return (uint32_t) data[0] | (uint32_t) data[1] << 8 | (uint32_t) data[2] << 16 |
+           (uint32_t) data[3] << 24;
+}
+
+/**
+ * 将模拟状态同步到寄存器：FMP / FULL、FIFO 首帧、TME / CODE
+ */
+static void host_can_sync(CAN_TypeDef* can)
+{
+    HostCan_t* c = host_can_of(can);
+    for (uint32_t fifo = 0; fifo < 2; fifo++)
+    {
+        *rf_reg(can, fifo) = c->rf_flags[fifo] | c->fill[fifo];
+        if (c->fill[fifo] > 0)
+        {
+            const HostCan_Frame_t* f = &c->fifo[fifo][0];
+            can->sFIFOMailBox[fifo].RIR  = frame_ir(f);
+            can->sFIFOMailBox[fifo].RDTR = f->dlc | (uint32_t) f->fmi << CAN_RDT0R_FMI_Pos;
+            can->sFIFOMailBox[fifo].RDLR = frame_word(f->data);
+            can->sFIFOMailBox[fifo].RDHR = frame_word(f->data + 4);
+        }
+    }
+
+    uint32_t tsr  = can->TSR & ~(CAN_TSR_TME | CAN_TSR_CODE);
+    uint32_t code = 0;
+    for (uint32_t i = 3; i-- > 0;)
+    {
+        if (!c->mailbox[i].pending)
+        {
+            tsr |= CAN_TSR_TME0 << i;
+            code = i; // 最小的空邮箱
+        }
+    }
+    can->TSR = tsr | code << CAN_TSR_CODE_Pos;
+}
+
+/**
+ * 模拟写 RFxR：FULL / FOVR 写 1 清零，RFOM 写 1 释放首帧
+ */
+static void rf_write(CAN_TypeDef* can, const uint32_t fifo, const uint32_t value)
+{
+    HostCan_t* c = host_can_of(can);
+    c->rf_flags[fifo] &= ~(value & (CAN_RF0R_FULL0 | CAN_RF0R_FOVR0));
+    if ((value & CAN_RF0R_RFOM0) && c->fill[fifo] > 0)
+    {
+        memmove(&c->fifo[fifo][0], &c->fifo[fifo][1], (--c->fill[fifo]) * sizeof(HostCan_Frame_t));
+    }
+    host_can_sync(can);
+}
+
+void HostCan_ClearFlag(CAN_TypeDef* can, const uint32_t flag)
+{
+    const uint32_t bit = 1U << (flag & CAN_FLAG_MASK);
+    switch (flag >> 8U)
+    {
+    case 1U:
+        can->MSR &= ~bit;
+        break;
+    case 2U:
+        rf_write(can, CAN_RX_FIFO0, bit);
+        break;
+    case 4U:
+        rf_write(can, CAN_RX_FIFO1, bit);
+        break;
+    case 5U:
+        can->TSR &= ~bit;
+        break;
+    default:
+        break;
+    }
+}
+
+HAL_StatusTypeDef HAL_CAN_ConfigFilter(CAN_HandleTypeDef* hcan, const CAN_FilterTypeDef* sFilterConfig)
+{
+    // CAN1 和 CAN2 共用 CAN1 的 28 个过滤器组
+    CAN_TypeDef* can_ip = CAN1;
+
+    if (hcan->State != HAL_CAN_STATE_READY && hcan->State != HAL_CAN_STATE_LISTENING)
+    {
+        hcan->ErrorCode |= HAL_CAN_ERROR_NOT_INITIALIZED;
+        return HAL_ERROR;
+    }
+    if (sFilterConfig->FilterBank >= HOST_CAN_FILTER_BANKS ||
+        sFilterConfig->SlaveStartFilterBank >= HOST_CAN_FILTER_BANKS)
+    {
+        hcan->ErrorCode |= HAL_CAN_ERROR_PARAM;
+        return HAL_ERROR;
+    }
+
+    can_ip->FMR |= CAN_FMR_FINIT;
+    can_ip->FMR = (can_ip->FMR & ~CAN_FMR_CAN2SB) |
+                  sFilterConfig->SlaveStartFilterBank << CAN_FMR_CAN2SB_Pos;
+
+    const uint32_t              pos = 1U << (sFilterConfig->FilterBank & 0x1FU);
+    CAN_FilterRegister_TypeDef* fr  = &can_ip->sFilterRegister[sFilterConfig->FilterBank];
+    can_ip->FA1R &= ~pos;
+    if (sFilterConfig->FilterScale == CAN_FILTERSCALE_16BIT)
+    {
+        can_ip->FS1R &= ~pos;
+        fr->FR1 = (sFilterConfig->FilterMaskIdLow & 0xFFFFU) << 16 |
+                  (sFilterConfig->FilterIdLow & 0xFFFFU);
+        fr->FR2 = (sFilterConfig->FilterMaskIdHigh & 0xFFFFU) << 16 |
+                  (sFilterConfig->FilterIdHigh & 0xFFFFU);
+    }
+    else
+    {
+        can_ip->FS1R |= pos;
+        fr->FR1 = (sFilterConfig->FilterIdHigh & 0xFFFFU) << 16 |
+                  (sFilterConfig->FilterIdLow & 0xFFFFU);
+        fr->FR2 = (sFilterConfig->FilterMaskIdHigh & 0xFFFFU) << 16 |
+                  (sFilterConfig->FilterMaskIdLow & 0xFFFFU);
+    }
+    if (sFilterConfig->FilterMode == CAN_FILTERMODE_IDLIST)
+        can_ip->FM1R |= pos;
+    else
+        can_ip->FM1R &= ~pos;
+    if (sFilterConfig->FilterFIFOAssignment == CAN_FILTER_FIFO1)
+        can_ip->FFA1R |= pos;
+    else
+        can_ip->FFA1R &= ~pos;
+    if (sFilterConfig->FilterActivation == ENABLE)
+        can_ip->FA1R |= pos;
+
+    can_ip->FMR &= ~CAN_FMR_FINIT;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef* hcan)
+{
+    if (hcan->State != HAL_CAN_STATE_READY)
+    {
+        hcan->ErrorCode |= HAL_CAN_ERROR_NOT_READY;
+        return HAL_ERROR;
+    }
+    host_can_bind(hcan);
+    hcan->State     = HAL_CAN_STATE_LISTENING;
+    hcan->ErrorCode = HAL_CAN_ERROR_NONE;
+    host_can_sync(hcan->Instance);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_Stop(CAN_HandleTypeDef* hcan)
+{
+    if (hcan->State != HAL_CAN_STATE_LISTENING)
+    {
+        hcan->ErrorCode |= HAL_CAN_ERROR_NOT_STARTED;
+        return HAL_ERROR;
+    }
+    hcan->State = HAL_CAN_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_AddTxMessage(CAN_HandleTypeDef*         hcan,
+                                       const CAN_TxHeaderTypeDef* pHeader,
+                                       const uint8_t              aData[],
+                                       uint32_t*                  pTxMailbox)
+{
+    if (hcan->State != HAL_CAN_STATE_READY && hcan->State != HAL_CAN_STATE_LISTENING)
+    {
+        hcan->ErrorCode |= HAL_CAN_ERROR_NOT_INITIALIZED;
+        return HAL_ERROR;
+    }
+    CAN_TypeDef* can = hcan->Instance;
+    HostCan_t*   c   = host_can_bind(hcan);
+    host_can_sync(can);
+    if ((can->TSR & CAN_TSR_TME) == 0)
+    {
+        hcan->ErrorCode |= HAL_CAN_ERROR_PARAM;
+        return HAL_ERROR;
+    }
+
+    const uint32_t     index = (can->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+    HostCan_Mailbox_t* mb    = &c->mailbox[index];
+    *pTxMailbox              = 1U << index;
+
+    mb->frame = (HostCan_Frame_t){
+        .id  = pHeader->IDE == CAN_ID_STD ? pHeader->StdId : pHeader->ExtId,
+        .ide = (uint8_t) pHeader->IDE,
+        .rtr = (uint8_t) pHeader->RTR,
+        .dlc = (uint8_t) (pHeader->DLC > 8 ? 8 : pHeader->DLC),
+    };
+    memcpy(mb->frame.data, aData, mb->frame.dlc);
+    mb->order   = c->tx_order++;
+    mb->pending = true;
+    mb->abort   = false;
+
+    can->sTxMailBox[index].TDTR = pHeader->DLC;
+    can->sTxMailBox[index].TDLR = frame_word(mb->frame.data);
+    can->sTxMailBox[index].TDHR = frame_word(mb->frame.data + 4);
+    can->sTxMailBox[index].TIR  = frame_ir(&mb->frame) | CAN_TI0R_TXRQ;
+    host_can_sync(can);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_AbortTxRequest(CAN_HandleTypeDef* hcan, const uint32_t TxMailboxes)
+{
+    HostCan_t* c = host_can_bind(hcan);
+    for (uint32_t i = 0; i < 3; i++)
+        if ((TxMailboxes & 1U << i) && c->mailbox[i].pending)
+            c->mailbox[i].abort = true;
+    return HAL_OK;
+}
+
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(const CAN_HandleTypeDef* hcan)
+{
+    const HostCan_t* c    = host_can_of(hcan->Instance);
+    uint32_t         free = 0;
+    for (uint32_t i = 0; i < 3; i++)
+        if (!c->mailbox[i].pending)
+            free++;
+    return free;
+}
+
+uint32_t HAL_CAN_IsTxMessagePending(const CAN_HandleTypeDef* hcan, const uint32_t TxMailboxes)
+{
+    const HostCan_t* c = host_can_of(hcan->Instance);
+    for (uint32_t i = 0; i < 3; i++)
+        if ((TxMailboxes & 1U << i) && c->mailbox[i].pending)
+            return 1U;
+    return 0U;
+}
+
+HAL_StatusTypeDef HAL_CAN_GetRxMessage(CAN_HandleTypeDef*   hcan,
+                                       const uint32_t       RxFifo,
+                                       CAN_RxHeaderTypeDef* pHeader,
+                                       uint8_t              aData[])
+{
+    if (hcan->State != HAL_CAN_STATE_READY && hcan->State != HAL_CAN_STATE_LISTENING)
+    {
+        hcan->ErrorCode |= HAL_CAN_ERROR_NOT_INITIALIZED;
+        return HAL_ERROR;
+    }
+    CAN_TypeDef* can = hcan->Instance;
+    if ((*rf_reg(can, RxFifo) & CAN_RF0R_FMP0) == 0)
+    {
+        hcan->ErrorCode |= HAL_CAN_ERROR_PARAM;
+        return HAL_ERROR;
+    }
+
+    const CAN_FIFOMailBox_TypeDef* mb = &can->sFIFOMailBox[RxFifo];
+    pHeader->IDE   = mb->RIR & CAN_RI0R_IDE;
+    pHeader->StdId = (mb->RIR & CAN_RI0R_STID) >> CAN_RI0R_STID_Pos;
+    pHeader->ExtId = (mb->RIR & (CAN_RI0R_EXID | CAN_RI0R_STID)) >> CAN_RI0R_EXID_Pos;
+    pHeader->RTR   = mb->RIR & CAN_RI0R_RTR;
+    pHeader->DLC   = mb->RDTR & CAN_RDT0R_DLC;
+    pHeader->FilterMatchIndex = (mb->RDTR & CAN_RDT0R_FMI) >> CAN_RDT0R_FMI_Pos;
+    pHeader->Timestamp        = mb->RDTR >> CAN_RDT0R_TIME_Pos;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        aData[i]     = (uint8_t) (mb->RDLR >> (8 * i));
+        aData[i + 4] = (uint8_t) (mb->RDHR >> (8 * i));
+    }
+
+    // 与 HAL 相同的 SET_BIT(RFxR, RFOM)：读-改-写，会把读到的 FOVR / FULL 写 1 清除
+    rf_write(can, RxFifo, *rf_reg(can, RxFifo) | CAN_RF0R_RFOM0);
+    return HAL_OK;
+}
+
+uint32_t HAL_CAN_GetRxFifoFillLevel(const CAN_HandleTypeDef* hcan, const uint32_t RxFifo)
+{
+    return (RxFifo == CAN_RX_FIFO0 ? hcan->Instance->RF0R : hcan->Instance->RF1R) &
+           CAN_RF0R_FMP0;
+}
+
+HAL_StatusTypeDef HAL_CAN_ActivateNotification(CAN_HandleTypeDef* hcan, const uint32_t ActiveITs)
+{
+    host_can_bind(hcan);
+    hcan->Instance->IER |= ActiveITs;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_DeactivateNotification(CAN_HandleTypeDef* hcan, const uint32_t InactiveITs)
+{
+    hcan->Instance->IER &= ~InactiveITs;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_RegisterCallback(CAN_HandleTypeDef*              hcan,
+                                           const HAL_CAN_CallbackIDTypeDef CallbackID,
+                                           const pCAN_CallbackTypeDef      pCallback)
+{
+    if (pCallback == NULL || CallbackID >= HAL_CAN_CALLBACK_NUM)
+    {
+        hcan->ErrorCode |= HAL_CAN_ERROR_INVALID_CALLBACK;
+        return HAL_ERROR;
+    }
+    host_can_bind(hcan)->callbacks[CallbackID] = pCallback;
+    return HAL_OK;
+}
+
+/**
+ * 收到一帧，不经过过滤器直接放入 FIFO
+ *
+ * FIFO 已满时与 RFLM = 0 的 bxCAN 相同：新帧覆盖最后一帧并置位 FOVR
+ * @param hcan can handle
+ * @param fifo CAN_RX_FIFO0 或 CAN_RX_FIFO1
+ * @param frame 帧，fmi 原样写入 RDTR
+ * @return 发生溢出时返回 false
+ */
+bool HostCan_Receive(CAN_HandleTypeDef* hcan, const uint32_t fifo, const HostCan_Frame_t* frame)
+{
+    HostCan_t* c = host_can_bind(hcan);
+    bool       ok = true;
+    if (c->fill[fifo] == HOST_CAN_FIFO_DEPTH)
+    {
+        c->fifo[fifo][HOST_CAN_FIFO_DEPTH - 1] = *frame;
+        c->rf_flags[fifo] |= CAN_RF0R_FOVR0;
+        ok = false;
+    }
+    else
+    {
+        c->fifo[fifo][c->fill[fifo]++] = *frame;
+        if (c->fill[fifo] == HOST_CAN_FIFO_DEPTH)
+            c->rf_flags[fifo] |= CAN_RF0R_FULL0;
+    }
+    host_can_sync(hcan->Instance);
+    return ok;
+}
+
+/**
+ * 32 位过滤器格式：STID[10:0] EXID[17:0] IDE RTR 0
+ */
+static uint32_t filter_word32(const HostCan_Frame_t* f)
+{
+    return frame_ir(f);
+}
+
+/**
+ * 16 位过滤器格式：STID[10:0] RTR IDE EXID[17:15]
+ */
+static uint32_t filter_word16(const HostCan_Frame_t* f)
+{
+    const uint32_t stid = f->ide == CAN_ID_STD ? f->id : f->id >> 18;
+    const uint32_t exid = f->ide == CAN_ID_STD ? 0U : f->id >> 15 & 0x7U;
+    return (stid & 0x7FFU) << 5 | (f->rtr ? 1U << 4 : 0U) | (f->ide ? 1U << 3 : 0U) | exid;
+}
+
+/**
+ * 按 CAN1 中的过滤器组配置匹配一帧
+ *
+ * 过滤器编号按 FIFO 分别从该实例的第一个过滤器组开始计数，与过滤器组是否激活无关。
+ * 多个过滤器匹配时：32 位优先于 16 位，同位宽时列表优先于掩码，再按编号从小到大
+ * @param fmi 输出匹配的过滤器编号
+ * @return 放入的 FIFO，没有匹配时返回 -1
+ */
+static int filter_match(const CAN_TypeDef* can, const HostCan_Frame_t* f, uint8_t* fmi)
+{
+    const CAN_TypeDef* m     = CAN1;
+    const uint32_t     sb    = (m->FMR & CAN_FMR_CAN2SB) >> CAN_FMR_CAN2SB_Pos;
+    const uint32_t     first = can == CAN1 ? 0 : sb;
+    const uint32_t     last  = can == CAN1 ? sb : HOST_CAN_FILTER_BANKS;
+    const uint32_t     w32   = filter_word32(f);
+    const uint32_t     w16   = filter_word16(f);
+    uint32_t           number[2] = {0, 0};
+    uint32_t           best_rank = UINT32_MAX;
+    int                best_fifo = -1;
+
+    for (uint32_t bank = first; bank < last; bank++)
+    {
+        const uint32_t pos    = 1U << bank;
+        const uint32_t fifo   = (m->FFA1R & pos) ? 1U : 0U;
+        const bool     s32    = (m->FS1R & pos) != 0;
+        const bool     list   = (m->FM1R & pos) != 0;
+        const uint32_t fr1    = m->sFilterRegister[bank].FR1;
+        const uint32_t fr2    = m->sFilterRegister[bank].FR2;
+        const uint32_t base   = number[fifo];
+        uint32_t       hit    = UINT32_MAX;
+        number[fifo]         += s32 ? (list ? 2U : 1U) : (list ? 4U : 2U);
+        if ((m->FA1R & pos) == 0)
+            continue;
+
+        if (s32 && list)
+            hit = w32 == (fr1 & ~1U) ? base : w32 == (fr2 & ~1U) ? base + 1 : UINT32_MAX;
+        else if (s32)
+            hit = ((w32 ^ fr1) & fr2 & ~1U) == 0 ? base : UINT32_MAX;
+        else if (list)
+        {
+            const uint32_t ids[4] = {fr1 & 0xFFFFU, fr1 >> 16, fr2 & 0xFFFFU, fr2 >> 16};
+            for (uint32_t k = 0; k < 4 && hit == UINT32_MAX; k++)
+                if (w16 == ids[k])
+                    hit = base + k;
+        }
+        else
+        {
+            if (((w16 ^ fr1) & fr1 >> 16 & 0xFFFFU) == 0)
+                hit = base;
+            else if (((w16 ^ fr2) & fr2 >> 16 & 0xFFFFU) == 0)
+                hit = base + 1;
+        }
+        if (hit == UINT32_MAX)
+            continue;
+
+        const uint32_t rank = (s32 ? 0U : 1U) << 17 | (list ? 0U : 1U) << 16 | hit;
+        if (rank < best_rank)
+        {
+            best_rank = rank;
+            best_fifo = (int) fifo;
+            *fmi      = (uint8_t) hit;
+        }
+    }
+    return best_fifo;
+}
+
+/**
+ * 收到一帧，按已配置的过滤器匹配，生成 FMI 后放入对应 FIFO
+ * @param hcan can handle
+ * @param frame 帧，fmi 字段被忽略
+ * @return 放入的 FIFO，被过滤器丢弃时返回 -1
+ */
+int HostCan_ReceiveFiltered(CAN_HandleTypeDef* hcan, const HostCan_Frame_t* frame)
+{
+    HostCan_Frame_t f    = *frame;
+    const int       fifo = filter_match(hcan->Instance, frame, &f.fmi);
+    if (fifo >= 0)
+        HostCan_Receive(hcan, (uint32_t) fifo, &f);
+    return fifo;
+}
+
+/**
+ * 模拟接收中断：FIFO 非空且开启了对应中断时调用注册的 MSG_PENDING 回调
+ * @param hcan can handle
+ * @param fifo CAN_RX_FIFO0 或 CAN_RX_FIFO1
+ */
+/**
+ * 处理直接写入寄存器的操作（寄存器快速路径）
+ *
+ * 模拟器中的寄存器是普通内存，写入没有副作用，需要在此补上：RFxR 中的 RFOM 释放首帧，
+ * FULL / FOVR 写 1 清零；TIR 中新置位的 TXRQ 按 TDTR / TDLR / TDHR 请求发送。
+ * HostCan_RxIrq 和 HostCan_Transmit 在调用回调前后会自动调用本函数
+ * @param hcan can handle
+ */
+void HostCan_SyncRegisters(CAN_HandleTypeDef* hcan)
+{
+    CAN_TypeDef* can = hcan->Instance;
+    HostCan_t*   c   = host_can_bind(hcan);
+    for (uint32_t fifo = 0; fifo < 2; fifo++)
+    {
+        const uint32_t rf = *rf_reg(can, fifo);
+        if (rf & CAN_RF0R_RFOM0)
+            rf_write(can, fifo, rf);
+    }
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        const CAN_TxMailBox_TypeDef* reg = &can->sTxMailBox[i];
+        HostCan_Mailbox_t*           mb  = &c->mailbox[i];
+        if (mb->pending || (reg->TIR & CAN_TI0R_TXRQ) == 0)
+            continue;
+        const uint32_t tir = reg->TIR;
+        mb->frame          = (HostCan_Frame_t){
+                     .ide = (uint8_t) (tir & CAN_TI0R_IDE),
+                     .rtr = (uint8_t) (tir & CAN_TI0R_RTR),
+                     .dlc = (uint8_t) (reg->TDTR & CAN_TDT0R_DLC),
+        };
+        mb->frame.id = mb->frame.ide == CAN_ID_STD ? (tir & CAN_TI0R_STID) >> CAN_TI0R_STID_Pos
+                                                   : (tir & (CAN_TI0R_EXID | CAN_TI0R_STID)) >>
+                                                             CAN_TI0R_EXID_Pos;
+        if (mb->frame.dlc > 8)
+            mb->frame.dlc = 8;
+        for (uint32_t k = 0; k < 4; k++)
+        {
+            mb->frame.data[k]     = (uint8_t) (reg->TDLR >> (8 * k));
+            mb->frame.data[k + 4] = (uint8_t) (reg->TDHR >> (8 * k));
+        }
+        mb->order   = c->tx_order++;
+        mb->pending = true;
+        mb->abort   = false;
+    }
+    host_can_sync(can);
+}
+
+/**
+ * FIFO 消息挂起中断
+ *
+ * 与硬件相同，中断返回时 FIFO 仍非空会再次进入，直到 FIFO 为空或回调不再读取
+ * @param hcan can handle
+ * @param fifo CAN_RX_FIFO0 或 CAN_RX_FIFO1
+ */
+void HostCan_RxIrq(CAN_HandleTypeDef* hcan, const uint32_t fifo)
+{
+    HostCan_t*     c  = host_can_bind(hcan);
+    const uint32_t it = fifo == CAN_RX_FIFO0 ? CAN_IT_RX_FIFO0_MSG_PENDING
+                                             : CAN_IT_RX_FIFO1_MSG_PENDING;
+    const HAL_CAN_CallbackIDTypeDef id = fifo == CAN_RX_FIFO0 ? HAL_CAN_RX_FIFO0_MSG_PENDING_CB_ID
+                                                              : HAL_CAN_RX_FIFO1_MSG_PENDING_CB_ID;
+    HostCan_SyncRegisters(hcan);
+    while ((hcan->Instance->IER & it) && c->fill[fifo] > 0 && c->callbacks[id] != NULL)
+    {
+        const uint32_t fill = c->fill[fifo];
+        HostIrq_Enter();
+        c->callbacks[id](hcan);
+        HostIrq_Exit();
+        HostCan_SyncRegisters(hcan);
+        if (c->fill[fifo] >= fill)
+            break;
+    }
+}
+
+static void host_can_log(HostCan_t* c, const HostCan_Frame_t* f)
+{
+    c->log[c->log_head++ % HOST_CAN_LOG_SIZE] = *f;
+    if (c->log_head - c->log_tail > HOST_CAN_LOG_SIZE)
+        c->log_tail = c->log_head - HOST_CAN_LOG_SIZE;
+}
+
+/**
+ * 仲裁优先级，数值小的先发送
+ */
+static uint32_t arbitration_key(const HostCan_Frame_t* f)
+{
+    return frame_ir(f);
+}
+
+/**
+ * 依次处理中止请求和发送挂起的邮箱，每完成一个邮箱就调用一次对应的回调（开启了 TME 中断时）
+ *
+ * TXFP = 0 时按标识符优先级发送（相同时邮箱编号小的优先），TXFP = 1 时按请求顺序发送。
+ * 回调中写入的新帧参与后续的选择，与硬件相同
+ * @param hcan can handle，须已调用 HAL_CAN_Start
+ * @param max 最多发送的帧数
+ * @return 发送的帧数
+ */
+uint32_t HostCan_Transmit(CAN_HandleTypeDef* hcan, const uint32_t max)
+{
+    HostCan_t*   c   = host_can_bind(hcan);
+    CAN_TypeDef* can = hcan->Instance;
+    uint32_t     sent = 0;
+
+    if (hcan->State != HAL_CAN_STATE_LISTENING)
+        return 0;
+
+    HostCan_SyncRegisters(hcan);
+    while (sent < max)
+    {
+        int  index = -1;
+        bool abort = false;
+        for (uint32_t i = 0; i < 3 && index < 0; i++)
+            if (c->mailbox[i].pending && c->mailbox[i].abort)
+            {
+                index = (int) i;
+                abort = true;
+            }
+        for (uint32_t i = 0; i < 3 && !abort; i++)
+        {
+            const HostCan_Mailbox_t* mb = &c->mailbox[i];
+            if (!mb->pending)
+                continue;
+            if (index < 0)
+            {
+                index = (int) i;
+                continue;
+            }
+            const HostCan_Mailbox_t* best = &c->mailbox[index];
+            const bool               earlier =
+                (can->MCR & CAN_MCR_TXFP)
+                                  ? mb->order < best->order
+                                  : arbitration_key(&mb->frame) < arbitration_key(&best->frame);
+            if (earlier)
+                index = (int) i;
+        }
+        if (index < 0)
+            break;
+
+        HostCan_Mailbox_t* mb = &c->mailbox[index];
+        mb->pending           = false;
+        mb->abort             = false;
+        can->sTxMailBox[index].TIR &= ~CAN_TI0R_TXRQ;
+        can->TSR |= (CAN_TSR_RQCP0 | (abort ? 0U : CAN_TSR_TXOK0)) << (8 * index);
+        if (!abort)
+        {
+            host_can_log(c, &mb->frame);
+            sent++;
+        }
+        host_can_sync(can);
+
+        const HAL_CAN_CallbackIDTypeDef id =
+            (HAL_CAN_CallbackIDTypeDef) ((abort ? HAL_CAN_TX_MAILBOX0_ABORT_CB_ID
+                                                : HAL_CAN_TX_MAILBOX0_COMPLETE_CB_ID) +
+                                         index);
+        if ((can->IER & CAN_IT_TX_MAILBOX_EMPTY) && c->callbacks[id] != NULL)
+        {
+            HostIrq_Enter();
+            c->callbacks[id](hcan);
+            HostIrq_Exit();
+            HostCan_SyncRegisters(hcan);
+        }
+    }
+    return sent;
+}
+
+/**
+ * 已发送、尚未取出的帧数
+ */
+size_t HostCan_TxCount(const CAN_HandleTypeDef* hcan)
+{
+    const HostCan_t* c = host_can_of(hcan->Instance);
+    return c->log_head - c->log_tail;
+}
+
+/**
+ * 按发送顺序取出一帧
+ * @return 没有帧时返回 false
+ */
+bool HostCan_PopTx(CAN_HandleTypeDef* hcan, HostCan_Frame_t* frame)
+{
+    HostCan_t* c = host_can_of(hcan->Instance);
+    if (c->log_tail == c->log_head)
+        return false;
+    *frame = c->log[c->log_tail++ % HOST_CAN_LOG_SIZE];
+    return true;
+}
+
+/**
+ * 挂起的发送邮箱，位 i 对应邮箱 i
+ */
+uint32_t HostCan_PendingMailboxes(const CAN_HandleTypeDef* hcan)
+{
+    const HostCan_t* c    = host_can_of(hcan->Instance);
+    uint32_t         mask = 0;
+    for (uint32_t i = 0; i < 3; i++)
+        if (c->mailbox[i].pending)
+            mask |= 1U << i;
+    return mask;
+}
+
+/* TIM */
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim)
+{
+    htim->Instance->DIER |= 1U;
+    htim->Instance->CR1 |= 1U;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef* htim, const uint32_t Channel)
+{
+    htim->Instance->CCER |= 1U << Channel;
+    htim->Instance->CR1 |= 1U;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef* htim, const uint32_t Channel)
+{
+    htim->Instance->CCER &= ~(1U << Channel);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef* htim, const uint32_t Channel)
+{
+    (void) Channel;
+    htim->Instance->CR1 |= 1U;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Stop(TIM_HandleTypeDef* htim, const uint32_t Channel)
+{
+    (void) Channel;
+    htim->Instance->CR1 &= ~1U;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_RegisterCallback(TIM_HandleTypeDef*              htim,
+                                           const HAL_TIM_CallbackIDTypeDef CallbackID,
+                                           const pTIM_CallbackTypeDef      pCallback)
+{
+    if (CallbackID != HAL_TIM_PERIOD_ELAPSED_CB_ID || pCallback == NULL)
+        return HAL_ERROR;
+    htim->PeriodElapsedCallback = pCallback;
+    return HAL_OK;
+}
+
+/**
+ * 模拟定时器更新中断
+ */
+void HostTim_PeriodElapsed(TIM_HandleTypeDef* htim)
+{
+    if ((htim->Instance->DIER & 1U) && htim->PeriodElapsedCallback != NULL)
+    {
+        HostIrq_Enter();
+        htim->PeriodElapsedCallback(htim);
+        HostIrq_Exit();
+    }
+}
+
+/* GPIO */
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, const uint16_t GPIO_Pin, const GPIO_PinState PinState)
+{
+    if (PinState != GPIO_PIN_RESET)
+        GPIOx->ODR |= GPIO_Pin;
+    else
+        GPIOx->ODR &= ~(uint32_t) GPIO_Pin;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef* GPIOx, const uint16_t GPIO_Pin)
+{
+    GPIOx->ODR ^= GPIO_Pin;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(const GPIO_TypeDef* GPIOx, const uint16_t GPIO_Pin)
+{
+    return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+/**
+ * 程序启动时把模拟器复位到上电状态
+ */
+__attribute__((constructor)) static void host_hal_init(void)
+{
+    HostHal_Reset();
+}
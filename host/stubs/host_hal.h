@@ -0,0 +1,101 @@
+/**
+ * @file    host_hal.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   主机构建的 HAL 模拟器接口，供测试和基准程序驱动“硬件”
+ *
+ * CAN 模拟 bxCAN 的行为：
+ *   - 接收：每个 FIFO 3 级，满后新帧覆盖最后一帧并置位 FOVR（RFLM = 0）；
+ *     可以绕过过滤器直接放入 FIFO，也可以按已配置的过滤器组匹配并生成 FMI；
+ *     HAL_CAN_GetRxMessage 与 HAL 一样以读-改-写释放邮箱，FOVR 等写 1 清零的位会被一起清除；
+ *   - 发送：3 个邮箱，HostCan_Transmit 按 TXFP 选择的优先级发出并调用发送完成回调，
+ *     发出的帧记录在内存中，可以逐帧取出检查；
+ *   - 寄存器：RFxR / TSR 与模拟状态同步，FIFO 首帧同步到 sFIFOMailBox，
+ *     过滤器配置写入 CAN1 的过滤器寄存器。
+ *     寄存器快速路径直接读写寄存器，写入没有硬件副作用，模拟器看不到，只能单帧测试。
+ *
+ * 中断：测试线程调用 HostIrq_Enter / HostIrq_Exit 包住中断处理函数，
+ * 即可与 __disable_irq 保护的代码段互斥（见 cmsis_compiler.h）。
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "main.h"
+
+#ifndef HOST_CAN_LOG_SIZE
+/**
+ * 每条总线记录的发送帧数，超出后丢弃最旧的
+ */
+#    define HOST_CAN_LOG_SIZE (4096U)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * 模拟器使用的帧，与驱动的 CAN_Frame_t 无关
+ */
+typedef struct
+{
+    uint32_t id;  ///< StdId 或 ExtId
+    uint8_t  ide; ///< CAN_ID_STD / CAN_ID_EXT
+    uint8_t  rtr; ///< CAN_RTR_DATA / CAN_RTR_REMOTE
+    uint8_t  dlc;
+    uint8_t  fmi; ///< 接收时的 FilterMatchIndex
+    uint8_t  data[8];
+} HostCan_Frame_t;
+
+/* 系统 */
+
+void     HostHal_Reset(void);
+void     HostHal_SetTick(uint32_t tick);
+void     HostHal_AdvanceTick(uint32_t ms);
+void     HostHal_TrapErrors(bool trap);
+uint32_t HostHal_ErrorCount(void);
+
+/* CAN */
+
+bool     HostCan_Receive(CAN_HandleTypeDef* hcan, uint32_t fifo, const HostCan_Frame_t* frame);
+int      HostCan_ReceiveFiltered(CAN_HandleTypeDef* hcan, const HostCan_Frame_t* frame);
+void     HostCan_SyncRegisters(CAN_HandleTypeDef* hcan);
+void     HostCan_RxIrq(CAN_HandleTypeDef* hcan, uint32_t fifo);
+uint32_t HostCan_Transmit(CAN_HandleTypeDef* hcan, uint32_t max);
+size_t   HostCan_TxCount(const CAN_HandleTypeDef* hcan);
+bool     HostCan_PopTx(CAN_HandleTypeDef* hcan, HostCan_Frame_t* frame);
+uint32_t HostCan_PendingMailboxes(const CAN_HandleTypeDef* hcan);
+
+/* TIM */
+
+void HostTim_PeriodElapsed(TIM_HandleTypeDef* htim);
+
+/* 中断 */
+
+void HostIrq_Enter(void);
+void HostIrq_Exit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_HAL_H
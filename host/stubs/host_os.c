@@ -0,0 +1,217 @@
+/**
+ * @file    host_os.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   主机构建的 CMSIS-RTOS2 子集，线程、线程标志和互斥量基于 pthread
+ *
+ * 线程真正并行运行，没有优先级抢占；系统节拍即 HAL_GetTick，由测试控制。
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#include "cmsis_os2.h"
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "main.h"
+
+#define HOST_OS_THREAD_MAX (16U)
+#define HOST_OS_MUTEX_MAX  (16U)
+
+typedef struct
+{
+    pthread_t       tid;
+    osThreadFunc_t  func;
+    void*           argument;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    uint32_t        flags;
+} HostThread_t;
+
+static HostThread_t    threads[HOST_OS_THREAD_MAX];
+static uint32_t        thread_count = 0;
+static pthread_mutex_t thread_lock  = PTHREAD_MUTEX_INITIALIZER;
+static __thread HostThread_t* current_thread = NULL;
+
+static pthread_mutex_t mutexes[HOST_OS_MUTEX_MAX];
+static uint32_t        mutex_count = 0;
+
+static HostThread_t* thread_alloc(void)
+{
+    HostThread_t* t = NULL;
+    pthread_mutex_lock(&thread_lock);
+    if (thread_count < HOST_OS_THREAD_MAX)
+    {
+        t = &threads[thread_count++];
+        pthread_mutex_init(&t->lock, NULL);
+        pthread_cond_init(&t->cond, NULL);
+        t->flags = 0;
+    }
+    pthread_mutex_unlock(&thread_lock);
+    return t;
+}
+
+static void* thread_entry(void* arg)
+{
+    HostThread_t* t = arg;
+    current_thread  = t;
+    t->func(t->argument);
+    return NULL;
+}
+
+uint32_t osKernelGetTickCount(void)
+{
+    return HAL_GetTick();
+}
+
+osThreadId_t osThreadNew(const osThreadFunc_t func, void* argument, const osThreadAttr_t* attr)
+{
+    (void) attr;
+    HostThread_t* t = thread_alloc();
+    if (t == NULL)
+        return NULL;
+    t->func     = func;
+    t->argument = argument;
+    if (pthread_create(&t->tid, NULL, thread_entry, t) != 0)
+        return NULL;
+    pthread_detach(t->tid);
+    return t;
+}
+
+/**
+ * 当前线程，主线程等不是由 osThreadNew 创建的线程在第一次调用时登记
+ */
+osThreadId_t osThreadGetId(void)
+{
+    if (current_thread == NULL)
+    {
+        current_thread = thread_alloc();
+        if (current_thread != NULL)
+            current_thread->tid = pthread_self();
+    }
+    return current_thread;
+}
+
+void osThreadExit(void)
+{
+    pthread_exit(NULL);
+}
+
+uint32_t osThreadFlagsSet(const osThreadId_t thread_id, const uint32_t flags)
+{
+    HostThread_t* t = thread_id;
+    if (t == NULL || (flags & osFlagsError))
+        return osFlagsErrorParameter;
+    pthread_mutex_lock(&t->lock);
+    t->flags |= flags;
+    const uint32_t result = t->flags;
+    pthread_cond_broadcast(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    return result;
+}
+
+uint32_t osThreadFlagsWait(const uint32_t flags, const uint32_t options, const uint32_t timeout)
+{
+    HostThread_t* t = osThreadGetId();
+    if (t == NULL)
+        return osFlagsErrorResource;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout / 1000U;
+    deadline.tv_nsec += (long) (timeout % 1000U) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&t->lock);
+    for (;;)
+    {
+        const uint32_t set = t->flags & flags;
+        if ((options & osFlagsWaitAll) ? set == flags : set != 0)
+            break;
+        if (timeout == 0U)
+        {
+            pthread_mutex_unlock(&t->lock);
+            return osFlagsErrorResource;
+        }
+        if (timeout == osWaitForever)
+            pthread_cond_wait(&t->cond, &t->lock);
+        else if (pthread_cond_timedwait(&t->cond, &t->lock, &deadline) == ETIMEDOUT)
+        {
+            pthread_mutex_unlock(&t->lock);
+            return osFlagsErrorTimeout;
+        }
+    }
+    const uint32_t result = t->flags;
+    if ((options & osFlagsNoClear) == 0)
+        t->flags &= ~flags;
+    pthread_mutex_unlock(&t->lock);
+    return result;
+}
+
+osStatus_t osDelay(const uint32_t ticks)
+{
+    usleep(ticks * 1000U);
+    return osOK;
+}
+
+osMutexId_t osMutexNew(const osMutexAttr_t* attr)
+{
+    pthread_mutexattr_t mattr;
+    pthread_mutex_t*    m = NULL;
+
+    pthread_mutex_lock(&thread_lock);
+    if (mutex_count < HOST_OS_MUTEX_MAX)
+        m = &mutexes[mutex_count++];
+    pthread_mutex_unlock(&thread_lock);
+    if (m == NULL)
+        return NULL;
+
+    pthread_mutexattr_init(&mattr);
+    if (attr != NULL && (attr->attr_bits & osMutexRecursive))
+        pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(m, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+    return m;
+}
+
+osStatus_t osMutexAcquire(const osMutexId_t mutex_id, const uint32_t timeout)
+{
+    if (mutex_id == NULL)
+        return osErrorParameter;
+    if (timeout == 0U)
+        return pthread_mutex_trylock(mutex_id) == 0 ? osOK : osErrorResource;
+    return pthread_mutex_lock(mutex_id) == 0 ? osOK : osError;
+}
+
+osStatus_t osMutexRelease(const osMutexId_t mutex_id)
+{
+    if (mutex_id == NULL)
+        return osErrorParameter;
+    return pthread_mutex_unlock(mutex_id) == 0 ? osOK : osErrorResource;
+}
+
+osStatus_t osMutexDelete(const osMutexId_t mutex_id)
+{
+    if (mutex_id == NULL)
+        return osErrorParameter;
+    pthread_mutex_destroy(mutex_id);
+    return osOK;
+}
@@ -0,0 +1,449 @@
+/**
+ * @file    main.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   主机构建使用的 main.h 替身
+ *
+ * 只提供 UserCode 用到的 STM32F4 HAL / CMSIS 子集：
+ * CAN / TIM / GPIO 的类型、寄存器和常量与 stm32f4xx_hal 保持一致，
+ * HAL 函数由 host_hal.c 在内存中模拟，寄存器是普通的内存，没有硬件副作用。
+ * 需要模拟写 1 清零等副作用的宏（如 __HAL_CAN_CLEAR_FLAG）改为调用模拟函数。
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef MAIN_H
+#define MAIN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cmsis_compiler.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define __IO volatile
+#define __weak __attribute__((weak))
+
+typedef enum
+{
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    DISABLE = 0U,
+    ENABLE  = !DISABLE
+} FunctionalState;
+
+/* Core: DWT / CoreDebug */
+
+typedef struct
+{
+    __IO uint32_t CTRL;
+    __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type       HostDWT;
+extern CoreDebug_Type HostCoreDebug;
+extern uint32_t       SystemCoreClock;
+
+#define DWT       (&HostDWT)
+#define CoreDebug (&HostCoreDebug)
+
+#define DWT_CTRL_CYCCNTENA_Msk     (0x1UL << 0U)
+#define CoreDebug_DEMCR_TRCENA_Msk (0x1UL << 24U)
+
+/* CAN */
+
+typedef struct
+{
+    __IO uint32_t TIR;
+    __IO uint32_t TDTR;
+    __IO uint32_t TDLR;
+    __IO uint32_t TDHR;
+} CAN_TxMailBox_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t RIR;
+    __IO uint32_t RDTR;
+    __IO uint32_t RDLR;
+    __IO uint32_t RDHR;
+} CAN_FIFOMailBox_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t FR1;
+    __IO uint32_t FR2;
+} CAN_FilterRegister_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t              MCR;
+    __IO uint32_t              MSR;
+    __IO uint32_t              TSR;
+    __IO uint32_t              RF0R;
+    __IO uint32_t              RF1R;
+    __IO uint32_t              IER;
+    __IO uint32_t              ESR;
+    __IO uint32_t              BTR;
+    uint32_t                   RESERVED0[88];
+    CAN_TxMailBox_TypeDef      sTxMailBox[3];
+    CAN_FIFOMailBox_TypeDef    sFIFOMailBox[2];
+    uint32_t                   RESERVED1[12];
+    __IO uint32_t              FMR;
+    __IO uint32_t              FM1R;
+    uint32_t                   RESERVED2;
+    __IO uint32_t              FS1R;
+    uint32_t                   RESERVED3;
+    __IO uint32_t              FFA1R;
+    uint32_t                   RESERVED4;
+    __IO uint32_t              FA1R;
+    uint32_t                   RESERVED5[8];
+    CAN_FilterRegister_TypeDef sFilterRegister[28];
+} CAN_TypeDef;
+
+extern CAN_TypeDef HostCAN1, HostCAN2;
+
+#define CAN1 (&HostCAN1)
+#define CAN2 (&HostCAN2)
+
+typedef enum
+{
+    HAL_CAN_STATE_RESET         = 0x00U,
+    HAL_CAN_STATE_READY         = 0x01U,
+    HAL_CAN_STATE_LISTENING     = 0x02U,
+    HAL_CAN_STATE_SLEEP_PENDING = 0x03U,
+    HAL_CAN_STATE_SLEEP_ACTIVE  = 0x04U,
+    HAL_CAN_STATE_ERROR         = 0x05U
+} HAL_CAN_StateTypeDef;
+
+typedef struct __CAN_HandleTypeDef
+{
+    CAN_TypeDef*                  Instance;
+    __IO HAL_CAN_StateTypeDef     State;
+    __IO uint32_t                 ErrorCode;
+} CAN_HandleTypeDef;
+
+typedef struct
+{
+    uint32_t        StdId;
+    uint32_t        ExtId;
+    uint32_t        IDE;
+    uint32_t        RTR;
+    uint32_t        DLC;
+    FunctionalState TransmitGlobalTime;
+} CAN_TxHeaderTypeDef;
+
+typedef struct
+{
+    uint32_t StdId;
+    uint32_t ExtId;
+    uint32_t IDE;
+    uint32_t RTR;
+    uint32_t DLC;
+    uint32_t Timestamp;
+    uint32_t FilterMatchIndex;
+} CAN_RxHeaderTypeDef;
+
+typedef struct
+{
+    uint32_t FilterIdHigh;
+    uint32_t FilterIdLow;
+    uint32_t FilterMaskIdHigh;
+    uint32_t FilterMaskIdLow;
+    uint32_t FilterFIFOAssignment;
+    uint32_t FilterBank;
+    uint32_t FilterMode;
+    uint32_t FilterScale;
+    uint32_t FilterActivation;
+    uint32_t SlaveStartFilterBank;
+} CAN_FilterTypeDef;
+
+typedef enum
+{
+    HAL_CAN_TX_MAILBOX0_COMPLETE_CB_ID = 0x00U,
+    HAL_CAN_TX_MAILBOX1_COMPLETE_CB_ID = 0x01U,
+    HAL_CAN_TX_MAILBOX2_COMPLETE_CB_ID = 0x02U,
+    HAL_CAN_TX_MAILBOX0_ABORT_CB_ID    = 0x03U,
+    HAL_CAN_TX_MAILBOX1_ABORT_CB_ID    = 0x04U,
+    HAL_CAN_TX_MAILBOX2_ABORT_CB_ID    = 0x05U,
+    HAL_CAN_RX_FIFO0_MSG_PENDING_CB_ID = 0x06U,
+    HAL_CAN_RX_FIFO0_FULL_CB_ID        = 0x07U,
+    HAL_CAN_RX_FIFO1_MSG_PENDING_CB_ID = 0x08U,
+    HAL_CAN_RX_FIFO1_FULL_CB_ID        = 0x09U,
+    HAL_CAN_SLEEP_CB_ID                = 0x0AU,
+    HAL_CAN_WAKEUP_FROM_RX_MSG_CB_ID   = 0x0BU,
+    HAL_CAN_ERROR_CB_ID                = 0x0CU,
+    HAL_CAN_CALLBACK_NUM
+} HAL_CAN_CallbackIDTypeDef;
+
+typedef void (*pCAN_CallbackTypeDef)(CAN_HandleTypeDef* hcan);
+
+#define CAN_ID_STD     (0x00000000U)
+#define CAN_ID_EXT     (0x00000004U)
+#define CAN_RTR_DATA   (0x00000000U)
+#define CAN_RTR_REMOTE (0x00000002U)
+
+#define CAN_RX_FIFO0     (0x00000000U)
+#define CAN_RX_FIFO1     (0x00000001U)
+#define CAN_FILTER_FIFO0 (0x00000000U)
+#define CAN_FILTER_FIFO1 (0x00000001U)
+
+#define CAN_FILTERMODE_IDMASK (0x00000000U)
+#define CAN_FILTERMODE_IDLIST (0x00000001U)
+#define CAN_FILTERSCALE_16BIT (0x00000000U)
+#define CAN_FILTERSCALE_32BIT (0x00000001U)
+
+#define CAN_TX_MAILBOX0 (0x00000001U)
+#define CAN_TX_MAILBOX1 (0x00000002U)
+#define CAN_TX_MAILBOX2 (0x00000004U)
+
+#define CAN_IT_TX_MAILBOX_EMPTY     (0x00000001U)
+#define CAN_IT_RX_FIFO0_MSG_PENDING (0x00000002U)
+#define CAN_IT_RX_FIFO0_FULL        (0x00000004U)
+#define CAN_IT_RX_FIFO0_OVERRUN     (0x00000008U)
+#define CAN_IT_RX_FIFO1_MSG_PENDING (0x00000010U)
+#define CAN_IT_RX_FIFO1_FULL        (0x00000020U)
+#define CAN_IT_RX_FIFO1_OVERRUN     (0x00000040U)
+
+#define HAL_CAN_ERROR_NONE            (0x00000000U)
+#define HAL_CAN_ERROR_RX_FOV0         (0x00000200U)
+#define HAL_CAN_ERROR_RX_FOV1         (0x00000400U)
+#define HAL_CAN_ERROR_NOT_INITIALIZED (0x00040000U)
+#define HAL_CAN_ERROR_NOT_READY       (0x00080000U)
+#define HAL_CAN_ERROR_NOT_STARTED     (0x00100000U)
+#define HAL_CAN_ERROR_PARAM           (0x00200000U)
+#define HAL_CAN_ERROR_INVALID_CALLBACK (0x00400000U)
+
+/* 标志编码与 HAL 相同：高字节为寄存器 (1 MSR, 2 RF0R, 4 RF1R, 5 TSR)，低字节为位号 */
+#define CAN_FLAG_MASK (0x000000FFU)
+#define CAN_FLAG_FF0  (0x00000203U)
+#define CAN_FLAG_FOV0 (0x00000204U)
+#define CAN_FLAG_FF1  (0x00000403U)
+#define CAN_FLAG_FOV1 (0x00000404U)
+
+#define CAN_MCR_TXFP (0x1UL << 2U)
+#define CAN_MCR_RFLM (0x1UL << 3U)
+
+#define CAN_TSR_RQCP0    (0x1UL << 0U)
+#define CAN_TSR_TXOK0    (0x1UL << 1U)
+#define CAN_TSR_ABRQ0    (0x1UL << 7U)
+#define CAN_TSR_CODE_Pos (24U)
+#define CAN_TSR_CODE     (0x3UL << CAN_TSR_CODE_Pos)
+#define CAN_TSR_TME0     (0x1UL << 26U)
+#define CAN_TSR_TME1     (0x1UL << 27U)
+#define CAN_TSR_TME2     (0x1UL << 28U)
+#define CAN_TSR_TME      (0x7UL << 26U)
+
+#define CAN_RF0R_FMP0  (0x3UL << 0U)
+#define CAN_RF0R_FULL0 (0x1UL << 3U)
+#define CAN_RF0R_FOVR0 (0x1UL << 4U)
+#define CAN_RF0R_RFOM0 (0x1UL << 5U)
+#define CAN_RF1R_FMP1  (0x3UL << 0U)
+#define CAN_RF1R_FULL1 (0x1UL << 3U)
+#define CAN_RF1R_FOVR1 (0x1UL << 4U)
+#define CAN_RF1R_RFOM1 (0x1UL << 5U)
+
+#define CAN_TI0R_TXRQ     (0x1UL << 0U)
+#define CAN_TI0R_RTR      (0x1UL << 1U)
+#define CAN_TI0R_IDE      (0x1UL << 2U)
+#define CAN_TI0R_EXID_Pos (3U)
+#define CAN_TI0R_EXID     (0x3FFFFUL << CAN_TI0R_EXID_Pos)
+#define CAN_TI0R_STID_Pos (21U)
+#define CAN_TI0R_STID     (0x7FFUL << CAN_TI0R_STID_Pos)
+#define CAN_TDT0R_DLC     (0xFUL << 0U)
+
+#define CAN_RI0R_RTR       (0x1UL << 1U)
+#define CAN_RI0R_IDE       (0x1UL << 2U)
+#define CAN_RI0R_EXID_Pos  (3U)
+#define CAN_RI0R_EXID      (0x3FFFFUL << CAN_RI0R_EXID_Pos)
+#define CAN_RI0R_STID_Pos  (21U)
+#define CAN_RI0R_STID      (0x7FFUL << CAN_RI0R_STID_Pos)
+#define CAN_RDT0R_DLC      (0xFUL << 0U)
+#define CAN_RDT0R_FMI_Pos  (8U)
+#define CAN_RDT0R_FMI      (0xFFUL << CAN_RDT0R_FMI_Pos)
+#define CAN_RDT0R_TIME_Pos (16U)
+
+#define CAN_BTR_BRP     (0x3FFUL << 0U)
+#define CAN_BTR_TS1_Pos (16U)
+#define CAN_BTR_TS1     (0xFUL << CAN_BTR_TS1_Pos)
+#define CAN_BTR_TS2_Pos (20U)
+#define CAN_BTR_TS2     (0x7UL << CAN_BTR_TS2_Pos)
+
+#define CAN_FMR_FINIT      (0x1UL << 0U)
+#define CAN_FMR_CAN2SB_Pos (8U)
+#define CAN_FMR_CAN2SB     (0x3FUL << CAN_FMR_CAN2SB_Pos)
+
+void HostCan_ClearFlag(CAN_TypeDef* can, uint32_t flag);
+
+#define __HAL_CAN_GET_FLAG(__HANDLE__, __FLAG__)                                                   \
+    ((((__FLAG__) >> 8U) == 5U)   ? (((__HANDLE__)->Instance->TSR >> ((__FLAG__) & CAN_FLAG_MASK)) & 1U) \
+     : (((__FLAG__) >> 8U) == 2U) ? (((__HANDLE__)->Instance->RF0R >> ((__FLAG__) & CAN_FLAG_MASK)) & 1U) \
+     : (((__FLAG__) >> 8U) == 4U) ? (((__HANDLE__)->Instance->RF1R >> ((__FLAG__) & CAN_FLAG_MASK)) & 1U) \
+     : (((__FLAG__) >> 8U) == 1U) ? (((__HANDLE__)->Instance->MSR >> ((__FLAG__) & CAN_FLAG_MASK)) & 1U) \
+                                  : 0U)
+/* HAL 中为一次寄存器写入，这里交给模拟器处理写 1 清零 */
+#define __HAL_CAN_CLEAR_FLAG(__HANDLE__, __FLAG__) HostCan_ClearFlag((__HANDLE__)->Instance, (__FLAG__))
+
+HAL_StatusTypeDef HAL_CAN_ConfigFilter(CAN_HandleTypeDef* hcan, const CAN_FilterTypeDef* sFilterConfig);
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef* hcan);
+HAL_StatusTypeDef HAL_CAN_Stop(CAN_HandleTypeDef* hcan);
+HAL_StatusTypeDef HAL_CAN_AddTxMessage(CAN_HandleTypeDef*         hcan,
+                                       const CAN_TxHeaderTypeDef* pHeader,
+                                       const uint8_t              aData[],
+                                       uint32_t*                  pTxMailbox);
+HAL_StatusTypeDef HAL_CAN_AbortTxRequest(CAN_HandleTypeDef* hcan, uint32_t TxMailboxes);
+uint32_t          HAL_CAN_GetTxMailboxesFreeLevel(const CAN_HandleTypeDef* hcan);
+uint32_t          HAL_CAN_IsTxMessagePending(const CAN_HandleTypeDef* hcan, uint32_t TxMailboxes);
+HAL_StatusTypeDef HAL_CAN_GetRxMessage(CAN_HandleTypeDef*   hcan,
+                                       uint32_t             RxFifo,
+                                       CAN_RxHeaderTypeDef* pHeader,
+                                       uint8_t              aData[]);
+uint32_t          HAL_CAN_GetRxFifoFillLevel(const CAN_HandleTypeDef* hcan, uint32_t RxFifo);
+HAL_StatusTypeDef HAL_CAN_ActivateNotification(CAN_HandleTypeDef* hcan, uint32_t ActiveITs);
+HAL_StatusTypeDef HAL_CAN_DeactivateNotification(CAN_HandleTypeDef* hcan, uint32_t InactiveITs);
+HAL_StatusTypeDef HAL_CAN_RegisterCallback(CAN_HandleTypeDef*        hcan,
+                                           HAL_CAN_CallbackIDTypeDef CallbackID,
+                                           pCAN_CallbackTypeDef      pCallback);
+
+/* TIM */
+
+typedef struct
+{
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMCR;
+    __IO uint32_t DIER;
+    __IO uint32_t SR;
+    __IO uint32_t EGR;
+    __IO uint32_t CCMR1;
+    __IO uint32_t CCMR2;
+    __IO uint32_t CCER;
+    __IO uint32_t CNT;
+    __IO uint32_t PSC;
+    __IO uint32_t ARR;
+    __IO uint32_t RCR;
+    __IO uint32_t CCR1;
+    __IO uint32_t CCR2;
+    __IO uint32_t CCR3;
+    __IO uint32_t CCR4;
+} TIM_TypeDef;
+
+typedef struct __TIM_HandleTypeDef
+{
+    TIM_TypeDef* Instance;
+    void (*PeriodElapsedCallback)(struct __TIM_HandleTypeDef* htim);
+} TIM_HandleTypeDef;
+
+typedef enum
+{
+    HAL_TIM_PERIOD_ELAPSED_CB_ID = 0x0EU,
+} HAL_TIM_CallbackIDTypeDef;
+
+typedef void (*pTIM_CallbackTypeDef)(TIM_HandleTypeDef* htim);
+
+#define TIM_CHANNEL_1   (0x00000000U)
+#define TIM_CHANNEL_2   (0x00000004U)
+#define TIM_CHANNEL_3   (0x00000008U)
+#define TIM_CHANNEL_4   (0x0000000CU)
+#define TIM_CHANNEL_ALL (0x0000003CU)
+
+#define __HAL_TIM_GET_COUNTER(__HANDLE__)        ((__HANDLE__)->Instance->CNT)
+#define __HAL_TIM_SET_COUNTER(__HANDLE__, __V__) ((__HANDLE__)->Instance->CNT = (__V__))
+#define __HAL_TIM_GET_AUTORELOAD(__HANDLE__)     ((__HANDLE__)->Instance->ARR)
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__)                                \
+    ((__CHANNEL__) == TIM_CHANNEL_1   ? ((__HANDLE__)->Instance->CCR1 = (__COMPARE__))             \
+     : (__CHANNEL__) == TIM_CHANNEL_2 ? ((__HANDLE__)->Instance->CCR2 = (__COMPARE__))             \
+     : (__CHANNEL__) == TIM_CHANNEL_3 ? ((__HANDLE__)->Instance->CCR3 = (__COMPARE__))             \
+                                      : ((__HANDLE__)->Instance->CCR4 = (__COMPARE__)))
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef* htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef* htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef* htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_Encoder_Stop(TIM_HandleTypeDef* htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_RegisterCallback(TIM_HandleTypeDef*        htim,
+                                           HAL_TIM_CallbackIDTypeDef CallbackID,
+                                           pTIM_CallbackTypeDef      pCallback);
+
+/* GPIO */
+
+typedef struct
+{
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+extern GPIO_TypeDef HostGPIOA, HostGPIOB, HostGPIOC, HostGPIOD, HostGPIOE;
+
+#define GPIOA (&HostGPIOA)
+#define GPIOB (&HostGPIOB)
+#define GPIOC (&HostGPIOC)
+#define GPIOD (&HostGPIOD)
+#define GPIOE (&HostGPIOE)
+
+#define GPIO_PIN_0  ((uint16_t) 0x0001)
+#define GPIO_PIN_1  ((uint16_t) 0x0002)
+#define GPIO_PIN_2  ((uint16_t) 0x0004)
+#define GPIO_PIN_3  ((uint16_t) 0x0008)
+#define GPIO_PIN_4  ((uint16_t) 0x0010)
+#define GPIO_PIN_5  ((uint16_t) 0x0020)
+#define GPIO_PIN_6  ((uint16_t) 0x0040)
+#define GPIO_PIN_7  ((uint16_t) 0x0080)
+#define GPIO_PIN_8  ((uint16_t) 0x0100)
+#define GPIO_PIN_9  ((uint16_t) 0x0200)
+#define GPIO_PIN_10 ((uint16_t) 0x0400)
+#define GPIO_PIN_11 ((uint16_t) 0x0800)
+#define GPIO_PIN_12 ((uint16_t) 0x1000)
+#define GPIO_PIN_13 ((uint16_t) 0x2000)
+#define GPIO_PIN_14 ((uint16_t) 0x4000)
+#define GPIO_PIN_15 ((uint16_t) 0x8000)
+
+void          HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void          HAL_GPIO_TogglePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
+GPIO_PinState HAL_GPIO_ReadPin(const GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
+
+/* System */
+
+uint32_t HAL_GetTick(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+void     Error_Handler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAIN_H
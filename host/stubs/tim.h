@@ -0,0 +1,14 @@
+/**
+ * @file    tim.h
+ * @brief   主机构建使用的 tim.h 替身，对应 CubeMX 生成的定时器句柄
+ */
+#ifndef TIM_H_HOST
+#define TIM_H_HOST
+
+#include "main.h"
+
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim6;
+extern TIM_HandleTypeDef htim8;
+
+#endif // TIM_H_HOST
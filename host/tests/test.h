@@ -0,0 +1,88 @@
+/**
+ * @file    test.h
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   主机测试使用的最小测试框架
+ *
+ * 每个测试文件是一个独立的可执行程序（驱动内部的静态状态无法在用例之间复位），
+ * 在 main 中用 TEST_RUN 依次运行用例，最后 return TEST_RESULT()：
+ *
+ *   static void test_xxx(void) { TEST_CHECK(a == b); }
+ *   int main(void) { TEST_RUN(test_xxx); return TEST_RESULT(); }
+ *
+ * 检查失败时打印位置并继续运行，程序返回值非 0 即表示失败，由 ctest 收集。
+ *
+ * --------------------------------------------------------------------------
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Project repository: https://github.com/HITSZ-WTR2026/motor_drivers
+ */
+#ifndef TEST_H
+#define TEST_H
+
+#include <math.h>
+#include <stdio.h>
+
+static int test_failures = 0; ///< 失败的检查数
+static int test_cases    = 0; ///< 运行的用例数
+
+#define TEST_CHECK(__COND__)                                                                       \
+    do                                                                                             \
+    {                                                                                              \
+        if (!(__COND__))                                                                           \
+        {                                                                                          \
+            test_failures++;                                                                       \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #__COND__);                    \
+        }                                                                                          \
+    } while (0)
+
+#define TEST_CHECK_EQ(__A__, __B__)                                                                \
+    do                                                                                             \
+    {                                                                                              \
+        const long long __test_a = (long long) (__A__);                                            \
+        const long long __test_b = (long long) (__B__);                                            \
+        if (__test_a != __test_b)                                                                  \
+        {                                                                                          \
+            test_failures++;                                                                       \
+            printf("%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #__A__,   \
+                   #__B__, __test_a, __test_b);                                                    \
+        }                                                                                          \
+    } while (0)
+
+#define TEST_CHECK_NEAR(__A__, __B__, __TOL__)                                                     \
+    do                                                                                             \
+    {                                                                                              \
+        const double __test_a = (double) (__A__);                                                  \
+        const double __test_b = (double) (__B__);                                                  \
+        if (!(fabs(__test_a - __test_b) <= (__TOL__)))                                             \
+        {                                                                                          \
+            test_failures++;                                                                       \
+            printf("%s:%d: check failed: %s ~= %s (%g vs %g, tol %g)\n", __FILE__, __LINE__,       \
+                   #__A__, #__B__, __test_a, __test_b, (double) (__TOL__));                        \
+        }                                                                                          \
+    } while (0)
+
+#define TEST_RUN(__FUNC__)                                                                         \
+    do                                                                                             \
+    {                                                                                              \
+        const int __test_before = test_failures;                                                   \
+        test_cases++;                                                                              \
+        __FUNC__();                                                                                \
+        printf("[%s] %s\n", test_failures == __test_before ? " OK " : "FAIL", #__FUNC__);          \
+    } while (0)
+
+#define TEST_RESULT()                                                                              \
+    (printf("%d cases, %d failed checks\n", test_cases, test_failures), test_failures != 0)
+
+#endif // TEST_H
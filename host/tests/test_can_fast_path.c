@@ -0,0 +1,140 @@
+/**
+ * @file    test_can_fast_path.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   寄存器快速路径 (USE_CAN_FAST_PATH)：收发内容与 HAL 路径一致，释放邮箱不清除 FOVR
+ *
+ * 快速路径直接写寄存器，模拟器在 HostCan_SyncRegisters 中补上写入的副作用，
+ * 因此一次中断只能读出一帧（读出后 FMP 读为 0），HostCan_RxIrq 会像硬件一样重复进入中断
+ */
+#include <string.h>
+#include "bsp/can_driver.h"
+#include "can.h"
+#include "host_hal.h"
+#include "test.h"
+
+#ifndef USE_CAN_FAST_PATH
+#    error "test_can_fast_path must be built with USE_CAN_FAST_PATH"
+#endif
+
+static CAN_Frame_t decoded[8];
+static uint32_t    decoded_n = 0;
+
+static void record_decoder(void* handle, const CAN_Frame_t* frame)
+{
+    (void) handle;
+    if (decoded_n < 8)
+        decoded[decoded_n++] = *frame;
+}
+
+static void test_read_frame(void)
+{
+    const HostCan_Frame_t in[3] = {
+        {.id = 0x201, .ide = CAN_ID_STD, .dlc = 8, .fmi = 5, .data = {1, 2, 3, 4, 5, 6, 7, 8}},
+        {.id = 0x1ABCDE01, .ide = CAN_ID_EXT, .dlc = 3, .data = {0xAA, 0xBB, 0xCC}},
+        {.id = 0x7FF, .ide = CAN_ID_STD, .rtr = CAN_RTR_REMOTE, .dlc = 0},
+    };
+    HAL_CAN_Start(&hcan1);
+    for (int i = 0; i < 3; i++)
+        HostCan_Receive(&hcan1, CAN_RX_FIFO0, &in[i]);
+
+    for (int i = 0; i < 3; i++)
+    {
+        CAN_Frame_t frame;
+        TEST_CHECK(CAN_ReadFrame(&hcan1, CAN_RX_FIFO0, &frame));
+        TEST_CHECK_EQ(frame.id, in[i].id);
+        TEST_CHECK_EQ(frame.ide, in[i].ide);
+        TEST_CHECK_EQ(frame.rtr, in[i].rtr);
+        TEST_CHECK_EQ(frame.dlc, in[i].dlc);
+        TEST_CHECK_EQ(frame.fmi, in[i].fmi);
+        TEST_CHECK(memcmp(frame.data, in[i].data, in[i].dlc) == 0);
+        // 只写了 RFOM
+        TEST_CHECK_EQ(CAN1->RF0R, CAN_RF0R_RFOM0);
+        HostCan_SyncRegisters(&hcan1);
+    }
+    TEST_CHECK_EQ(HAL_CAN_GetRxFifoFillLevel(&hcan1, CAN_RX_FIFO0), 0);
+}
+
+static void test_release_keeps_overrun(void)
+{
+    const HostCan_Frame_t f = {.id = 0x202, .ide = CAN_ID_STD, .dlc = 8};
+    for (int i = 0; i < 4; i++)
+        HostCan_Receive(&hcan1, CAN_RX_FIFO0, &f);
+    TEST_CHECK(__HAL_CAN_GET_FLAG(&hcan1, CAN_FLAG_FOV0));
+
+    CAN_Frame_t frame;
+    TEST_CHECK(CAN_ReadFrame(&hcan1, CAN_RX_FIFO0, &frame));
+    HostCan_SyncRegisters(&hcan1);
+    TEST_CHECK_EQ(HAL_CAN_GetRxFifoFillLevel(&hcan1, CAN_RX_FIFO0), 2);
+    TEST_CHECK(__HAL_CAN_GET_FLAG(&hcan1, CAN_FLAG_FOV0));
+
+    TEST_CHECK(CAN_TakeRxOverrun(&hcan1, CAN_RX_FIFO0));
+    TEST_CHECK(!CAN_TakeRxOverrun(&hcan1, CAN_RX_FIFO0));
+    TEST_CHECK_EQ(HAL_CAN_GetRxFifoFillLevel(&hcan1, CAN_RX_FIFO0), 2);
+    while (CAN_ReadFrame(&hcan1, CAN_RX_FIFO0, &frame))
+        HostCan_SyncRegisters(&hcan1);
+}
+
+static void test_dispatch(void)
+{
+    HostHal_Reset();
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    HAL_CAN_RegisterCallback(&hcan1, HAL_CAN_RX_FIFO0_MSG_PENDING_CB_ID, CAN_Fifo0ReceiveCallback);
+    CAN_RegisterRoute(&hcan1, CAN_ID_STD, 0x201, record_decoder, NULL);
+    CAN_RegisterRoute(&hcan1, CAN_ID_EXT, 0x0901, record_decoder, NULL);
+
+    const HostCan_Frame_t a = {.id = 0x201, .ide = CAN_ID_STD, .dlc = 8, .data = {9}};
+    const HostCan_Frame_t b = {.id = 0x0901, .ide = CAN_ID_EXT, .dlc = 8, .data = {7}};
+    HostCan_Receive(&hcan1, CAN_RX_FIFO0, &a);
+    HostCan_Receive(&hcan1, CAN_RX_FIFO0, &b);
+    HostCan_RxIrq(&hcan1, CAN_RX_FIFO0);
+
+    TEST_CHECK_EQ(decoded_n, 2);
+    TEST_CHECK_EQ(decoded[0].id, 0x201);
+    TEST_CHECK_EQ(decoded[0].data[0], 9);
+    TEST_CHECK_EQ(decoded[1].id, 0x0901);
+    TEST_CHECK_EQ(decoded[1].ide, CAN_ID_EXT);
+    TEST_CHECK_EQ(decoded[1].data[0], 7);
+}
+
+static void test_send(void)
+{
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        const CAN_TxHeaderTypeDef header = {
+            .StdId = 0x300 + i,
+            .ExtId = 0x1000000 + i,
+            .IDE   = i % 2 ? CAN_ID_EXT : CAN_ID_STD,
+            .DLC   = 4,
+        };
+        const uint8_t data[8] = {(uint8_t) i, 0x11, 0x22, 0x33};
+        TEST_CHECK_EQ(CAN_SendMessage(&hcan1, &header, data),
+                      i < 3 ? CAN_TX_MAILBOX0 << i : CAN_SEND_QUEUED);
+        // 邮箱只在寄存器中写入，同步后模拟器才会看到
+        HostCan_SyncRegisters(&hcan1);
+    }
+    TEST_CHECK_EQ(HostCan_Transmit(&hcan1, 16), 4);
+
+    uint32_t        seen = 0;
+    HostCan_Frame_t f;
+    while (HostCan_PopTx(&hcan1, &f))
+    {
+        const uint32_t i = f.data[0];
+        TEST_CHECK(i < 4);
+        TEST_CHECK_EQ(f.ide, i % 2 ? CAN_ID_EXT : CAN_ID_STD);
+        TEST_CHECK_EQ(f.id, i % 2 ? 0x1000000 + i : 0x300 + i);
+        TEST_CHECK_EQ(f.dlc, 4);
+        TEST_CHECK_EQ(f.data[3], 0x33);
+        seen |= 1U << i;
+    }
+    TEST_CHECK_EQ(seen, 0xF);
+}
+
+int main(void)
+{
+    TEST_RUN(test_read_frame);
+    TEST_RUN(test_release_keeps_overrun);
+    TEST_RUN(test_dispatch);
+    TEST_RUN(test_send);
+    return TEST_RESULT();
+}
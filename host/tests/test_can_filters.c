@@ -0,0 +1,164 @@
+/**
+ * @file    test_can_filters.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   CAN_ConfigFilters 的过滤器打包（按模拟器的 bxCAN 过滤器匹配模型检查）和
+ *          FilterMatchIndex 回调表的越界检查
+ */
+#include <string.h>
+#include "bsp/can_driver.h"
+#include "can.h"
+#include "host_hal.h"
+#include "test.h"
+
+static uint32_t fmi_calls = 0;
+
+static void null_decoder(void* handle, const CAN_Frame_t* frame)
+{
+    (void) handle;
+    (void) frame;
+}
+
+static void fmi_callback(CAN_HandleTypeDef* hcan, CAN_RxHeaderTypeDef* header, uint8_t data[])
+{
+    fmi_calls++;
+}
+
+/**
+ * 帧是否被过滤器放行（放行后从 FIFO 中取出）
+ */
+static bool accepted(CAN_HandleTypeDef* hcan, const uint32_t ide, const uint32_t id)
+{
+    const HostCan_Frame_t f = {.id = id, .ide = (uint8_t) ide, .dlc = 8};
+    const int             fifo = HostCan_ReceiveFiltered(hcan, &f);
+    if (fifo < 0)
+        return false;
+    CAN_RxHeaderTypeDef header;
+    uint8_t             data[8];
+    HAL_CAN_GetRxMessage(hcan, (uint32_t) fifo, &header, data);
+    return fifo == CAN_RX_FIFO0;
+}
+
+static uint32_t std_id(const uint32_t i)
+{
+    return 0x100 + i * 7;
+}
+
+static uint32_t ext_id(const uint32_t i)
+{
+    return 0x2000 + i * 0x101;
+}
+
+static void register_ids(CAN_HandleTypeDef* hcan, const uint32_t n_std, const uint32_t n_ext)
+{
+    for (uint32_t i = 0; i < n_std; i++)
+        CAN_RegisterRoute(hcan, CAN_ID_STD, std_id(i), null_decoder, NULL);
+    for (uint32_t i = 0; i < n_ext; i++)
+        CAN_RegisterRoute(hcan, CAN_ID_EXT, ext_id(i), null_decoder, NULL);
+}
+
+/**
+ * ID 较少时全部打包为列表，只放行注册的 ID
+ */
+static void test_list_exact(void)
+{
+    HostHal_Reset();
+    register_ids(&hcan1, 6, 3);
+    register_ids(&hcan2, 5, 0);
+    CAN_ConfigFilters(CAN_FILTER_FIFO0);
+    HAL_CAN_Start(&hcan1);
+    HAL_CAN_Start(&hcan2);
+
+    uint32_t hits1 = 0, hits2 = 0;
+    for (uint32_t id = 0; id <= 0x7FF; id++)
+    {
+        hits1 += accepted(&hcan1, CAN_ID_STD, id);
+        hits2 += accepted(&hcan2, CAN_ID_STD, id);
+    }
+    TEST_CHECK_EQ(hits1, 6);
+    TEST_CHECK_EQ(hits2, 5);
+    for (uint32_t i = 0; i < 6; i++)
+        TEST_CHECK(accepted(&hcan1, CAN_ID_STD, std_id(i)));
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        TEST_CHECK(accepted(&hcan1, CAN_ID_EXT, ext_id(i)));
+        TEST_CHECK(!accepted(&hcan1, CAN_ID_EXT, ext_id(i) + 1));
+        TEST_CHECK(!accepted(&hcan2, CAN_ID_EXT, ext_id(i)));
+    }
+    // 标准帧 ID 与扩展帧 ID 数值相同时不能混淆
+    TEST_CHECK(!accepted(&hcan1, CAN_ID_EXT, std_id(0)));
+}
+
+/**
+ * 过滤器组不够时合并为掩码：注册的 ID 仍全部放行，额外放行的 ID 有限
+ */
+static void test_mask_merge(void)
+{
+    HostHal_Reset();
+    // 累计 CAN1 90 个标准帧 + 30 个扩展帧，CAN2 60 个标准帧，列表需要 23 + 15 + 15 组
+    register_ids(&hcan1, 90, 30);
+    register_ids(&hcan2, 60, 0);
+    CAN_ConfigFilters(CAN_FILTER_FIFO0);
+    HAL_CAN_Start(&hcan1);
+    HAL_CAN_Start(&hcan2);
+
+    for (uint32_t i = 0; i < 90; i++)
+        TEST_CHECK(accepted(&hcan1, CAN_ID_STD, std_id(i)));
+    for (uint32_t i = 0; i < 30; i++)
+        TEST_CHECK(accepted(&hcan1, CAN_ID_EXT, ext_id(i)));
+    for (uint32_t i = 0; i < 60; i++)
+        TEST_CHECK(accepted(&hcan2, CAN_ID_STD, std_id(i)));
+
+    uint32_t extra1 = 0, extra2 = 0;
+    for (uint32_t id = 0; id <= 0x7FF; id++)
+    {
+        const bool registered1 = id >= 0x100 && (id - 0x100) % 7 == 0 && (id - 0x100) / 7 < 90;
+        const bool registered2 = id >= 0x100 && (id - 0x100) % 7 == 0 && (id - 0x100) / 7 < 60;
+        extra1 += accepted(&hcan1, CAN_ID_STD, id) && !registered1;
+        extra2 += accepted(&hcan2, CAN_ID_STD, id) && !registered2;
+    }
+    printf("extra std ids accepted: CAN1 %u, CAN2 %u\n", extra1, extra2);
+    // 不超过标准帧 ID 空间的 1/4
+    TEST_CHECK(extra1 < 512);
+    TEST_CHECK(extra2 < 512);
+}
+
+/**
+ * FilterMatchIndex 超出回调表时拒绝注册，收到时按未处理计数
+ */
+static void test_fmi_bound(void)
+{
+    HostHal_Reset();
+    HostHal_TrapErrors(false);
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO1_MSG_PENDING);
+    HAL_CAN_RegisterCallback(&hcan1, HAL_CAN_RX_FIFO1_MSG_PENDING_CB_ID, CAN_Fifo1ReceiveCallback);
+
+    CAN_RegisterCallback(&hcan1, CAN_CALLBACK_NUM - 1, fmi_callback);
+    TEST_CHECK_EQ(HostHal_ErrorCount(), 0);
+    CAN_RegisterCallback(&hcan1, CAN_CALLBACK_NUM, fmi_callback);
+    TEST_CHECK_EQ(HostHal_ErrorCount(), 1);
+    CAN_UnregisterCallback(&hcan1, 111);
+    TEST_CHECK_EQ(HostHal_ErrorCount(), 2);
+
+    CAN_RxStats_t before;
+    CAN_GetRxStats(&hcan1, &before);
+    const HostCan_Frame_t in_range  = {.id = 0x7F0, .ide = CAN_ID_STD, .fmi = CAN_CALLBACK_NUM - 1};
+    const HostCan_Frame_t out_range = {.id = 0x7F1, .ide = CAN_ID_STD, .fmi = 111};
+    HostCan_Receive(&hcan1, CAN_RX_FIFO1, &in_range);
+    HostCan_Receive(&hcan1, CAN_RX_FIFO1, &out_range);
+    HostCan_RxIrq(&hcan1, CAN_RX_FIFO1);
+
+    CAN_RxStats_t stats;
+    CAN_GetRxStats(&hcan1, &stats);
+    TEST_CHECK_EQ(fmi_calls, 1);
+    TEST_CHECK_EQ(stats.frames[1] - before.frames[1], 2);
+    TEST_CHECK_EQ(stats.unhandled[1] - before.unhandled[1], 1);
+}
+
+int main(void)
+{
+    TEST_RUN(test_list_exact);
+    TEST_RUN(test_mask_merge);
+    TEST_RUN(test_fmi_bound);
+    return TEST_RESULT();
+}
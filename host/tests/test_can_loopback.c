@@ -0,0 +1,177 @@
+/**
+ * @file    test_can_loopback.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   can_driver 经 HAL 路径收发：中断读空 FIFO 并按路由分发，发送队列经邮箱完成回调发出
+ */
+#include <string.h>
+#include "bsp/can_driver.h"
+#include "can.h"
+#include "host_hal.h"
+#include "test.h"
+
+static uint32_t decoded[8];
+static uint32_t decoded_n = 0;
+
+static void record_decoder(void* handle, const CAN_Frame_t* frame)
+{
+    (void) handle;
+    if (decoded_n < 8)
+        decoded[decoded_n++] = frame->id;
+}
+
+static void test_receive(void)
+{
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    HAL_CAN_RegisterCallback(&hcan1, HAL_CAN_RX_FIFO0_MSG_PENDING_CB_ID, CAN_Fifo0ReceiveCallback);
+    CAN_RegisterRoute(&hcan1, CAN_ID_STD, 0x201, record_decoder, NULL);
+    CAN_RegisterRoute(&hcan1, CAN_ID_STD, 0x202, record_decoder, NULL);
+
+    const HostCan_Frame_t a = {.id = 0x201, .ide = CAN_ID_STD, .dlc = 8};
+    const HostCan_Frame_t b = {.id = 0x202, .ide = CAN_ID_STD, .dlc = 8};
+    const HostCan_Frame_t c = {.id = 0x203, .ide = CAN_ID_STD, .dlc = 8};
+    HostCan_Receive(&hcan1, CAN_RX_FIFO0, &a);
+    HostCan_Receive(&hcan1, CAN_RX_FIFO0, &b);
+    HostCan_Receive(&hcan1, CAN_RX_FIFO0, &c);
+    HostCan_RxIrq(&hcan1, CAN_RX_FIFO0);
+
+    // 一次中断读空 FIFO
+    TEST_CHECK_EQ(HAL_CAN_GetRxFifoFillLevel(&hcan1, CAN_RX_FIFO0), 0);
+    TEST_CHECK_EQ(decoded_n, 2);
+    TEST_CHECK_EQ(decoded[0], 0x201);
+    TEST_CHECK_EQ(decoded[1], 0x202);
+
+    CAN_RxStats_t stats;
+    CAN_GetRxStats(&hcan1, &stats);
+    TEST_CHECK_EQ(stats.frames[0], 3);
+    TEST_CHECK_EQ(stats.irqs[0], 1);
+    TEST_CHECK_EQ(stats.max_batch[0], 3);
+    TEST_CHECK_EQ(stats.unhandled[0], 1);
+}
+
+static void test_overrun(void)
+{
+    CAN_RxStats_t before;
+    CAN_GetRxStats(&hcan1, &before);
+    decoded_n = 0;
+    // 第 4 帧到达时 FIFO 已满，溢出
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        const HostCan_Frame_t f = {.id = 0x201, .ide = CAN_ID_STD, .dlc = 8};
+        HostCan_Receive(&hcan1, CAN_RX_FIFO0, &f);
+    }
+    HostCan_RxIrq(&hcan1, CAN_RX_FIFO0);
+
+    CAN_RxStats_t stats;
+    CAN_GetRxStats(&hcan1, &stats);
+    TEST_CHECK_EQ(stats.frames[0] - before.frames[0], 3);
+    TEST_CHECK_EQ(stats.overrun[0] - before.overrun[0], 1);
+    TEST_CHECK_EQ(decoded_n, 3);
+    TEST_CHECK(!__HAL_CAN_GET_FLAG(&hcan1, CAN_FLAG_FOV0));
+
+    // 没有溢出时不计数
+    const HostCan_Frame_t f = {.id = 0x202, .ide = CAN_ID_STD, .dlc = 8};
+    HostCan_Receive(&hcan1, CAN_RX_FIFO0, &f);
+    HostCan_RxIrq(&hcan1, CAN_RX_FIFO0);
+    CAN_GetRxStats(&hcan1, &stats);
+    TEST_CHECK_EQ(stats.overrun[0] - before.overrun[0], 1);
+}
+
+static void record_frame(const CAN_HandleTypeDef* hcan, const CAN_Frame_t* frame)
+{
+    if (hcan == &hcan1 && decoded_n < 8)
+        decoded[decoded_n++] = frame->id;
+}
+
+/**
+ * 驱动自己的 FIFO 回调：不经过路由表，逐帧交给驱动，溢出和批量与 CAN_Fifo1ReceiveCallback 一样统计
+ */
+static void test_drain_fifo(void)
+{
+    CAN_RxStats_t before;
+    CAN_GetRxStats(&hcan1, &before);
+    decoded_n = 0;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        const HostCan_Frame_t f = {.id = 0x210 + i, .ide = CAN_ID_STD, .dlc = 8};
+        HostCan_Receive(&hcan1, CAN_RX_FIFO1, &f);
+    }
+    CAN_DrainFifo(&hcan1, CAN_RX_FIFO1, record_frame);
+
+    TEST_CHECK_EQ(HAL_CAN_GetRxFifoFillLevel(&hcan1, CAN_RX_FIFO1), 0);
+    TEST_CHECK_EQ(decoded_n, 3);
+    TEST_CHECK_EQ(decoded[0], 0x210);
+    // RFLM = 0：溢出的新帧覆盖最后一帧
+    TEST_CHECK_EQ(decoded[2], 0x213);
+
+    CAN_RxStats_t stats;
+    CAN_GetRxStats(&hcan1, &stats);
+    TEST_CHECK_EQ(stats.frames[1] - before.frames[1], 3);
+    TEST_CHECK_EQ(stats.irqs[1] - before.irqs[1], 1);
+    TEST_CHECK_EQ(stats.overrun[1] - before.overrun[1], 1);
+    TEST_CHECK_EQ(stats.unhandled[1], before.unhandled[1]);
+    TEST_CHECK(!__HAL_CAN_GET_FLAG(&hcan1, CAN_FLAG_FOV1));
+}
+
+static void test_send(void)
+{
+    // 前 3 帧直接写入邮箱，返回邮箱编号，其余入队
+    static const uint32_t expect[5] = {
+        CAN_TX_MAILBOX0, CAN_TX_MAILBOX1, CAN_TX_MAILBOX2, CAN_SEND_QUEUED, CAN_SEND_QUEUED,
+    };
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        const CAN_TxHeaderTypeDef header  = {.StdId = 0x300 + i, .IDE = CAN_ID_STD, .DLC = 2};
+        const uint8_t             data[8] = {(uint8_t) i, 0xA5};
+        TEST_CHECK_EQ(CAN_SendMessage(&hcan1, &header, data), expect[i]);
+    }
+    // 3 帧进入邮箱，2 帧在队列中
+    CAN_TxQueueStats_t stats;
+    CAN_GetTxQueueStats(&hcan1, &stats);
+    TEST_CHECK_EQ(stats.depth, 2);
+    TEST_CHECK_EQ(HostCan_PendingMailboxes(&hcan1), 7);
+
+    // 邮箱完成回调把队列中的帧补进邮箱
+    TEST_CHECK_EQ(HostCan_Transmit(&hcan1, 16), 5);
+    CAN_GetTxQueueStats(&hcan1, &stats);
+    TEST_CHECK_EQ(stats.depth, 0);
+
+    uint32_t        seen = 0;
+    HostCan_Frame_t f;
+    while (HostCan_PopTx(&hcan1, &f))
+    {
+        TEST_CHECK(f.id >= 0x300 && f.id < 0x305);
+        TEST_CHECK_EQ(f.dlc, 2);
+        TEST_CHECK_EQ(f.data[0], f.id - 0x300);
+        TEST_CHECK_EQ(f.data[1], 0xA5);
+        seen |= 1U << (f.id - 0x300);
+    }
+    TEST_CHECK_EQ(seen, 0x1F);
+}
+
+static void test_send_cached(void)
+{
+    CAN_TxCache_t             cache;
+    const CAN_TxHeaderTypeDef header  = {.StdId = 0x310, .IDE = CAN_ID_STD, .DLC = 8};
+    const uint8_t             data[8] = {1, 2, 3};
+    HostCan_Frame_t           f;
+
+    CAN_TxCache_Init(&cache, 50);
+    TEST_CHECK_EQ(CAN_SendMessageCached(&cache, &hcan1, &header, data), CAN_TX_MAILBOX0);
+    TEST_CHECK_EQ(CAN_SendMessageCached(&cache, &hcan1, &header, data), CAN_SEND_SUPPRESSED);
+    TEST_CHECK_EQ(cache.sent, 1);
+    TEST_CHECK_EQ(cache.suppressed, 1);
+    HostCan_Transmit(&hcan1, 16);
+    TEST_CHECK(HostCan_PopTx(&hcan1, &f) && f.id == 0x310);
+    TEST_CHECK(!HostCan_PopTx(&hcan1, &f));
+}
+
+int main(void)
+{
+    TEST_RUN(test_receive);
+    TEST_RUN(test_overrun);
+    TEST_RUN(test_drain_fifo);
+    TEST_RUN(test_send);
+    TEST_RUN(test_send_cached);
+    return TEST_RESULT();
+}
@@ -0,0 +1,160 @@
+/**
+ * @file    test_can_trace.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   CAN trace 导出的文件头、回放时的文件头检查，以及 candump 文本转换
+ */
+#include <string.h>
+#include "bsp/can_driver.h"
+#include "can.h"
+#include "host_hal.h"
+#include "test.h"
+
+#ifndef USE_CAN_TRACE
+#    error "test_can_trace needs the trace variant"
+#endif
+
+static uint32_t decoded[8];
+static uint32_t decoded_n = 0;
+
+static void record_decoder(void* handle, const CAN_Frame_t* frame)
+{
+    (void) handle;
+    if (decoded_n < 8)
+        decoded[decoded_n++] = frame->id;
+}
+
+static uint32_t file[64]; ///< 导出的文件，按 4 字节对齐
+
+/**
+ * 记录 2 帧接收和 1 帧发送，导出后检查文件头
+ */
+static size_t record_and_export(void)
+{
+    CAN_Trace_Start();
+
+    const HostCan_Frame_t a = {.id = 0x201, .ide = CAN_ID_STD, .dlc = 8, .data = {1, 2}};
+    const HostCan_Frame_t b = {.id = 0x202, .ide = CAN_ID_STD, .dlc = 8, .data = {3, 4}};
+    HostCan_Receive(&hcan1, CAN_RX_FIFO0, &a);
+    HostCan_Receive(&hcan1, CAN_RX_FIFO0, &b);
+    HostCan_RxIrq(&hcan1, CAN_RX_FIFO0);
+
+    const CAN_TxHeaderTypeDef header  = {.StdId = 0x200, .IDE = CAN_ID_STD, .DLC = 8};
+    const uint8_t             data[8] = {0};
+    CAN_SendMessage(&hcan1, &header, data);
+    HostCan_Transmit(&hcan1, 4);
+    while (HostCan_PopTx(&hcan1, &(HostCan_Frame_t) {0}))
+        ;
+
+    CAN_Trace_Stop();
+    return CAN_Trace_Export(file, sizeof(file));
+}
+
+static void test_export_header(void)
+{
+    const size_t size = record_and_export();
+    TEST_CHECK_EQ(size, sizeof(CAN_TraceHeader_t) + 3 * sizeof(CAN_TraceRecord_t));
+
+    CAN_TraceHeader_t header;
+    memcpy(&header, file, sizeof(header));
+    TEST_CHECK_EQ(header.magic, CAN_TRACE_MAGIC);
+    TEST_CHECK_EQ(header.version, CAN_TRACE_VERSION);
+    TEST_CHECK_EQ(header.record_size, sizeof(CAN_TraceRecord_t));
+    TEST_CHECK_EQ(header.count, 3);
+
+    const CAN_TraceRecord_t* records;
+    size_t                   count;
+    TEST_CHECK(CAN_Trace_ParseFile(file, size, &records, &count));
+    TEST_CHECK_EQ(count, 3);
+    TEST_CHECK_EQ(records[0].id, 0x201);
+    TEST_CHECK_EQ(records[1].id, 0x202);
+    TEST_CHECK_EQ(records[1].data[0], 3);
+    TEST_CHECK_EQ(records[2].id, 0x200 | CAN_TRACE_FLAG_TX);
+
+    // 空间不足时只导出最新的记录
+    TEST_CHECK_EQ(CAN_Trace_Export(file, sizeof(CAN_TraceHeader_t) + sizeof(CAN_TraceRecord_t)),
+                  sizeof(CAN_TraceHeader_t) + sizeof(CAN_TraceRecord_t));
+    TEST_CHECK(CAN_Trace_ParseFile(file, sizeof(file), &records, &count));
+    TEST_CHECK_EQ(count, 1);
+    TEST_CHECK_EQ(records[0].id, 0x200 | CAN_TRACE_FLAG_TX);
+    TEST_CHECK_EQ(CAN_Trace_Export(file, sizeof(CAN_TraceHeader_t) - 1), 0);
+}
+
+static void test_replay_file(void)
+{
+    CAN_HandleTypeDef* const hcans[CAN_NUM] = {&hcan1, NULL};
+    const size_t             size           = record_and_export();
+
+    // 发送记录被跳过
+    decoded_n = 0;
+    TEST_CHECK_EQ(CAN_Trace_ReplayFile(hcans, file, size, false), 2);
+    TEST_CHECK_EQ(decoded_n, 2);
+    TEST_CHECK_EQ(decoded[0], 0x201);
+    TEST_CHECK_EQ(decoded[1], 0x202);
+}
+
+static void test_replay_rejects(void)
+{
+    CAN_HandleTypeDef* const hcans[CAN_NUM] = {&hcan1, NULL};
+    const size_t             size           = record_and_export();
+    CAN_TraceHeader_t        header;
+
+    HostHal_TrapErrors(false);
+    decoded_n             = 0;
+    const uint32_t errors = HostHal_ErrorCount();
+
+    // 截断
+    TEST_CHECK_EQ(CAN_Trace_ReplayFile(hcans, file, size - 1, false), 0);
+    TEST_CHECK_EQ(CAN_Trace_ReplayFile(hcans, file, sizeof(header) - 1, false), 0);
+
+    // 字节序不同
+    memcpy(&header, file, sizeof(header));
+    header.magic = __builtin_bswap32(CAN_TRACE_MAGIC);
+    memcpy(file, &header, sizeof(header));
+    TEST_CHECK_EQ(CAN_Trace_ReplayFile(hcans, file, size, false), 0);
+
+    // 版本或记录格式不同
+    header.magic   = CAN_TRACE_MAGIC;
+    header.version = CAN_TRACE_VERSION + 1;
+    memcpy(file, &header, sizeof(header));
+    TEST_CHECK_EQ(CAN_Trace_ReplayFile(hcans, file, size, false), 0);
+    header.version     = CAN_TRACE_VERSION;
+    header.record_size = sizeof(CAN_TraceRecord_t) + 4;
+    memcpy(file, &header, sizeof(header));
+    TEST_CHECK_EQ(CAN_Trace_ReplayFile(hcans, file, size, false), 0);
+
+    TEST_CHECK_EQ(HostHal_ErrorCount(), errors + 5);
+    TEST_CHECK_EQ(decoded_n, 0);
+    HostHal_TrapErrors(true);
+}
+
+static void test_candump_round_trip(void)
+{
+    CAN_TraceRecord_t record;
+    char              line[64];
+
+    TEST_CHECK(CAN_Trace_ParseCandump("(1436509052.249713) can0 123#DEADBEEF", &record));
+    TEST_CHECK_EQ(record.id, 0x123);
+    TEST_CHECK_EQ(record.dlc, 4);
+    TEST_CHECK(CAN_Trace_FormatCandump(&record, line, sizeof(line)) > 0);
+
+    CAN_TraceRecord_t again;
+    TEST_CHECK(CAN_Trace_ParseCandump(line, &again));
+    TEST_CHECK_EQ(again.id, record.id);
+    TEST_CHECK_EQ(again.dlc, record.dlc);
+    TEST_CHECK(memcmp(again.data, record.data, sizeof(record.data)) == 0);
+}
+
+int main(void)
+{
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    HAL_CAN_RegisterCallback(&hcan1, HAL_CAN_RX_FIFO0_MSG_PENDING_CB_ID, CAN_Fifo0ReceiveCallback);
+    CAN_RegisterRoute(&hcan1, CAN_ID_STD, 0x201, record_decoder, NULL);
+    CAN_RegisterRoute(&hcan1, CAN_ID_STD, 0x202, record_decoder, NULL);
+
+    TEST_RUN(test_export_header);
+    TEST_RUN(test_replay_file);
+    TEST_RUN(test_replay_rejects);
+    TEST_RUN(test_candump_round_trip);
+    return TEST_RESULT();
+}
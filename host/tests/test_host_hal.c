@@ -0,0 +1,172 @@
+/**
+ * @file    test_host_hal.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   HAL 模拟器自检：FIFO 溢出与写 1 清零、发送邮箱优先级、过滤器匹配
+ */
+#include <string.h>
+#include "host_hal.h"
+#include "test.h"
+#include "can.h"
+
+static HostCan_Frame_t std_frame(const uint32_t id, const uint8_t first)
+{
+    return (HostCan_Frame_t){.id = id, .ide = CAN_ID_STD, .dlc = 8, .data = {first}};
+}
+
+static void test_fifo_overrun(void)
+{
+    HostHal_Reset();
+    HAL_CAN_Start(&hcan1);
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        const HostCan_Frame_t f = std_frame(0x100 + i, i);
+        TEST_CHECK(HostCan_Receive(&hcan1, CAN_RX_FIFO0, &f));
+    }
+    TEST_CHECK_EQ(HAL_CAN_GetRxFifoFillLevel(&hcan1, CAN_RX_FIFO0), 3);
+    TEST_CHECK(__HAL_CAN_GET_FLAG(&hcan1, CAN_FLAG_FF0));
+    TEST_CHECK(!__HAL_CAN_GET_FLAG(&hcan1, CAN_FLAG_FOV0));
+
+    // 第 4 帧覆盖最后一帧 (RFLM = 0)
+    const HostCan_Frame_t f = std_frame(0x1FF, 9);
+    TEST_CHECK(!HostCan_Receive(&hcan1, CAN_RX_FIFO0, &f));
+    TEST_CHECK(__HAL_CAN_GET_FLAG(&hcan1, CAN_FLAG_FOV0));
+    TEST_CHECK(!__HAL_CAN_GET_FLAG(&hcan1, CAN_FLAG_FOV1));
+
+    CAN_RxHeaderTypeDef header;
+    uint8_t             data[8];
+    TEST_CHECK(HAL_CAN_GetRxMessage(&hcan1, CAN_RX_FIFO0, &header, data) == HAL_OK);
+    TEST_CHECK_EQ(header.StdId, 0x100);
+    // HAL 以读-改-写释放邮箱，FOVR 被一起清除
+    TEST_CHECK(!__HAL_CAN_GET_FLAG(&hcan1, CAN_FLAG_FOV0));
+    TEST_CHECK(HAL_CAN_GetRxMessage(&hcan1, CAN_RX_FIFO0, &header, data) == HAL_OK);
+    TEST_CHECK_EQ(header.StdId, 0x101);
+    TEST_CHECK(HAL_CAN_GetRxMessage(&hcan1, CAN_RX_FIFO0, &header, data) == HAL_OK);
+    TEST_CHECK_EQ(header.StdId, 0x1FF);
+    TEST_CHECK_EQ(data[0], 9);
+    TEST_CHECK(HAL_CAN_GetRxMessage(&hcan1, CAN_RX_FIFO0, &header, data) == HAL_ERROR);
+}
+
+static void test_clear_flag(void)
+{
+    HostHal_Reset();
+    HAL_CAN_Start(&hcan2);
+    const HostCan_Frame_t f = std_frame(0x200, 0);
+    for (int i = 0; i < 4; i++)
+        HostCan_Receive(&hcan2, CAN_RX_FIFO1, &f);
+    TEST_CHECK(__HAL_CAN_GET_FLAG(&hcan2, CAN_FLAG_FOV1));
+    __HAL_CAN_CLEAR_FLAG(&hcan2, CAN_FLAG_FOV1);
+    TEST_CHECK(!__HAL_CAN_GET_FLAG(&hcan2, CAN_FLAG_FOV1));
+    // 清除标志不影响 FIFO 内容
+    TEST_CHECK_EQ(HAL_CAN_GetRxFifoFillLevel(&hcan2, CAN_RX_FIFO1), 3);
+
+    // 只写 RFOM（寄存器快速路径的做法）不清除 FOVR：模拟器中寄存器没有副作用，这里直接检查位
+    HostCan_Receive(&hcan2, CAN_RX_FIFO1, &f);
+    TEST_CHECK((CAN2->RF1R & CAN_RF1R_FOVR1) != 0);
+    TEST_CHECK((CAN_RF1R_RFOM1 & CAN_RF1R_FOVR1) == 0);
+}
+
+static void test_tx_priority(void)
+{
+    static const uint32_t ids[3] = {0x300, 0x100, 0x200};
+    uint32_t              mailbox;
+    HostCan_Frame_t       f;
+
+    HostHal_Reset();
+    HAL_CAN_Start(&hcan1);
+    for (int i = 0; i < 3; i++)
+    {
+        const CAN_TxHeaderTypeDef header = {.StdId = ids[i], .IDE = CAN_ID_STD, .DLC = 1};
+        const uint8_t             data[8] = {(uint8_t) i};
+        TEST_CHECK(HAL_CAN_AddTxMessage(&hcan1, &header, data, &mailbox) == HAL_OK);
+        TEST_CHECK_EQ(mailbox, 1U << i);
+    }
+    TEST_CHECK_EQ(HAL_CAN_GetTxMailboxesFreeLevel(&hcan1), 0);
+    TEST_CHECK_EQ(HostCan_PendingMailboxes(&hcan1), 7);
+    TEST_CHECK_EQ(HostCan_Transmit(&hcan1, 3), 3);
+    // TXFP = 0：按标识符优先级
+    TEST_CHECK(HostCan_PopTx(&hcan1, &f) && f.id == 0x100);
+    TEST_CHECK(HostCan_PopTx(&hcan1, &f) && f.id == 0x200);
+    TEST_CHECK(HostCan_PopTx(&hcan1, &f) && f.id == 0x300);
+    TEST_CHECK(!HostCan_PopTx(&hcan1, &f));
+
+    // TXFP = 1：按请求顺序
+    CAN1->MCR |= CAN_MCR_TXFP;
+    for (int i = 0; i < 3; i++)
+    {
+        const CAN_TxHeaderTypeDef header = {.StdId = ids[i], .IDE = CAN_ID_STD, .DLC = 1};
+        const uint8_t             data[8] = {0};
+        HAL_CAN_AddTxMessage(&hcan1, &header, data, &mailbox);
+    }
+    HostCan_Transmit(&hcan1, 3);
+    for (int i = 0; i < 3; i++)
+        TEST_CHECK(HostCan_PopTx(&hcan1, &f) && f.id == ids[i]);
+}
+
+static void test_filter_match(void)
+{
+    HostHal_Reset();
+    // bank 0：16 位列表，4 个标准帧 ID，FIFO0
+    const CAN_FilterTypeDef list = {
+        .FilterIdLow          = 0x201 << 5,
+        .FilterMaskIdLow      = 0x202 << 5,
+        .FilterIdHigh         = 0x203 << 5,
+        .FilterMaskIdHigh     = 0x204 << 5,
+        .FilterFIFOAssignment = CAN_FILTER_FIFO0,
+        .FilterBank           = 0,
+        .FilterMode           = CAN_FILTERMODE_IDLIST,
+        .FilterScale          = CAN_FILTERSCALE_16BIT,
+        .FilterActivation     = ENABLE,
+        .SlaveStartFilterBank = 14,
+    };
+    // bank 1：32 位掩码，扩展帧 0x1000 ~ 0x10FF，FIFO1
+    const CAN_FilterTypeDef mask = {
+        .FilterIdHigh         = (0x1000 << 3 | CAN_ID_EXT) >> 16,
+        .FilterIdLow          = (0x1000 << 3 | CAN_ID_EXT) & 0xFFFF,
+        .FilterMaskIdHigh     = (0x1FFFFF00U << 3 | 0x6) >> 16,
+        .FilterMaskIdLow      = (0x1FFFFF00U << 3 | 0x6) & 0xFFFF,
+        .FilterFIFOAssignment = CAN_FILTER_FIFO1,
+        .FilterBank           = 1,
+        .FilterMode           = CAN_FILTERMODE_IDMASK,
+        .FilterScale          = CAN_FILTERSCALE_32BIT,
+        .FilterActivation     = ENABLE,
+        .SlaveStartFilterBank = 14,
+    };
+    TEST_CHECK(HAL_CAN_ConfigFilter(&hcan1, &list) == HAL_OK);
+    TEST_CHECK(HAL_CAN_ConfigFilter(&hcan1, &mask) == HAL_OK);
+    HAL_CAN_Start(&hcan1);
+
+    CAN_RxHeaderTypeDef header;
+    uint8_t             data[8];
+    for (uint32_t k = 0; k < 4; k++)
+    {
+        const HostCan_Frame_t f = std_frame(0x201 + k, 0);
+        TEST_CHECK_EQ(HostCan_ReceiveFiltered(&hcan1, &f), 0);
+        HAL_CAN_GetRxMessage(&hcan1, CAN_RX_FIFO0, &header, data);
+        TEST_CHECK_EQ(header.FilterMatchIndex, k);
+    }
+    const HostCan_Frame_t miss = std_frame(0x205, 0);
+    TEST_CHECK_EQ(HostCan_ReceiveFiltered(&hcan1, &miss), -1);
+
+    const HostCan_Frame_t ext = {.id = 0x1042, .ide = CAN_ID_EXT, .dlc = 8};
+    TEST_CHECK_EQ(HostCan_ReceiveFiltered(&hcan1, &ext), 1);
+    HAL_CAN_GetRxMessage(&hcan1, CAN_RX_FIFO1, &header, data);
+    TEST_CHECK_EQ(header.ExtId, 0x1042);
+    TEST_CHECK_EQ(header.IDE, CAN_ID_EXT);
+    TEST_CHECK_EQ(header.FilterMatchIndex, 0); // FIFO1 的第一个过滤器
+    const HostCan_Frame_t ext_miss = {.id = 0x1142, .ide = CAN_ID_EXT, .dlc = 8};
+    TEST_CHECK_EQ(HostCan_ReceiveFiltered(&hcan1, &ext_miss), -1);
+
+    // CAN2 使用 bank 14 之后的过滤器，这里都没有配置
+    TEST_CHECK_EQ(HostCan_ReceiveFiltered(&hcan2, &ext), -1);
+}
+
+int main(void)
+{
+    TEST_RUN(test_fifo_overrun);
+    TEST_RUN(test_clear_flag);
+    TEST_RUN(test_tx_priority);
+    TEST_RUN(test_filter_match);
+    return TEST_RESULT();
+}
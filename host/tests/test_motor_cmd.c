@@ -0,0 +1,185 @@
+/**
+ * @file    test_motor_cmd.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   内部控制模式的指令：motor_if 每次更新都交给驱动，由驱动的发送缓存省略重复的帧；
+ *          反馈延迟测量到指令写入邮箱或入队为止
+ */
+#include "bsp/can_driver.h"
+#include "can.h"
+#include "host_hal.h"
+#include "interfaces/motor_if.h"
+#include "test.h"
+
+static DM_t            dm;
+static Motor_VelCtrl_t vel_dm;
+static DJI_t           dji;
+static Motor_VelCtrl_t vel_dji;
+
+/**
+ * 发出并取出 hcan2 上的全部帧
+ * @return 帧数
+ */
+static uint32_t sent_frames(void)
+{
+    HostCan_Transmit(&hcan2, 64);
+    uint32_t        n = 0;
+    HostCan_Frame_t f;
+    while (HostCan_PopTx(&hcan2, &f))
+        n++;
+    return n;
+}
+
+static void test_keepalive(void)
+{
+    DM_Init(&dm,
+            &(DM_Config_t) {
+                    .hcan        = &hcan2,
+                    .id0         = 0,
+                    .POS_MAX_RAD = 3.1416f,
+                    .VEL_MAX_RAD = 40,
+                    .T_MAX       = 10,
+                    .mode        = DM_MODE_VEL,
+                    .motor_type  = DM_S3519,
+            });
+    Motor_VelCtrl_Init(&vel_dm,
+                       &(Motor_VelCtrlConfig_t) {.motor_type = MOTOR_TYPE_DM, .motor = &dm});
+    sent_frames(); // 使能帧
+
+    // 指令不变时只发一次，保活间隔到达后重发
+    Motor_VelCtrl_SetRef(&vel_dm, 60.0f);
+    uint32_t frames = 0;
+    for (uint32_t ms = 0; ms < DM_CMD_KEEPALIVE_MS; ms++)
+    {
+        Motor_VelCtrlUpdate(&vel_dm);
+        frames += sent_frames();
+        HostHal_AdvanceTick(1);
+    }
+    TEST_CHECK_EQ(frames, 1);
+    TEST_CHECK_EQ(dm.tx_cache.suppressed, DM_CMD_KEEPALIVE_MS - 1);
+    Motor_VelCtrlUpdate(&vel_dm);
+    TEST_CHECK_EQ(sent_frames(), 1);
+
+    // 指令变化时立即发送
+    Motor_VelCtrl_SetRef(&vel_dm, 61.0f);
+    Motor_VelCtrlUpdate(&vel_dm);
+    TEST_CHECK_EQ(sent_frames(), 1);
+    Motor_VelCtrlUpdate(&vel_dm);
+    TEST_CHECK_EQ(sent_frames(), 0);
+}
+
+static void test_enable_resends(void)
+{
+    // 重新启用控制后的第一条指令不被省略，即使与上一条相同
+    __MOTOR_CTRL_DISABLE(&vel_dm);
+    Motor_VelCtrlUpdate(&vel_dm);
+    TEST_CHECK_EQ(sent_frames(), 0);
+    __MOTOR_CTRL_ENABLE(&vel_dm);
+    Motor_VelCtrlUpdate(&vel_dm);
+    TEST_CHECK_EQ(sent_frames(), 1);
+    Motor_VelCtrlUpdate(&vel_dm);
+    TEST_CHECK_EQ(sent_frames(), 0);
+
+    // 重新初始化（切换控制器或模式）同样一定发送
+    static Motor_PosCtrl_t pos_dm;
+    Motor_PosCtrl_Init(&pos_dm,
+                       &(Motor_PosCtrlConfig_t) {
+                               .motor_type         = MOTOR_TYPE_DM,
+                               .motor              = &dm,
+                               .position_pid       = {.Kp = 0, .abs_output_max = 100},
+                               .pos_vel_freq_ratio = 1,
+                       });
+    // 位置环输出为 0，与上一条速度指令不同；先发一条 0 速度，再验证相同指令在重新初始化后重发
+    Motor_PosCtrlUpdate(&pos_dm);
+    TEST_CHECK_EQ(sent_frames(), 1);
+    Motor_PosCtrl_Init(&pos_dm,
+                       &(Motor_PosCtrlConfig_t) {
+                               .motor_type         = MOTOR_TYPE_DM,
+                               .motor              = &dm,
+                               .position_pid       = {.Kp = 0, .abs_output_max = 100},
+                               .pos_vel_freq_ratio = 1,
+                       });
+    Motor_PosCtrlUpdate(&pos_dm);
+    TEST_CHECK_EQ(sent_frames(), 1);
+}
+
+static void test_latency(void)
+{
+    DJI_Init(&dji, &(DJI_Config_t) {.motor_type = M3508_C620, .hcan = &hcan1, .id1 = 1});
+    Motor_VelCtrl_Init(&vel_dji,
+                       &(Motor_VelCtrlConfig_t) {
+                               .motor_type = MOTOR_TYPE_DJI,
+                               .motor      = &dji,
+                               .pid        = {.Kp = 10, .abs_output_max = 10000},
+                       });
+    Motor_VelCtrl_SetRef(&vel_dji, 100.0f);
+
+    // 反馈在 1000 周期时读出，2000 周期时更新，电流指令 5000 周期时才发出
+    const HostCan_Frame_t feedback = {.id = 0x201, .ide = CAN_ID_STD, .dlc = 8};
+    HostDWT.CYCCNT                 = 1000;
+    HostCan_Receive(&hcan1, CAN_RX_FIFO0, &feedback);
+    HostCan_RxIrq(&hcan1, CAN_RX_FIFO0);
+    HostDWT.CYCCNT = 2000;
+    Motor_VelCtrlUpdate(&vel_dji);
+    HostDWT.CYCCNT = 5000;
+    DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_1_4);
+
+    // 上一次输出的延迟在下一次更新时记录
+    TEST_CHECK_EQ(vel_dji.latency.hist.summary.count, 0);
+    HostDWT.CYCCNT = 8000;
+    Motor_VelCtrlUpdate(&vel_dji);
+    TEST_CHECK_EQ(vel_dji.latency.hist.summary.count, 1);
+    TEST_CHECK_EQ(vel_dji.latency.hist.summary.max, 5000 - 1000);
+
+    // 本次输出没有发出，不记录
+    HostDWT.CYCCNT = 9000;
+    Motor_VelCtrlUpdate(&vel_dji);
+    TEST_CHECK_EQ(vel_dji.latency.hist.summary.count, 1);
+
+    HostCan_Transmit(&hcan1, 64);
+    HostCan_Frame_t f;
+    while (HostCan_PopTx(&hcan1, &f))
+        ;
+}
+
+static void test_latency_internal_vel(void)
+{
+    // 内部速度控制同样在指令交给驱动之前记录上一次输出的延迟
+    TEST_CHECK_EQ(vel_dm.latency.hist.summary.count, 0);
+    const HostCan_Frame_t feedback = {.id = MST_ID, .ide = CAN_ID_STD, .dlc = 8};
+    HostDWT.CYCCNT                 = 1000;
+    HostCan_Receive(&hcan2, CAN_RX_FIFO0, &feedback);
+    HostCan_RxIrq(&hcan2, CAN_RX_FIFO0);
+
+    // 新的速度指令在 3000 周期时发出
+    Motor_VelCtrl_SetRef(&vel_dm, 70.0f);
+    HostDWT.CYCCNT = 3000;
+    Motor_VelCtrlUpdate(&vel_dm);
+    TEST_CHECK_EQ(sent_frames(), 1);
+    TEST_CHECK_EQ(vel_dm.latency.hist.summary.count, 0);
+
+    HostDWT.CYCCNT = 6000;
+    Motor_VelCtrlUpdate(&vel_dm);
+    TEST_CHECK_EQ(vel_dm.latency.hist.summary.count, 1);
+    TEST_CHECK_EQ(vel_dm.latency.hist.summary.max, 3000 - 1000);
+
+    // 相同的指令被发送缓存省略，没有新的指令发出，不记录
+    HostDWT.CYCCNT = 7000;
+    Motor_VelCtrlUpdate(&vel_dm);
+    TEST_CHECK_EQ(sent_frames(), 0);
+    TEST_CHECK_EQ(vel_dm.latency.hist.summary.count, 1);
+}
+
+int main(void)
+{
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    HAL_CAN_RegisterCallback(&hcan1, HAL_CAN_RX_FIFO0_MSG_PENDING_CB_ID, CAN_Fifo0ReceiveCallback);
+    CAN_Start(&hcan2, CAN_IT_RX_FIFO0_MSG_PENDING);
+    HAL_CAN_RegisterCallback(&hcan2, HAL_CAN_RX_FIFO0_MSG_PENDING_CB_ID, CAN_Fifo0ReceiveCallback);
+
+    TEST_RUN(test_keepalive);
+    TEST_RUN(test_enable_resends);
+    TEST_RUN(test_latency);
+    TEST_RUN(test_latency_internal_vel);
+    return TEST_RESULT();
+}
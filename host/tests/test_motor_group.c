@@ -0,0 +1,288 @@
+/**
+ * @file    test_motor_group.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   MotorCtrlGroup 经 HAL 路径：每个 Tick 的指令帧数、分频，以及 CAN_TxHold 期间不写邮箱；
+ *          事件驱动模式下两条更新路径都清除新反馈标记；注册电机时声明的带宽
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "bsp/can_driver.h"
+#include "can.h"
+#include "host_hal.h"
+#include "interfaces/motor_group.h"
+#include "test.h"
+
+static DJI_t            dji[3];
+static DM_t             dm;
+static VESC_t           vesc;
+static MotorCtrlGroup_t group;
+
+/**
+ * 发出并取出一条总线上的全部帧
+ * @param ids 输出，帧 ID
+ * @param max ids 的容量
+ * @return 帧数
+ */
+static uint32_t drain_bus(CAN_HandleTypeDef* hcan, uint32_t* ids, const uint32_t max)
+{
+    HostCan_Transmit(hcan, 64);
+    uint32_t        n = 0;
+    HostCan_Frame_t f;
+    while (HostCan_PopTx(hcan, &f))
+    {
+        if (n < max)
+            ids[n] = f.id;
+        n++;
+    }
+    return n;
+}
+
+static void test_hold(void)
+{
+    const CAN_TxHeaderTypeDef header  = {.StdId = 0x300, .IDE = CAN_ID_STD, .DLC = 8};
+    const uint8_t             data[8] = {0};
+
+    // 暂停期间只入队，包括邮箱空中断中的搬运
+    TEST_CHECK_EQ(CAN_SendMessage(&hcan1, &header, data), CAN_TX_MAILBOX0);
+    CAN_TxHold(&hcan1);
+    TEST_CHECK_EQ(CAN_SendMessage(&hcan1, &header, data), CAN_SEND_QUEUED);
+    TEST_CHECK_EQ(CAN_SendMessage(&hcan1, &header, data), CAN_SEND_QUEUED);
+    TEST_CHECK_EQ(HostCan_Transmit(&hcan1, 1), 1);
+    TEST_CHECK_EQ(HostCan_PendingMailboxes(&hcan1), 0);
+
+    // 恢复后一起写入邮箱
+    CAN_TxRelease(&hcan1);
+    TEST_CHECK_EQ(HostCan_PendingMailboxes(&hcan1), 3);
+    uint32_t ids[4];
+    TEST_CHECK_EQ(drain_bus(&hcan1, ids, 4), 3);
+}
+
+static void test_tick_frames(void)
+{
+    static const uint8_t ids[3] = {1, 2, 5};
+    for (uint8_t i = 0; i < 3; i++)
+        DJI_Init(&dji[i],
+                 &(DJI_Config_t) {.motor_type = M3508_C620, .hcan = &hcan1, .id1 = ids[i]});
+    DM_Init(&dm,
+            &(DM_Config_t) {
+                    .hcan        = &hcan2,
+                    .id0         = 0,
+                    .POS_MAX_RAD = 3.1416f,
+                    .VEL_MAX_RAD = 40,
+                    .T_MAX       = 10,
+                    .mode        = DM_MODE_VEL,
+                    .motor_type  = DM_S3519,
+            });
+    VESC_Init(&vesc, &(VESC_Config_t) {.hcan = &hcan2, .id = 15, .electrodes = 7});
+    // 初始化时的使能帧等
+    uint32_t frame_ids[16];
+    drain_bus(&hcan1, frame_ids, 16);
+    drain_bus(&hcan2, frame_ids, 16);
+
+    MotorCtrlGroup_Init(&group, 1000);
+    for (uint8_t i = 0; i < 3; i++)
+        MotorCtrlGroup_AddPos(&group,
+                              &(Motor_PosCtrlConfig_t) {
+                                      .motor_type         = MOTOR_TYPE_DJI,
+                                      .motor              = &dji[i],
+                                      .velocity_pid       = {.Kp = 1, .abs_output_max = 1000},
+                                      .position_pid       = {.Kp = 1, .abs_output_max = 100},
+                                      .pos_vel_freq_ratio = 1,
+                              },
+                              1);
+    Motor_VelCtrl_t* vel_dm = MotorCtrlGroup_AddVel(
+            &group, &(Motor_VelCtrlConfig_t) {.motor_type = MOTOR_TYPE_DM, .motor = &dm}, 5);
+    Motor_VelCtrl_t* vel_vesc = MotorCtrlGroup_AddVel(
+            &group, &(Motor_VelCtrlConfig_t) {.motor_type = MOTOR_TYPE_VESC, .motor = &vesc}, 5);
+    TEST_CHECK_EQ(group.bus_count, 2);
+
+    uint32_t bad_dji = 0, bad_divider = 0, internal = 0;
+    for (uint32_t tick = 0; tick < 20; tick++)
+    {
+        // 目标值每次变化，内部模式的指令每次更新都会发送
+        Motor_VelCtrl_SetRef(vel_dm, 10.0f + (float) tick);
+        Motor_VelCtrl_SetRef(vel_vesc, 1000.0f + (float) tick);
+        MotorCtrlGroup_Tick(&group);
+
+        // hcan1：每个 Tick 一帧 0x200 和一帧 0x1FF
+        const uint32_t n1 = drain_bus(&hcan1, frame_ids, 16);
+        if (n1 != 2 || frame_ids[0] + frame_ids[1] != 0x200 + 0x1FF)
+            bad_dji++;
+
+        // hcan2：只在分频后的 Tick 发出达妙和 VESC 的指令
+        const uint32_t n2 = drain_bus(&hcan2, frame_ids, 16);
+        if (n2 != (tick % 5 == 0 ? 2U : 0U))
+            bad_divider++;
+        // 达妙速度模式 0x200 | id0，VESC 扩展帧 cmd << 8 | id，发出顺序按总线仲裁
+        const uint32_t expect = (DM_MODE_VEL | 0U) + (VESC_CAN_SET_RPM << 8 | 15U);
+        if (n2 == 2 && frame_ids[0] + frame_ids[1] == expect)
+            internal++;
+    }
+    TEST_CHECK_EQ(bad_dji, 0);
+    TEST_CHECK_EQ(bad_divider, 0);
+    TEST_CHECK_EQ(internal, 4);
+}
+
+/**
+ * Tick 中各总线的帧只在 CAN_TxRelease 时写入邮箱，连续发出
+ */
+static void test_tick_back_to_back(void)
+{
+    const CAN_TxHeaderTypeDef header  = {.StdId = 0x300, .IDE = CAN_ID_STD, .DLC = 8};
+    const uint8_t             data[8] = {0};
+
+    // 邮箱被占满时 Tick 的帧全部入队，邮箱空出后按顺序连续发出
+    for (int i = 0; i < 3; i++)
+        CAN_SendMessage(&hcan1, &header, data);
+    MotorCtrlGroup_Tick(&group);
+    CAN_TxQueueStats_t stats;
+    CAN_GetTxQueueStats(&hcan1, &stats);
+    TEST_CHECK_EQ(stats.depth, 2);
+
+    uint32_t ids[8];
+    TEST_CHECK_EQ(drain_bus(&hcan1, ids, 8), 5);
+    int pos_1_4 = -1, pos_5_8 = -1;
+    for (int i = 0; i < 5; i++)
+    {
+        if (ids[i] == 0x200)
+            pos_1_4 = i;
+        if (ids[i] == 0x1FF)
+            pos_5_8 = i;
+    }
+    TEST_CHECK(pos_1_4 >= 0 && pos_5_8 >= 0);
+    TEST_CHECK_EQ(abs(pos_1_4 - pos_5_8), 1);
+    drain_bus(&hcan2, ids, 8);
+}
+
+/**
+ * 注入一帧大疆反馈并进入接收中断
+ */
+static void dji_feedback(const uint8_t id1)
+{
+    const HostCan_Frame_t f = {.id = 0x200 + id1, .ide = CAN_ID_STD, .dlc = 8};
+    HostCan_Receive(&hcan1, CAN_RX_FIFO0, &f);
+    HostCan_RxIrq(&hcan1, CAN_RX_FIFO0);
+}
+
+static void test_event_deadline(void)
+{
+    static MotorCtrlGroup_t ev;
+    MotorCtrlGroup_Init(&ev, 1000);
+    for (uint8_t i = 0; i < 3; i++)
+        MotorCtrlGroup_AddVel(&ev,
+                              &(Motor_VelCtrlConfig_t) {
+                                      .motor_type = MOTOR_TYPE_DJI,
+                                      .motor      = &dji[i],
+                                      .pid        = {.Kp = 1, .abs_output_max = 1000},
+                              },
+                              1);
+    MotorCtrlGroup_SetEventDriven(&ev, true);
+    HAL_CAN_RegisterCallback(&hcan1, HAL_CAN_RX_FIFO0_MSG_PENDING_CB_ID, CAN_Fifo0ReceiveCallback);
+    // 清除之前的用例留下的新反馈标记
+    MotorCtrlGroup_Tick(&ev);
+
+    // 5 号电机的反馈到达后还没有 Poll 就到了截止时间，由 Tick 更新
+    dji_feedback(1);
+    dji_feedback(2);
+    TEST_CHECK(!MotorCtrlGroup_Poll(&ev));
+    dji_feedback(5);
+    MotorCtrlGroup_Tick(&ev);
+    TEST_CHECK_EQ(ev.buses[0].deadlines, 2);
+
+    // Tick 已经用过 5 号电机的反馈，1、2 号电机的新反馈不足以触发更新
+    dji_feedback(1);
+    dji_feedback(2);
+    TEST_CHECK(!MotorCtrlGroup_Poll(&ev));
+    TEST_CHECK_EQ(ev.buses[0].events, 0);
+    dji_feedback(5);
+    TEST_CHECK(MotorCtrlGroup_Poll(&ev));
+    TEST_CHECK_EQ(ev.buses[0].events, 1);
+
+    // 两条路径分别记录
+    TEST_CHECK_EQ(ev.monitor.exec.count, 2);
+    TEST_CHECK_EQ(ev.event_monitor.exec.count, 1);
+    TEST_CHECK_EQ(ev.event_monitor.stages[0].count, 1);
+    TEST_CHECK_EQ(ev.event_monitor.stages[1].count, 1);
+    TEST_CHECK(strcmp(ev.event_monitor.stages[1].name, "CAN1") == 0);
+
+    uint32_t ids[8];
+    drain_bus(&hcan1, ids, 8);
+}
+
+static void test_stage_names(void)
+{
+    // 先注册 CAN2 上的电机，阶段名仍按实例命名
+    static MotorCtrlGroup_t other;
+    MotorCtrlGroup_Init(&other, 1000);
+    MotorCtrlGroup_AddVel(
+            &other, &(Motor_VelCtrlConfig_t) {.motor_type = MOTOR_TYPE_DM, .motor = &dm}, 1);
+    MotorCtrlGroup_AddVel(&other,
+                          &(Motor_VelCtrlConfig_t) {
+                                  .motor_type = MOTOR_TYPE_DJI,
+                                  .motor      = &dji[0],
+                                  .pid        = {.Kp = 1, .abs_output_max = 1000},
+                          },
+                          1);
+    TEST_CHECK(strcmp(other.monitor.stages[0].name, "update") == 0);
+    TEST_CHECK(strcmp(other.monitor.stages[1].name, "CAN2") == 0);
+    TEST_CHECK(strcmp(other.monitor.stages[2].name, "CAN1") == 0);
+}
+
+static void test_reserve_once(void)
+{
+    const uint32_t std8 = CAN_FrameBits(CAN_ID_STD, CAN_RTR_DATA, 8);
+    const uint32_t ext8 = CAN_FrameBits(CAN_ID_EXT, CAN_RTR_DATA, 8);
+    const uint32_t ext4 = CAN_FrameBits(CAN_ID_EXT, CAN_RTR_DATA, 4);
+    CAN_BusLoad_t  load1, load2;
+    CAN_GetBusLoad(&hcan1, &load1);
+    CAN_GetBusLoad(&hcan2, &load2);
+    // 3 路 DJI 反馈 + 两组电流指令；DM 指令与反馈各一帧；VESC 指令 + 5 种状态帧
+    TEST_CHECK_EQ(load1.reserved, (3 + 2) * std8 * DJI_FEEDBACK_HZ);
+    TEST_CHECK_EQ(load2.reserved,
+                  2 * std8 * DM_CMD_HZ + ext4 * VESC_CMD_HZ + 5 * ext8 * VESC_STATUS_HZ);
+
+    // 重复初始化同一个 handle 不再重复声明
+    DJI_Init(&dji[0], &(DJI_Config_t) {.motor_type = M3508_C620, .hcan = &hcan1, .id1 = 1});
+    DM_Init(&dm,
+            &(DM_Config_t) {
+                    .hcan        = &hcan2,
+                    .id0         = 0,
+                    .POS_MAX_RAD = 3.1416f,
+                    .VEL_MAX_RAD = 40,
+                    .T_MAX       = 10,
+                    .mode        = DM_MODE_VEL,
+                    .motor_type  = DM_S3519,
+            });
+    VESC_Init(&vesc, &(VESC_Config_t) {.hcan = &hcan2, .id = 15, .electrodes = 7});
+    CAN_BusLoad_t again;
+    CAN_GetBusLoad(&hcan1, &again);
+    TEST_CHECK_EQ(again.reserved, load1.reserved);
+    CAN_GetBusLoad(&hcan2, &again);
+    TEST_CHECK_EQ(again.reserved, load2.reserved);
+
+    // 超出预算的声明被拒绝，不计入 reserved，之后预算内的声明仍可接受
+    TEST_CHECK(!CAN_ReserveBandwidth(&hcan1, CAN_ID_STD, 8, CAN_DEFAULT_BITRATE));
+    CAN_GetBusLoad(&hcan1, &again);
+    TEST_CHECK_EQ(again.reserved, load1.reserved);
+    TEST_CHECK_EQ(again.over_budget, load1.over_budget + 1);
+    TEST_CHECK(CAN_ReserveBandwidth(&hcan1, CAN_ID_STD, 8, 1));
+    CAN_GetBusLoad(&hcan1, &again);
+    TEST_CHECK_EQ(again.reserved, load1.reserved + std8);
+    uint32_t ids[8];
+    drain_bus(&hcan2, ids, 8);
+}
+
+int main(void)
+{
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    CAN_Start(&hcan2, CAN_IT_RX_FIFO0_MSG_PENDING);
+
+    TEST_RUN(test_hold);
+    TEST_RUN(test_tick_frames);
+    TEST_RUN(test_tick_back_to_back);
+    TEST_RUN(test_event_deadline);
+    TEST_RUN(test_stage_names);
+    TEST_RUN(test_reserve_once);
+    return TEST_RESULT();
+}
@@ -0,0 +1,286 @@
+/**
+ * @file    test_motor_ops.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   motor_if 的 MotorOps_t：与按类型 switch 的接口一致，闭环轨迹与 switch 写法的参考实现一致
+ *
+ * 改为操作表之前 motor_if 中按 switch 分发的控制更新已经不存在，参考实现按原来的流程
+ * 在测试中用 Motor_GetAngle / Motor_GetVelocity 重写（外部 PID，pos_vel_freq_ratio = 1），
+ * 位置误差与 motor_if 一样以转子刻度计算
+ */
+#include "can.h"
+#include "drivers/motor_sim.h"
+#include "host_hal.h"
+#include "interfaces/motor_if.h"
+#include "test.h"
+
+#define SIM_DT    (0.001f)
+#define SIM_STEPS (2000)
+
+static const MotorPID_Config_t velocity_pid = {
+    .Kp = 12.0f, .Ki = 0.01f, .Kd = 0, .abs_output_max = 16384.0f};
+static const MotorPID_Config_t position_pid = {
+    .Kp = 10.0f, .Ki = 0, .Kd = 0, .abs_output_max = 2000.0f};
+
+static void sim_step(void)
+{
+    MotorSim_Step(SIM_DT);
+    HostHal_AdvanceTick(1);
+}
+
+/**
+ * 两个相同的 DJI 电机，一个由 Motor_PosCtrlUpdate 控制，一个由 switch 写法的参考实现控制，
+ * 每一步的角度、转速和电流指令都应完全相同
+ */
+static void test_trajectory_matches_switch(void)
+{
+    static DJI_t      dji[2];
+    static MotorSim_t sim[2];
+    for (uint8_t k = 0; k < 2; k++)
+    {
+        DJI_Init(&dji[k],
+                 &(DJI_Config_t) {.motor_type = M3508_C620, .hcan = &hcan1, .id1 = 1 + k});
+        MotorSim_Init(&sim[k],
+                      &(MotorSim_Config_t) {
+                              .type = MOTOR_SIM_M3508_C620, .hcan = &hcan1, .id = 1 + k});
+    }
+
+    static Motor_PosCtrl_t pos;
+    Motor_PosCtrl_Init(&pos,
+                       &(Motor_PosCtrlConfig_t) {
+                               .motor_type         = MOTOR_TYPE_DJI,
+                               .motor              = &dji[0],
+                               .velocity_pid       = velocity_pid,
+                               .position_pid       = position_pid,
+                               .pos_vel_freq_ratio = 1,
+                       });
+    MotorPID_t ref_pos, ref_vel;
+    MotorPID_Init(&ref_pos, position_pid);
+    MotorPID_Init(&ref_vel, velocity_pid);
+
+    for (int i = 0; i < 10; i++)
+        sim_step();
+
+    Motor_PosCtrl_SetRef(&pos, 90.0f);
+    const int64_t ref_ticks = MotorPIDFixed_FloatToI64(90.0f / dji[1].angle_per_tick);
+
+    uint32_t mismatch = 0;
+    for (int i = 0; i < SIM_STEPS; i++)
+    {
+        sim_step();
+
+        Motor_PosCtrlUpdate(&pos);
+
+        ref_pos.ref = MultiTurn_AngleError(ref_ticks, DJI_GetTicks(&dji[1]), dji[1].angle_per_tick);
+        ref_pos.fdb = 0;
+        MotorPID_Calculate(&ref_pos);
+        ref_vel.ref = ref_pos.output;
+        ref_vel.fdb = Motor_GetVelocity(MOTOR_TYPE_DJI, &dji[1]);
+        MotorPID_Calculate(&ref_vel);
+        __DJI_SET_IQ_CMD(&dji[1], ref_vel.output);
+
+        DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_1_4);
+
+        if (__DJI_GET_ANGLE(&dji[0]) != __DJI_GET_ANGLE(&dji[1]) ||
+            __DJI_GET_VELOCITY(&dji[0]) != __DJI_GET_VELOCITY(&dji[1]) ||
+            dji[0].iq_cmd != dji[1].iq_cmd)
+            mismatch++;
+    }
+    TEST_CHECK_EQ(mismatch, 0);
+    TEST_CHECK_NEAR(__DJI_GET_ANGLE(&dji[0]), 90.0, 0.5);
+}
+
+/**
+ * 内置操作表的读数与按类型 switch 的 Motor_GetAngle / Motor_GetVelocity 相同
+ */
+static void test_accessors_match_switch(void)
+{
+    static DM_t       dm;
+    static VESC_t     vesc;
+    static MotorSim_t sim_dm, sim_vesc;
+
+    MotorSim_Init(&sim_dm,
+                  &(MotorSim_Config_t) {
+                          .type        = MOTOR_SIM_DM_S3519,
+                          .hcan        = &hcan2,
+                          .id          = 0,
+                          .pos_max_rad = 3.1416f,
+                          .vel_max_rad = 40,
+                          .t_max       = 10,
+                  });
+    DM_Init(&dm,
+            &(DM_Config_t) {
+                    .hcan        = &hcan2,
+                    .id0         = 0,
+                    .POS_MAX_RAD = 3.1416f,
+                    .VEL_MAX_RAD = 40,
+                    .T_MAX       = 10,
+                    .mode        = DM_MODE_VEL,
+                    .motor_type  = DM_S3519,
+            });
+    MotorSim_Init(&sim_vesc,
+                  &(MotorSim_Config_t) {
+                          .type = MOTOR_SIM_VESC, .hcan = &hcan2, .id = 15, .electrodes = 7});
+    VESC_Init(&vesc, &(VESC_Config_t) {.hcan = &hcan2, .id = 15, .electrodes = 7});
+
+    static Motor_VelCtrl_t vel_dm, vel_vesc;
+    Motor_VelCtrl_Init(&vel_dm,
+                       &(Motor_VelCtrlConfig_t) {.motor_type = MOTOR_TYPE_DM, .motor = &dm});
+    Motor_VelCtrl_Init(&vel_vesc,
+                       &(Motor_VelCtrlConfig_t) {.motor_type = MOTOR_TYPE_VESC, .motor = &vesc});
+    Motor_VelCtrl_SetRef(&vel_dm, 100.0f);
+    Motor_VelCtrl_SetRef(&vel_vesc, 3000.0f);
+
+    const MotorOps_t* dm_ops   = Motor_GetOps(MOTOR_TYPE_DM);
+    const MotorOps_t* vesc_ops = Motor_GetOps(MOTOR_TYPE_VESC);
+    TEST_CHECK(vel_dm.ops == dm_ops);
+    TEST_CHECK(vel_vesc.ops == vesc_ops);
+    // DM 和 VESC 不接受电流输出，DM 不支持角度清零
+    TEST_CHECK(dm_ops->apply_output == NULL);
+    TEST_CHECK(dm_ops->reset_angle == NULL);
+    TEST_CHECK(vesc_ops->apply_output == NULL);
+    TEST_CHECK_EQ(vel_dm.ctrl_mode, MOTOR_DEFAULT_MODE_DM);
+    TEST_CHECK_EQ(vel_vesc.ctrl_mode, MOTOR_DEFAULT_MODE_VESC);
+
+    uint32_t mismatch = 0;
+    for (int i = 0; i < 500; i++)
+    {
+        sim_step();
+        if (i % 5 == 0)
+        {
+            Motor_VelCtrlUpdate(&vel_dm);
+            Motor_VelCtrlUpdate(&vel_vesc);
+        }
+        if (dm_ops->get_angle(&dm) != Motor_GetAngle(MOTOR_TYPE_DM, &dm) ||
+            dm_ops->get_velocity(&dm) != Motor_GetVelocity(MOTOR_TYPE_DM, &dm) ||
+            vesc_ops->get_angle(&vesc) != Motor_GetAngle(MOTOR_TYPE_VESC, &vesc) ||
+            vesc_ops->get_velocity(&vesc) != Motor_GetVelocity(MOTOR_TYPE_VESC, &vesc))
+            mismatch++;
+    }
+    TEST_CHECK_EQ(mismatch, 0);
+    TEST_CHECK(vesc.velocity > 1000.0f);
+}
+
+typedef struct
+{
+    float velocity;
+    float output;
+    int   outputs;
+} FakeMotor_t;
+
+static float fake_get_angle(void* hmotor)
+{
+    (void) hmotor;
+    return 0.0f;
+}
+
+static float fake_get_velocity(void* hmotor)
+{
+    return ((FakeMotor_t*) hmotor)->velocity;
+}
+
+static void fake_apply_output(void* hmotor, const float output)
+{
+    FakeMotor_t* fake = hmotor;
+    fake->output      = output;
+    fake->outputs++;
+}
+
+/**
+ * 自定义操作表不需要修改 motor_if 即可接入
+ */
+static void test_custom_ops(void)
+{
+    static const MotorOps_t fake_ops = {
+        .get_angle    = fake_get_angle,
+        .get_velocity = fake_get_velocity,
+        .apply_output = fake_apply_output,
+        .default_mode = MOTOR_CTRL_EXTERNAL_PID,
+    };
+    static FakeMotor_t     fake = {.velocity = 10.0f};
+    static Motor_VelCtrl_t vel;
+    Motor_VelCtrl_Init(&vel,
+                       &(Motor_VelCtrlConfig_t) {
+                               .motor = &fake,
+                               .ops   = &fake_ops,
+                               .pid   = {.Kp = 2.0f, .abs_output_max = 100.0f},
+                       });
+    TEST_CHECK(vel.ops == &fake_ops);
+    TEST_CHECK_EQ(vel.ctrl_mode, MOTOR_CTRL_EXTERNAL_PID);
+
+    Motor_VelCtrl_SetRef(&vel, 30.0f);
+    Motor_VelCtrlUpdate(&vel);
+    TEST_CHECK_EQ(fake.outputs, 1);
+    TEST_CHECK_NEAR(fake.output, 40.0, 1e-4);
+}
+
+#define FAKE_ANGLE_PER_TICK (360.0f / 8192.0f / 19.0f)
+
+static int64_t fake_ticks;
+
+static int64_t fake_get_angle_raw(void* hmotor)
+{
+    (void) hmotor;
+    return fake_ticks;
+}
+
+static void fake_get_raw_scale(void* hmotor, MotorRawScale_t* scale)
+{
+    (void) hmotor;
+    scale->angle    = FAKE_ANGLE_PER_TICK;
+    scale->velocity = 0.0f;
+    scale->output   = 0.0f;
+}
+
+/**
+ * 位置远超 2^24 刻度时，浮点位置环的误差仍精确到一个刻度
+ */
+static void test_tick_referenced_error(void)
+{
+    static const MotorOps_t fake_ops = {
+        .get_angle     = fake_get_angle,
+        .get_velocity  = fake_get_velocity,
+        .apply_output  = fake_apply_output,
+        .get_angle_raw = fake_get_angle_raw,
+        .get_raw_scale = fake_get_raw_scale,
+        .default_mode  = MOTOR_CTRL_EXTERNAL_PID,
+    };
+    static FakeMotor_t     fake;
+    static Motor_PosCtrl_t pos;
+    Motor_PosCtrl_Init(&pos,
+                       &(Motor_PosCtrlConfig_t) {
+                               .motor              = &fake,
+                               .ops                = &fake_ops,
+                               .velocity_pid       = {.Kp = 1.0f, .abs_output_max = 1e9f},
+                               .position_pid       = {.Kp = 1.0f, .abs_output_max = 1e9f},
+                               .pos_vel_freq_ratio = 1,
+                       });
+    TEST_CHECK(pos.tick_ref);
+
+    // 约 1.9 万圈，分别换算为角度后相差一个刻度的两个位置相等
+    fake_ticks = 3000000001LL;
+    TEST_CHECK((float) fake_ticks * FAKE_ANGLE_PER_TICK ==
+               (float) (fake_ticks + 1) * FAKE_ANGLE_PER_TICK);
+
+    Motor_PosCtrl_SetRefRaw(&pos, fake_ticks + 1);
+    Motor_PosCtrlUpdate(&pos);
+    TEST_CHECK(pos.position_pid.ref == FAKE_ANGLE_PER_TICK);
+
+    // 再移动 3 个刻度，增量不受目标值大小的影响
+    Motor_PosCtrl_MoveRef(&pos, 3.0f * FAKE_ANGLE_PER_TICK);
+    TEST_CHECK_EQ(pos.position_raw, fake_ticks + 4);
+    Motor_PosCtrlUpdate(&pos);
+    TEST_CHECK(pos.position_pid.ref == 4.0f * FAKE_ANGLE_PER_TICK);
+}
+
+int main(void)
+{
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    CAN_Start(&hcan2, CAN_IT_RX_FIFO1_MSG_PENDING);
+
+    TEST_RUN(test_trajectory_matches_switch);
+    TEST_RUN(test_accessors_match_switch);
+    TEST_RUN(test_custom_ops);
+    TEST_RUN(test_tick_referenced_error);
+    return TEST_RESULT();
+}
@@ -0,0 +1,234 @@
+/**
+ * @file    test_motor_sim.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   仿真电机闭环测试（USE_CAN_SIM）
+ *
+ * 四种电机各挂一个仿真对象，使用与实际程序相同的驱动和控制接口运行闭环，检查收敛；
+ * 另外检查模型参数的校验和 TB6612 仿真的电源电压。
+ */
+#include "can.h"
+#include "drivers/motor_sim.h"
+#include "host_hal.h"
+#include "interfaces/motor_if.h"
+#include "test.h"
+
+#define SIM_DT         (0.001f)
+#define SIM_LOOP_STEPS (3000)
+
+static void sim_step(void)
+{
+    MotorSim_Step(SIM_DT);
+    HostHal_AdvanceTick(1);
+}
+
+static void test_plant_validate(void)
+{
+    MotorPlant_t              plant;
+    const MotorPlant_Config_t ok = {
+        .inertia = 1e-5f, .torque_const = 0.01f, .resistance = 0.5f, .reduction_rate = 1};
+
+    TEST_CHECK(MotorPlant_Init(&plant, &ok));
+
+    MotorPlant_Config_t bad = ok;
+    bad.resistance          = 0;
+    TEST_CHECK(!MotorPlant_Init(&plant, &bad));
+    bad.resistance = -1;
+    TEST_CHECK(!MotorPlant_Init(&plant, &bad));
+    bad            = ok;
+    bad.inertia    = 0;
+    TEST_CHECK(!MotorPlant_Init(&plant, &bad));
+}
+
+static void test_sim_init_rejects_resistance(void)
+{
+    static MotorSim_t sim;
+
+    HostHal_TrapErrors(false);
+    const uint32_t errors = HostHal_ErrorCount();
+    MotorSim_Init(&sim,
+                  &(MotorSim_Config_t) {
+                          .type  = MOTOR_SIM_M3508_C620,
+                          .hcan  = &hcan1,
+                          .id    = 8,
+                          .plant = {.inertia = 1e-5f, .torque_const = 0.01f, .resistance = 0},
+                  });
+    TEST_CHECK_EQ(HostHal_ErrorCount(), errors + 1);
+    HostHal_TrapErrors(true);
+}
+
+/**
+ * duty 保持 1 时，空载转速近似与电源电压成正比
+ */
+static void test_tb6612_supply_voltage(void)
+{
+    static TIM_TypeDef       enc_regs[2];
+    static TIM_HandleTypeDef encoder[2] = {{.Instance = &enc_regs[0]}, {.Instance = &enc_regs[1]}};
+    static const float       duty       = 1.0f;
+    static MotorSim_t        sim[2];
+
+    for (int k = 0; k < 2; k++)
+        MotorSim_Init(&sim[k],
+                      &(MotorSim_Config_t) {
+                              .type           = MOTOR_SIM_TB6612,
+                              .duty           = &duty,
+                              .encoder        = &encoder[k],
+                              .roto_radio     = 44,
+                              .supply_voltage = k == 0 ? 0 : 24.0f,
+                      });
+    TEST_CHECK_NEAR(sim[0].supply_voltage, 12.0f, 0);
+
+    for (int i = 0; i < 3000; i++)
+        sim_step();
+
+    const float ratio = sim[1].plant.velocity / sim[0].plant.velocity;
+    printf("  no-load speed 12V %.1f rad/s, 24V %.1f rad/s\n",
+           sim[0].plant.velocity,
+           sim[1].plant.velocity);
+    TEST_CHECK(sim[0].plant.velocity > 0);
+    TEST_CHECK_NEAR(ratio, 2.0, 0.1);
+}
+
+/**
+ * DJI 位置环、DM / VESC 速度、TB6612 速度环同时运行
+ */
+static void test_closed_loop(void)
+{
+    static TIM_TypeDef       enc_regs, pwm_regs;
+    static GPIO_TypeDef      gpio;
+    static TIM_HandleTypeDef encoder = {.Instance = &enc_regs};
+    static TIM_HandleTypeDef pwm     = {.Instance = &pwm_regs};
+
+    static DJI_t      dji;
+    static DM_t       dm;
+    static VESC_t     vesc;
+    static TB6612_t   tb;
+    static MotorSim_t sim_dji, sim_dm, sim_vesc, sim_tb;
+
+    static Motor_PosCtrl_t pos_dji;
+    static Motor_VelCtrl_t vel_dm, vel_vesc, vel_tb;
+
+    DJI_Init(&dji, &(DJI_Config_t) {.motor_type = M3508_C620, .hcan = &hcan1, .id1 = 1});
+    MotorSim_Init(&sim_dji,
+                  &(MotorSim_Config_t) {.type = MOTOR_SIM_M3508_C620, .hcan = &hcan1, .id = 1});
+
+    MotorSim_Init(&sim_dm,
+                  &(MotorSim_Config_t) {
+                          .type        = MOTOR_SIM_DM_S3519,
+                          .hcan        = &hcan2,
+                          .id          = 0,
+                          .pos_max_rad = 3.1416f,
+                          .vel_max_rad = 40,
+                          .t_max       = 10,
+                  });
+    DM_Init(&dm,
+            &(DM_Config_t) {
+                    .hcan        = &hcan2,
+                    .id0         = 0,
+                    .POS_MAX_RAD = 3.1416f,
+                    .VEL_MAX_RAD = 40,
+                    .T_MAX       = 10,
+                    .mode        = DM_MODE_VEL,
+                    .motor_type  = DM_S3519,
+            });
+
+    MotorSim_Init(&sim_vesc,
+                  &(MotorSim_Config_t) {
+                          .type = MOTOR_SIM_VESC, .hcan = &hcan2, .id = 15, .electrodes = 7});
+    VESC_Init(&vesc, &(VESC_Config_t) {.hcan = &hcan2, .id = 15, .electrodes = 7});
+
+    pwm_regs.ARR = 1000;
+    TB6612_Init(&tb,
+                &(TB6612_Config_t) {
+                        .encoder         = &encoder,
+                        .in1             = {&gpio, GPIO_PIN_0},
+                        .in2             = {&gpio, GPIO_PIN_1},
+                        .pwm             = {.htim = &pwm},
+                        .sampling_period = SIM_DT,
+                        .roto_radio      = 44,
+                        .reduction_radio = 30,
+                });
+    MotorSim_Init(&sim_tb,
+                  &(MotorSim_Config_t) {
+                          .type       = MOTOR_SIM_TB6612,
+                          .duty       = &tb.duty_cmd,
+                          .encoder    = &encoder,
+                          .roto_radio = 44,
+                  });
+
+    // 增量式 PID：Kp 作用于误差的增量，相当于位置式的比例项
+    Motor_PosCtrl_Init(&pos_dji,
+                       &(Motor_PosCtrlConfig_t) {
+                               .motor_type         = MOTOR_TYPE_DJI,
+                               .motor              = &dji,
+                               .velocity_pid       = {.Kp             = 12,
+                                                      .Ki             = 0.01f,
+                                                      .Kd             = 0,
+                                                      .abs_output_max = 16384},
+                               .position_pid       = {.Kp             = 10,
+                                                      .Ki             = 0,
+                                                      .Kd             = 0,
+                                                      .abs_output_max = 2000},
+                               .pos_vel_freq_ratio = 1,
+                       });
+    Motor_VelCtrl_Init(&vel_dm,
+                       &(Motor_VelCtrlConfig_t) {.motor_type = MOTOR_TYPE_DM, .motor = &dm});
+    Motor_VelCtrl_Init(&vel_vesc,
+                       &(Motor_VelCtrlConfig_t) {.motor_type = MOTOR_TYPE_VESC, .motor = &vesc});
+    Motor_VelCtrl_Init(&vel_tb,
+                       &(Motor_VelCtrlConfig_t) {
+                               .motor_type = MOTOR_TYPE_TB6612,
+                               .motor      = &tb,
+                               .pid        = {.Kp             = 0.002f,
+                                              .Ki             = 0.0005f,
+                                              .Kd             = 0,
+                                              .abs_output_max = 1},
+                       });
+
+    for (int i = 0; i < 100; i++)
+        sim_step();
+
+    Motor_PosCtrl_SetRef(&pos_dji, 90);
+    Motor_VelCtrl_SetRef(&vel_dm, 100);
+    Motor_VelCtrl_SetRef(&vel_vesc, 3000);
+    Motor_VelCtrl_SetRef(&vel_tb, 200);
+    float tb_sum = 0; // TB6612 的测速分辨率约 45rpm，取最后 1s 的平均值
+    for (int i = 0; i < SIM_LOOP_STEPS; i++)
+    {
+        sim_step();
+        TB6612_Encoder_DataDecode(&tb);
+        if (i >= SIM_LOOP_STEPS - 1000)
+            tb_sum += tb.velocity;
+        Motor_PosCtrlUpdate(&pos_dji);
+        DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_1_4);
+        if (i % 5 == 0)
+        {
+            Motor_VelCtrlUpdate(&vel_dm);
+            Motor_VelCtrlUpdate(&vel_vesc);
+        }
+        Motor_VelCtrlUpdate(&vel_tb);
+    }
+    printf("  dji %.2f deg, dm %.1f rpm, vesc %.1f rpm, tb %.1f rpm\n",
+           __DJI_GET_ANGLE(&dji),
+           dm.vel,
+           vesc.velocity,
+           tb_sum / 1000);
+
+    TEST_CHECK_NEAR(__DJI_GET_ANGLE(&dji), 90.0, 0.5);
+    TEST_CHECK_NEAR(MotorPlant_GetOutputAngle(&sim_dji.plant) * 57.29578f, 90.0, 0.5);
+    TEST_CHECK_NEAR(dm.vel, 100.0, 2.0);
+    TEST_CHECK_NEAR(vesc.velocity, 3000.0, 30.0);
+    TEST_CHECK_NEAR(tb_sum / 1000, 200.0, 5.0);
+}
+
+int main(void)
+{
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    CAN_Start(&hcan2, CAN_IT_RX_FIFO1_MSG_PENDING);
+
+    TEST_RUN(test_plant_validate);
+    TEST_RUN(test_sim_init_rejects_resistance);
+    TEST_RUN(test_tb6612_supply_voltage);
+    TEST_RUN(test_closed_loop);
+    return TEST_RESULT();
+}
@@ -0,0 +1,81 @@
+/**
+ * @file    test_motor_watchdog.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   MotorWatchdog：第一次超时从添加时刻开始计算，与时间轮上一次推进的时刻无关；
+ *          掉线和恢复时各清除一次速度观测器
+ */
+#include "host_hal.h"
+#include "interfaces/motor_watchdog.h"
+#include "test.h"
+
+static bool     has_feedback = false;
+static uint32_t feedback_time;
+static uint32_t observer_resets;
+
+static float fake_get_zero(void* hmotor)
+{
+    return 0.0f;
+}
+
+static bool fake_get_feedback_time(void* hmotor, uint32_t* timestamp)
+{
+    *timestamp = feedback_time;
+    return has_feedback;
+}
+
+static void fake_reset_observer(void* hmotor)
+{
+    observer_resets++;
+}
+
+static const MotorOps_t fake_ops = {
+    .get_angle         = fake_get_zero,
+    .get_velocity      = fake_get_zero,
+    .get_feedback_time = fake_get_feedback_time,
+    .reset_observer    = fake_reset_observer,
+};
+
+static void test_add_after_idle(void)
+{
+    static MotorWatchdog_t watchdog;
+    static MotorWatch_t    watch;
+    static volatile bool   stale;
+
+    HostHal_SetTick(0);
+    MotorWatchdog_Init(&watchdog);
+    // Init 之后过了很久才添加，期间没有 Tick
+    HostHal_AdvanceTick(1000);
+    MotorWatchdog_Add(&watchdog,
+                      &watch,
+                      &(MotorWatch_Config_t) {.ops = &fake_ops, .timeout_ms = 20, .stale = &stale});
+    TEST_CHECK_EQ(watch.last_seen, 1000);
+
+    for (uint32_t ms = 1; ms < 20; ms++)
+    {
+        HostHal_AdvanceTick(1);
+        MotorWatchdog_Tick(&watchdog);
+    }
+    TEST_CHECK(!stale);
+    TEST_CHECK_EQ(observer_resets, 0);
+    HostHal_AdvanceTick(1);
+    MotorWatchdog_Tick(&watchdog);
+    TEST_CHECK(stale);
+    TEST_CHECK_EQ(observer_resets, 1);
+    TEST_CHECK_EQ(watch.dropouts, 1);
+    TEST_CHECK_EQ(watch.last_dropout_tick, 1020);
+
+    // 收到反馈后下一个 tick 恢复
+    feedback_time = PerfCounter_Now();
+    has_feedback  = true;
+    HostHal_AdvanceTick(1);
+    MotorWatchdog_Tick(&watchdog);
+    TEST_CHECK(!stale);
+    TEST_CHECK_EQ(observer_resets, 2);
+}
+
+int main(void)
+{
+    TEST_RUN(test_add_after_idle);
+    return TEST_RESULT();
+}
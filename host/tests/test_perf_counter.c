@@ -0,0 +1,85 @@
+/**
+ * @file    test_perf_counter.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   perf_counter 的 clock_gettime 后端、CSV 输出和直方图百分位数
+ */
+#include <string.h>
+#include <time.h>
+#include "bsp/perf_counter.h"
+#include "test.h"
+
+#ifndef USE_PERF_CLOCK_GETTIME
+#    error "host builds use the clock_gettime backend"
+#endif
+
+static void sleep_us(const long us)
+{
+    const struct timespec ts = {.tv_sec = 0, .tv_nsec = us * 1000L};
+    nanosleep(&ts, NULL);
+}
+
+static void test_measure(void)
+{
+    PerfCounter_t counter;
+    PerfCounter_Init();
+    PerfCounter_Reset(&counter, "sleep");
+    for (int i = 0; i < 5; i++)
+        PERF_MEASURE(&counter, sleep_us(2000));
+
+    TEST_CHECK_EQ(counter.count, 5);
+    // 至少 2ms，调度延迟不会超过 50ms
+    const uint32_t ns = PerfCounter_CyclesToNs(counter.min);
+    TEST_CHECK(ns >= 2000000U);
+    TEST_CHECK(PerfCounter_CyclesToNs(counter.max) < 50000000U);
+    TEST_CHECK(counter.min <= PerfCounter_Average(&counter));
+    TEST_CHECK(PerfCounter_Average(&counter) <= counter.max);
+}
+
+static void test_csv(void)
+{
+    PerfCounter_t c[2];
+    char          buf[200];
+    PerfCounter_Reset(&c[0], "a");
+    PerfCounter_Reset(&c[1], "bbbb");
+    PerfCounter_Record(&c[0], 168);
+    PerfCounter_Record(&c[0], 336);
+
+    const size_t n = PerfCounter_FormatCsv(c, 2, buf, sizeof(buf));
+    TEST_CHECK_EQ(n, strlen(buf));
+    TEST_CHECK(strcmp(buf, "name,count,cycles_min,cycles_avg,cycles_max,ns_avg\n"
+                           "a,2,168,252,336,1500\n"
+                           "bbbb,0,0,0,0,0\n") == 0);
+    // 截断时返回值与实际写入一致
+    for (size_t len = 1; len < sizeof(buf); len += 3)
+        TEST_CHECK_EQ(PerfCounter_FormatCsv(c, 2, buf, len), strlen(buf));
+}
+
+static void test_histogram(void)
+{
+    PerfHistogram_t hist;
+    // 1000ns = 168 cycles @ 168MHz
+    PerfHistogram_Reset(&hist, "h", 1000);
+    TEST_CHECK_EQ(hist.bucket_cycles, 168);
+    for (uint32_t i = 0; i < 99; i++)
+        PerfHistogram_Record(&hist, 100);
+    PerfHistogram_Record(&hist, 100000); // 落入最后一个桶
+    TEST_CHECK_EQ(hist.buckets[0], 99);
+    TEST_CHECK_EQ(hist.buckets[PERF_HISTOGRAM_BUCKETS - 1], 1);
+    TEST_CHECK_EQ(PerfHistogram_Percentile(&hist, 50), 168);
+    TEST_CHECK_EQ(PerfHistogram_Percentile(&hist, 99), 168);
+    TEST_CHECK_EQ(PerfHistogram_Percentile(&hist, 100), 100000);
+
+    char         buf[1024];
+    const size_t n = PerfHistogram_FormatCsv(&hist, buf, sizeof(buf));
+    TEST_CHECK_EQ(n, strlen(buf));
+    TEST_CHECK(strncmp(buf, "name,bucket_ns_lo,bucket_ns_hi,count\nh,0,1000,99\n", 48) == 0);
+}
+
+int main(void)
+{
+    TEST_RUN(test_measure);
+    TEST_RUN(test_csv);
+    TEST_RUN(test_histogram);
+    return TEST_RESULT();
+}
@@ -0,0 +1,67 @@
+/**
+ * @file    test_pid_fixed.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   定点 PID：增量的舍入正负对称，浮点到整数的换算饱和
+ */
+#include <math.h>
+#include "libs/pid_fixed.h"
+#include "test.h"
+
+static void test_round_symmetric(void)
+{
+    MotorPIDFixed_t pos, neg;
+    MotorPIDFixed_Init(&pos, (MotorPID_Config_t) {0.37f, 0.011f, 0.05f, 1e6f}, 1.0f, 1.0f);
+    MotorPIDFixed_Init(&neg, (MotorPID_Config_t) {0.37f, 0.011f, 0.05f, 1e6f}, 1.0f, 1.0f);
+
+    // 误差正负相反时输出也正负相反；直接右移时负方向每步多减 1，输出逐渐偏离
+    uint32_t rng = 1U;
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        rng             = rng * 1664525U + 1013904223U;
+        const int32_t e = (int32_t) (rng >> 16) - 32768;
+        pos.ref         = e;
+        neg.ref         = -e;
+        MotorPIDFixed_Calculate(&pos);
+        MotorPIDFixed_Calculate(&neg);
+        if (pos.output != -neg.output)
+            break;
+    }
+    TEST_CHECK_EQ(pos.output, -neg.output);
+
+    // 0.5 远离 0 舍入
+    MotorPIDFixed_t half = {.Kp = 1, .shift = 1, .abs_output_max = 100};
+    half.ref             = 1;
+    MotorPIDFixed_Calculate(&half);
+    TEST_CHECK_EQ(half.output, 1);
+    MotorPIDFixed_Reset(&half);
+    half.ref = -1;
+    MotorPIDFixed_Calculate(&half);
+    TEST_CHECK_EQ(half.output, -1);
+}
+
+static void test_float_saturate(void)
+{
+    TEST_CHECK_EQ(MotorPIDFixed_FloatToI32(3e9f), INT32_MAX);
+    TEST_CHECK_EQ(MotorPIDFixed_FloatToI32(-3e9f), INT32_MIN);
+    TEST_CHECK_EQ(MotorPIDFixed_FloatToI32(NAN), 0);
+    TEST_CHECK_EQ(MotorPIDFixed_FloatToI32(-2.5f), -3);
+    TEST_CHECK_EQ(MotorPIDFixed_FloatToI64(1e30f), INT64_MAX);
+    TEST_CHECK_EQ(MotorPIDFixed_FloatToI64(-INFINITY), INT64_MIN);
+    TEST_CHECK_EQ(MotorPIDFixed_FloatToI64(NAN), 0);
+    TEST_CHECK_EQ(MotorPIDFixed_FloatToI64(1e12f), 999999995904LL);
+
+    // 负的或无穷大的限幅
+    MotorPIDFixed_t pid;
+    MotorPIDFixed_Init(&pid, (MotorPID_Config_t) {1.0f, 0.0f, 0.0f, -INFINITY}, 1.0f, 1.0f);
+    TEST_CHECK_EQ(pid.abs_output_max, INT32_MAX);
+    MotorPIDFixed_Init(&pid, (MotorPID_Config_t) {1.0f, 0.0f, 0.0f, -100.0f}, 1.0f, 1.0f);
+    TEST_CHECK_EQ(pid.abs_output_max, 100 << MOTOR_PID_FIXED_OUT_FRAC);
+}
+
+int main(void)
+{
+    TEST_RUN(test_round_symmetric);
+    TEST_RUN(test_float_saturate);
+    return TEST_RESULT();
+}
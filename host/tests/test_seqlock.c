@@ -0,0 +1,156 @@
+/**
+ * @file    test_seqlock.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   反馈快照的一致性：模拟中断的线程解包，任务线程清零角度，多个读者线程读取快照
+ *
+ * 解包线程用 HostIrq_Enter / HostIrq_Exit 包住 DJI_DataDecode，与 DJI_ResetAngle 的关中断互斥，
+ * 与单核 MCU 上中断和任务的关系相同；读者不加锁，共读取 READERS * READS_PER_READER 次。
+ * 另有一个读者在写者写到一半时读取多圈位置，重读次数用完后应关中断等到写完，而不是返回半截的值
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "can.h"
+#include "drivers/DJI.h"
+#include "host_hal.h"
+#include "test.h"
+
+#define READERS          (4)
+#define READS_PER_READER (3000000)
+
+static DJI_t       dji;
+static atomic_bool stop;
+
+static atomic_ulong resets;
+static atomic_ulong reads_ok;
+static atomic_ulong reads_failed;
+static atomic_ulong torn;
+
+/**
+ * 第 n 帧反馈的单圈原始值和转速，读者据此检查快照中的字段是否来自同一帧
+ */
+static uint16_t frame_angle(const uint32_t n)
+{
+    return (uint16_t) ((uint64_t) n * 1500U % DJI_TICKS_PER_ROUND);
+}
+
+static int16_t frame_rpm(const uint32_t n)
+{
+    return (int16_t) (n % 2000U) - 1000;
+}
+
+static void* decode_thread(void* arg)
+{
+    uint32_t n = 0;
+    while (!atomic_load(&stop))
+    {
+        n++;
+        const uint16_t angle   = frame_angle(n);
+        const uint16_t rpm     = (uint16_t) frame_rpm(n);
+        const uint8_t  data[8] = {angle >> 8, angle & 0xFF, rpm >> 8, rpm & 0xFF};
+        HostIrq_Enter();
+        DJI_DataDecode(&dji, data);
+        HostIrq_Exit();
+    }
+    return NULL;
+}
+
+static void* reset_thread(void* arg)
+{
+    while (!atomic_load(&stop))
+    {
+        DJI_ResetAngle(&dji);
+        atomic_fetch_add(&resets, 1);
+    }
+    return NULL;
+}
+
+static void* reader_thread(void* arg)
+{
+    unsigned long ok = 0, failed = 0, bad = 0;
+    for (uint32_t i = 0; i < READS_PER_READER; i++)
+    {
+        DJI_Snapshot_t s;
+        if (!DJI_GetSnapshot(&dji, &s))
+        {
+            failed++;
+            continue;
+        }
+        ok++;
+        const uint32_t n = s.feedback_count;
+        if (n == 0)
+            continue;
+        // 清零时多圈位置和整圈数一起归零，二者之差始终是清零时的单圈值 (0 ~ 8191)
+        const int64_t offset = s.abs_ticks - (int64_t) s.feedback.round_cnt * DJI_TICKS_PER_ROUND -
+                               s.feedback.raw_angle;
+        if (s.feedback.raw_angle != frame_angle(n) || s.feedback.raw_rpm != frame_rpm(n) ||
+            s.rotor_rpm != frame_rpm(n) || offset > 0 || offset <= -(int64_t) DJI_TICKS_PER_ROUND)
+            bad++;
+    }
+    atomic_fetch_add(&reads_ok, ok);
+    atomic_fetch_add(&reads_failed, failed);
+    atomic_fetch_add(&torn, bad);
+    return NULL;
+}
+
+static void test_reset_during_decode(void)
+{
+    DJI_Init(&dji, &(DJI_Config_t) {.motor_type = M3508_C620, .hcan = &hcan1, .id1 = 1});
+
+    pthread_t decoder, resetter, readers[READERS];
+    pthread_create(&decoder, NULL, decode_thread, NULL);
+    pthread_create(&resetter, NULL, reset_thread, NULL);
+    for (int i = 0; i < READERS; i++)
+        pthread_create(&readers[i], NULL, reader_thread, NULL);
+    for (int i = 0; i < READERS; i++)
+        pthread_join(readers[i], NULL);
+    atomic_store(&stop, true);
+    pthread_join(decoder, NULL);
+    pthread_join(resetter, NULL);
+
+    printf("frames %u, resets %lu, reads %lu ok / %lu retried out, torn %lu\n",
+           (unsigned) dji.feedback_count, atomic_load(&resets), atomic_load(&reads_ok),
+           atomic_load(&reads_failed), atomic_load(&torn));
+    TEST_CHECK(dji.feedback_count > 0 && atomic_load(&resets) > 0);
+    TEST_CHECK_EQ(atomic_load(&reads_ok) + atomic_load(&reads_failed),
+                  (unsigned long) READERS * READS_PER_READER);
+    TEST_CHECK_EQ(atomic_load(&torn), 0);
+    // 两个写者互相打断时序号的奇偶会被破坏
+    TEST_CHECK_EQ(atomic_load(&dji.lock.seq) & 1U, 0);
+}
+
+static void* ticks_reader_thread(void* arg)
+{
+    *(int64_t*) arg = DJI_GetTicks(&dji);
+    return NULL;
+}
+
+static void test_reader_preempts_writer(void)
+{
+    const int64_t zero = dji.turns.zero;
+
+    // 写者持有"中断"写到一半：序号为奇数，位置只写了高 32 位
+    HostIrq_Enter();
+    Seqlock_WriteBegin(&dji.lock);
+    dji.turns.ticks = zero + (INT64_C(1) << 32);
+
+    int64_t   ticks = 0;
+    pthread_t reader;
+    pthread_create(&reader, NULL, ticks_reader_thread, &ticks);
+    usleep(20000); // 读者在此期间用完重读次数
+
+    dji.turns.ticks = zero + (INT64_C(1) << 32) + 12345;
+    Seqlock_WriteEnd(&dji.lock);
+    HostIrq_Exit();
+    pthread_join(reader, NULL);
+
+    TEST_CHECK_EQ(ticks, (INT64_C(1) << 32) + 12345);
+}
+
+int main(void)
+{
+    TEST_RUN(test_reset_during_decode);
+    TEST_RUN(test_reader_preempts_writer);
+    return TEST_RESULT();
+}
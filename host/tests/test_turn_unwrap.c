@@ -0,0 +1,197 @@
+/**
+ * @file    test_turn_unwrap.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   按转速预测的多圈位置：高转速低反馈频率下不丢圈，帧间隔过长时退化为最短路径
+ *          并清除速度观测器
+ *
+ * 与 app/sim_example.c 的 Sim_TurnUnwrap 相同的场景：50Hz 反馈、25% 丢帧，
+ * DJI 和 VESC 开环加速后反转，每收到一帧位置反馈都与模型比较。
+ */
+#include "can.h"
+#include "drivers/DJI.h"
+#include "drivers/motor_sim.h"
+#include "drivers/vesc.h"
+#include "host_hal.h"
+#include "test.h"
+
+#define SIM_DT             (0.001f)
+#define SIM_UNWRAP_STEPS   (3000)
+#define SIM_UNWRAP_DIVIDER (20U)
+#define SIM_UNWRAP_HZ      (50U)
+#define SIM_UNWRAP_DROP    (0.25f)
+
+#define CYCLES_PER_MS (168000U) ///< 主机上 SystemCoreClock 为 168MHz
+
+/**
+ * 模型的转子多圈位置 (unit: 刻度)
+ */
+static double sim_rotor_ticks(const MotorSim_t* hsim, const double ticks_per_round)
+{
+    return ((double) hsim->plant.turns + hsim->plant.angle / MOTOR_PLANT_2PI) * ticks_per_round;
+}
+
+static void unwrap_check(const int64_t ticks,
+                         const double  expected,
+                         double*       last,
+                         const double  ticks_per_round,
+                         double*       max_error,
+                         double*       max_turns)
+{
+    const double error = fabs((double) ticks - expected);
+    const double turns = fabs(expected - *last) / ticks_per_round;
+    if (error > *max_error)
+        *max_error = error;
+    if (turns > *max_turns)
+        *max_turns = turns;
+    *last = expected;
+}
+
+/**
+ * 两帧之间转过 1 圈以上时，多圈位置与模型只差编码器的量化误差：
+ * 大疆的单圈值截断，VESC 的单圈值舍入，都小于 1 个刻度
+ */
+static void test_high_speed(void)
+{
+    static DJI_t      dji;
+    static VESC_t     vesc;
+    static MotorSim_t sim[2];
+
+    MotorSim_DriveCycleCounter(true);
+    DJI_Init(&dji,
+             &(DJI_Config_t) {
+                     .motor_type  = M3508_C620,
+                     .hcan        = &hcan1,
+                     .id1         = 5,
+                     .feedback_hz = SIM_UNWRAP_HZ,
+             });
+    VESC_Init(&vesc,
+              &(VESC_Config_t) {
+                      .hcan = &hcan1, .id = 1, .electrodes = 7, .status_hz = SIM_UNWRAP_HZ});
+    MotorSim_Init(&sim[0],
+                  &(MotorSim_Config_t) {
+                          .type             = MOTOR_SIM_M3508_C620,
+                          .hcan             = &hcan1,
+                          .id               = 5,
+                          .feedback_divider = SIM_UNWRAP_DIVIDER,
+                          .drop_rate        = SIM_UNWRAP_DROP,
+                  });
+    MotorSim_Init(&sim[1],
+                  &(MotorSim_Config_t) {
+                          .type             = MOTOR_SIM_VESC,
+                          .hcan             = &hcan1,
+                          .id               = 1,
+                          .electrodes       = 7,
+                          .feedback_divider = SIM_UNWRAP_DIVIDER,
+                          .drop_rate        = SIM_UNWRAP_DROP,
+                  });
+
+    double   dji_last = 0, dji_max_error = 0, dji_max_turns = 0;
+    double   vesc_last = 0, vesc_max_error = 0, vesc_max_turns = 0;
+    uint32_t dji_count  = 0;
+    int64_t  vesc_ticks = 0;
+    for (uint32_t i = 0; i < SIM_UNWRAP_STEPS; i++)
+    {
+        const bool forward = i < SIM_UNWRAP_STEPS / 2;
+        if (dji.feedback_count > 0)
+            __DJI_SET_IQ_CMD(&dji, forward ? DJI_M3508_C620_IQ_MAX : -DJI_M3508_C620_IQ_MAX);
+        if (vesc.turns.started)
+            VESC_SendSetCmd(&vesc, VESC_CAN_SET_DUTY, forward ? 0.9f : -0.9f);
+        DJI_SendSetIqCommand(&hcan1, IQ_CMD_GROUP_5_8);
+        MotorSim_Step(SIM_DT);
+
+        if (dji.feedback_count != dji_count)
+        {
+            dji_count = dji.feedback_count;
+            unwrap_check(DJI_GetTicks(&dji),
+                         sim_rotor_ticks(&sim[0], DJI_TICKS_PER_ROUND),
+                         &dji_last,
+                         DJI_TICKS_PER_ROUND,
+                         &dji_max_error,
+                         &dji_max_turns);
+        }
+        if (vesc.turns.ticks != vesc_ticks)
+        {
+            vesc_ticks = vesc.turns.ticks;
+            unwrap_check(VESC_GetTicks(&vesc),
+                         sim_rotor_ticks(&sim[1], VESC_TICKS_PER_ROUND),
+                         &vesc_last,
+                         VESC_TICKS_PER_ROUND,
+                         &vesc_max_error,
+                         &vesc_max_turns);
+        }
+    }
+    MotorSim_DriveCycleCounter(false);
+
+    printf("  dji  %.2f turns between frames, max error %.3f ticks (%.5f deg), %u dropped\n",
+           dji_max_turns,
+           dji_max_error,
+           dji_max_error * dji.angle_per_tick,
+           sim[0].dropped);
+    printf("  vesc %.2f turns between frames, max error %.3f ticks (%.5f deg), %u dropped\n",
+           vesc_max_turns,
+           vesc_max_error,
+           vesc_max_error / VESC_TICKS_PER_DEGREE,
+           sim[1].dropped);
+    TEST_CHECK(dji_max_turns > 1.0);
+    TEST_CHECK(vesc_max_turns > 1.0);
+    TEST_CHECK(dji_max_error < 1.0);
+    TEST_CHECK(vesc_max_error < 1.0);
+    TEST_CHECK(sim[0].dropped > 0);
+    TEST_CHECK(sim[1].dropped > 0);
+}
+
+static void dji_decode_at(DJI_t* hdji, const uint32_t timestamp, const uint16_t raw, int16_t rpm)
+{
+    const uint8_t data[8]    = {raw >> 8, raw & 0xFF, (uint16_t) rpm >> 8, (uint16_t) rpm & 0xFF};
+    hdji->feedback_timestamp = timestamp;
+    DJI_DataDecode(hdji, data);
+}
+
+/**
+ * 6000rpm 下 7ms 转过 0.7 圈，预测值选对整圈数；之后 20ms 无反馈，正好转过 2 圈：
+ * 1kHz 的电调已超过 DJI_UNWRAP_MAX_PERIODS 个周期，取最短路径并清除观测器；
+ * 50Hz 的电调仍按转速预测，观测器照常更新
+ */
+static void test_gap_fallback(void)
+{
+    static DJI_t                           dji[2];
+    static VelocityObserver_t              observer[2];
+    static const VelocityObserver_Config_t observer_config = {.accel_noise    = 3000.0f,
+                                                              .velocity_noise = 0.1f};
+
+    for (int dir = -1; dir <= 1; dir += 2)
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            DJI_Init(&dji[k],
+                     &(DJI_Config_t) {
+                             .motor_type  = M3508_C620,
+                             .hcan        = &hcan2,
+                             .id1         = (uint8_t) (k + 1),
+                             .feedback_hz = k == 0 ? 1000 : 50,
+                     });
+            DJI_AttachObserver(&dji[k], &observer[k], &observer_config);
+            const int16_t  rpm = (int16_t) (dir * 6000);
+            const uint16_t raw = (uint16_t) (dir * 5734 & 0x1FFF); // 0.7 圈为 5734.4 个刻度
+            dji_decode_at(&dji[k], 1000, 0, rpm);
+            dji_decode_at(&dji[k], 1000 + 7 * CYCLES_PER_MS, raw, rpm);
+            TEST_CHECK_EQ(DJI_GetTicks(&dji[k]), dir * 5734);
+            dji_decode_at(&dji[k], 1000 + 27 * CYCLES_PER_MS, raw, rpm);
+        }
+        TEST_CHECK_EQ(DJI_GetTicks(&dji[0]), dir * 5734);
+        TEST_CHECK_EQ(DJI_GetTicks(&dji[1]), dir * (5734 + 2 * DJI_TICKS_PER_ROUND));
+        TEST_CHECK_EQ(observer[0].velocity, 0);
+        TEST_CHECK(observer[1].velocity * (float) dir > 0);
+    }
+}
+
+int main(void)
+{
+    CAN_Start(&hcan1, CAN_IT_RX_FIFO0_MSG_PENDING);
+    CAN_Start(&hcan2, CAN_IT_RX_FIFO1_MSG_PENDING);
+
+    TEST_RUN(test_high_speed);
+    TEST_RUN(test_gap_fallback);
+    return TEST_RESULT();
+}
@@ -0,0 +1,123 @@
+/**
+ * @file    test_velctrl_batch.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   Motor_VelCtrlBatchUpdate 与逐个 Motor_VelCtrlUpdate 的输出逐位一致
+ */
+#include <string.h>
+#include "host_hal.h"
+#include "interfaces/motor_if.h"
+#include "test.h"
+
+#define CTRL_NUM (6U)
+
+typedef struct
+{
+    float velocity;
+    float output;
+    bool  applied;
+} FakeMotor_t;
+
+static float fake_get_zero(void* hmotor)
+{
+    return 0.0f;
+}
+
+static float fake_get_velocity(void* hmotor)
+{
+    return ((FakeMotor_t*) hmotor)->velocity;
+}
+
+static void fake_apply_output(void* hmotor, const float output)
+{
+    ((FakeMotor_t*) hmotor)->output  = output;
+    ((FakeMotor_t*) hmotor)->applied = true;
+}
+
+static const MotorOps_t fake_ops = {
+    .get_angle    = fake_get_zero,
+    .get_velocity = fake_get_velocity,
+    .apply_output = fake_apply_output,
+    .default_mode = MOTOR_CTRL_EXTERNAL_PID,
+};
+
+static FakeMotor_t          motors_single[CTRL_NUM];
+static FakeMotor_t          motors_batch[CTRL_NUM];
+static Motor_VelCtrl_t      ctrls_single[CTRL_NUM];
+static Motor_VelCtrl_t      ctrls_batch[CTRL_NUM];
+static Motor_VelCtrlBatch_t batch;
+
+static void ctrl_init(Motor_VelCtrl_t* hctrl, FakeMotor_t* motor, const uint32_t k)
+{
+    Motor_VelCtrl_Init(hctrl,
+                       &(Motor_VelCtrlConfig_t) {
+                               .motor = motor,
+                               .ops   = &fake_ops,
+                               .pid   = {.Kp             = 8.0f + (float) k,
+                                         .Ki             = 0.3f,
+                                         .Kd             = 0.1f * (float) k,
+                                         .abs_output_max = k == 5 ? 0.0f : 10000.0f},
+                       });
+}
+
+static void test_bit_identical(void)
+{
+    Motor_VelCtrlBatch_Init(&batch);
+    for (uint32_t k = 0; k < CTRL_NUM; k++)
+    {
+        ctrl_init(&ctrls_single[k], &motors_single[k], k);
+        ctrl_init(&ctrls_batch[k], &motors_batch[k], k);
+        TEST_CHECK(Motor_VelCtrlBatch_Add(&batch, &ctrls_batch[k]));
+    }
+
+    uint32_t rng      = 1U;
+    uint32_t mismatch = 0;
+    for (uint32_t i = 0; i < 2000; i++)
+    {
+        for (uint32_t k = 0; k < CTRL_NUM; k++)
+        {
+            rng = rng * 1664525U + 1013904223U;
+            motors_single[k].velocity = motors_batch[k].velocity = (float) (rng >> 20) - 2048.0f;
+            motors_single[k].applied = motors_batch[k].applied = false;
+            ctrls_single[k].velocity = ctrls_batch[k].velocity = (i & 128U) ? 500.0f : -500.0f;
+        }
+        // 1 号反馈超时一段时间，2 号禁用一段时间
+        ctrls_single[1].stale = ctrls_batch[1].stale = i >= 300 && i < 400;
+        ctrls_single[2].enable = ctrls_batch[2].enable = i < 500 || i >= 700;
+
+        for (uint32_t k = 0; k < CTRL_NUM; k++)
+            Motor_VelCtrlUpdate(&ctrls_single[k]);
+        Motor_VelCtrlBatchUpdate(&batch);
+
+        for (uint32_t k = 0; k < CTRL_NUM; k++)
+        {
+            if (memcmp(&motors_single[k].output, &motors_batch[k].output, sizeof(float)) != 0 ||
+                motors_single[k].applied != motors_batch[k].applied ||
+                memcmp(&ctrls_single[k].pid, &ctrls_batch[k].pid, sizeof(MotorPID_t)) != 0)
+                mismatch++;
+        }
+    }
+    TEST_CHECK_EQ(mismatch, 0);
+}
+
+static void test_reject(void)
+{
+    static Motor_VelCtrl_t hctrl;
+    ctrl_init(&hctrl, &motors_single[0], 0);
+    hctrl.ctrl_mode = MOTOR_CTRL_INTERNAL_VEL;
+
+    Motor_VelCtrlBatch_Init(&batch);
+    HostHal_TrapErrors(false);
+    const uint32_t errors = HostHal_ErrorCount();
+    TEST_CHECK(!Motor_VelCtrlBatch_Add(&batch, &hctrl));
+    TEST_CHECK_EQ(HostHal_ErrorCount(), errors + 1);
+    HostHal_TrapErrors(true);
+    TEST_CHECK_EQ(batch.bank.count, 0);
+}
+
+int main(void)
+{
+    TEST_RUN(test_bit_identical);
+    TEST_RUN(test_reject);
+    return TEST_RESULT();
+}
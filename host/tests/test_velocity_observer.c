@@ -0,0 +1,172 @@
+/**
+ * @file    test_velocity_observer.c
+ * @author  syhanjin
+ * @date    2026-10-17
+ * @brief   速度观测器：估计误差小于测量误差，丢帧时按周期数预测，清除后重新收敛
+ *
+ * 合成的运动：指令为正弦，另有一个中途跳变的负载加速度。
+ * 位置按编码器刻度截断，转速加噪声后取整并滞后一帧，与实际的电调反馈相似。
+ */
+#include "libs/velocity_observer.h"
+#include "test.h"
+
+#define OBS_DT             (0.001)
+#define OBS_STEPS          (3000U)
+#define OBS_ANGLE_PER_TICK (360.0 / 8192.0)
+#define OBS_COMMAND_GAIN   (5.0)     ///< (unit: deg/s^2)
+#define OBS_LOAD           (-4000.0) ///< 1s 之后的负载加速度 (unit: deg/s^2)
+#define OBS_NOISE_RPM      (2.0)
+#define OBS_DROP_RATE      (0.25)
+
+static const VelocityObserver_Config_t obs_config = {
+    .accel_noise    = 20000.0f,
+    .velocity_noise = (float) OBS_NOISE_RPM,
+    .command_gain   = (float) OBS_COMMAND_GAIN,
+};
+
+static uint32_t rng_state;
+
+static double rng_uniform(void)
+{
+    rng_state = rng_state * 1664525U + 1013904223U;
+    return ((double) (rng_state >> 8) + 0.5) / (double) (1U << 24);
+}
+
+/**
+ * 标准正态分布 (Box-Muller)
+ */
+static double rng_normal(void)
+{
+    const double u1 = rng_uniform();
+    const double u2 = rng_uniform();
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+typedef struct
+{
+    double velocity_rms;     ///< 观测器转速误差的均方根 (unit: rpm)
+    double raw_rms;          ///< 反馈转速误差的均方根 (unit: rpm)
+    double acceleration_rms; ///< 观测器加速度误差的均方根 (unit: rpm/s)
+    double signal_rms;       ///< 真实加速度的均方根 (unit: rpm/s)
+} ObsResult_t;
+
+/**
+ * 运行合成的运动
+ * @param drop_rate 丢帧概率
+ * @param use_steps 丢帧时是否按经过的周期数更新，否则每帧都按一个周期更新
+ */
+static ObsResult_t obs_run(const double drop_rate, const bool use_steps)
+{
+    VelocityObserver_t obs;
+    VelocityObserver_Init(&obs, &obs_config, (float) OBS_DT, (float) OBS_ANGLE_PER_TICK);
+    rng_state = 1U;
+
+    double position = 0, omega = 0, last_rpm = 0;
+    double sum_v = 0, sum_raw = 0, sum_a = 0, sum_signal = 0;
+
+    int64_t  last_ticks = 0;
+    uint32_t steps      = 0;
+    uint32_t count      = 0;
+    float    command    = 0;
+    for (uint32_t i = 1; i <= OBS_STEPS; i++)
+    {
+        // 上一周期的指令在本周期内作用
+        const double t   = i * OBS_DT;
+        const double acc = OBS_COMMAND_GAIN * command + (t > 1.0 ? OBS_LOAD : 0.0);
+        position += (omega + 0.5 * acc * OBS_DT) * OBS_DT;
+        omega += acc * OBS_DT;
+        steps++;
+
+        // 反馈转速取整并滞后一帧
+        const double  rpm      = omega / 6.0;
+        const double  measured = last_rpm;
+        const int64_t ticks    = (int64_t) floor(position / OBS_ANGLE_PER_TICK);
+        last_rpm               = round(rpm + OBS_NOISE_RPM * rng_normal());
+
+        if (rng_uniform() >= drop_rate)
+        {
+            VelocityObserver_UpdateSteps(
+                    &obs, use_steps ? steps : 1, (int32_t) (ticks - last_ticks), measured, command);
+            last_ticks = ticks;
+            steps      = 0;
+            if (t > 0.2) // 跳过初始收敛
+            {
+                sum_v += (obs.velocity - rpm) * (obs.velocity - rpm);
+                sum_raw += (measured - rpm) * (measured - rpm);
+                sum_a += (obs.acceleration - acc / 6.0) * (obs.acceleration - acc / 6.0);
+                sum_signal += acc / 6.0 * acc / 6.0;
+                count++;
+            }
+        }
+        command = (float) (1000.0 * sin(2.0 * M_PI * 2.0 * t));
+    }
+    return (ObsResult_t) {
+        .velocity_rms     = sqrt(sum_v / count),
+        .raw_rms          = sqrt(sum_raw / count),
+        .acceleration_rms = sqrt(sum_a / count),
+        .signal_rms       = sqrt(sum_signal / count),
+    };
+}
+
+static void test_accuracy(void)
+{
+    const ObsResult_t r = obs_run(0, true);
+    printf("  velocity rms %.3f rpm (raw %.3f rpm), acceleration rms %.1f rpm/s (signal %.1f)\n",
+           r.velocity_rms,
+           r.raw_rms,
+           r.acceleration_rms,
+           r.signal_rms);
+    TEST_CHECK(r.velocity_rms < 0.5 * r.raw_rms);
+    TEST_CHECK(r.acceleration_rms < 0.2 * r.signal_rms);
+}
+
+/**
+ * 丢帧时位置增量包含多个周期的运动，按一个周期预测会把多出的位移当作误差
+ */
+static void test_dropped_frames(void)
+{
+    const ObsResult_t steps  = obs_run(OBS_DROP_RATE, true);
+    const ObsResult_t single = obs_run(OBS_DROP_RATE, false);
+    printf("  %.0f%% dropped: velocity rms %.3f rpm with steps, %.3f rpm without (raw %.3f)\n",
+           OBS_DROP_RATE * 100,
+           steps.velocity_rms,
+           single.velocity_rms,
+           steps.raw_rms);
+    TEST_CHECK(steps.velocity_rms < 0.5 * steps.raw_rms);
+    TEST_CHECK(steps.velocity_rms * 10 < single.velocity_rms);
+}
+
+/**
+ * 清除后估计归零，以恒定转速运行后重新收敛
+ */
+static void test_reset(void)
+{
+    VelocityObserver_t obs;
+    VelocityObserver_Init(&obs, &obs_config, (float) OBS_DT, (float) OBS_ANGLE_PER_TICK);
+
+    // 600 rpm = 3600 deg/s，每个周期 3.6 deg，约 81.92 个刻度
+    double  position   = 0;
+    int64_t last_ticks = 0;
+    for (uint32_t i = 0; i < 500; i++)
+    {
+        if (i == 250)
+        {
+            VelocityObserver_Reset(&obs);
+            TEST_CHECK_EQ(obs.velocity, 0);
+            TEST_CHECK_EQ(obs.acceleration, 0);
+        }
+        position += 3600.0 * OBS_DT;
+        const int64_t ticks = (int64_t) floor(position / OBS_ANGLE_PER_TICK);
+        VelocityObserver_Update(&obs, (int32_t) (ticks - last_ticks), 600.0f, 0);
+        last_ticks = ticks;
+    }
+    TEST_CHECK_NEAR(obs.velocity, 600.0, 0.5);
+}
+
+int main(void)
+{
+    TEST_RUN(test_accuracy);
+    TEST_RUN(test_dropped_frames);
+    TEST_RUN(test_reset);
+    return TEST_RESULT();
+}